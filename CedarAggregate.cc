@@ -0,0 +1,373 @@
+// CedarAggregate.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <memory>
+
+using std::endl ;
+using std::auto_ptr ;
+using std::ostringstream ;
+using std::sort ;
+using std::push_heap ;
+using std::pop_heap ;
+
+#include "CedarAggregate.h"
+#include "CedarArchive.h"
+#include "CedarFile.h"
+#include "CedarFileCache.h"
+#include "CedarInputFile.h"
+#include "TheBESKeys.h"
+#include "BESInternalError.h"
+#include "BESSyntaxUserError.h"
+#include "BESDebug.h"
+
+// files that can be read together when Cedar.Archive.MaxFiles is not set
+#define CEDAR_AGGREGATE_FILES 256
+
+unsigned long CedarAggregate::_max_files = CEDAR_AGGREGATE_FILES ;
+bool CedarAggregate::_configured = false ;
+
+/** @brief one of the files being merged and the record it has waiting
+ *
+ * A compressed file is read from its decompressed copy, see
+ * CedarPlainFile, by the raw reader as well as the Cedar library.
+ */
+class CedarAggregate::Source
+{
+private:
+    bool			_started ;
+public:
+    string			path ;
+    auto_ptr<CedarPlainFile>	plain ;
+    CedarFile *			file ;
+    CedarRawFile		raw ;
+    const CedarLogicalRecord *	lr ;
+    CedarRawRecord		rec ;
+    long long			stamp ;
+
+    				Source( const string &p, bool library )
+				    : _started( false ), path( p ),
+				      plain( new CedarPlainFile( p ) ),
+				      file( 0 ), raw( plain->get_path() ),
+				      lr( 0 ), stamp( 0 )
+				{
+				    if( library )
+				    {
+					file = new CedarFile ;
+					file->open_file(
+					    plain->get_path().c_str() ) ;
+				    }
+				}
+    				~Source() { delete file ; }
+
+    bool			advance() ;
+} ;
+
+/** @brief read the next record of the file
+ *
+ * @return false at the end of the file
+ * @throws BESInternalError if the Cedar library can not read the file
+ */
+bool
+CedarAggregate::Source::advance()
+{
+    if( file )
+    {
+	if( !_started )
+	{
+	    lr = file->get_first_logical_record() ;
+	    if( !lr )
+	    {
+		string err = (string)"Failure reading data from file " + path
+			     + ", corrupted file or not a cbf file." ;
+		throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	    }
+	}
+	else
+	{
+	    lr = 0 ;
+	    if( !file->end_dataset() )
+		lr = file->get_next_logical_record() ;
+	    if( !lr )
+		return false ;
+	}
+	raw.next_record( rec, *lr ) ;
+    }
+    else if( !raw.next_record( rec ) )
+    {
+	return false ;
+    }
+    _started = true ;
+
+    // the start of the record, to the centisecond
+    stamp = rec.get_word( CEDAR_RAW_IBYRT ) ;
+    stamp = stamp * 10000 + rec.get_word( CEDAR_RAW_IBDTT ) ;
+    stamp = stamp * 10000 + rec.get_word( CEDAR_RAW_IBHMT ) ;
+    stamp = stamp * 10000 + rec.get_word( CEDAR_RAW_IBCST ) ;
+    return true ;
+}
+
+/** @brief orders the heap of sources so the earliest record is on top,
+ * the first file first when two start together
+ */
+class CedarAggregate::Earlier
+{
+private:
+    const vector<Source *> &	_sources ;
+public:
+    				Earlier( const vector<Source *> &sources )
+				    : _sources( sources ) {}
+
+    bool			operator()( int a, int b ) const
+				{
+				    long long sa = _sources[a]->stamp ;
+				    long long sb = _sources[b]->stamp ;
+				    if( sa != sb )
+					return sa > sb ;
+				    return a > b ;
+				}
+} ;
+
+/** @brief open every file and read its first record
+ *
+ * @param files the cedar files, the header and catalog records of the
+ * first are the ones handed out
+ * @param library true to walk the files with the Cedar library as well
+ * @throws BESInternalError if a file can not be read
+ */
+CedarAggregate::CedarAggregate( const vector<string> &files, bool library )
+    : _current( -1 ),
+      _ordinal( 0 ),
+      _duplicates( 0 ),
+      _stamp( 0 )
+{
+    try
+    {
+	for( size_t i = 0; i < files.size(); i++ )
+	{
+	    _sources.push_back( new Source( files[i], library ) ) ;
+	    if( _sources.back()->advance() )
+		push( i ) ;
+	}
+    }
+    catch( ... )
+    {
+	for( size_t i = 0; i < _sources.size(); i++ )
+	    delete _sources[i] ;
+	throw ;
+    }
+}
+
+CedarAggregate::~CedarAggregate()
+{
+    for( size_t i = 0; i < _sources.size(); i++ )
+	delete _sources[i] ;
+}
+
+void
+CedarAggregate::push( int s )
+{
+    _heap.push_back( s ) ;
+    push_heap( _heap.begin(), _heap.end(), Earlier( _sources ) ) ;
+}
+
+/** @brief true if the record waiting in source s is not handed out
+ */
+bool
+CedarAggregate::skip( int s )
+{
+    const Source &src = *_sources[s] ;
+    if( src.rec.get_type() != 1 )
+	return s != 0 ;
+    if( _sources.size() == 1 )
+	return false ;
+
+    // only records starting together can be copies of each other
+    if( src.stamp != _stamp )
+    {
+	_seen.clear() ;
+	_stamp = src.stamp ;
+    }
+    const char *bytes = src.rec.get_bytes() ;
+    size_t size = src.rec.get_size() ;
+    for( size_t i = 0; i < _seen.size(); i++ )
+    {
+	if( _seen[i].first != s && _seen[i].second.size() == size
+	    && memcmp( &_seen[i].second[0], bytes, size ) == 0 )
+	{
+	    _duplicates++ ;
+	    return true ;
+	}
+    }
+    _seen.push_back( pair< int, vector<char> >( s,
+			vector<char>( bytes, bytes + size ) ) ) ;
+    return false ;
+}
+
+/** @brief the next record of the merged files
+ *
+ * @param rec set to the record, good until the next call
+ * @return false once every record has been handed out
+ * @throws BESInternalError if a file can not be read
+ */
+bool
+CedarAggregate::next( const CedarRawRecord *&rec )
+{
+    const CedarLogicalRecord *lr = 0 ;
+    return next( lr, rec ) ;
+}
+
+/** @brief the next record of the merged files, along with the logical
+ * record the Cedar library read for it
+ *
+ * @param lr set to the logical record, null if the Cedar library is not
+ * used
+ * @param rec set to the raw record, both good until the next call
+ * @return false once every record has been handed out
+ * @throws BESInternalError if a file can not be read
+ */
+bool
+CedarAggregate::next( const CedarLogicalRecord *&lr,
+                      const CedarRawRecord *&rec )
+{
+    // the record handed out last is still in use until now
+    if( _current >= 0 )
+    {
+	if( _sources[_current]->advance() )
+	    push( _current ) ;
+	_current = -1 ;
+    }
+    while( !_heap.empty() )
+    {
+	pop_heap( _heap.begin(), _heap.end(), Earlier( _sources ) ) ;
+	int s = _heap.back() ;
+	_heap.pop_back() ;
+	if( skip( s ) )
+	{
+	    if( _sources[s]->advance() )
+		push( s ) ;
+	    continue ;
+	}
+	Source &src = *_sources[s] ;
+	src.rec._ordinal = _ordinal++ ;
+	_current = s ;
+	lr = src.lr ;
+	rec = &src.rec ;
+	return true ;
+    }
+    return false ;
+}
+
+/** @brief true if filename is the archive index, which stands for the
+ * files of the archive selected by a constraint
+ */
+bool
+CedarAggregate::is_aggregate( const string &filename )
+{
+    const string &index = CedarArchive::get_index() ;
+    return !index.empty() && filename == index ;
+}
+
+static bool
+begins_before( const CedarArchiveFile *a, const CedarArchiveFile *b )
+{
+    if( a->begin != b->begin )
+	return a->begin < b->begin ;
+    return a->name < b->name ;
+}
+
+/** @brief the files to read for filename and the constraint
+ *
+ * A cedar file is read on its own. For the archive index these are the
+ * files of the archive with records in the period, record types and
+ * parameters of the constraint, earliest first, read from their copies
+ * in the file cache where there are any.
+ *
+ * @throws BESSyntaxUserError if the constraint has no date clause or
+ * selects too many files
+ */
+void
+CedarAggregate::get_files( const string &filename, const string &query,
+                           vector<string> &files )
+{
+    files.clear() ;
+    if( !is_aggregate( filename ) )
+    {
+	files.push_back( filename ) ;
+	return ;
+    }
+
+    CedarArchiveQuery q ;
+    string error ;
+    if( !q.parse( query, error ) )
+	throw BESSyntaxUserError( error, __FILE__, __LINE__ ) ;
+    if( !q.dated )
+    {
+	string err = "Reading records from the archive requires a date "
+		     "constraint" ;
+	throw BESSyntaxUserError( err, __FILE__, __LINE__ ) ;
+    }
+
+    vector<const CedarArchiveFile *> found ;
+    CedarArchive::TheArchive()->find( q, found ) ;
+    if( found.size() > get_max_files() )
+    {
+	ostringstream err ;
+	err << "The constraint selects " << found.size() << " files of the "
+	    << "archive, no more than " << get_max_files() << " can be read "
+	    << "together. Narrow the date constraint" ;
+	throw BESSyntaxUserError( err.str(), __FILE__, __LINE__ ) ;
+    }
+    sort( found.begin(), found.end(), begins_before ) ;
+    for( size_t i = 0; i < found.size(); i++ )
+	files.push_back( CedarFileCache::get_file( found[i]->path ) ) ;
+    BESDEBUG( "cedar", "CedarAggregate::get_files - " << files.size()
+		       << " files for " << query << endl ) ;
+}
+
+/** @brief files that can be read together, from Cedar.Archive.MaxFiles
+ */
+unsigned long
+CedarAggregate::get_max_files()
+{
+    if( !_configured )
+    {
+	_configured = true ;
+	bool found = false ;
+	string value ;
+	TheBESKeys::TheKeys()->get_value( "Cedar.Archive.MaxFiles", value,
+					  found ) ;
+	if( found && !value.empty() )
+	    _max_files = strtoul( value.c_str(), 0, 10 ) ;
+    }
+    return _max_files ;
+}
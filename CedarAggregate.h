@@ -0,0 +1,99 @@
+// CedarAggregate.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarAggregate_h
+#define I_CedarAggregate_h 1
+
+#include <string>
+#include <vector>
+#include <utility>
+
+using std::string ;
+using std::vector ;
+using std::pair ;
+
+#include "CedarRawFile.h"
+
+class CedarFile ;
+class CedarLogicalRecord ;
+
+/** @brief the records of several cedar files merged into one file, in
+ * time order
+ *
+ * Every file is kept open and the record with the earliest start is
+ * handed out next, so the records of each file stay in file order and a
+ * single file comes out exactly as it is. Only the header and catalog
+ * records of the first file are handed out. A data record with the same
+ * start and the same bytes as one already handed out from another file,
+ * as where the periods of two files overlap, is dropped.
+ *
+ * Records handed out are numbered in the order they are handed out, in
+ * place of their position in their own file, and the same files always
+ * merge the same way, so a record can be found again by its ordinal.
+ *
+ * When the Cedar library is used a CedarFile is walked in step with each
+ * file and next returns the logical record along with the raw record.
+ */
+class CedarAggregate
+{
+private:
+    class Source ;
+    class Earlier ;
+
+    vector<Source *>		_sources ;
+    vector<int>			_heap ;
+    int				_current ;
+    unsigned long		_ordinal ;
+    unsigned long		_duplicates ;
+    long long			_stamp ;
+    vector< pair< int, vector<char> > > _seen ;
+
+    static unsigned long	_max_files ;
+    static bool			_configured ;
+
+    void			push( int s ) ;
+    bool			skip( int s ) ;
+public:
+    				CedarAggregate( const vector<string> &files,
+						bool library ) ;
+    virtual			~CedarAggregate() ;
+
+    virtual bool		next( const CedarRawRecord *&rec ) ;
+    virtual bool		next( const CedarLogicalRecord *&lr,
+				      const CedarRawRecord *&rec ) ;
+
+    /** @brief data records dropped as copies of one from another file */
+    unsigned long		get_duplicates() const { return _duplicates ; }
+
+    static bool			is_aggregate( const string &filename ) ;
+    static void			get_files( const string &filename,
+					   const string &query,
+					   vector<string> &files ) ;
+    static unsigned long	get_max_files() ;
+} ;
+
+#endif // I_CedarAggregate_h
@@ -0,0 +1,735 @@
+// CedarArchive.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+#include <set>
+
+using std::ifstream ;
+using std::ofstream ;
+using std::ostringstream ;
+using std::endl ;
+using std::set ;
+using std::binary_search ;
+
+#include "CedarArchive.h"
+#include "CedarRawFile.h"
+#include "TheBESKeys.h"
+#include "BESInternalError.h"
+#include "BESError.h"
+#include "BESDebug.h"
+
+#define CEDAR_ARCHIVE_HEADER "# cedar archive index"
+
+CedarArchive *CedarArchive::_the_archive = 0 ;
+string CedarArchive::_index ;
+bool CedarArchive::_configured = false ;
+time_t CedarArchive::_loaded = 0 ;
+long long CedarArchive::_loaded_ino = 0 ;
+
+// the filter is kept apart for kindats and parameters
+#define CEDAR_FILTER_KINDAT 0x4b000000
+#define CEDAR_FILTER_PARAMETER 0x50000000
+
+/** @brief the three bits of the filter standing for value
+ */
+static void
+filter_bits( unsigned int kind, int value, unsigned int bits[3] )
+{
+    unsigned int h = ( (unsigned int)value ^ kind ) * 2654435761U ;
+    h ^= h >> 15 ;
+    h *= 2246822519U ;
+    h ^= h >> 13 ;
+    bits[0] = h % CEDAR_ARCHIVE_FILTER_BITS ;
+    bits[1] = ( h >> 9 ) % CEDAR_ARCHIVE_FILTER_BITS ;
+    bits[2] = ( h >> 18 ) % CEDAR_ARCHIVE_FILTER_BITS ;
+}
+
+static void
+filter_add( unsigned int *filter, unsigned int kind, int value )
+{
+    unsigned int bits[3] ;
+    filter_bits( kind, value, bits ) ;
+    for( int b = 0; b < 3; b++ )
+	filter[bits[b] / 32] |= 1U << ( bits[b] % 32 ) ;
+}
+
+static bool
+filter_test( const unsigned int *filter, unsigned int kind, int value )
+{
+    unsigned int bits[3] ;
+    filter_bits( kind, value, bits ) ;
+    for( int b = 0; b < 3; b++ )
+	if( !( filter[bits[b] / 32] & ( 1U << ( bits[b] % 32 ) ) ) )
+	    return false ;
+    return true ;
+}
+
+/** @brief set the filter from the record types and parameters
+ */
+void
+CedarArchiveFile::build_filter()
+{
+    for( int w = 0; w < CEDAR_ARCHIVE_FILTER_WORDS; w++ )
+	filter[w] = 0 ;
+    for( size_t i = 0; i < record_types.size(); i++ )
+	filter_add( filter, CEDAR_FILTER_KINDAT, record_types[i].second ) ;
+    for( size_t i = 0; i < parameters.size(); i++ )
+	filter_add( filter, CEDAR_FILTER_PARAMETER, parameters[i] ) ;
+}
+
+/** @brief false if the file has no records of kindat, true if it may
+ */
+bool
+CedarArchiveFile::may_have_kindat( int kindat ) const
+{
+    return filter_test( filter, CEDAR_FILTER_KINDAT, kindat ) ;
+}
+
+/** @brief false if the file does not hold parameter code, true if it may
+ */
+bool
+CedarArchiveFile::may_have_parameter( int code ) const
+{
+    return filter_test( filter, CEDAR_FILTER_PARAMETER, code ) ;
+}
+
+/** @brief the filter as hex digits, as written in the index
+ */
+string
+CedarArchiveFile::get_filter() const
+{
+    string hex ;
+    char buf[16] ;
+    for( int w = 0; w < CEDAR_ARCHIVE_FILTER_WORDS; w++ )
+    {
+	snprintf( buf, sizeof buf, "%08x", filter[w] ) ;
+	hex += buf ;
+    }
+    return hex ;
+}
+
+/** @brief set the filter from hex digits written by get_filter
+ *
+ * @return false if hex is not a filter
+ */
+bool
+CedarArchiveFile::set_filter( const string &hex )
+{
+    if( hex.length() != CEDAR_ARCHIVE_FILTER_WORDS * 8 )
+	return false ;
+    for( int w = 0; w < CEDAR_ARCHIVE_FILTER_WORDS; w++ )
+    {
+	string word = hex.substr( w * 8, 8 ) ;
+	char *end = 0 ;
+	filter[w] = (unsigned int)strtoul( word.c_str(), &end, 16 ) ;
+	if( *end != '\0' )
+	    return false ;
+    }
+    return true ;
+}
+
+bool
+CedarArchiveFile::has_kinst( int kinst ) const
+{
+    for( size_t i = 0; i < record_types.size(); i++ )
+	if( record_types[i].first == kinst )
+	    return true ;
+    return false ;
+}
+
+bool
+CedarArchiveFile::has_kindat( int kindat ) const
+{
+    for( size_t i = 0; i < record_types.size(); i++ )
+	if( record_types[i].second == kindat )
+	    return true ;
+    return false ;
+}
+
+bool
+CedarArchiveFile::has_record_type( int kinst, int kindat ) const
+{
+    return binary_search( record_types.begin(), record_types.end(),
+			  pair<int,int>( kinst, kindat ) ) ;
+}
+
+bool
+CedarArchiveFile::has_parameter( int code ) const
+{
+    return binary_search( parameters.begin(), parameters.end(), code ) ;
+}
+
+/** @brief a time from the prologue words of a record, or the arguments of
+ * date(...), as yyyymmddhhmmss
+ *
+ * @param cs seconds in hundredths, as in IBCST
+ */
+long long
+CedarArchiveFile::get_stamp( int year, int mmdd, int hhmm, int cs )
+{
+    return (long long)year * 10000000000LL + (long long)mmdd * 1000000LL
+	   + (long long)hhmm * 100LL + cs / 100 ;
+}
+
+static string
+trim( const string &s )
+{
+    string::size_type b = s.find_first_not_of( " \t\r\n" ) ;
+    if( b == string::npos )
+	return "" ;
+    string::size_type e = s.find_last_not_of( " \t\r\n" ) ;
+    return s.substr( b, e - b + 1 ) ;
+}
+
+static bool
+to_int( const string &s, int &value )
+{
+    string t = trim( s ) ;
+    if( t.empty() )
+	return false ;
+    char *end = 0 ;
+    long l = strtol( t.c_str(), &end, 10 ) ;
+    if( *end != '\0' )
+	return false ;
+    value = (int)l ;
+    return true ;
+}
+
+/** @brief parse the clauses of constraint
+ *
+ * @return false, with error set, if a clause is not understood
+ */
+bool
+CedarArchiveQuery::parse( const string &constraint, string &error )
+{
+    // clauses are separated by ; or & outside of parentheses
+    vector<string> clauses ;
+    string clause ;
+    int depth = 0 ;
+    for( string::size_type i = 0; i < constraint.length(); i++ )
+    {
+	char c = constraint[i] ;
+	if( c == '(' ) depth++ ;
+	if( c == ')' ) depth-- ;
+	if( depth == 0 && ( c == ';' || c == '&' ) )
+	{
+	    clauses.push_back( clause ) ;
+	    clause = "" ;
+	    continue ;
+	}
+	clause += c ;
+    }
+    clauses.push_back( clause ) ;
+
+    for( size_t c = 0; c < clauses.size(); c++ )
+    {
+	string cl = trim( clauses[c] ) ;
+	if( cl.empty() )
+	    continue ;
+	string::size_type open = cl.find( '(' ) ;
+	if( open == string::npos || cl[cl.length()-1] != ')' )
+	{
+	    error = "Malformed archive query clause " + cl ;
+	    return false ;
+	}
+	string name = trim( cl.substr( 0, open ) ) ;
+	string inside = cl.substr( open + 1, cl.length() - open - 2 ) ;
+	vector<string> args ;
+	if( !trim( inside ).empty() )
+	{
+	    string::size_type start = 0 ;
+	    string::size_type comma = 0 ;
+	    while( ( comma = inside.find( ',', start ) ) != string::npos )
+	    {
+		args.push_back( inside.substr( start, comma - start ) ) ;
+		start = comma + 1 ;
+	    }
+	    args.push_back( inside.substr( start ) ) ;
+	}
+
+	if( name == "date" )
+	{
+	    int d[8] ;
+	    bool good = ( args.size() == 8 ) ;
+	    for( size_t a = 0; good && a < 8; a++ )
+		good = to_int( args[a], d[a] ) ;
+	    if( !good )
+	    {
+		error = "date takes eight numbers, the year, month and day, "
+			"hour and minute, and centiseconds of the start and "
+			"of the end: " + cl ;
+		return false ;
+	    }
+	    dated = true ;
+	    begin = CedarArchiveFile::get_stamp( d[0], d[1], d[2], d[3] ) ;
+	    end = CedarArchiveFile::get_stamp( d[4], d[5], d[6], d[7] ) ;
+	}
+	else if( name == "record_type" )
+	{
+	    for( size_t a = 0; a < args.size(); a++ )
+	    {
+		string::size_type slash = args[a].find( '/' ) ;
+		int kinst = 0 ;
+		int kindat = 0 ;
+		if( slash == string::npos
+		    || !to_int( args[a].substr( 0, slash ), kinst )
+		    || !to_int( args[a].substr( slash + 1 ), kindat ) )
+		{
+		    error = "record_type takes kinst/kindat pairs: " + cl ;
+		    return false ;
+		}
+		record_types.push_back( pair<int,int>( kinst, kindat ) ) ;
+	    }
+	}
+	else if( name == "kinst" || name == "kindat" || name == "parameters" )
+	{
+	    vector<int> &values = ( name == "kinst" ) ? kinsts
+				  : ( name == "kindat" ) ? kindats
+				  : parameters ;
+	    for( size_t a = 0; a < args.size(); a++ )
+	    {
+		int value = 0 ;
+		if( !to_int( args[a], value ) )
+		{
+		    error = name + " takes numbers: " + cl ;
+		    return false ;
+		}
+		values.push_back( value ) ;
+	    }
+	}
+	else
+	{
+	    error = "Unknown archive query clause " + name ;
+	    return false ;
+	}
+    }
+    return true ;
+}
+
+/** @brief true if file satisfies every clause of the query
+ */
+bool
+CedarArchiveQuery::matches( const CedarArchiveFile &file ) const
+{
+    if( dated && ( file.record_types.empty()
+		   || file.begin > end || file.end < begin ) )
+    {
+	return false ;
+    }
+
+    size_t i = 0 ;
+    bool found = record_types.empty() ;
+    for( i = 0; !found && i < record_types.size(); i++ )
+	found = file.may_have_kindat( record_types[i].second )
+		&& file.has_record_type( record_types[i].first,
+					 record_types[i].second ) ;
+    if( !found )
+	return false ;
+
+    found = kinsts.empty() ;
+    for( i = 0; !found && i < kinsts.size(); i++ )
+	found = file.has_kinst( kinsts[i] ) ;
+    if( !found )
+	return false ;
+
+    // the filter passes over most files without the kindat or parameter
+    found = kindats.empty() ;
+    for( i = 0; !found && i < kindats.size(); i++ )
+	found = file.may_have_kindat( kindats[i] )
+		&& file.has_kindat( kindats[i] ) ;
+    if( !found )
+	return false ;
+
+    found = parameters.empty() ;
+    for( i = 0; !found && i < parameters.size(); i++ )
+	found = file.may_have_parameter( parameters[i] )
+		&& file.has_parameter( parameters[i] ) ;
+    return found ;
+}
+
+/** @brief summarize the data records of the cedar file at path
+ *
+ * Only the raw records are read, the Cedar library is not needed.
+ *
+ * @return false, with error set, if the file can not be read
+ */
+bool
+CedarArchive::read_file( const string &path, CedarArchiveFile &file,
+			 string &error )
+{
+    struct stat st ;
+    if( stat( path.c_str(), &st ) != 0 )
+    {
+	error = "Failed to find " + path + ": " + strerror( errno ) ;
+	return false ;
+    }
+    file.path = path ;
+    file.mtime = st.st_mtime ;
+    file.size = st.st_size ;
+    file.begin = 0 ;
+    file.end = 0 ;
+
+    set< pair<int,int> > types ;
+    set<int> codes ;
+    try
+    {
+	CedarRawFile raw( path ) ;
+	CedarRawRecord rec ;
+	bool first = true ;
+	while( raw.next_record( rec ) )
+	{
+	    if( rec.get_type() != 1 || !rec.is_valid_data() )
+		continue ;
+	    long long b = CedarArchiveFile::get_stamp(
+		rec.get_word( CEDAR_RAW_IBYRT ), rec.get_word( CEDAR_RAW_IBDTT ),
+		rec.get_word( CEDAR_RAW_IBHMT ), rec.get_word( CEDAR_RAW_IBCST ) ) ;
+	    long long e = CedarArchiveFile::get_stamp(
+		rec.get_word( CEDAR_RAW_IEYRT ), rec.get_word( CEDAR_RAW_IEDTT ),
+		rec.get_word( CEDAR_RAW_IEHMT ), rec.get_word( CEDAR_RAW_IECST ) ) ;
+	    if( first || b < file.begin ) file.begin = b ;
+	    if( first || e > file.end ) file.end = e ;
+	    first = false ;
+	    types.insert( pair<int,int>( rec.get_kinst(), rec.get_kindat() ) ) ;
+	    int j = 0 ;
+	    for( j = 0; j < rec.get_jpar(); j++ )
+		codes.insert( rec.get_jpar_code( j ) ) ;
+	    for( j = 0; j < rec.get_mpar(); j++ )
+		codes.insert( rec.get_mpar_code( j ) ) ;
+	}
+    }
+    catch( BESError &e )
+    {
+	error = e.get_message() ;
+	return false ;
+    }
+    file.record_types.assign( types.begin(), types.end() ) ;
+    file.parameters.assign( codes.begin(), codes.end() ) ;
+    file.build_filter() ;
+    return true ;
+}
+
+static string
+join_record_types( const vector< pair<int,int> > &types )
+{
+    if( types.empty() )
+	return "-" ;
+    ostringstream strm ;
+    for( size_t i = 0; i < types.size(); i++ )
+    {
+	if( i ) strm << "," ;
+	strm << types[i].first << "/" << types[i].second ;
+    }
+    return strm.str() ;
+}
+
+static string
+join_codes( const vector<int> &codes )
+{
+    if( codes.empty() )
+	return "-" ;
+    ostringstream strm ;
+    for( size_t i = 0; i < codes.size(); i++ )
+    {
+	if( i ) strm << "," ;
+	strm << codes[i] ;
+    }
+    return strm.str() ;
+}
+
+static vector<string>
+split( const string &s, char sep )
+{
+    vector<string> parts ;
+    string::size_type start = 0 ;
+    string::size_type pos = 0 ;
+    while( ( pos = s.find( sep, start ) ) != string::npos )
+    {
+	parts.push_back( s.substr( start, pos - start ) ) ;
+	start = pos + 1 ;
+    }
+    parts.push_back( s.substr( start ) ) ;
+    return parts ;
+}
+
+/** @brief read the index written by save
+ *
+ * @return false, with error set, if the index can not be read
+ */
+bool
+CedarArchive::load( const string &index, string &error )
+{
+    ifstream strm( index.c_str() ) ;
+    if( !strm )
+    {
+	error = "Failed to open the archive index " + index ;
+	return false ;
+    }
+    _files.clear() ;
+    string line ;
+    unsigned long lineno = 0 ;
+    while( getline( strm, line ) )
+    {
+	lineno++ ;
+	if( line.empty() || line[0] == '#' )
+	    continue ;
+	vector<string> fields = split( line, '\t' ) ;
+	CedarArchiveFile file ;
+	// indexes written before the filter was kept have no filter field
+	bool good = ( fields.size() == 8 || fields.size() == 9 ) ;
+	if( good )
+	{
+	    file.name = fields[0] ;
+	    file.path = fields[1] ;
+	    file.mtime = strtoll( fields[2].c_str(), 0, 10 ) ;
+	    file.size = strtoll( fields[3].c_str(), 0, 10 ) ;
+	    file.begin = strtoll( fields[4].c_str(), 0, 10 ) ;
+	    file.end = strtoll( fields[5].c_str(), 0, 10 ) ;
+	}
+	if( good && fields[6] != "-" )
+	{
+	    vector<string> types = split( fields[6], ',' ) ;
+	    for( size_t t = 0; good && t < types.size(); t++ )
+	    {
+		vector<string> kk = split( types[t], '/' ) ;
+		pair<int,int> type ;
+		good = ( kk.size() == 2 && to_int( kk[0], type.first )
+			 && to_int( kk[1], type.second ) ) ;
+		file.record_types.push_back( type ) ;
+	    }
+	}
+	if( good && fields[7] != "-" )
+	{
+	    vector<string> codes = split( fields[7], ',' ) ;
+	    for( size_t c = 0; good && c < codes.size(); c++ )
+	    {
+		int code = 0 ;
+		good = to_int( codes[c], code ) ;
+		file.parameters.push_back( code ) ;
+	    }
+	}
+	if( good && fields.size() == 9 )
+	    good = file.set_filter( fields[8] ) ;
+	else if( good )
+	    file.build_filter() ;
+	if( !good )
+	{
+	    ostringstream err ;
+	    err << "Malformed line " << lineno << " in the archive index "
+		<< index ;
+	    error = err.str() ;
+	    return false ;
+	}
+	_files[file.path] = file ;
+    }
+    return true ;
+}
+
+/** @brief write the index, replacing any index already there in one step
+ *
+ * @return false, with error set, if the index can not be written
+ */
+bool
+CedarArchive::save( const string &index, string &error ) const
+{
+    ostringstream tmp ;
+    tmp << index << "." << getpid() ;
+    {
+	ofstream strm( tmp.str().c_str() ) ;
+	if( !strm )
+	{
+	    error = "Failed to create " + tmp.str() ;
+	    return false ;
+	}
+	strm << CEDAR_ARCHIVE_HEADER << "\n" ;
+	strm << "# name\tpath\tmtime\tsize\tbegin\tend\trecord types\tparameters\tfilter\n" ;
+	map<string,CedarArchiveFile>::const_iterator i = _files.begin() ;
+	for( ; i != _files.end(); i++ )
+	{
+	    const CedarArchiveFile &f = i->second ;
+	    strm << f.name << "\t" << f.path << "\t" << f.mtime << "\t"
+		 << f.size << "\t" << f.begin << "\t" << f.end << "\t"
+		 << join_record_types( f.record_types ) << "\t"
+		 << join_codes( f.parameters ) << "\t"
+		 << f.get_filter() << "\n" ;
+	}
+	strm.close() ;
+	if( !strm )
+	{
+	    error = "Failed to write " + tmp.str() ;
+	    unlink( tmp.str().c_str() ) ;
+	    return false ;
+	}
+    }
+    if( rename( tmp.str().c_str(), index.c_str() ) != 0 )
+    {
+	error = "Failed to replace the archive index " + index + ": "
+		+ strerror( errno ) ;
+	unlink( tmp.str().c_str() ) ;
+	return false ;
+    }
+    return true ;
+}
+
+/** @brief add the file at path to the index, reading it only if it is
+ * not indexed or has changed since it was
+ *
+ * @param name the symbolic name of the file, its container name
+ * @param changed set to true if the file was read
+ * @return false, with error set, if the file can not be read, the file
+ * is then left out of the index
+ */
+bool
+CedarArchive::update( const string &name, const string &path,
+		      bool &changed, string &error )
+{
+    changed = false ;
+    struct stat st ;
+    map<string,CedarArchiveFile>::iterator i = _files.find( path ) ;
+    if( i != _files.end() && stat( path.c_str(), &st ) == 0
+	&& (long long)st.st_mtime == i->second.mtime
+	&& (long long)st.st_size == i->second.size )
+    {
+	i->second.name = name ;
+	return true ;
+    }
+
+    changed = true ;
+    CedarArchiveFile file ;
+    if( !read_file( path, file, error ) )
+    {
+	_files.erase( path ) ;
+	return false ;
+    }
+    file.name = name ;
+    _files[path] = file ;
+    return true ;
+}
+
+/** @brief drop the files that are not in paths, those no longer found in
+ * the archive
+ */
+void
+CedarArchive::retain( const vector<string> &paths )
+{
+    set<string> keep( paths.begin(), paths.end() ) ;
+    map<string,CedarArchiveFile>::iterator i = _files.begin() ;
+    while( i != _files.end() )
+    {
+	if( keep.find( i->first ) == keep.end() )
+	    _files.erase( i++ ) ;
+	else
+	    i++ ;
+    }
+}
+
+/** @brief the files satisfying query, in order of path
+ */
+void
+CedarArchive::find( const CedarArchiveQuery &query,
+		    vector<const CedarArchiveFile *> &found ) const
+{
+    map<string,CedarArchiveFile>::const_iterator i = _files.begin() ;
+    for( ; i != _files.end(); i++ )
+    {
+	if( query.matches( i->second ) )
+	    found.push_back( &(i->second) ) ;
+    }
+}
+
+/** @brief the index named by Cedar.Archive.Index, empty if there is none
+ */
+const string &
+CedarArchive::get_index()
+{
+    if( !_configured )
+    {
+	_configured = true ;
+	bool found = false ;
+	TheBESKeys::TheKeys()->get_value( "Cedar.Archive.Index", _index,
+					  found ) ;
+	if( !found )
+	    _index = "" ;
+    }
+    return _index ;
+}
+
+/** @brief the archive index of the server, loaded again if it has been
+ * rewritten since it was last loaded
+ *
+ * @return null if there is no Cedar.Archive.Index
+ * @throws BESInternalError if the index can not be read
+ */
+CedarArchive *
+CedarArchive::TheArchive()
+{
+    const string &index = get_index() ;
+    if( index.empty() )
+	return 0 ;
+
+    struct stat st ;
+    if( stat( index.c_str(), &st ) != 0 )
+    {
+	string err = "Failed to find the archive index " + index + ": "
+		     + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    // the index is replaced rather than written over, a new inode
+    if( _the_archive && st.st_mtime == _loaded
+	&& (long long)st.st_ino == _loaded_ino )
+    {
+	return _the_archive ;
+    }
+
+    CedarArchive *archive = new CedarArchive ;
+    string error ;
+    if( !archive->load( index, error ) )
+    {
+	delete archive ;
+	throw BESInternalError( error, __FILE__, __LINE__ ) ;
+    }
+    BESDEBUG( "cedar", "CedarArchive::TheArchive - loaded " << index
+		       << " with " << archive->get_files().size()
+		       << " files" << endl ) ;
+    if( _the_archive )
+	delete _the_archive ;
+    _the_archive = archive ;
+    _loaded = st.st_mtime ;
+    _loaded_ino = st.st_ino ;
+    return _the_archive ;
+}
+
@@ -0,0 +1,168 @@
+// CedarArchive.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarArchive_h
+#define I_CedarArchive_h 1
+
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::pair ;
+
+// bits of the filter of the parameters and kindats of a file
+#define CEDAR_ARCHIVE_FILTER_BITS 512
+#define CEDAR_ARCHIVE_FILTER_WORDS ( CEDAR_ARCHIVE_FILTER_BITS / 32 )
+
+/** @brief what the archive index knows about one cedar file
+ *
+ * The span runs from the earliest start to the latest end of the data
+ * records, as yyyymmddhhmmss. Record types are the KINST/KINDAT pairs of
+ * the data records and parameters the JPAR and MPAR codes, both sorted.
+ *
+ * The filter is a Bloom filter of the parameter codes and kindats. A code
+ * or kindat not in it is not in the file, so most files without the
+ * parameters or kindats of a query are passed over with a few bit tests
+ * rather than a search of their lists.
+ */
+class CedarArchiveFile
+{
+public:
+    string			name ;
+    string			path ;
+    long long			mtime ;
+    long long			size ;
+    long long			begin ;
+    long long			end ;
+    vector< pair<int,int> >	record_types ;
+    vector<int>			parameters ;
+    unsigned int		filter[CEDAR_ARCHIVE_FILTER_WORDS] ;
+
+    				CedarArchiveFile()
+				    : mtime( 0 ), size( 0 ),
+				      begin( 0 ), end( 0 )
+				{
+				    for( int w = 0; w < CEDAR_ARCHIVE_FILTER_WORDS; w++ )
+					filter[w] = 0 ;
+				}
+
+    void			build_filter() ;
+    bool			may_have_kindat( int kindat ) const ;
+    bool			may_have_parameter( int code ) const ;
+    string			get_filter() const ;
+    bool			set_filter( const string &hex ) ;
+
+    bool			has_kinst( int kinst ) const ;
+    bool			has_kindat( int kindat ) const ;
+    bool			has_record_type( int kinst, int kindat ) const ;
+    bool			has_parameter( int code ) const ;
+
+    static long long		get_stamp( int year, int mmdd, int hhmm,
+					   int cs ) ;
+} ;
+
+/** @brief what to look for in the archive index
+ *
+ * Parsed from a constraint made of the clauses date(...), record_type(...)
+ * and parameters(...), as understood by the products, along with
+ * kinst(...) and kindat(...). A file is found when it satisfies every
+ * clause, and one of the values of each clause.
+ */
+class CedarArchiveQuery
+{
+public:
+    bool			dated ;
+    long long			begin ;
+    long long			end ;
+    vector< pair<int,int> >	record_types ;
+    vector<int>			kinsts ;
+    vector<int>			kindats ;
+    vector<int>			parameters ;
+
+    				CedarArchiveQuery()
+				    : dated( false ), begin( 0 ), end( 0 ) {}
+
+    virtual bool		parse( const string &constraint,
+				       string &error ) ;
+    virtual bool		matches( const CedarArchiveFile &file ) const ;
+} ;
+
+/** @brief an index of the cedar files of the archive
+ *
+ * Built and kept up to date by the indexArchive tool, which only reads
+ * files that are new or have changed since the index was written. The
+ * server loads the index named by the Cedar.Archive.Index key and loads it
+ * again whenever it is rewritten, so looking for the files holding some
+ * instrument, record type or parameter over a period does not open any of
+ * them.
+ *
+ * The index is a text file, a line per file with tab separated fields.
+ */
+class CedarArchive
+{
+private:
+    map<string,CedarArchiveFile> _files ;
+
+    static CedarArchive *	_the_archive ;
+    static string		_index ;
+    static bool			_configured ;
+    static time_t		_loaded ;
+    static long long		_loaded_ino ;
+public:
+    				CedarArchive() {}
+    virtual			~CedarArchive() {}
+
+    virtual bool		load( const string &index, string &error ) ;
+    virtual bool		save( const string &index,
+				      string &error ) const ;
+
+    virtual bool		update( const string &name,
+					const string &path, bool &changed,
+					string &error ) ;
+    virtual void		retain( const vector<string> &paths ) ;
+    virtual void		find( const CedarArchiveQuery &query,
+				      vector<const CedarArchiveFile *> &found )
+				      const ;
+
+    /** @brief the files in the index, keyed by path */
+    const map<string,CedarArchiveFile> &get_files() const { return _files ; }
+
+    static bool			read_file( const string &path,
+					   CedarArchiveFile &file,
+					   string &error ) ;
+    static CedarArchive *	TheArchive() ;
+    static const string &	get_index() ;
+} ;
+
+#endif // I_CedarArchive_h
+
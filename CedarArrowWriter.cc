@@ -0,0 +1,506 @@
+// CedarArrowWriter.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarArrowWriter.h"
+#include "CedarRawOutput.h"
+#include "CedarRawFile.h"
+#include "BESInternalError.h"
+
+// Arrow metadata version 5 and the message header types used
+#define ARROW_METADATA_V5	4
+#define ARROW_SCHEMA		1
+#define ARROW_RECORD_BATCH	3
+
+// the Int member of the Arrow Type union
+#define ARROW_TYPE_INT		2
+
+#define ARROW_CONTINUATION	0xFFFFFFFFUL
+
+static void
+put_le( string &buf, unsigned long long v, int size )
+{
+    for( int i = 0; i < size; i++ )
+    {
+	buf += (char)( v & 0xFF ) ;
+	v >>= 8 ;
+    }
+}
+
+static void
+pad8( string &buf )
+{
+    while( buf.length() % 8 )
+	buf += '\0' ;
+}
+
+/** @brief the parts of a flatbuffer, tables, strings and vectors, built
+ * as a tree and encoded in one go
+ *
+ * Objects are laid out with each parent before its children, so every
+ * offset points forward as flatbuffers require. Each table is preceded by
+ * its own vtable.
+ */
+class ArrowFlatBuffer
+{
+public:
+    typedef enum { TABLE, STRING, TABLES, STRUCTS } Kind ;
+
+    typedef struct _fb_field
+    {
+	int id ;
+	int size ;
+	unsigned long long value ;
+	int child ;
+    } Field ;
+
+    typedef struct _fb_node
+    {
+	Kind kind ;
+	vector<Field> fields ;
+	string bytes ;
+	unsigned int count ;
+	vector<int> children ;
+    } Node ;
+private:
+    vector<Node>		_nodes ;
+    string			_buf ;
+
+    void			align( size_t n )
+				{
+				    while( _buf.length() % n )
+					_buf += '\0' ;
+				}
+    void			patch( size_t at, unsigned long v, int size )
+				{
+				    for( int i = 0; i < size; i++ )
+				    {
+					_buf[at+i] = (char)( v & 0xFF ) ;
+					v >>= 8 ;
+				    }
+				}
+    size_t			encode( int node ) ;
+public:
+    int				table()
+				{
+				    Node n ;
+				    n.kind = TABLE ;
+				    n.count = 0 ;
+				    _nodes.push_back( n ) ;
+				    return _nodes.size() - 1 ;
+				}
+    int				str( const string &s )
+				{
+				    int n = table() ;
+				    _nodes[n].kind = STRING ;
+				    _nodes[n].bytes = s ;
+				    return n ;
+				}
+    int				tables()
+				{
+				    int n = table() ;
+				    _nodes[n].kind = TABLES ;
+				    return n ;
+				}
+    int				structs( const string &bytes,
+					 unsigned int count )
+				{
+				    int n = table() ;
+				    _nodes[n].kind = STRUCTS ;
+				    _nodes[n].bytes = bytes ;
+				    _nodes[n].count = count ;
+				    return n ;
+				}
+    void			add( int node, int id, int size,
+				     unsigned long long value )
+				{
+				    Field f ;
+				    f.id = id ;
+				    f.size = size ;
+				    f.value = value ;
+				    f.child = -1 ;
+				    _nodes[node].fields.push_back( f ) ;
+				}
+    void			add_child( int node, int id, int child )
+				{
+				    Field f ;
+				    f.id = id ;
+				    f.size = 4 ;
+				    f.value = 0 ;
+				    f.child = child ;
+				    _nodes[node].fields.push_back( f ) ;
+				}
+    void			append( int node, int child )
+				{
+				    _nodes[node].children.push_back( child ) ;
+				}
+    string			finish( int root ) ;
+} ;
+
+/** @brief encode a node at the end of the buffer
+ *
+ * @return the position of the node, which is what offsets point at
+ */
+size_t
+ArrowFlatBuffer::encode( int node )
+{
+    Node &n = _nodes[node] ;
+    size_t pos = 0 ;
+    if( n.kind == STRING )
+    {
+	align( 4 ) ;
+	pos = _buf.length() ;
+	put_le( _buf, n.bytes.length(), 4 ) ;
+	_buf += n.bytes ;
+	_buf += '\0' ;
+	return pos ;
+    }
+    if( n.kind == STRUCTS )
+    {
+	// the structs, all 8 byte aligned, follow the length
+	align( 4 ) ;
+	if( _buf.length() % 8 == 0 )
+	    put_le( _buf, 0, 4 ) ;
+	pos = _buf.length() ;
+	put_le( _buf, n.count, 4 ) ;
+	_buf += n.bytes ;
+	return pos ;
+    }
+    if( n.kind == TABLES )
+    {
+	align( 4 ) ;
+	pos = _buf.length() ;
+	size_t count = n.children.size() ;
+	put_le( _buf, count, 4 ) ;
+	size_t elems = _buf.length() ;
+	_buf.append( count * 4, '\0' ) ;
+	vector<int> children = n.children ;
+	for( size_t i = 0; i < count; i++ )
+	{
+	    size_t child = encode( children[i] ) ;
+	    patch( elems + i * 4, child - ( elems + i * 4 ), 4 ) ;
+	}
+	return pos ;
+    }
+
+    // the vtable, then the table itself
+    vector<Field> fields = _nodes[node].fields ;
+    int nfields = 0 ;
+    for( size_t i = 0; i < fields.size(); i++ )
+    {
+	if( fields[i].id + 1 > nfields )
+	    nfields = fields[i].id + 1 ;
+    }
+    align( 2 ) ;
+    size_t vtable = _buf.length() ;
+    put_le( _buf, 4 + 2 * nfields, 2 ) ;
+    _buf.append( 2 + 2 * nfields, '\0' ) ;
+
+    align( 8 ) ;
+    pos = _buf.length() ;
+    put_le( _buf, pos - vtable, 4 ) ;
+    vector<size_t> at( fields.size() ) ;
+    // largest fields first keeps the padding down
+    for( int size = 8; size > 0; size /= 2 )
+    {
+	for( size_t i = 0; i < fields.size(); i++ )
+	{
+	    if( fields[i].size != size )
+		continue ;
+	    align( size ) ;
+	    at[i] = _buf.length() ;
+	    put_le( _buf, fields[i].value, size ) ;
+	    patch( vtable + 4 + 2 * fields[i].id, at[i] - pos, 2 ) ;
+	}
+    }
+    patch( vtable + 2, _buf.length() - pos, 2 ) ;
+
+    for( size_t i = 0; i < fields.size(); i++ )
+    {
+	if( fields[i].child >= 0 )
+	{
+	    size_t child = encode( fields[i].child ) ;
+	    patch( at[i], child - at[i], 4 ) ;
+	}
+    }
+    return pos ;
+}
+
+/** @brief encode the tree under root, padded to a multiple of 8 bytes
+ */
+string
+ArrowFlatBuffer::finish( int root )
+{
+    _buf.erase() ;
+    put_le( _buf, 0, 4 ) ;
+    size_t pos = encode( root ) ;
+    patch( 0, pos, 4 ) ;
+    pad8( _buf ) ;
+    return _buf ;
+}
+
+/** @brief a vector of KeyValue tables for key, value pairs
+ */
+static int
+key_values( ArrowFlatBuffer &fb, const vector<string> &metadata )
+{
+    int kvs = fb.tables() ;
+    for( size_t i = 0; i + 1 < metadata.size(); i += 2 )
+    {
+	int kv = fb.table() ;
+	fb.add_child( kv, 0, fb.str( metadata[i] ) ) ;
+	fb.add_child( kv, 1, fb.str( metadata[i+1] ) ) ;
+	fb.append( kvs, kv ) ;
+    }
+    return kvs ;
+}
+
+CedarArrowWriter::CedarArrowWriter( CedarRawOutput &out )
+    : _out( out ),
+      _rows( 0 ),
+      _total( 0 ),
+      _started( false )
+{
+}
+
+/** @brief add key/value metadata to the schema
+ */
+void
+CedarArrowWriter::add_metadata( const string &key, const string &value )
+{
+    _metadata.push_back( key ) ;
+    _metadata.push_back( value ) ;
+}
+
+/** @brief add a signed integer column
+ *
+ * @param name name of the column, must be unique
+ * @param bits 16 or 32
+ * @param nullable true if the cedar missing value should be null
+ * @return the index of the column, used to add metadata and set values
+ */
+int
+CedarArrowWriter::add_column( const string &name, int bits, bool nullable )
+{
+    if( _started )
+    {
+	throw BESInternalError( "arrow column added after the schema",
+				__FILE__, __LINE__ ) ;
+    }
+    ArrowColumn col ;
+    col.name = name ;
+    col.bits = bits ;
+    col.nullable = nullable ;
+    col.nulls = 0 ;
+    _columns.push_back( col ) ;
+    _row.push_back( CEDAR_RAW_MISSING ) ;
+    return _columns.size() - 1 ;
+}
+
+void
+CedarArrowWriter::add_metadata( int column, const string &key,
+                                const string &value )
+{
+    _columns[column].metadata.push_back( key ) ;
+    _columns[column].metadata.push_back( value ) ;
+}
+
+bool
+CedarArrowWriter::has_column( const string &name ) const
+{
+    vector<ArrowColumn>::const_iterator i = _columns.begin() ;
+    vector<ArrowColumn>::const_iterator e = _columns.end() ;
+    for( ; i != e; i++ )
+    {
+	if( (*i).name == name )
+	    return true ;
+    }
+    return false ;
+}
+
+/** @brief write one encapsulated message, the flatbuffer followed by the
+ * body
+ */
+void
+CedarArrowWriter::write_message( const string &header, const string &body )
+{
+    string msg ;
+    put_le( msg, ARROW_CONTINUATION, 4 ) ;
+    put_le( msg, header.length(), 4 ) ;
+    msg += header ;
+    _out.write( msg.data(), msg.length() ) ;
+    if( !body.empty() )
+	_out.write( body.data(), body.length() ) ;
+}
+
+/** @brief write the schema message
+ */
+void
+CedarArrowWriter::write_schema()
+{
+    _started = true ;
+
+    ArrowFlatBuffer fb ;
+    int schema = fb.table() ;
+    int fields = fb.tables() ;
+    for( size_t i = 0; i < _columns.size(); i++ )
+    {
+	const ArrowColumn &col = _columns[i] ;
+	int type = fb.table() ;
+	fb.add( type, 0, 4, col.bits ) ;
+	fb.add( type, 1, 1, 1 ) ;
+
+	int field = fb.table() ;
+	fb.add_child( field, 0, fb.str( col.name ) ) ;
+	fb.add( field, 1, 1, col.nullable ? 1 : 0 ) ;
+	fb.add( field, 2, 1, ARROW_TYPE_INT ) ;
+	fb.add_child( field, 3, type ) ;
+	fb.add_child( field, 5, fb.tables() ) ;
+	if( !col.metadata.empty() )
+	    fb.add_child( field, 6, key_values( fb, col.metadata ) ) ;
+	fb.append( fields, field ) ;
+    }
+    fb.add( schema, 0, 2, 0 ) ;
+    fb.add_child( schema, 1, fields ) ;
+    if( !_metadata.empty() )
+	fb.add_child( schema, 2, key_values( fb, _metadata ) ) ;
+
+    int message = fb.table() ;
+    fb.add( message, 0, 2, ARROW_METADATA_V5 ) ;
+    fb.add( message, 1, 1, ARROW_SCHEMA ) ;
+    fb.add_child( message, 2, schema ) ;
+    fb.add( message, 3, 8, 0 ) ;
+
+    write_message( fb.finish( message ), "" ) ;
+}
+
+/** @brief set every value of the row back to missing
+ */
+void
+CedarArrowWriter::clear_row()
+{
+    for( size_t i = 0; i < _row.size(); i++ )
+	_row[i] = CEDAR_RAW_MISSING ;
+}
+
+/** @brief add the row to the record batch
+ *
+ * The row is left as it is, so values shared by several rows need only be
+ * set once.
+ */
+void
+CedarArrowWriter::end_row()
+{
+    size_t byte = _rows / 8 ;
+    unsigned char bit = 1 << ( _rows % 8 ) ;
+    for( size_t i = 0; i < _columns.size(); i++ )
+    {
+	ArrowColumn &col = _columns[i] ;
+	int v = _row[i] ;
+	if( col.validity.length() <= byte )
+	    col.validity += '\0' ;
+	if( col.nullable && v == CEDAR_RAW_MISSING )
+	{
+	    col.nulls++ ;
+	    v = 0 ;
+	}
+	else
+	{
+	    col.validity[byte] = (char)( col.validity[byte] | bit ) ;
+	}
+	put_le( col.data, (unsigned int)v, col.bits / 8 ) ;
+    }
+    _rows++ ;
+}
+
+/** @brief write the rows collected so far as a record batch
+ */
+void
+CedarArrowWriter::flush()
+{
+    if( !_rows )
+	return ;
+
+    string nodes ;
+    string buffers ;
+    string body ;
+    for( size_t i = 0; i < _columns.size(); i++ )
+    {
+	ArrowColumn &col = _columns[i] ;
+	put_le( nodes, _rows, 8 ) ;
+	put_le( nodes, col.nulls, 8 ) ;
+
+	// without nulls the validity bitmap can be left out
+	put_le( buffers, body.length(), 8 ) ;
+	if( col.nulls )
+	{
+	    put_le( buffers, col.validity.length(), 8 ) ;
+	    body += col.validity ;
+	    pad8( body ) ;
+	}
+	else
+	{
+	    put_le( buffers, 0, 8 ) ;
+	}
+	put_le( buffers, body.length(), 8 ) ;
+	put_le( buffers, col.data.length(), 8 ) ;
+	body += col.data ;
+	pad8( body ) ;
+
+	col.data.erase() ;
+	col.validity.erase() ;
+	col.nulls = 0 ;
+    }
+
+    ArrowFlatBuffer fb ;
+    int batch = fb.table() ;
+    fb.add( batch, 0, 8, _rows ) ;
+    fb.add_child( batch, 1, fb.structs( nodes, _columns.size() ) ) ;
+    fb.add_child( batch, 2, fb.structs( buffers, 2 * _columns.size() ) ) ;
+
+    int message = fb.table() ;
+    fb.add( message, 0, 2, ARROW_METADATA_V5 ) ;
+    fb.add( message, 1, 1, ARROW_RECORD_BATCH ) ;
+    fb.add_child( message, 2, batch ) ;
+    fb.add( message, 3, 8, body.length() ) ;
+
+    write_message( fb.finish( message ), body ) ;
+    _total += _rows ;
+    _rows = 0 ;
+}
+
+/** @brief write any remaining rows and the end of stream marker
+ */
+void
+CedarArrowWriter::finish()
+{
+    flush() ;
+    string eos ;
+    put_le( eos, ARROW_CONTINUATION, 4 ) ;
+    put_le( eos, 0, 4 ) ;
+    _out.write( eos.data(), eos.length() ) ;
+}
+
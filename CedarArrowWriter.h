@@ -0,0 +1,103 @@
+// CedarArrowWriter.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarArrowWriter_h
+#define I_CedarArrowWriter_h 1
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+class CedarRawOutput ;
+
+/** @brief writes an Arrow IPC stream of integer columns, a record batch
+ * at a time
+ *
+ * The schema, integer columns of 16 or 32 bits with optional key/value
+ * metadata, is written first. Rows are then built a value at a time and
+ * collected, column by column, into a record batch that is written out
+ * when flush is called. A column added as nullable treats the cedar
+ * missing value as null.
+ *
+ * The flatbuffer messages are encoded here, there is no dependency on the
+ * Arrow libraries.
+ */
+class CedarArrowWriter
+{
+private:
+    typedef struct _arrow_column
+    {
+	string name ;
+	int bits ;
+	bool nullable ;
+	vector<string> metadata ;
+	string data ;
+	string validity ;
+	unsigned long nulls ;
+    } ArrowColumn ;
+
+    CedarRawOutput &		_out ;
+    vector<string>		_metadata ;
+    vector<ArrowColumn>		_columns ;
+    vector<int>			_row ;
+    unsigned long		_rows ;
+    unsigned long		_total ;
+    bool			_started ;
+
+    void			write_message( const string &header,
+					       const string &body ) ;
+public:
+    				CedarArrowWriter( CedarRawOutput &out ) ;
+    virtual			~CedarArrowWriter() {}
+
+    virtual void		add_metadata( const string &key,
+					      const string &value ) ;
+    virtual int			add_column( const string &name, int bits,
+					    bool nullable ) ;
+    virtual void		add_metadata( int column, const string &key,
+					      const string &value ) ;
+    virtual bool		has_column( const string &name ) const ;
+
+    virtual void		write_schema() ;
+    virtual void		clear_row() ;
+    virtual void		set_value( int column, int value )
+				{
+				    _row[column] = value ;
+				}
+    virtual void		end_row() ;
+    /** @brief rows collected for the next record batch */
+    unsigned long		get_batch_rows() const { return _rows ; }
+    /** @brief rows written out in record batches so far */
+    unsigned long		get_total_rows() const { return _total ; }
+    virtual void		flush() ;
+    virtual void		finish() ;
+} ;
+
+#endif // I_CedarArrowWriter_h
+
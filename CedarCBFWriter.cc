@@ -0,0 +1,210 @@
+// CedarCBFWriter.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <string.h>
+
+#include "CedarCBFWriter.h"
+#include "CedarRawOutput.h"
+#include "CedarRawFile.h"
+
+// largest physical record, in 16 bit words, written by the Cedar tools
+#define CBF_MAX_PHYS_WORDS 8042
+
+// 64 bit words in a Cray block
+#define CBF_BLOCK_WORDS 512
+
+// cray control word types
+#define COS_BCW 0x0
+#define COS_RCW 0x8
+#define COS_EOF 0xE
+#define COS_EOD 0xF
+
+CedarCBFWriter::CedarCBFWriter( CedarRawOutput &out )
+    : _out( out ),
+      _word( 0 ),
+      _last_cw( 0 ),
+      _block_num( 0 ),
+      _rec_block( 0 ),
+      _finished( false )
+{
+    _phys.reserve( CBF_MAX_PHYS_WORDS * 2 ) ;
+    new_block() ;
+}
+
+CedarCBFWriter::~CedarCBFWriter()
+{
+}
+
+/** @brief start a new block with its block control word
+ */
+void
+CedarCBFWriter::new_block()
+{
+    memset( _block, 0, sizeof _block ) ;
+    // the block number is held in the 24 bits above the forward index
+    unsigned long bn = _block_num & 0xFFFFFF ;
+    _block[3] = ( bn >> 23 ) & 0x01 ;
+    _block[4] = ( bn >> 15 ) & 0xFF ;
+    _block[5] = ( bn >> 7 ) & 0xFF ;
+    _block[6] = ( bn << 1 ) & 0xFE ;
+    _last_cw = 0 ;
+    _word = 1 ;
+}
+
+/** @brief point the last control word at the end of the block and send
+ * the block
+ */
+void
+CedarCBFWriter::write_block()
+{
+    unsigned int fwi = CBF_BLOCK_WORDS - _last_cw - 1 ;
+    unsigned char *cw = _block + _last_cw * 8 ;
+    cw[6] = ( cw[6] & 0xFE ) | ( ( fwi >> 8 ) & 0x01 ) ;
+    cw[7] = fwi & 0xFF ;
+    _out.write( (const char *)_block, sizeof _block ) ;
+    _block_num++ ;
+    new_block() ;
+}
+
+void
+CedarCBFWriter::put_word( const unsigned char *w )
+{
+    if( _word == CBF_BLOCK_WORDS )
+	write_block() ;
+    memcpy( _block + _word * 8, w, 8 ) ;
+    _word++ ;
+}
+
+/** @brief add a record, end of file or end of data control word
+ *
+ * The forward index of the previous control word is set to point at this
+ * one.
+ */
+void
+CedarCBFWriter::put_control( unsigned int type, unsigned long pfi,
+                             unsigned long pri )
+{
+    if( _word == CBF_BLOCK_WORDS )
+	write_block() ;
+    unsigned int fwi = _word - _last_cw - 1 ;
+    unsigned char *prev = _block + _last_cw * 8 ;
+    prev[6] = ( prev[6] & 0xFE ) | ( ( fwi >> 8 ) & 0x01 ) ;
+    prev[7] = fwi & 0xFF ;
+
+    unsigned char *cw = _block + _word * 8 ;
+    memset( cw, 0, 8 ) ;
+    cw[0] = ( type & 0x0F ) << 4 ;
+    pfi &= 0xFFFFF ;
+    pri &= 0x7FFF ;
+    cw[2] = ( pfi >> 16 ) & 0x0F ;
+    cw[3] = ( pfi >> 8 ) & 0xFF ;
+    cw[4] = pfi & 0xFF ;
+    cw[5] = ( pri >> 7 ) & 0xFF ;
+    cw[6] = ( pri << 1 ) & 0xFE ;
+    _last_cw = _word ;
+    _word++ ;
+}
+
+/** @brief finish the physical record being built, set its length and
+ * checksum words and write it out as one cray record
+ */
+void
+CedarCBFWriter::flush_physical()
+{
+    if( _phys.empty() )
+	return ;
+
+    // room for the checksum word
+    _phys.push_back( 0 ) ;
+    _phys.push_back( 0 ) ;
+    size_t nwords = _phys.size() / 2 ;
+    _phys[0] = ( nwords >> 8 ) & 0xFF ;
+    _phys[1] = nwords & 0xFF ;
+    unsigned short sum = CedarRawFile::checksum( &_phys[0], nwords - 1 ) ;
+    _phys[_phys.size()-2] = ( sum >> 8 ) & 0xFF ;
+    _phys[_phys.size()-1] = sum & 0xFF ;
+    while( _phys.size() % 8 )
+	_phys.push_back( 0 ) ;
+
+    for( size_t i = 0; i < _phys.size(); i += 8 )
+    {
+	if( i == 0 )
+	{
+	    if( _word == CBF_BLOCK_WORDS )
+		write_block() ;
+	    _rec_block = _block_num ;
+	}
+	put_word( (const unsigned char *)&_phys[i] ) ;
+    }
+    put_control( COS_RCW, _block_num, _block_num - _rec_block ) ;
+    _phys.clear() ;
+}
+
+void
+CedarCBFWriter::add_record( const CedarRawRecord &rec )
+{
+    add_record( rec.get_bytes(), rec.get_size() ) ;
+}
+
+/** @brief add the bytes of one logical record to the output
+ *
+ * @param buf the logical record, big endian 16 bit words starting with
+ * the LTOT
+ * @param len number of bytes in the record
+ */
+void
+CedarCBFWriter::add_record( const char *buf, size_t len )
+{
+    // length word, record, checksum word
+    if( !_phys.empty() && _phys.size() + len + 2 > CBF_MAX_PHYS_WORDS * 2 )
+    {
+	flush_physical() ;
+    }
+    if( _phys.empty() )
+    {
+	// place holder for the length word
+	_phys.push_back( 0 ) ;
+	_phys.push_back( 0 ) ;
+    }
+    _phys.insert( _phys.end(), buf, buf + len ) ;
+}
+
+/** @brief write the last physical record and the end of file and end of
+ * data control words, then pad out the last block
+ */
+void
+CedarCBFWriter::finish()
+{
+    if( _finished )
+	return ;
+    _finished = true ;
+    flush_physical() ;
+    put_control( COS_EOF, _block_num, 0 ) ;
+    put_control( COS_EOD, 0, 0 ) ;
+    _out.write( (const char *)_block, sizeof _block ) ;
+}
+
@@ -0,0 +1,75 @@
+// CedarCBFWriter.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarCBFWriter_h
+#define I_CedarCBFWriter_h 1
+
+#include <vector>
+
+using std::vector ;
+
+class CedarRawOutput ;
+class CedarRawRecord ;
+
+/** @brief writes logical records out as a cbf file
+ *
+ * Logical records are packed, unchanged, into physical records which are
+ * given their length and checksum words and written out in Cray blocked
+ * format, 4096 byte blocks with block, record, end of file and end of data
+ * control words. The result can be read by the Cedar library and by the
+ * existing cbf tools.
+ */
+class CedarCBFWriter
+{
+private:
+    CedarRawOutput &		_out ;
+    vector<char>		_phys ;
+    unsigned char		_block[4096] ;
+    unsigned int		_word ;
+    unsigned int		_last_cw ;
+    unsigned long		_block_num ;
+    unsigned long		_rec_block ;
+    bool			_finished ;
+
+    void			new_block() ;
+    void			write_block() ;
+    void			put_word( const unsigned char *w ) ;
+    void			put_control( unsigned int type,
+					     unsigned long pfi,
+					     unsigned long pri ) ;
+    void			flush_physical() ;
+public:
+    				CedarCBFWriter( CedarRawOutput &out ) ;
+    virtual			~CedarCBFWriter() ;
+
+    virtual void		add_record( const CedarRawRecord &rec ) ;
+    virtual void		add_record( const char *buf, size_t len ) ;
+    virtual void		finish() ;
+} ;
+
+#endif // I_CedarCBFWriter_h
+
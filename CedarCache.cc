@@ -0,0 +1,760 @@
+// CedarCache.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <utime.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <algorithm>
+
+using std::ofstream ;
+using std::ios ;
+using std::vector ;
+using std::sort ;
+using std::endl ;
+using std::cout ;
+
+#include "config_cedar.h"
+
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
+
+#include "CedarCache.h"
+#include "CedarCatalog.h"
+#include "BESInfo.h"
+#include "BESInternalError.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+// megabytes kept in the cache when Cedar.Cache.Size is not set
+#define CEDAR_CACHE_SIZE 500
+
+// bytes read from a cached product at a time when it can not be sent
+// with sendfile
+#define CEDAR_CACHE_CHUNK 65536
+
+// characters in a key, two 64 bit hashes in hex
+#define CEDAR_CACHE_KEY_LENGTH 32
+
+// microseconds to wait, at first and at most, for more of a product being
+// generated by another request
+#define CEDAR_CACHE_FOLLOW_PAUSE 1000
+#define CEDAR_CACHE_FOLLOW_MAX_PAUSE 64000
+
+CedarCache *CedarCache::_the_cache = 0 ;
+bool CedarCache::_configured = false ;
+
+CedarCache::CedarCache( const string &dir, unsigned long long size )
+    : _dir( dir ),
+      _size( size )
+{
+}
+
+string
+CedarCache::get_path( const string &key ) const
+{
+    return _dir + "/" + key ;
+}
+
+/** @brief wait for and take the lock on the products whose keys start
+ * like key
+ *
+ * @return the locked file, closing it releases the lock
+ * @throws BESInternalError if the lock file can not be locked
+ */
+int
+CedarCache::lock( const string &key ) const
+{
+    string path = _dir + "/lock." + key.substr( 0, 2 ) ;
+    int fd = ::open( path.c_str(), O_RDWR|O_CREAT, 0644 ) ;
+    if( fd < 0 )
+    {
+	string err = (string)"Failed to open the cache lock " + path + ": "
+		     + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    while( flock( fd, LOCK_EX ) != 0 )
+    {
+	if( errno == EINTR )
+	    continue ;
+	string err = (string)"Failed to lock the cache lock " + path + ": "
+		     + strerror( errno ) ;
+	::close( fd ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    return fd ;
+}
+
+/** @brief open the cached product, touching it as recently used
+ *
+ * @return the open product or -1 if it is not cached
+ */
+int
+CedarCache::open( const string &key ) const
+{
+    string path = get_path( key ) ;
+    int fd = ::open( path.c_str(), O_RDONLY ) ;
+    if( fd >= 0 )
+	utime( path.c_str(), 0 ) ;
+    return fd ;
+}
+
+/** @brief open the cached product, generating it first if it is not
+ * cached
+ *
+ * Only one request generates a product, others asking for it meanwhile
+ * wait for it to be cached.
+ *
+ * @param key the key of the product
+ * @param producer generates the product if it is not cached
+ * @param error set if the product can not be generated
+ * @return the open product or -1 if it can not be generated
+ * @throws BESInternalError if the cache can not be written or the request
+ * generating the product fails
+ */
+int
+CedarCache::get( const string &key, CedarCacheProducer &producer,
+                 string &error )
+{
+    bool partial = false ;
+    int fd = get( key, producer, error, partial ) ;
+    if( partial )
+    {
+	try
+	{
+	    wait( fd ) ;
+	}
+	catch( ... )
+	{
+	    ::close( fd ) ;
+	    throw ;
+	}
+    }
+    return fd ;
+}
+
+/** @brief open the cached product, generating it first if it is neither
+ * cached nor being generated
+ *
+ * Only one request generates a product. The product is generated into
+ * the key's .part file, locked until the product is finished, and a
+ * request asking for it meanwhile gets the .part file to follow as it
+ * grows. A .part file that is not locked was left by a request that
+ * died, it is removed and the product generated again.
+ *
+ * @param key the key of the product
+ * @param producer generates the product if it is not cached
+ * @param error set if the product can not be generated
+ * @param partial set if the product returned is still being generated by
+ * another request, it is to be sent with follow
+ * @return the open product or -1 if it can not be generated
+ * @throws BESInternalError if the cache can not be written
+ */
+int
+CedarCache::get( const string &key, CedarCacheProducer &producer,
+                 string &error, bool &partial )
+{
+    partial = false ;
+    int fd = open( key ) ;
+    if( fd >= 0 )
+    {
+	BESDEBUG( "cedar", "CedarCache::get - " << key << " cached" << endl ) ;
+	return fd ;
+    }
+
+    // held only while the product is looked for and the .part file
+    // created, not while it is generated
+    int lk = lock( key ) ;
+    fd = open( key ) ;
+    if( fd >= 0 )
+    {
+	BESDEBUG( "cedar", "CedarCache::get - " << key
+			   << " cached by another request" << endl ) ;
+	::close( lk ) ;
+	return fd ;
+    }
+
+    string path = get_path( key ) ;
+    string part = path + ".part" ;
+    fd = ::open( part.c_str(), O_RDONLY ) ;
+    if( fd >= 0 )
+    {
+	if( !is_finished( fd ) )
+	{
+	    BESDEBUG( "cedar", "CedarCache::get - " << key
+			       << " being generated by another request"
+			       << endl ) ;
+	    ::close( lk ) ;
+	    partial = true ;
+	    return fd ;
+	}
+	if( is_complete( fd ) )
+	{
+	    // finished between looking for the product and the .part file
+	    ::close( lk ) ;
+	    return fd ;
+	}
+	struct stat pst ;
+	struct stat fst ;
+	if( stat( part.c_str(), &pst ) == 0 && fstat( fd, &fst ) == 0
+	    && pst.st_ino == fst.st_ino )
+	{
+	    BESDEBUG( "cedar", "CedarCache::get - removing " << part
+			       << " left by a failed request" << endl ) ;
+	    unlink( part.c_str() ) ;
+	}
+	::close( fd ) ;
+	fd = -1 ;
+    }
+
+    string tmpl = path + ".XXXXXX" ;
+    vector<char> tmp( tmpl.begin(), tmpl.end() ) ;
+    tmp.push_back( '\0' ) ;
+    int tfd = mkstemp( &tmp[0] ) ;
+    if( tfd < 0 )
+    {
+	string err = (string)"Failed to create a file in the cache "
+		     + _dir + ": " + strerror( errno ) ;
+	::close( lk ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    // locked before it is named .part, so a request finding the .part
+    // file always finds it locked until the product is finished
+    if( flock( tfd, LOCK_EX ) != 0 || rename( &tmp[0], part.c_str() ) != 0 )
+    {
+	string err = (string)"Failed to create a file in the cache "
+		     + _dir + ": " + strerror( errno ) ;
+	unlink( &tmp[0] ) ;
+	::close( tfd ) ;
+	::close( lk ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    ::close( lk ) ;
+
+    BESDEBUG( "cedar", "CedarCache::get - generating " << key << endl ) ;
+    bool ok = false ;
+    try
+    {
+	ofstream strm( part.c_str(), ios::out|ios::binary|ios::trunc ) ;
+	ok = producer.produce( strm, error ) ;
+	strm.close() ;
+	if( ok && !strm )
+	{
+	    error = (string)"Failed to write the product to the cache "
+		    + _dir ;
+	    ok = false ;
+	}
+    }
+    catch( ... )
+    {
+	unlink( part.c_str() ) ;
+	::close( tfd ) ;
+	throw ;
+    }
+
+    // readable by others only once it is whole, which is how a request
+    // following the product tells that it finished
+    if( ok && ( fchmod( tfd, 0644 ) != 0
+		|| rename( part.c_str(), path.c_str() ) != 0 ) )
+    {
+	error = (string)"Failed to add the product to the cache " + _dir
+		+ ": " + strerror( errno ) ;
+	ok = false ;
+    }
+    if( ok )
+	fd = ::open( path.c_str(), O_RDONLY ) ;
+    else
+	unlink( part.c_str() ) ;
+    ::close( tfd ) ;
+
+    if( ok )
+	purge() ;
+    return fd ;
+}
+
+/** @brief true if the request generating a product has finished with it,
+ * whether it succeeded or not
+ */
+bool
+CedarCache::is_finished( int fd )
+{
+    if( flock( fd, LOCK_SH|LOCK_NB ) != 0 )
+	return false ;
+    flock( fd, LOCK_UN ) ;
+    return true ;
+}
+
+/** @brief true if a finished product is whole, false if the request
+ * generating it failed
+ */
+bool
+CedarCache::is_complete( int fd )
+{
+    struct stat st ;
+    return fstat( fd, &st ) == 0 && ( st.st_mode & S_IRGRP ) ;
+}
+
+/** @brief wait for another request to finish generating a product
+ *
+ * @throws BESInternalError if the request generating it failed
+ */
+void
+CedarCache::wait( int fd )
+{
+    while( flock( fd, LOCK_SH ) != 0 )
+    {
+	if( errno == EINTR )
+	    continue ;
+	string err = (string)"Failed to wait for the product: "
+		     + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    flock( fd, LOCK_UN ) ;
+    if( !is_complete( fd ) )
+    {
+	throw BESInternalError( "The request generating the product failed",
+				__FILE__, __LINE__ ) ;
+    }
+}
+
+/** @brief wait for bytes past pos of a product being generated by another
+ * request
+ *
+ * @return the number of bytes past pos, 0 if the product is finished and
+ * has no more
+ * @throws BESInternalError if the request generating it failed
+ */
+unsigned long long
+CedarCache::wait_for( int fd, unsigned long long pos )
+{
+    useconds_t pause = CEDAR_CACHE_FOLLOW_PAUSE ;
+    for( ;; )
+    {
+	// checked before the length, so once finished the length is final
+	bool finished = is_finished( fd ) ;
+	unsigned long long len = get_length( fd ) ;
+	if( len > pos )
+	    return len - pos ;
+	if( finished )
+	{
+	    if( !is_complete( fd ) )
+	    {
+		throw BESInternalError(
+			    "The request generating the product failed",
+			    __FILE__, __LINE__ ) ;
+	    }
+	    return 0 ;
+	}
+	usleep( pause ) ;
+	if( pause < CEDAR_CACHE_FOLLOW_MAX_PAUSE )
+	    pause *= 2 ;
+    }
+}
+
+/** @brief send a product being generated by another request as it is
+ * written
+ *
+ * @throws BESInternalError if the request generating it failed
+ */
+void
+CedarCache::follow( int fd, ostream &strm )
+{
+    unsigned long long pos = 0 ;
+    unsigned long long len = 0 ;
+    while( ( len = wait_for( fd, pos ) ) )
+    {
+	send( fd, strm, pos, len ) ;
+	pos += len ;
+    }
+}
+
+/** @brief add a text product being generated by another request to the
+ * response as it is written
+ *
+ * @throws BESInternalError if the request generating it failed
+ */
+void
+CedarCache::follow( int fd, BESInfo &info )
+{
+    unsigned long long pos = 0 ;
+    unsigned long long len = 0 ;
+    while( ( len = wait_for( fd, pos ) ) )
+    {
+	send( fd, info, pos, len ) ;
+	pos += len ;
+    }
+}
+
+struct CedarCacheEntry
+{
+    string			path ;
+    time_t			used ;
+    unsigned long long		size ;
+
+    bool operator<( const CedarCacheEntry &e ) const { return used < e.used ; }
+} ;
+
+/** @brief remove the products read least recently until the cache is no
+ * larger than its size
+ *
+ * A product still being sent is only removed from the directory, the
+ * request sending it keeps it open.
+ */
+void
+CedarCache::purge()
+{
+    DIR *dir = opendir( _dir.c_str() ) ;
+    if( !dir )
+	return ;
+
+    vector<CedarCacheEntry> entries ;
+    unsigned long long total = 0 ;
+    struct dirent *ent = 0 ;
+    while( ( ent = readdir( dir ) ) )
+    {
+	string name = ent->d_name ;
+	if( name.length() != CEDAR_CACHE_KEY_LENGTH
+	    || name.find_first_not_of( "0123456789abcdef" ) != string::npos )
+	{
+	    continue ;
+	}
+	CedarCacheEntry entry ;
+	entry.path = get_path( name ) ;
+	struct stat st ;
+	if( stat( entry.path.c_str(), &st ) != 0 )
+	    continue ;
+	entry.used = st.st_mtime ;
+	entry.size = st.st_size ;
+	total += entry.size ;
+	entries.push_back( entry ) ;
+    }
+    closedir( dir ) ;
+
+    if( total <= _size )
+	return ;
+    sort( entries.begin(), entries.end() ) ;
+    for( size_t i = 0; i < entries.size() && total > _size; i++ )
+    {
+	BESDEBUG( "cedar", "CedarCache::purge - removing "
+			   << entries[i].path << endl ) ;
+	unlink( entries[i].path.c_str() ) ;
+	total -= entries[i].size ;
+    }
+}
+
+/** @brief the cache set up by the Cedar.Cache.Dir and Cedar.Cache.Size
+ * keys
+ *
+ * @return the cache, or null if Cedar.Cache.Dir is not set
+ * @throws BESInternalError if the cache directory can not be used
+ */
+CedarCache *
+CedarCache::TheCache()
+{
+    if( _configured )
+	return _the_cache ;
+    _configured = true ;
+
+    bool found = false ;
+    string dir ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Cache.Dir", dir, found ) ;
+    if( !found || dir.empty() )
+	return 0 ;
+
+    unsigned long long size = CEDAR_CACHE_SIZE ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Cache.Size", value, found ) ;
+    if( found && !value.empty() )
+	size = strtoull( value.c_str(), 0, 10 ) ;
+
+    if( mkdir( dir.c_str(), 0755 ) != 0 && errno != EEXIST )
+    {
+	string err = (string)"Failed to create the cache directory " + dir
+		     + ": " + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    if( access( dir.c_str(), R_OK|W_OK|X_OK ) != 0 )
+    {
+	string err = (string)"Can not use the cache directory " + dir
+		     + ": " + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+
+    BESDEBUG( "cedar", "CedarCache::TheCache - " << dir << ", "
+		       << size << " MB" << endl ) ;
+    _the_cache = new CedarCache( dir, size * 1024 * 1024 ) ;
+    return _the_cache ;
+}
+
+/** @brief open a product of a cedar file from the cache, generating it
+ * first if it is not cached
+ *
+ * @return the open product, or -1 if there is no cache or the file can not
+ * be found, in which case the product is generated as usual
+ * @throws BESInternalError if the product can not be generated
+ */
+int
+CedarCache::get_product( const string &filename, const string &product,
+                         const string &constraint,
+			 CedarCacheProducer &producer )
+{
+    bool partial = false ;
+    int fd = get_product( filename, product, constraint, producer,
+			  partial ) ;
+    if( partial )
+    {
+	try
+	{
+	    wait( fd ) ;
+	}
+	catch( ... )
+	{
+	    ::close( fd ) ;
+	    throw ;
+	}
+    }
+    return fd ;
+}
+
+/** @brief open a product of a cedar file from the cache, generating it
+ * first if it is neither cached nor being generated
+ *
+ * Identical requests arriving together cost one generation of the
+ * product, the others follow it as it is written.
+ *
+ * @param partial set if the product is still being generated by another
+ * request, it is to be sent with follow
+ * @return the open product, or -1 if there is no cache or the file can not
+ * be found, in which case the product is generated as usual
+ * @throws BESInternalError if the product can not be generated
+ */
+int
+CedarCache::get_product( const string &filename, const string &product,
+                         const string &constraint,
+			 CedarCacheProducer &producer, bool &partial )
+{
+    partial = false ;
+    CedarCache *cache = TheCache() ;
+    if( !cache )
+	return -1 ;
+    string key = get_key( filename, product, constraint ) ;
+    if( key.empty() )
+	return -1 ;
+    string error ;
+    int fd = cache->get( key, producer, error, partial ) ;
+    if( fd < 0 )
+	throw BESInternalError( error, __FILE__, __LINE__ ) ;
+    return fd ;
+}
+
+/** @brief the key of a product of a cedar file
+ *
+ * @param filename the cedar file
+ * @param product the product and anything else it depends on
+ * @param constraint the constraint, normalized before it is hashed
+ * @return the key, empty if the file can not be found
+ */
+string
+CedarCache::get_key( const string &filename, const string &product,
+                     const string &constraint )
+{
+    struct stat st ;
+    if( stat( filename.c_str(), &st ) != 0 )
+	return "" ;
+
+    // the catalog generation, products hold names and units from it
+    char id[128] ;
+    snprintf( id, sizeof id, "%lld %lld %lld %lld", (long long)st.st_mtime,
+	      (long long)st.st_size, (long long)st.st_ino,
+	      (long long)CedarCatalog::get_generation() ) ;
+    string identity = filename ;
+    identity += '\0' ;
+    identity += id ;
+    identity += '\0' ;
+    identity += product ;
+    identity += '\0' ;
+    identity += normalize( constraint ) ;
+    identity += '\0' ;
+    identity += PACKAGE_VERSION ;
+
+    // FNV-1a from two different starting points
+    unsigned long long h1 = 14695981039346656037ULL ;
+    unsigned long long h2 = 1099511628211ULL * 0x9e3779b97f4a7c15ULL ;
+    for( size_t i = 0; i < identity.length(); i++ )
+    {
+	unsigned char c = identity[i] ;
+	h1 = ( h1 ^ c ) * 1099511628211ULL ;
+	h2 = ( h2 ^ c ) * 1099511628211ULL ;
+    }
+    char key[CEDAR_CACHE_KEY_LENGTH + 1] ;
+    snprintf( key, sizeof key, "%016llx%016llx", h1, h2 ) ;
+    return key ;
+}
+
+/** @brief the constraint without white space outside of quotes, and with
+ * the clauses after the first in order
+ *
+ * The clauses all have to be satisfied, so their order does not change
+ * the product.
+ */
+string
+CedarCache::normalize( const string &constraint )
+{
+    vector<string> clauses( 1 ) ;
+    bool quoted = false ;
+    for( size_t i = 0; i < constraint.length(); i++ )
+    {
+	char c = constraint[i] ;
+	if( c == '"' )
+	    quoted = !quoted ;
+	if( !quoted && ( c == ' ' || c == '\t' || c == '\n' || c == '\r' ) )
+	    continue ;
+	if( !quoted && c == '&' )
+	{
+	    clauses.push_back( "" ) ;
+	    continue ;
+	}
+	clauses.back() += c ;
+    }
+    sort( clauses.begin() + 1, clauses.end() ) ;
+
+    string normalized = clauses[0] ;
+    for( size_t i = 1; i < clauses.size(); i++ )
+	normalized += "&" + clauses[i] ;
+    return normalized ;
+}
+
+/** @brief the size of an open product
+ */
+unsigned long long
+CedarCache::get_length( int fd )
+{
+    struct stat st ;
+    if( fstat( fd, &st ) != 0 )
+	return 0 ;
+    return st.st_size ;
+}
+
+/** @brief send len bytes of an open product from start
+ *
+ * When the product goes to standard output it is sent with sendfile, the
+ * bytes are never copied through the server.
+ *
+ * @throws BESInternalError if the product can not be read or sent
+ */
+void
+CedarCache::send( int fd, ostream &strm, unsigned long long start,
+                  unsigned long long len )
+{
+    off_t offset = start ;
+
+#ifdef HAVE_SYS_SENDFILE_H
+    if( &strm == &cout )
+    {
+	cout.flush() ;
+	int out = fileno( stdout ) ;
+	while( len > 0 )
+	{
+	    ssize_t sent = sendfile( out, fd, &offset, len ) ;
+	    if( sent < 0 && errno == EINTR )
+		continue ;
+	    if( sent <= 0 )
+	    {
+		string err = (string)"Failed to send the cached product: "
+			     + strerror( errno ) ;
+		throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	    }
+	    len -= sent ;
+	}
+	return ;
+    }
+#endif
+
+    char buf[CEDAR_CACHE_CHUNK] ;
+    while( len > 0 )
+    {
+	size_t want = len < sizeof buf ? len : sizeof buf ;
+	ssize_t got = pread( fd, buf, want, offset ) ;
+	if( got < 0 && errno == EINTR )
+	    continue ;
+	if( got <= 0 )
+	{
+	    string err = (string)"Failed to read the cached product: "
+			 + strerror( errno ) ;
+	    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	}
+	strm.write( buf, got ) ;
+	if( !strm )
+	{
+	    throw BESInternalError( "Failed to write the response",
+				    __FILE__, __LINE__ ) ;
+	}
+	offset += got ;
+	len -= got ;
+    }
+}
+
+/** @brief add len bytes of an open text product from start to the
+ * response
+ *
+ * @throws BESInternalError if the product can not be read
+ */
+void
+CedarCache::send( int fd, BESInfo &info, unsigned long long start,
+                  unsigned long long len )
+{
+    off_t offset = start ;
+    char buf[CEDAR_CACHE_CHUNK] ;
+    while( len > 0 )
+    {
+	size_t want = len < sizeof buf ? len : sizeof buf ;
+	ssize_t got = pread( fd, buf, want, offset ) ;
+	if( got < 0 && errno == EINTR )
+	    continue ;
+	if( got <= 0 )
+	{
+	    string err = (string)"Failed to read the cached product: "
+			 + strerror( errno ) ;
+	    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	}
+	info.add_data( string( buf, got ) ) ;
+	offset += got ;
+	len -= got ;
+    }
+}
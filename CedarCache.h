@@ -0,0 +1,131 @@
+// CedarCache.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarCache_h
+#define I_CedarCache_h 1
+
+#include <string>
+#include <iostream>
+
+using std::string ;
+using std::ostream ;
+
+class BESInfo ;
+
+/** @brief generates a product into the cache
+ */
+class CedarCacheProducer
+{
+public:
+    virtual			~CedarCacheProducer() {}
+
+    /** @brief write the whole product to strm
+     *
+     * @return false, with error set, if the product can not be generated
+     */
+    virtual bool		produce( ostream &strm, string &error ) = 0 ;
+} ;
+
+/** @brief a size bounded cache on disk of finished products
+ *
+ * A product is kept in a file named for its key, a hash of the identity of
+ * the cedar file (its path, modification time and size), the product and
+ * the normalized constraint, along with the catalog generation. A file
+ * that changes, or a catalog refresh, gives new keys, the old products are
+ * never asked for again and age out.
+ *
+ * Products are generated into a .part file and renamed into place once
+ * whole, and a reader keeps the product it opened even if it is evicted
+ * meanwhile. Only one request generates a product: the .part file is
+ * locked while it is written, and identical requests arriving meanwhile
+ * follow it, sending it as it grows, rather than generating it again.
+ * Looking for a product and starting to generate it is done under a lock
+ * shared by all keys starting with the same two characters, so there are
+ * never more than 256 lock files.
+ *
+ * Reading a product touches it, when the cache grows past its size the
+ * products read least recently are removed.
+ */
+class CedarCache
+{
+private:
+    string			_dir ;
+    unsigned long long		_size ;
+
+    static CedarCache *		_the_cache ;
+    static bool			_configured ;
+
+    string			get_path( const string &key ) const ;
+    int				lock( const string &key ) const ;
+public:
+    				CedarCache( const string &dir,
+					    unsigned long long size ) ;
+    virtual			~CedarCache() {}
+
+    const string &		get_dir() const { return _dir ; }
+    unsigned long long		get_size() const { return _size ; }
+
+    virtual int			open( const string &key ) const ;
+    virtual int			get( const string &key,
+				     CedarCacheProducer &producer,
+				     string &error ) ;
+    virtual int			get( const string &key,
+				     CedarCacheProducer &producer,
+				     string &error, bool &partial ) ;
+    virtual void		purge() ;
+
+    static CedarCache *		TheCache() ;
+    static int			get_product( const string &filename,
+					     const string &product,
+					     const string &constraint,
+					     CedarCacheProducer &producer ) ;
+    static int			get_product( const string &filename,
+					     const string &product,
+					     const string &constraint,
+					     CedarCacheProducer &producer,
+					     bool &partial ) ;
+    static string		get_key( const string &filename,
+					 const string &product,
+					 const string &constraint ) ;
+    static string		normalize( const string &constraint ) ;
+    static unsigned long long	get_length( int fd ) ;
+    static void			send( int fd, ostream &strm,
+				      unsigned long long start,
+				      unsigned long long len ) ;
+    static void			send( int fd, BESInfo &info,
+				      unsigned long long start,
+				      unsigned long long len ) ;
+
+    static bool			is_finished( int fd ) ;
+    static bool			is_complete( int fd ) ;
+    static void			wait( int fd ) ;
+    static unsigned long long	wait_for( int fd, unsigned long long pos ) ;
+    static void			follow( int fd, ostream &strm ) ;
+    static void			follow( int fd, BESInfo &info ) ;
+} ;
+
+#endif // I_CedarCache_h
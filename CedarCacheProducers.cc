@@ -0,0 +1,118 @@
+// CedarCacheProducers.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarCacheProducers.h"
+#include "CedarResponseNames.h"
+#include "cedar_read_attributes.h"
+#include "cedar_read_descriptors.h"
+#include "cedar_read_tab.h"
+#include "cedar_read_flat.h"
+#include "cedar_read_csv.h"
+#include "cedar_read_jsonl.h"
+#include "cedar_read_netcdf.h"
+#include "cedar_read_arrow.h"
+#include "CedarTab.h"
+#include "CedarFlat.h"
+#include "CedarCSV.h"
+#include "CedarJSONL.h"
+#include "BaseTypeFactory.h"
+
+bool
+CedarDASProducer::produce( ostream &strm, string &error )
+{
+    DAS das ;
+    if( !cedar_read_attributes( das, _filename, _query, error ) )
+	return false ;
+    das.print( strm ) ;
+    return true ;
+}
+
+bool
+CedarDDSProducer::produce( ostream &strm, string &error )
+{
+    BaseTypeFactory factory ;
+    DDS dds( &factory ) ;
+    if( !cedar_read_descriptors( dds, _filename, _name, _query, error ) )
+	return false ;
+    dds.print( strm ) ;
+    return true ;
+}
+
+/** @brief format the product into a response of its own that writes to
+ * strm rather than to the client
+ */
+bool
+CedarTextProducer::produce( ostream &strm, string &error )
+{
+    if( _product == TAB_RESPONSE )
+    {
+	CedarTab tab( false, &strm ) ;
+	if( !cedar_read_tab( tab, _filename, _query, _compact, error ) )
+	    return false ;
+	tab.print( strm ) ;
+    }
+    else if( _product == FLAT_RESPONSE )
+    {
+	CedarFlat flat( false, &strm ) ;
+	if( !cedar_read_flat( flat, _filename, _query, "", _compact, error ) )
+	    return false ;
+	flat.print( strm ) ;
+    }
+    else if( _product == CSV_RESPONSE )
+    {
+	CedarCSV csv( false, &strm ) ;
+	if( !cedar_read_csv( csv, _filename, _query, error ) )
+	    return false ;
+	csv.print( strm ) ;
+    }
+    else if( _product == JSONL_RESPONSE )
+    {
+	CedarJSONL jsonl( false, &strm ) ;
+	if( !cedar_read_jsonl( jsonl, _filename, _query, error ) )
+	    return false ;
+	jsonl.print( strm ) ;
+    }
+    else
+    {
+	error = "Can not cache the " + _product + " product" ;
+	return false ;
+    }
+    return true ;
+}
+
+bool
+CedarBinaryProducer::produce( ostream &strm, string &error )
+{
+    if( _product == NETCDF_RESPONSE )
+	return cedar_read_netcdf( strm, false, _filename, _name, _query,
+				  error ) ;
+    if( _product == ARROW_RESPONSE )
+	return cedar_read_arrow( strm, false, _filename, _name, _query,
+				 error ) ;
+    error = "Can not cache the " + _product + " product" ;
+    return false ;
+}
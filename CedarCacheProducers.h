@@ -0,0 +1,111 @@
+// CedarCacheProducers.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarCacheProducers_h
+#define I_CedarCacheProducers_h 1
+
+#include "CedarCache.h"
+
+/** @brief the attributes of a cedar file as a DAS
+ *
+ * The constraint only matters for an aggregate, it selects the files.
+ */
+class CedarDASProducer : public CedarCacheProducer
+{
+private:
+    string			_filename ;
+    string			_query ;
+public:
+    				CedarDASProducer( const string &filename,
+						  const string &query )
+				    : _filename( filename ),
+				      _query( query ) {}
+    virtual bool		produce( ostream &strm, string &error ) ;
+} ;
+
+/** @brief the descriptors of the records of a cedar file satisfying a
+ * constraint as a DDS
+ */
+class CedarDDSProducer : public CedarCacheProducer
+{
+private:
+    string			_filename ;
+    string			_name ;
+    string			_query ;
+public:
+    				CedarDDSProducer( const string &filename,
+						  const string &name,
+						  const string &query )
+				    : _filename( filename ),
+				      _name( name ),
+				      _query( query ) {}
+    virtual bool		produce( ostream &strm, string &error ) ;
+} ;
+
+/** @brief the tab or flat product
+ */
+class CedarTextProducer : public CedarCacheProducer
+{
+private:
+    string			_product ;
+    string			_filename ;
+    string			_query ;
+    bool			_compact ;
+public:
+    				CedarTextProducer( const string &product,
+						   const string &filename,
+						   const string &query,
+						   bool compact = false )
+				    : _product( product ),
+				      _filename( filename ),
+				      _query( query ),
+				      _compact( compact ) {}
+    virtual bool		produce( ostream &strm, string &error ) ;
+} ;
+
+/** @brief the netcdf or arrow product
+ */
+class CedarBinaryProducer : public CedarCacheProducer
+{
+private:
+    string			_product ;
+    string			_filename ;
+    string			_name ;
+    string			_query ;
+public:
+    				CedarBinaryProducer( const string &product,
+						     const string &filename,
+						     const string &name,
+						     const string &query )
+				    : _product( product ),
+				      _filename( filename ),
+				      _name( name ),
+				      _query( query ) {}
+    virtual bool		produce( ostream &strm, string &error ) ;
+} ;
+
+#endif // I_CedarCacheProducers_h
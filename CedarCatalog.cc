@@ -0,0 +1,92 @@
+// CedarCatalog.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <iostream>
+
+using std::endl ;
+
+#include "CedarCatalog.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+list<p_cedar_refresh> CedarCatalog::_refresh ;
+bool CedarCatalog::_configured = false ;
+bool CedarCatalog::_checked = false ;
+string CedarCatalog::_stamp ;
+time_t CedarCatalog::_generation = 0 ;
+
+/** @brief the generation of the catalog, refreshing what was read from it
+ * if it has changed since last asked
+ *
+ * @return the modification time of the Cedar.Catalog.Stamp file, 0 if
+ * there is none
+ */
+time_t
+CedarCatalog::get_generation()
+{
+    if( !_configured )
+    {
+	_configured = true ;
+	bool found = false ;
+	TheBESKeys::TheKeys()->get_value( "Cedar.Catalog.Stamp", _stamp,
+					  found ) ;
+	if( !found )
+	    _stamp = "" ;
+    }
+    if( _stamp.empty() )
+	return 0 ;
+
+    struct stat st ;
+    time_t generation = 0 ;
+    if( stat( _stamp.c_str(), &st ) == 0 )
+	generation = st.st_mtime ;
+    if( _checked && generation == _generation )
+	return _generation ;
+
+    if( _checked )
+    {
+	BESDEBUG( "cedar", "CedarCatalog::get_generation - catalog refreshed"
+			   << endl ) ;
+	list<p_cedar_refresh>::iterator i = _refresh.begin() ;
+	for( ; i != _refresh.end(); i++ )
+	    (*i)() ;
+    }
+    _checked = true ;
+    _generation = generation ;
+    return _generation ;
+}
+
+/** @brief add a function to be called when the catalog is refreshed
+ */
+void
+CedarCatalog::add_refresh( p_cedar_refresh refresh )
+{
+    _refresh.push_back( refresh ) ;
+}
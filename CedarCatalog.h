@@ -0,0 +1,63 @@
+// CedarCatalog.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarCatalog_h
+#define I_CedarCatalog_h 1
+
+#include <time.h>
+
+#include <list>
+#include <string>
+
+using std::list ;
+using std::string ;
+
+typedef void (*p_cedar_refresh)() ;
+
+/** @brief the generation of the Cedar catalog database
+ *
+ * Whatever updates the catalog database touches the file named by the
+ * Cedar.Catalog.Stamp key. The modification time of that file is the
+ * generation of the catalog, and is part of the key of every cached
+ * product. When it changes the functions added with add_refresh are
+ * called to drop what was read from the old catalog. Without the key the
+ * catalog is taken to never change.
+ */
+class CedarCatalog
+{
+private:
+    static list<p_cedar_refresh> _refresh ;
+    static bool			_configured ;
+    static bool			_checked ;
+    static string		_stamp ;
+    static time_t		_generation ;
+public:
+    static time_t		get_generation() ;
+    static void			add_refresh( p_cedar_refresh refresh ) ;
+} ;
+
+#endif // I_CedarCatalog_h
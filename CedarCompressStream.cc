@@ -0,0 +1,451 @@
+// CedarCompressStream.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "CedarCompressStream.h"
+#include "CedarTransmitter.h"
+#include "CedarResponseNames.h"
+#include "BESInternalError.h"
+#include "BESContextManager.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+using std::endl ;
+
+// bytes written before compression starts, smaller products are sent as
+// they are
+#define CEDAR_COMPRESS_THRESHOLD 4096
+
+CedarCompressBuf::CedarCompressBuf( ostream &strm, const string &encoding,
+                                    int level, size_t threshold,
+				    bool is_http )
+    : _strm( strm ),
+      _encoding( encoding ),
+      _level( level ),
+      _threshold( threshold ),
+      _is_http( is_http ),
+      _started( false ),
+      _compress( false ),
+      _finished( false ),
+      _in_bytes( 0 ),
+      _out_bytes( 0 )
+{
+#ifdef HAVE_ZSTD
+    _zcs = 0 ;
+#endif
+    if( !CedarCompressStream::is_supported( _encoding ) )
+    {
+	string err = "Unsupported content encoding " + _encoding ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    setp( _in, _in + sizeof _in ) ;
+}
+
+CedarCompressBuf::~CedarCompressBuf()
+{
+#ifdef HAVE_LIBZ
+    if( _compress && _encoding == "gzip" )
+	deflateEnd( &_zs ) ;
+#endif
+#ifdef HAVE_ZSTD
+    if( _zcs )
+	ZSTD_freeCStream( _zcs ) ;
+#endif
+}
+
+/** @brief write the response header, if any, and set up the compressor
+ *
+ * @param compress false if the product is to be sent as is
+ */
+void
+CedarCompressBuf::start( bool compress )
+{
+    _started = true ;
+    _compress = compress ;
+    if( _is_http )
+    {
+	string header =
+	    CedarTransmitter::get_text_header( _compress ? _encoding : "" ) ;
+	send( header.data(), header.length() ) ;
+	_out_bytes = 0 ;
+    }
+    if( !_compress )
+	return ;
+
+    _out.resize( CEDAR_COMPRESS_CHUNK ) ;
+#ifdef HAVE_LIBZ
+    if( _encoding == "gzip" )
+    {
+	memset( &_zs, 0, sizeof _zs ) ;
+	int level = ( _level < 0 || _level > 9 ) ? Z_DEFAULT_COMPRESSION
+						 : _level ;
+	// 16 more window bits asks for a gzip rather than a zlib wrapper
+	if( deflateInit2( &_zs, level, Z_DEFLATED, 15 + 16, 8,
+			  Z_DEFAULT_STRATEGY ) != Z_OK )
+	{
+	    _compress = false ;
+	    throw BESInternalError( "Failed to start gzip compression",
+				    __FILE__, __LINE__ ) ;
+	}
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if( _encoding == "zstd" )
+    {
+	_zcs = ZSTD_createCStream() ;
+	int level = _level < 0 ? 3 : _level ;
+	if( !_zcs || ZSTD_isError( ZSTD_initCStream( _zcs, level ) ) )
+	{
+	    _compress = false ;
+	    throw BESInternalError( "Failed to start zstd compression",
+				    __FILE__, __LINE__ ) ;
+	}
+    }
+#endif
+}
+
+void
+CedarCompressBuf::send( const char *buf, size_t len )
+{
+    _strm.write( buf, len ) ;
+    if( !_strm )
+    {
+	throw BESInternalError( "Failed to write the response",
+				__FILE__, __LINE__ ) ;
+    }
+    _out_bytes += len ;
+}
+
+/** @brief compress len bytes of buf and send what the compressor gives
+ * back
+ *
+ * @param end true to end the compressed stream
+ */
+void
+CedarCompressBuf::encode( const char *buf, size_t len, bool end )
+{
+#ifdef HAVE_LIBZ
+    if( _encoding == "gzip" )
+    {
+	_zs.next_in = (Bytef *)buf ;
+	_zs.avail_in = len ;
+	int ret = Z_OK ;
+	do
+	{
+	    _zs.next_out = (Bytef *)&_out[0] ;
+	    _zs.avail_out = _out.size() ;
+	    ret = deflate( &_zs, end ? Z_FINISH : Z_NO_FLUSH ) ;
+	    if( ret == Z_STREAM_ERROR )
+	    {
+		throw BESInternalError( "Failed to gzip the response",
+					__FILE__, __LINE__ ) ;
+	    }
+	    send( &_out[0], _out.size() - _zs.avail_out ) ;
+	} while( _zs.avail_out == 0 || ( end && ret != Z_STREAM_END ) ) ;
+	return ;
+    }
+#endif
+#ifdef HAVE_ZSTD
+    if( _encoding == "zstd" )
+    {
+	ZSTD_inBuffer in = { buf, len, 0 } ;
+	size_t remaining = 0 ;
+	do
+	{
+	    ZSTD_outBuffer out = { &_out[0], _out.size(), 0 } ;
+	    if( end && in.pos == in.size )
+		remaining = ZSTD_endStream( _zcs, &out ) ;
+	    else
+		remaining = ZSTD_compressStream( _zcs, &out, &in ) ;
+	    if( ZSTD_isError( remaining ) )
+	    {
+		string err = (string)"Failed to zstd the response: "
+			     + ZSTD_getErrorName( remaining ) ;
+		throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	    }
+	    send( &_out[0], out.pos ) ;
+	} while( in.pos < in.size || ( end && remaining ) ) ;
+	return ;
+    }
+#endif
+    // is_supported keeps us from getting here
+    send( buf, len ) ;
+}
+
+/** @brief hold on to the first bytes of the product until the threshold
+ * is reached, then pass them on
+ */
+void
+CedarCompressBuf::consume( const char *buf, size_t len )
+{
+    if( len == 0 )
+	return ;
+    _in_bytes += len ;
+    if( !_started )
+    {
+	_held.append( buf, len ) ;
+	if( _held.length() < _threshold )
+	    return ;
+	start( true ) ;
+	string held ;
+	held.swap( _held ) ;
+	encode( held.data(), held.length(), false ) ;
+	return ;
+    }
+    if( _compress )
+	encode( buf, len, false ) ;
+    else
+	send( buf, len ) ;
+}
+
+CedarCompressBuf::int_type
+CedarCompressBuf::overflow( int_type c )
+{
+    consume( pbase(), pptr() - pbase() ) ;
+    setp( _in, _in + sizeof _in ) ;
+    if( !traits_type::eq_int_type( c, traits_type::eof() ) )
+    {
+	*pptr() = traits_type::to_char_type( c ) ;
+	pbump( 1 ) ;
+    }
+    return traits_type::not_eof( c ) ;
+}
+
+/** @brief pass on what has been written so far
+ *
+ * The compressor is not flushed, flushing after every record would cost
+ * most of the compression.
+ */
+int
+CedarCompressBuf::sync()
+{
+    try
+    {
+	consume( pbase(), pptr() - pbase() ) ;
+	setp( _in, _in + sizeof _in ) ;
+	if( _started )
+	    _strm.flush() ;
+    }
+    catch( BESInternalError & )
+    {
+	return -1 ;
+    }
+    return 0 ;
+}
+
+/** @brief send whatever has not yet been sent and end the compressed
+ * stream
+ *
+ * A product that never reached the threshold is sent as is.
+ */
+void
+CedarCompressBuf::finish()
+{
+    if( _finished )
+	return ;
+    _finished = true ;
+    consume( pbase(), pptr() - pbase() ) ;
+    setp( _in, _in + sizeof _in ) ;
+    if( !_started )
+    {
+	start( false ) ;
+	send( _held.data(), _held.length() ) ;
+	_held.erase() ;
+    }
+    else if( _compress )
+    {
+	encode( 0, 0, true ) ;
+    }
+    _strm.flush() ;
+    BESDEBUG( "cedar", "CedarCompressBuf::finish - " << _in_bytes
+		       << " bytes sent as " << _out_bytes << " "
+		       << ( _compress ? _encoding : "identity" )
+		       << " bytes" << endl ) ;
+}
+
+void
+CedarCompressStream::finish()
+{
+    _buf.finish() ;
+}
+
+/** @brief true if the product can be sent with the given encoding
+ */
+bool
+CedarCompressStream::is_supported( const string &encoding )
+{
+#ifdef HAVE_LIBZ
+    if( encoding == "gzip" )
+	return true ;
+#endif
+#ifdef HAVE_ZSTD
+    if( encoding == "zstd" )
+	return true ;
+#endif
+    return false ;
+}
+
+/** @brief choose the encoding to send a product with from the value of an
+ * Accept-Encoding request header
+ *
+ * The supported encoding with the highest quality value is chosen, zstd
+ * before gzip when they are equal. An encoding given a quality of zero is
+ * refused, * stands for any encoding not named.
+ *
+ * @param accept value of the Accept-Encoding header
+ * @return gzip, zstd or empty if the product should be sent as is
+ */
+string
+CedarCompressStream::negotiate( const string &accept )
+{
+    const char *supported[] = { "zstd", "gzip" } ;
+    const size_t nsupported = sizeof supported / sizeof supported[0] ;
+    double q[nsupported] ;
+    bool named[nsupported] ;
+    double any = -1 ;
+    size_t s = 0 ;
+    for( s = 0; s < nsupported; s++ )
+    {
+	q[s] = -1 ;
+	named[s] = false ;
+    }
+
+    string::size_type pos = 0 ;
+    while( pos < accept.length() )
+    {
+	string::size_type comma = accept.find( ',', pos ) ;
+	if( comma == string::npos )
+	    comma = accept.length() ;
+	string item = accept.substr( pos, comma - pos ) ;
+	pos = comma + 1 ;
+
+	double quality = 1 ;
+	string::size_type semi = item.find( ';' ) ;
+	if( semi != string::npos )
+	{
+	    string::size_type qp = item.find( "q=", semi ) ;
+	    if( qp != string::npos )
+		quality = strtod( item.c_str() + qp + 2, 0 ) ;
+	    item = item.substr( 0, semi ) ;
+	}
+	string::size_type first = item.find_first_not_of( " \t" ) ;
+	if( first == string::npos )
+	    continue ;
+	string::size_type last = item.find_last_not_of( " \t" ) ;
+	string coding = item.substr( first, last - first + 1 ) ;
+	for( string::size_type c = 0; c < coding.length(); c++ )
+	    coding[c] = tolower( coding[c] ) ;
+	if( coding == "x-gzip" )
+	    coding = "gzip" ;
+
+	if( coding == "*" )
+	{
+	    any = quality ;
+	    continue ;
+	}
+	for( s = 0; s < nsupported; s++ )
+	{
+	    if( coding == supported[s] )
+	    {
+		q[s] = quality ;
+		named[s] = true ;
+	    }
+	}
+    }
+
+    string best ;
+    double best_q = 0 ;
+    for( s = 0; s < nsupported; s++ )
+    {
+	double quality = named[s] ? q[s] : any ;
+	if( quality > best_q && is_supported( supported[s] ) )
+	{
+	    best = supported[s] ;
+	    best_q = quality ;
+	}
+    }
+    return best ;
+}
+
+/** @brief a compressing stream for a text product if the client accepts
+ * an encoding this module supports, otherwise null
+ *
+ * The Accept-Encoding of the request is passed in the cedar_accept_encoding
+ * context. Only products sent over HTTP are compressed, as the encoding
+ * is named in the response header. Compression is configured with
+ * Cedar.Compress.Mode=on|off, Cedar.Compress.Level, the gzip or zstd
+ * level, and Cedar.Compress.Threshold, the size in bytes below which a
+ * product is sent as is.
+ *
+ * @param strm the response stream
+ * @param is_http true if the response is sent over HTTP
+ * @return the stream to format the product on to, owned by the caller,
+ * or null if the product should be written straight to strm
+ */
+CedarCompressStream *
+CedarCompressStream::for_request( ostream &strm, bool is_http )
+{
+    if( !is_http )
+	return 0 ;
+
+    bool found = false ;
+    string accept =
+	BESContextManager::TheManager()->get_context(
+					CEDAR_ACCEPT_ENCODING_CONTEXT, found ) ;
+    if( !found || accept.empty() )
+	return 0 ;
+
+    string mode ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Compress.Mode", mode, found ) ;
+    if( found && ( mode == "off" || mode == "OFF" || mode == "no" ) )
+	return 0 ;
+
+    string encoding = negotiate( accept ) ;
+    if( encoding.empty() )
+	return 0 ;
+
+    int level = -1 ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Compress.Level", value, found ) ;
+    if( found && !value.empty() )
+	level = atoi( value.c_str() ) ;
+
+    size_t threshold = CEDAR_COMPRESS_THRESHOLD ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Compress.Threshold", value,
+				      found ) ;
+    if( found && !value.empty() )
+	threshold = strtoul( value.c_str(), 0, 10 ) ;
+
+    BESDEBUG( "cedar", "CedarCompressStream::for_request - " << encoding
+		       << " level " << level << " threshold " << threshold
+		       << endl ) ;
+    return new CedarCompressStream( strm, encoding, level, threshold,
+				    is_http ) ;
+}
@@ -0,0 +1,145 @@
+// CedarCompressStream.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarCompressStream_h
+#define I_CedarCompressStream_h 1
+
+#include <string>
+#include <iostream>
+#include <streambuf>
+#include <vector>
+
+using std::string ;
+using std::ostream ;
+using std::streambuf ;
+using std::vector ;
+
+#include "config_cedar.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+// bytes formatted before they are handed to the compressor
+#define CEDAR_COMPRESS_CHUNK 65536
+
+/** @brief compresses what is written to it on to another stream as it is
+ * written
+ *
+ * Nothing is sent until threshold bytes have been written. A product that
+ * ends before then is sent as is, otherwise everything is sent gzip or
+ * zstd encoded. When the product is sent over HTTP the response header is
+ * written once that choice is made, with the Content-Encoding of the
+ * product, see CedarTransmitter::get_text_header.
+ */
+class CedarCompressBuf : public streambuf
+{
+private:
+    ostream &			_strm ;
+    string			_encoding ;
+    int				_level ;
+    size_t			_threshold ;
+    bool			_is_http ;
+    bool			_started ;
+    bool			_compress ;
+    bool			_finished ;
+    unsigned long long		_in_bytes ;
+    unsigned long long		_out_bytes ;
+    char			_in[CEDAR_COMPRESS_CHUNK] ;
+    string			_held ;
+    vector<char>		_out ;
+#ifdef HAVE_LIBZ
+    z_stream			_zs ;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_CStream *		_zcs ;
+#endif
+
+    void			start( bool compress ) ;
+    void			consume( const char *buf, size_t len ) ;
+    void			encode( const char *buf, size_t len,
+					bool end ) ;
+    void			send( const char *buf, size_t len ) ;
+protected:
+    virtual int_type		overflow( int_type c ) ;
+    virtual int			sync() ;
+public:
+    				CedarCompressBuf( ostream &strm,
+						  const string &encoding,
+						  int level,
+						  size_t threshold,
+						  bool is_http ) ;
+    virtual			~CedarCompressBuf() ;
+
+    virtual void		finish() ;
+
+    /** @brief the encoding of the product, empty if it was sent as is */
+    string			get_encoding() const
+				{ return _compress ? _encoding : "" ; }
+    unsigned long long		get_in_bytes() const { return _in_bytes ; }
+    unsigned long long		get_out_bytes() const { return _out_bytes ; }
+} ;
+
+/** @brief an output stream that compresses a text product on to the
+ * response stream
+ *
+ * The text products are formatted a record at a time, so compression
+ * proceeds as the product is formatted rather than after.
+ */
+class CedarCompressStream : public ostream
+{
+private:
+    CedarCompressBuf		_buf ;
+public:
+    				CedarCompressStream( ostream &strm,
+						     const string &encoding,
+						     int level,
+						     size_t threshold,
+						     bool is_http )
+				    : ostream( 0 ),
+				      _buf( strm, encoding, level, threshold,
+					    is_http )
+				{
+				    rdbuf( &_buf ) ;
+				    // let write errors reach the reader
+				    exceptions( badbit ) ;
+				}
+    virtual			~CedarCompressStream() {}
+
+    virtual void		finish() ;
+    CedarCompressBuf &		get_buf() { return _buf ; }
+
+    static string		negotiate( const string &accept ) ;
+    static bool			is_supported( const string &encoding ) ;
+    static CedarCompressStream *for_request( ostream &strm,
+					     bool is_http ) ;
+} ;
+
+#endif // I_CedarCompressStream_h
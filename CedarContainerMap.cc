@@ -0,0 +1,822 @@
+// CedarContainerMap.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "config_cedar.h"
+
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <iostream>
+#include <deque>
+
+using std::endl ;
+using std::deque ;
+
+#include "CedarContainerMap.h"
+#include "CedarInputFile.h"
+#include "BESDebug.h"
+
+// how deep below a base directory files are looked for
+#define CEDAR_CONTAINER_DEPTH 8
+
+/** @brief the files and subdirectories of one directory below a base
+ * directory
+ */
+class CedarContainerMap::Dir
+{
+public:
+    string			path ;
+    size_t			root ;
+    string			prefix ;
+    int				depth ;
+    time_t			mtime ;
+    time_t			read_at ;
+    int				wd ;
+    bool			ok ;
+    set<string>			files ;
+    set<string>			subdirs ;
+
+    				Dir( const string &p, size_t r,
+				     const string &pre, int d )
+				    : path( p ), root( r ), prefix( pre ),
+				      depth( d ), mtime( 0 ), read_at( 0 ),
+				      wd( -1 ), ok( false ) {}
+
+    bool			read() ;
+} ;
+
+/** @brief list the directory
+ *
+ * The type readdir gives for each entry is used, an entry is only looked
+ * at with stat if the file system does not give its type or it is a
+ * symbolic link.
+ *
+ * @return false if the directory can not be read
+ */
+bool
+CedarContainerMap::Dir::read()
+{
+    read_at = time( 0 ) ;
+    struct stat st ;
+    if( stat( path.c_str(), &st ) == -1 || !S_ISDIR( st.st_mode ) )
+	return false ;
+    mtime = st.st_mtime ;
+    DIR *dip = opendir( path.c_str() ) ;
+    if( !dip )
+	return false ;
+
+    struct dirent *dit = 0 ;
+    while( ( dit = readdir( dip ) ) != NULL )
+    {
+	const char *name = dit->d_name ;
+	if( name[0] == '.' && ( name[1] == '\0'
+				|| ( name[1] == '.' && name[2] == '\0' ) ) )
+	{
+	    continue ;
+	}
+	bool is_dir = false ;
+#ifdef _DIRENT_HAVE_D_TYPE
+	is_dir = ( dit->d_type == DT_DIR ) ;
+	if( dit->d_type == DT_UNKNOWN || dit->d_type == DT_LNK )
+#endif
+	{
+	    string full = path + "/" + name ;
+	    struct stat est ;
+	    is_dir = ( stat( full.c_str(), &est ) == 0
+		       && S_ISDIR( est.st_mode ) ) ;
+	}
+	if( is_dir )
+	    subdirs.insert( name ) ;
+	else
+	    files.insert( name ) ;
+    }
+    closedir( dip ) ;
+    return true ;
+}
+
+/** @brief the directories waiting to be read and those read, shared by
+ * the threads reading them
+ *
+ * Each directory read adds the subdirectories not already listed.
+ */
+class CedarContainerMap::Scan
+{
+private:
+    const vector<string> &	_roots ;
+    const map<string,Dir *> &	_known ;
+    unsigned int		_busy ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t		_lock ;
+    pthread_cond_t		_cond ;
+#endif
+
+    void			lock()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_lock( &_lock ) ;
+#endif
+				}
+    void			unlock()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_unlock( &_lock ) ;
+#endif
+				}
+    void			wait()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_wait( &_cond, &_lock ) ;
+#endif
+				}
+    void			wake()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_broadcast( &_cond ) ;
+#endif
+				}
+public:
+    deque<Dir *>		todo ;
+    vector<Dir *>		done ;
+
+    				Scan( const vector<string> &roots,
+				      const map<string,Dir *> &known )
+				    : _roots( roots ), _known( known ),
+				      _busy( 0 )
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_init( &_lock, 0 ) ;
+				    pthread_cond_init( &_cond, 0 ) ;
+#endif
+				}
+    				~Scan()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_destroy( &_cond ) ;
+				    pthread_mutex_destroy( &_lock ) ;
+#endif
+				    for( size_t i = 0; i < todo.size(); i++ )
+					delete todo[i] ;
+				}
+
+    void			run() ;
+    static void *		start( void *arg )
+				{
+				    ((Scan *)arg)->run() ;
+				    return 0 ;
+				}
+} ;
+
+/** @brief read directories until there are none left to read
+ */
+void
+CedarContainerMap::Scan::run()
+{
+    lock() ;
+    for( ;; )
+    {
+	if( todo.empty() )
+	{
+	    // another thread may yet find subdirectories
+	    if( _busy == 0 )
+		break ;
+	    wait() ;
+	    continue ;
+	}
+	Dir *d = todo.front() ;
+	todo.pop_front() ;
+	_busy++ ;
+	unlock() ;
+
+	d->ok = d->read() ;
+
+	lock() ;
+	_busy-- ;
+	done.push_back( d ) ;
+	if( d->ok && d->depth < CEDAR_CONTAINER_DEPTH )
+	{
+	    set<string>::const_iterator s ;
+	    for( s = d->subdirs.begin(); s != d->subdirs.end(); s++ )
+	    {
+		string path = d->path + "/" + *s ;
+		if( _known.find( path ) != _known.end() )
+		    continue ;
+		// a base directory below another is listed on its own
+		bool is_root = false ;
+		for( size_t r = 0; r < _roots.size() && !is_root; r++ )
+		    is_root = ( _roots[r] == path ) ;
+		if( !is_root )
+		    todo.push_back( new Dir( path, d->root,
+					     d->prefix + *s + "/",
+					     d->depth + 1 ) ) ;
+	    }
+	}
+	wake() ;
+    }
+    wake() ;
+    unlock() ;
+}
+
+/** @brief the symbolic name file in the directory below prefix would
+ * have, empty if the file has no extension
+ *
+ * The .gz or .zst of a compressed file is not part of its extension, so
+ * mfp920504a.cbf.gz is named mfp920504a.
+ */
+static string
+sym_name_of( const string &prefix, const string &file )
+{
+    string plain = CedarInputFile::strip( file ) ;
+    string::size_type dot = plain.rfind( "." ) ;
+    if( dot == string::npos )
+	return "" ;
+    return prefix + plain.substr( 0, dot ) ;
+}
+
+/** @brief an empty map, files are looked for once a base directory is
+ * added
+ *
+ * @param refresh seconds between checks of the directories for changes
+ * not reported by inotify, 0 to not check them
+ * @param threads most threads reading directories at once
+ */
+CedarContainerMap::CedarContainerMap( time_t refresh, unsigned int threads )
+    : _refresh( refresh ),
+      _threads( threads ),
+      _scanned( 0 ),
+      _checked( 0 ),
+      _dirty( false ),
+      _notify( -1 )
+{
+}
+
+CedarContainerMap::~CedarContainerMap()
+{
+    clear() ;
+#ifdef HAVE_SYS_INOTIFY_H
+    if( _notify >= 0 )
+	close( _notify ) ;
+#endif
+}
+
+/** @brief look for files with extension below base, after those of the
+ * directories already added
+ *
+ * The directories are scanned when a file is next looked for.
+ *
+ * @param base the directory, not looked in if empty
+ * @param extension the extension of the files, without the dot
+ * @param layout the path below base of the file with a symbolic name, as
+ * for expand_layout, empty if files are named for their path
+ */
+void
+CedarContainerMap::add_base( const string &base, const string &extension,
+			     const string &layout )
+{
+    if( base.empty() )
+	return ;
+    string root = base ;
+    while( root.length() > 1 && root[root.length()-1] == '/' )
+	root.erase( root.length() - 1 ) ;
+    _bases.push_back( root ) ;
+    _extensions.push_back( extension ) ;
+    _layouts.push_back( layout ) ;
+    bool seen = false ;
+    for( size_t r = 0; r < _roots.size() && !seen; r++ )
+	seen = ( _roots[r] == root ) ;
+    if( !seen )
+	_roots.push_back( root ) ;
+    _dirty = true ;
+}
+
+/** @brief the path of the file with symbolic name sym_name
+ *
+ * @param sym_name the path of the file below its base directory, without
+ * the extension
+ * @param path set to the full path of the file
+ * @return false if there is no such file
+ */
+bool
+CedarContainerMap::find( const string &sym_name, string &path )
+{
+    // changes are looked for no more than once a second
+    time_t now = time( 0 ) ;
+    if( _dirty || now != _checked )
+    {
+	_checked = now ;
+	check() ;
+    }
+    map<string,string>::const_iterator i = _paths.find( sym_name ) ;
+    if( i == _paths.end() )
+	return false ;
+    path = i->second ;
+    return true ;
+}
+
+/** @brief read again the directories that have changed
+ *
+ * Changes reported by inotify are picked up every time. Every refresh
+ * seconds the modification time of every directory is checked as well,
+ * and base directories that could not be read are tried again.
+ */
+void
+CedarContainerMap::check()
+{
+    read_events() ;
+    if( _refresh > 0 && time( 0 ) - _scanned >= _refresh )
+    {
+	_scanned = time( 0 ) ;
+	find_changed() ;
+    }
+    if( _dirty )
+	scan() ;
+    else if( !_changed.empty() )
+	update() ;
+}
+
+/** @brief note the directories inotify reports have changed, without
+ * waiting for them to
+ *
+ * If events were lost every directory is read again.
+ */
+void
+CedarContainerMap::read_events()
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    if( _notify < 0 )
+	return ;
+    long buf[1024] ;
+    ssize_t n = 0 ;
+    while( ( n = read( _notify, buf, sizeof buf ) ) > 0 )
+    {
+	char *p = (char *)buf ;
+	while( p < (char *)buf + n )
+	{
+	    struct inotify_event *ev = (struct inotify_event *)p ;
+	    p += sizeof( struct inotify_event ) + ev->len ;
+	    if( ev->mask & IN_Q_OVERFLOW )
+	    {
+		_dirty = true ;
+		continue ;
+	    }
+	    map<int,string>::iterator w = _watches.find( ev->wd ) ;
+	    if( w == _watches.end() )
+		continue ;
+	    _changed.insert( w->second ) ;
+	    if( ev->mask & IN_IGNORED )
+		_watches.erase( w ) ;
+	}
+    }
+#endif
+}
+
+/** @brief note the directories modified since they were read, and the
+ * base directories not listed
+ */
+void
+CedarContainerMap::find_changed()
+{
+    map<string,Dir *>::const_iterator i ;
+    for( i = _dirs.begin(); i != _dirs.end(); i++ )
+    {
+	const Dir *d = i->second ;
+	struct stat st ;
+	// a directory modified in the second it was read may have changed
+	// after it was read
+	if( stat( d->path.c_str(), &st ) == -1 || st.st_mtime != d->mtime
+	    || st.st_mtime >= d->read_at )
+	{
+	    _changed.insert( d->path ) ;
+	}
+    }
+    for( size_t r = 0; r < _roots.size(); r++ )
+    {
+	if( _dirs.find( _roots[r] ) == _dirs.end() )
+	    _changed.insert( _roots[r] ) ;
+    }
+}
+
+/** @brief read the directories of scan, with up to the configured
+ * number of threads if parallel
+ */
+void
+CedarContainerMap::read_dirs( Scan &scan, bool parallel )
+{
+#ifdef HAVE_PTHREAD
+    vector<pthread_t> threads ;
+    for( unsigned int i = 1; parallel && i < _threads; i++ )
+    {
+	pthread_t t ;
+	if( pthread_create( &t, 0, Scan::start, &scan ) != 0 )
+	    break ;
+	threads.push_back( t ) ;
+    }
+    scan.run() ;
+    for( size_t i = 0; i < threads.size(); i++ )
+	pthread_join( threads[i], 0 ) ;
+#else
+    scan.run() ;
+#endif
+}
+
+/** @brief watch the directory for files added, removed or renamed
+ *
+ * If it can not be watched nothing is watched and changes are found by
+ * the checks every refresh seconds.
+ */
+void
+CedarContainerMap::watch( Dir *d )
+{
+#ifdef HAVE_SYS_INOTIFY_H
+    if( _notify < 0 )
+	return ;
+    uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+		    | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF ;
+    int wd = inotify_add_watch( _notify, d->path.c_str(), mask ) ;
+    if( wd < 0 )
+    {
+	BESDEBUG( "cedar", "CedarContainerMap::watch - unable to watch "
+			   << d->path << ", checking every " << _refresh
+			   << " seconds" << endl ) ;
+	close( _notify ) ;
+	_notify = -1 ;
+	_watches.clear() ;
+	return ;
+    }
+    d->wd = wd ;
+    _watches[wd] = d->path ;
+#endif
+}
+
+/** @brief drop the directory at path and every directory below it
+ *
+ * @param names the symbolic names of the files dropped are added to
+ * names, to be looked for again
+ */
+void
+CedarContainerMap::remove( const string &path, set<string> &names )
+{
+    string below = path + "/" ;
+    map<string,Dir *>::iterator i = _dirs.lower_bound( path ) ;
+    while( i != _dirs.end() && ( i->first == path
+	   || i->first.compare( 0, below.length(), below ) == 0 ) )
+    {
+	Dir *d = i->second ;
+	set<string>::const_iterator f ;
+	for( f = d->files.begin(); f != d->files.end(); f++ )
+	    add_names( d, *f, names ) ;
+	if( _watches.erase( d->wd ) )
+	{
+#ifdef HAVE_SYS_INOTIFY_H
+	    inotify_rm_watch( _notify, d->wd ) ;
+#endif
+	}
+	delete d ;
+	_dirs.erase( i++ ) ;
+    }
+}
+
+/** @brief the symbolic names a file in the directory may be found by,
+ * its path below the base directory and, placed by a layout, its own
+ * name
+ */
+void
+CedarContainerMap::add_names( const Dir *d, const string &file,
+			      set<string> &names )
+{
+    string sym = sym_name_of( d->prefix, file ) ;
+    if( sym.empty() )
+	return ;
+    names.insert( sym ) ;
+    if( !d->prefix.empty() )
+	names.insert( sym_name_of( "", file ) ) ;
+}
+
+/** @brief true if the listings hold the file at rel below base directory
+ * i, with the extension of that base directory
+ *
+ * A file that is not compressed is used before a gzip compressed one,
+ * and that before a zstd compressed one.
+ *
+ * @param path set to the full path of the file
+ */
+bool
+CedarContainerMap::in_base( size_t i, const string &rel, string &path ) const
+{
+    string sub ;
+    string name = rel ;
+    string::size_type slash = rel.rfind( "/" ) ;
+    if( slash != string::npos )
+    {
+	sub = "/" + rel.substr( 0, slash ) ;
+	name = rel.substr( slash + 1 ) ;
+    }
+    string dir = _bases[i] + sub ;
+    map<string,Dir *>::const_iterator d = _dirs.find( dir ) ;
+    if( d == _dirs.end() || _roots[d->second->root] != _bases[i] )
+	return false ;
+    static const char *suffixes[] = { "", ".gz", ".zst" } ;
+    const set<string> &files = d->second->files ;
+    for( size_t s = 0; s < sizeof suffixes / sizeof suffixes[0]; s++ )
+    {
+	string file = name + "." + _extensions[i] + suffixes[s] ;
+	if( files.find( file ) != files.end() )
+	{
+	    path = dir + "/" + file ;
+	    return true ;
+	}
+    }
+    return false ;
+}
+
+/** @brief look the file with symbolic name sym_name up again in the
+ * directory listings, the first base directory first
+ *
+ * In a base directory with a layout the file is looked for where the
+ * layout places it, then at its path below the base directory.
+ */
+void
+CedarContainerMap::resolve( const string &sym_name )
+{
+    if( sym_name.empty() )
+	return ;
+    for( size_t i = 0; i < _bases.size(); i++ )
+    {
+	string path ;
+	string rel ;
+	if( ( !_layouts[i].empty()
+	      && expand_layout( _layouts[i], sym_name, rel )
+	      && in_base( i, rel, path ) )
+	    || in_base( i, sym_name, path ) )
+	{
+	    _paths[sym_name] = path ;
+	    return ;
+	}
+    }
+    _paths.erase( sym_name ) ;
+}
+
+/** @brief false if the layout uses a field expand_layout does not know
+ * or does not name the file with %n
+ *
+ * @param error set to what is wrong with the layout
+ */
+bool
+CedarContainerMap::check_layout( const string &layout, string &error )
+{
+    if( layout.empty() )
+	return true ;
+    bool named = false ;
+    for( string::size_type i = 0; i < layout.length(); i++ )
+    {
+	if( layout[i] != '%' )
+	    continue ;
+	i++ ;
+	char c = ( i < layout.length() ) ? layout[i] : '\0' ;
+	if( c == 'n' )
+	    named = true ;
+	else if( c != 'p' && c != 'Y' && c != 'y' && c != 'm'
+		 && c != 'd' && c != '%' )
+	{
+	    error = "Unknown field in layout " + layout
+		    + ", use %n, %p, %Y, %y, %m, %d or %%" ;
+	    return false ;
+	}
+    }
+    if( !named )
+    {
+	error = "Layout " + layout + " does not name the file with %n" ;
+	return false ;
+    }
+    return true ;
+}
+
+/** @brief the path a layout places the file with a symbolic name at
+ *
+ * Cedar and Madrigal files are named for the instrument, the date and a
+ * letter, such as mfp920504a. In the layout %n is the symbolic name,
+ * %p the letters it starts with, %Y the four digit year of the date,
+ * %y, %m and %d the two digit year, month and day, and %% a percent
+ * sign. The layout %p/%Y/%n places mfp920504a at mfp/1992/mfp920504a.
+ * Years before 50 are taken to be in the 2000s.
+ *
+ * @param path set to the path below the base directory, without the
+ * extension
+ * @return false if the name does not have the fields the layout uses,
+ * or is itself a path
+ */
+bool
+CedarContainerMap::expand_layout( const string &layout,
+				  const string &sym_name, string &path )
+{
+    path.clear() ;
+    if( sym_name.find( "/" ) != string::npos )
+	return false ;
+    string::size_type p = 0 ;
+    while( p < sym_name.length() && isalpha( (unsigned char)sym_name[p] ) )
+	p++ ;
+    bool dated = ( p > 0 && sym_name.length() >= p + 6 ) ;
+    for( string::size_type i = p; dated && i < p + 6; i++ )
+	dated = isdigit( (unsigned char)sym_name[i] ) ;
+
+    for( string::size_type i = 0; i < layout.length(); i++ )
+    {
+	if( layout[i] != '%' )
+	{
+	    path += layout[i] ;
+	    continue ;
+	}
+	i++ ;
+	char c = ( i < layout.length() ) ? layout[i] : '\0' ;
+	if( c == 'n' )
+	    path += sym_name ;
+	else if( c == '%' )
+	    path += '%' ;
+	else if( c == 'p' && p > 0 )
+	    path += sym_name.substr( 0, p ) ;
+	else if( c == 'Y' && dated )
+	    path += ( sym_name[p] < '5' ? "20" : "19" ) + sym_name.substr( p, 2 ) ;
+	else if( c == 'y' && dated )
+	    path += sym_name.substr( p, 2 ) ;
+	else if( c == 'm' && dated )
+	    path += sym_name.substr( p + 2, 2 ) ;
+	else if( c == 'd' && dated )
+	    path += sym_name.substr( p + 4, 2 ) ;
+	else
+	    return false ;
+    }
+    return true ;
+}
+
+/** @brief read the directories noted as changed again, along with any
+ * new directories below them
+ */
+void
+CedarContainerMap::update()
+{
+    Scan scan( _roots, _dirs ) ;
+    set<string>::const_iterator c ;
+    for( c = _changed.begin(); c != _changed.end(); c++ )
+    {
+	map<string,Dir *>::const_iterator i = _dirs.find( *c ) ;
+	if( i != _dirs.end() )
+	{
+	    const Dir *old = i->second ;
+	    scan.todo.push_back( new Dir( old->path, old->root, old->prefix,
+					  old->depth ) ) ;
+	    continue ;
+	}
+	for( size_t r = 0; r < _roots.size(); r++ )
+	{
+	    if( _roots[r] == *c )
+		scan.todo.push_back( new Dir( *c, r, "", 0 ) ) ;
+	}
+    }
+    _changed.clear() ;
+    if( scan.todo.empty() )
+	return ;
+    read_dirs( scan, scan.todo.size() > 1 ) ;
+
+    set<string> names ;
+    for( size_t n = 0; n < scan.done.size(); n++ )
+    {
+	Dir *d = scan.done[n] ;
+	map<string,Dir *>::iterator i = _dirs.find( d->path ) ;
+	Dir *old = ( i == _dirs.end() ) ? 0 : i->second ;
+	if( !d->ok )
+	{
+	    if( old )
+		remove( d->path, names ) ;
+	    delete d ;
+	    continue ;
+	}
+	set<string>::const_iterator s ;
+	if( old )
+	{
+	    // subdirectories no longer there go with everything below them
+	    for( s = old->subdirs.begin(); s != old->subdirs.end(); s++ )
+	    {
+		if( d->subdirs.find( *s ) == d->subdirs.end() )
+		    remove( old->path + "/" + *s, names ) ;
+	    }
+	    for( s = old->files.begin(); s != old->files.end(); s++ )
+		add_names( old, *s, names ) ;
+	    d->wd = old->wd ;
+	    delete old ;
+	}
+	_dirs[d->path] = d ;
+	for( s = d->files.begin(); s != d->files.end(); s++ )
+	    add_names( d, *s, names ) ;
+	if( _watches.find( d->wd ) == _watches.end() )
+	    watch( d ) ;
+    }
+
+    set<string>::const_iterator s ;
+    for( s = names.begin(); s != names.end(); s++ )
+	resolve( *s ) ;
+    BESDEBUG( "cedar", "CedarContainerMap::update - read "
+		       << scan.done.size() << " directories, "
+		       << _paths.size() << " files" << endl ) ;
+}
+
+/** @brief drop every directory listing
+ */
+void
+CedarContainerMap::clear()
+{
+    map<string,Dir *>::iterator i ;
+    for( i = _dirs.begin(); i != _dirs.end(); i++ )
+	delete i->second ;
+    _dirs.clear() ;
+    _watches.clear() ;
+    _paths.clear() ;
+}
+
+/** @brief read every directory below the base directories again
+ *
+ * A base directory that can not be read adds no files until it can.
+ */
+void
+CedarContainerMap::scan()
+{
+    _dirty = false ;
+    _changed.clear() ;
+    _scanned = time( 0 ) ;
+    clear() ;
+#ifdef HAVE_SYS_INOTIFY_H
+    // a new instance, so directories removed since are no longer watched
+    if( _notify >= 0 )
+	close( _notify ) ;
+    _notify = inotify_init() ;
+    if( _notify >= 0 )
+	fcntl( _notify, F_SETFL, fcntl( _notify, F_GETFL ) | O_NONBLOCK ) ;
+#endif
+
+    Scan scan( _roots, _dirs ) ;
+    for( size_t r = 0; r < _roots.size(); r++ )
+	scan.todo.push_back( new Dir( _roots[r], r, "", 0 ) ) ;
+    read_dirs( scan, true ) ;
+
+    for( size_t n = 0; n < scan.done.size(); n++ )
+    {
+	Dir *d = scan.done[n] ;
+	if( !d->ok )
+	{
+	    BESDEBUG( "cedar", "CedarContainerMap::scan - unable to read "
+			       << d->path << endl ) ;
+	    delete d ;
+	    continue ;
+	}
+	_dirs[d->path] = d ;
+	watch( d ) ;
+    }
+
+    set<string> names ;
+    map<string,Dir *>::const_iterator i ;
+    for( i = _dirs.begin(); i != _dirs.end(); i++ )
+    {
+	const Dir *d = i->second ;
+	set<string>::const_iterator f ;
+	for( f = d->files.begin(); f != d->files.end(); f++ )
+	    add_names( d, *f, names ) ;
+    }
+    set<string>::const_iterator s ;
+    for( s = names.begin(); s != names.end(); s++ )
+	resolve( *s ) ;
+    BESDEBUG( "cedar", "CedarContainerMap::scan - " << _dirs.size()
+		       << " directories, " << _paths.size() << " files"
+		       << endl ) ;
+}
@@ -0,0 +1,124 @@
+// CedarContainerMap.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarContainerMap_h
+#define I_CedarContainerMap_h 1
+
+#include <time.h>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::set ;
+
+/** @brief the path of every cedar file under the base directories, by
+ * symbolic name
+ *
+ * A base directory is searched for files with an extension, the symbolic
+ * name of a file being its path below the base directory without the
+ * extension. A base directory can also be given a layout, a template of
+ * the path below it of the file with a symbolic name, so a large archive
+ * can be kept in small directories such as mfp/1992/mfp920504a.cbf and
+ * the file still be named mfp920504a. When several files have the same
+ * name the one of the base directory and extension added first is used.
+ *
+ * The listing of every directory is kept, so looking a name up does not
+ * touch the file system. The directories are read by several threads at
+ * once, using the type of each entry given by readdir rather than a stat
+ * of it. Where inotify is available the directories are watched and a
+ * directory is read again once it changes. Every refresh seconds the
+ * modification time of each directory is checked as well, for file
+ * systems such as NFS where changes made on other hosts are not
+ * reported. Only the directories that changed are read again.
+ */
+class CedarContainerMap
+{
+private:
+    class Dir ;
+    class Scan ;
+
+    vector<string>		_bases ;
+    vector<string>		_extensions ;
+    vector<string>		_layouts ;
+    vector<string>		_roots ;
+    map<string,string>		_paths ;
+    map<string,Dir *>		_dirs ;
+    map<int,string>		_watches ;
+    set<string>			_changed ;
+    time_t			_refresh ;
+    unsigned int		_threads ;
+    time_t			_scanned ;
+    time_t			_checked ;
+    bool			_dirty ;
+    int				_notify ;
+
+    void			read_dirs( Scan &scan, bool parallel ) ;
+    void			read_events() ;
+    void			find_changed() ;
+    void			update() ;
+    void			watch( Dir *d ) ;
+    void			remove( const string &path,
+					set<string> &names ) ;
+    void			add_names( const Dir *d, const string &file,
+					   set<string> &names ) ;
+    bool			in_base( size_t i, const string &rel,
+					 string &path ) const ;
+    void			resolve( const string &sym_name ) ;
+    void			clear() ;
+public:
+    				CedarContainerMap( time_t refresh,
+						   unsigned int threads ) ;
+    virtual			~CedarContainerMap() ;
+
+    virtual void		add_base( const string &base,
+					  const string &extension,
+					  const string &layout = "" ) ;
+    virtual bool		find( const string &sym_name,
+				      string &path ) ;
+    virtual void		check() ;
+    virtual void		scan() ;
+
+    /** @brief true if changes to the directories are being reported */
+    bool			is_watching() const { return _notify >= 0 ; }
+    /** @brief the directories listed */
+    size_t			get_dir_count() const { return _dirs.size() ; }
+    /** @brief the files found, by symbolic name */
+    const map<string,string> &	get_paths() const { return _paths ; }
+
+    static bool			check_layout( const string &layout,
+					      string &error ) ;
+    static bool			expand_layout( const string &layout,
+					       const string &sym_name,
+					       string &path ) ;
+} ;
+
+#endif // I_CedarContainerMap_h
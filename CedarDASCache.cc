@@ -0,0 +1,164 @@
+// CedarDASCache.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sstream>
+#include <iostream>
+
+using std::ostringstream ;
+using std::endl ;
+
+#include "CedarDASCache.h"
+#include "BESDebug.h"
+
+// files whose DAS is kept, all are dropped when there are more
+#define CEDAR_DAS_CACHE_FILES 4096
+
+// tables kept by signature, all are dropped when there are more
+#define CEDAR_DAS_CACHE_FRAGMENTS 4096
+
+map<string,AttrTable *> CedarDASCache::_fragments ;
+map<string,CedarDASCache::CedarDASFile> CedarDASCache::_files ;
+
+/** @brief the signature of a Data_Descriptor_for_KINDAT table, what it is
+ * built from
+ */
+string
+CedarDASCache::get_signature( int kinst, int kindat,
+			      const vector<short int> &jpars,
+			      const vector<short int> &mpars )
+{
+    ostringstream strm ;
+    strm << kinst << " " << kindat << " j" ;
+    for( size_t i = 0; i < jpars.size(); i++ )
+	strm << " " << jpars[i] ;
+    strm << " m" ;
+    for( size_t i = 0; i < mpars.size(); i++ )
+	strm << " " << mpars[i] ;
+    return strm.str() ;
+}
+
+/** @brief the table built for a signature, null if it has not been built
+ */
+const AttrTable *
+CedarDASCache::get_fragment( const string &signature )
+{
+    map<string,AttrTable *>::iterator i = _fragments.find( signature ) ;
+    if( i == _fragments.end() )
+	return 0 ;
+    return i->second ;
+}
+
+/** @brief keep the table built for a signature
+ *
+ * Once CEDAR_DAS_CACHE_FRAGMENTS tables are kept they are all dropped, as
+ * the file DAS are, before this one is added. A file DAS using a dropped
+ * table is then built again, see get_das.
+ *
+ * @param at the table, owned by the cache from now on
+ * @return the table kept for the signature, good until the next table is
+ * added
+ */
+const AttrTable *
+CedarDASCache::add_fragment( const string &signature, AttrTable *at )
+{
+    map<string,AttrTable *>::iterator i = _fragments.find( signature ) ;
+    if( i != _fragments.end() )
+    {
+	delete at ;
+	return i->second ;
+    }
+    if( _fragments.size() >= CEDAR_DAS_CACHE_FRAGMENTS )
+	drop_fragments() ;
+    _fragments[signature] = at ;
+    return at ;
+}
+
+/** @brief drop every table kept by signature
+ */
+void
+CedarDASCache::drop_fragments()
+{
+    map<string,AttrTable *>::iterator i = _fragments.begin() ;
+    for( ; i != _fragments.end(); i++ )
+	delete i->second ;
+    _fragments.clear() ;
+}
+
+/** @brief add the tables of a file's DAS to das
+ *
+ * @param key the cache key of the file's das
+ * @return false if the file's DAS is not kept, or one of its tables has
+ * been dropped
+ */
+bool
+CedarDASCache::get_das( DAS &das, const string &key )
+{
+    if( key.empty() )
+	return false ;
+    map<string,CedarDASFile>::iterator i = _files.find( key ) ;
+    if( i == _files.end() )
+	return false ;
+    const CedarDASFile &file = i->second ;
+    vector<const AttrTable *> tables ;
+    for( size_t t = 0; t < file.signatures.size(); t++ )
+    {
+	const AttrTable *at = get_fragment( file.signatures[t] ) ;
+	if( !at )
+	    return false ;
+	tables.push_back( at ) ;
+    }
+    BESDEBUG( "cedar", "CedarDASCache::get_das - " << key << " kept"
+		       << endl ) ;
+    for( size_t t = 0; t < tables.size(); t++ )
+	das.add_table( file.names[t], new AttrTable( *tables[t] ) ) ;
+    return true ;
+}
+
+/** @brief keep the DAS of a file as the names and signatures of its
+ * tables
+ */
+void
+CedarDASCache::add_das( const string &key, const vector<string> &names,
+                        const vector<string> &signatures )
+{
+    if( key.empty() )
+	return ;
+    if( _files.size() >= CEDAR_DAS_CACHE_FILES )
+	_files.clear() ;
+    CedarDASFile &file = _files[key] ;
+    file.names = names ;
+    file.signatures = signatures ;
+}
+
+/** @brief drop every table and file DAS kept
+ */
+void
+CedarDASCache::Clear()
+{
+    drop_fragments() ;
+    _files.clear() ;
+}
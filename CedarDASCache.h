@@ -0,0 +1,89 @@
+// CedarDASCache.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarDASCache_h
+#define I_CedarDASCache_h 1
+
+#include <map>
+#include <vector>
+#include <string>
+
+using std::map ;
+using std::vector ;
+using std::string ;
+
+#include "DAS.h"
+
+using namespace libdap ;
+
+/** @brief attribute tables kept across requests
+ *
+ * Building a Data_Descriptor_for_KINDAT table looks up the instrument and
+ * every parameter in the catalog. The finished table, a fragment, is kept
+ * keyed by its signature: the KINST, the KINDAT and the JPAR and MPAR
+ * codes it was built from. It is copied into the DAS of every later
+ * request with the same signature.
+ *
+ * The DAS of a whole file is kept as the names and signatures of its
+ * fragments, keyed by the cache key of the file's das, so it changes with
+ * the file. A file in the cache gets its DAS without being opened.
+ *
+ * Both are dropped when the catalog is refreshed, see CedarCatalog, and
+ * each is dropped when too many are kept.
+ */
+class CedarDASCache
+{
+private:
+    typedef struct _cedar_das_file
+    {
+	vector<string> names ;
+	vector<string> signatures ;
+    } CedarDASFile ;
+
+    static map<string,AttrTable *> _fragments ;
+    static map<string,CedarDASCache::CedarDASFile> _files ;
+
+				CedarDASCache() {}
+
+    static void			drop_fragments() ;
+public:
+    static string		get_signature( int kinst, int kindat,
+					       const vector<short int> &jpars,
+					       const vector<short int> &mpars ) ;
+    static const AttrTable *	get_fragment( const string &signature ) ;
+    static const AttrTable *	add_fragment( const string &signature,
+					      AttrTable *at ) ;
+
+    static bool			get_das( DAS &das, const string &key ) ;
+    static void			add_das( const string &key,
+					 const vector<string> &names,
+					 const vector<string> &signatures ) ;
+
+    static void			Clear() ;
+} ;
+
+#endif // I_CedarDASCache_h
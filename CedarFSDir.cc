@@ -8,9 +8,11 @@
 #endif
 #include <stdio.h>
 #include <iostream>
+#include <memory>
 
 using std::cout ;
 using std::endl ;
+using std::auto_ptr ;
 
 #include "CedarFSDir.h"
 #include "GNURegex.h"
@@ -84,44 +86,61 @@ CedarFSDir::loadDir()
     DIR * dip;
     struct dirent *dit;
 
+    // the expression is compiled once for the whole directory, before the
+    // directory is opened so a bad expression leaves nothing open
+    auto_ptr<Regex> reg_expr ;
+    if (_fileExpr != "") {
+        reg_expr.reset(new Regex(_fileExpr.c_str())) ;
+    }
+
     // open a directory stream
     // make sure the directory is valid and readable
     if ((dip = opendir(_dirName.c_str())) == NULL) {
         string err_str = "ERROR: failed to open directory '" + _dirName + "'" ;
         throw err_str ;
     }
-    else {
-        // read in the files in this directory
-        // add each filename to the list of filenames
+
+    // read in the files in this directory
+    // add each filename to the list of filenames, closing the directory
+    // if adding one throws
+    try {
         while ((dit = readdir(dip)) != NULL) {
-            struct stat buf;
             string dirEntry = dit->d_name ;
-            if (dirEntry != "." && dirEntry != "..") {
+            if (dirEntry == "." || dirEntry == "..") {
+                continue ;
+            }
+
+            // use the type readdir gives, only stat the entry when the
+            // file system does not give it or the entry is a link
+            bool isDir = false ;
+#ifdef _DIRENT_HAVE_D_TYPE
+            isDir = (dit->d_type == DT_DIR) ;
+            if (dit->d_type == DT_UNKNOWN || dit->d_type == DT_LNK)
+#endif
+            {
+                struct stat buf;
                 string fullPath = _dirName + "/" + dirEntry ;
-                stat(fullPath.c_str(), &buf) ;
-
-                // look at the mode and determine if this is a filename
-                // or a directory name
-                if (S_ISDIR(buf.st_mode)) {
-                    _dirList.push_back(CedarFSDir(fullPath)) ;
-                }
-                else {
-                    if (_fileExpr != "") {
-                        Regex reg_expr(_fileExpr.c_str()) ;
-                        if (reg_expr.match(dirEntry.c_str(),
-                                           dirEntry.length()) != -1) {
-                            _fileList.push_back(CedarFSFile(_dirName, dirEntry));
-                        }
-                    }
-                    else {
-                        _fileList.push_back(CedarFSFile(_dirName, dirEntry)) ;
-                    }
-                }
+                isDir = (stat(fullPath.c_str(), &buf) == 0
+                         && S_ISDIR(buf.st_mode)) ;
+            }
+
+            // look at the mode and determine if this is a filename
+            // or a directory name
+            if (isDir) {
+                _dirList.push_back(CedarFSDir(_dirName + "/" + dirEntry)) ;
+            }
+            else if (!reg_expr.get()
+                     || reg_expr->match(dirEntry.c_str(),
+                                        dirEntry.length()) != -1) {
+                _fileList.push_back(CedarFSFile(_dirName, dirEntry)) ;
             }
         }
     }
+    catch (...) {
+        closedir(dip) ;
+        throw ;
+    }
 
     // close the directory
     closedir(dip) ;
 }
-
@@ -0,0 +1,488 @@
+// CedarFileCache.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <utime.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+
+using std::vector ;
+using std::sort ;
+using std::endl ;
+
+#include "config_cedar.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "CedarFileCache.h"
+#include "BESInternalError.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+// megabytes kept in the cache when Cedar.FileCache.Size is not set
+#define CEDAR_FILE_CACHE_SIZE 10240
+
+// seconds a file found unchanged is not looked at again when
+// Cedar.FileCache.Validate is not set
+#define CEDAR_FILE_CACHE_VALIDATE 60
+
+// bytes copied at a time
+#define CEDAR_FILE_CACHE_CHUNK 65536
+
+CedarFileCache *CedarFileCache::_the_cache = 0 ;
+bool CedarFileCache::_configured = false ;
+
+/** @brief a cache in dir
+ *
+ * @param dir the cache directory, which must exist
+ * @param size bytes kept in the cache
+ * @param validate seconds a file found unchanged is not looked at again
+ */
+CedarFileCache::CedarFileCache( const string &dir, unsigned long long size,
+                                time_t validate )
+    : _dir( dir ),
+      _size( size ),
+      _validate( validate )
+{
+}
+
+/** @brief where the copy of origin is kept
+ */
+string
+CedarFileCache::get_path( const string &origin ) const
+{
+    if( !origin.empty() && origin[0] == '/' )
+	return _dir + origin ;
+    return _dir + "/" + origin ;
+}
+
+/** @brief the path to read origin from
+ *
+ * The copy of origin if it is in the cache and up to date, otherwise
+ * origin itself, in which case copying it is started.
+ */
+string
+CedarFileCache::get( const string &origin )
+{
+    string path = get_path( origin ) ;
+    time_t now = time( 0 ) ;
+    struct stat st ;
+    struct stat local ;
+    if( stat( path.c_str(), &local ) != 0 )
+    {
+	_validated.erase( origin ) ;
+	if( stat( origin.c_str(), &st ) == 0 && S_ISREG( st.st_mode ) )
+	    start( origin, st ) ;
+	return origin ;
+    }
+
+    map<string,time_t>::iterator i = _validated.find( origin ) ;
+    if( i == _validated.end() || now - i->second >= _validate )
+    {
+	if( stat( origin.c_str(), &st ) != 0 )
+	{
+	    // the original is gone, so is the copy
+	    BESDEBUG( "cedar", "CedarFileCache::get - " << origin
+			       << " removed" << endl ) ;
+	    unlink( path.c_str() ) ;
+	    _validated.erase( origin ) ;
+	    return origin ;
+	}
+	if( st.st_mtime != local.st_mtime || st.st_size != local.st_size )
+	{
+	    BESDEBUG( "cedar", "CedarFileCache::get - " << origin
+			       << " changed" << endl ) ;
+	    unlink( path.c_str() ) ;
+	    _validated.erase( origin ) ;
+	    start( origin, st ) ;
+	    return origin ;
+	}
+	_validated[origin] = now ;
+    }
+
+    // the access time orders the copies for eviction
+    if( local.st_atime < now )
+    {
+	struct utimbuf times ;
+	times.actime = now ;
+	times.modtime = local.st_mtime ;
+	utime( path.c_str(), &times ) ;
+    }
+    return path ;
+}
+
+/** @brief create the .part file of the copy at path, locked
+ *
+ * The .part file is made under another name, locked, then linked into
+ * place, so it is never seen unlocked while being written. A .part file
+ * left by a copy that did not finish is not locked, it is removed and the
+ * file copied by the next request for it.
+ *
+ * @return the open .part file, or -1 if the file is being copied already
+ * or the .part file can not be made
+ */
+int
+CedarFileCache::claim( const string &path ) const
+{
+    // the directories of the path below the cache directory
+    for( string::size_type s = path.find( '/', _dir.length() + 1 );
+	 s != string::npos; s = path.find( '/', s + 1 ) )
+    {
+	if( mkdir( path.substr( 0, s ).c_str(), 0755 ) != 0
+	    && errno != EEXIST )
+	{
+	    return -1 ;
+	}
+    }
+
+    string part = path + ".part" ;
+    string tmp = path + ".XXXXXX" ;
+    vector<char> name( tmp.begin(), tmp.end() ) ;
+    name.push_back( '\0' ) ;
+    int fd = mkstemp( &name[0] ) ;
+    if( fd < 0 )
+	return -1 ;
+    flock( fd, LOCK_EX ) ;
+    if( link( &name[0], part.c_str() ) != 0 )
+    {
+	unlink( &name[0] ) ;
+	close( fd ) ;
+	int pfd = open( part.c_str(), O_RDONLY ) ;
+	if( pfd >= 0 )
+	{
+	    if( flock( pfd, LOCK_EX|LOCK_NB ) == 0 )
+		unlink( part.c_str() ) ;
+	    close( pfd ) ;
+	}
+	return -1 ;
+    }
+    unlink( &name[0] ) ;
+    return fd ;
+}
+
+/** @brief copy origin into the claimed .part file fd and rename it into
+ * place at path
+ *
+ * The copy is thrown away if origin changes while it is copied. fd is
+ * closed, releasing the lock.
+ *
+ * @return true if the copy is in place
+ */
+bool
+CedarFileCache::fill( const string &origin, int fd,
+                      const string &path ) const
+{
+    string part = path + ".part" ;
+    bool ok = false ;
+    int in = open( origin.c_str(), O_RDONLY ) ;
+    struct stat before ;
+    if( in >= 0 && fstat( in, &before ) == 0 )
+    {
+	ok = true ;
+	char buf[CEDAR_FILE_CACHE_CHUNK] ;
+	ssize_t n = 0 ;
+	while( ok && ( n = read( in, buf, sizeof buf ) ) != 0 )
+	{
+	    if( n < 0 )
+	    {
+		ok = ( errno == EINTR ) ;
+		continue ;
+	    }
+	    for( ssize_t done = 0; ok && done < n; )
+	    {
+		ssize_t w = write( fd, buf + done, n - done ) ;
+		if( w < 0 && errno != EINTR )
+		    ok = false ;
+		else if( w > 0 )
+		    done += w ;
+	    }
+	}
+	struct stat after ;
+	if( ok && ( fstat( in, &after ) != 0
+		    || after.st_mtime != before.st_mtime
+		    || after.st_size != before.st_size ) )
+	{
+	    ok = false ;
+	}
+	if( ok )
+	{
+	    struct utimbuf times ;
+	    times.actime = time( 0 ) ;
+	    times.modtime = before.st_mtime ;
+	    ok = fchmod( fd, 0644 ) == 0
+		 && utime( part.c_str(), &times ) == 0
+		 && rename( part.c_str(), path.c_str() ) == 0 ;
+	}
+    }
+    if( in >= 0 )
+	close( in ) ;
+    if( !ok )
+	unlink( part.c_str() ) ;
+    close( fd ) ;
+    return ok ;
+}
+
+// a copy started by CedarFileCache::start, owned by the thread making it
+struct CedarFileCacheCopy
+{
+    CedarFileCache *		cache ;
+    string			origin ;
+    string			path ;
+    int				fd ;
+} ;
+
+/** @brief make the copy described by arg, a CedarFileCacheCopy
+ *
+ * Run on the thread started by start, the copy is deleted when done.
+ */
+void *
+CedarFileCache::run_copy( void *arg )
+{
+    CedarFileCacheCopy *copy = (CedarFileCacheCopy *)arg ;
+    try
+    {
+	if( copy->cache->fill( copy->origin, copy->fd, copy->path ) )
+	    copy->cache->purge() ;
+    }
+    catch( ... )
+    {
+    }
+    delete copy ;
+    return 0 ;
+}
+
+/** @brief start copying origin in the background
+ *
+ * The copy is made on a detached thread so the request does not wait for
+ * it. If the thread can not be started, or there are no threads, the copy
+ * is made before the request goes on. Files larger than the cache are not
+ * copied.
+ */
+void
+CedarFileCache::start( const string &origin, const struct stat &st )
+{
+    if( (unsigned long long)st.st_size > _size )
+	return ;
+    string path = get_path( origin ) ;
+    int fd = claim( path ) ;
+    if( fd < 0 )
+	return ;
+
+    BESDEBUG( "cedar", "CedarFileCache::start - copying " << origin
+		       << " to " << path << endl ) ;
+    CedarFileCacheCopy *copy = new CedarFileCacheCopy ;
+    copy->cache = this ;
+    copy->origin = origin ;
+    copy->path = path ;
+    copy->fd = fd ;
+#ifdef HAVE_PTHREAD
+    pthread_attr_t attr ;
+    pthread_attr_init( &attr ) ;
+    pthread_attr_setdetachstate( &attr, PTHREAD_CREATE_DETACHED ) ;
+    pthread_t thread ;
+    int ret = pthread_create( &thread, &attr, run_copy, copy ) ;
+    pthread_attr_destroy( &attr ) ;
+    if( ret == 0 )
+	return ;
+    BESDEBUG( "cedar", "CedarFileCache::start - no thread for the copy, "
+		       << "copying now" << endl ) ;
+#endif
+    run_copy( copy ) ;
+}
+
+/** @brief copy origin into the cache now
+ *
+ * @return true if the copy is in place, false if origin can not be read,
+ * is larger than the cache or is being copied by another thread or process
+ */
+bool
+CedarFileCache::copy( const string &origin )
+{
+    struct stat st ;
+    if( stat( origin.c_str(), &st ) != 0 || !S_ISREG( st.st_mode )
+	|| (unsigned long long)st.st_size > _size )
+    {
+	return false ;
+    }
+    string path = get_path( origin ) ;
+    int fd = claim( path ) ;
+    if( fd < 0 )
+	return false ;
+    if( !fill( origin, fd, path ) )
+	return false ;
+    purge() ;
+    return true ;
+}
+
+struct CedarFileCacheEntry
+{
+    string			path ;
+    time_t			used ;
+    unsigned long long		size ;
+
+    bool operator<( const CedarFileCacheEntry &e ) const { return used < e.used ; }
+} ;
+
+// every copy below dir, .part files being written left out
+static void
+list_copies( const string &dir, vector<CedarFileCacheEntry> &entries,
+             unsigned long long &total )
+{
+    DIR *d = opendir( dir.c_str() ) ;
+    if( !d )
+	return ;
+    struct dirent *ent = 0 ;
+    while( ( ent = readdir( d ) ) )
+    {
+	string name = ent->d_name ;
+	if( name == "." || name == ".." )
+	    continue ;
+	string path = dir + "/" + name ;
+	struct stat st ;
+	if( lstat( path.c_str(), &st ) != 0 )
+	    continue ;
+	if( S_ISDIR( st.st_mode ) )
+	{
+	    list_copies( path, entries, total ) ;
+	    continue ;
+	}
+	if( !S_ISREG( st.st_mode ) )
+	    continue ;
+	string::size_type dot = name.rfind( '.' ) ;
+	if( dot != string::npos && name.substr( dot ) == ".part" )
+	    continue ;
+	CedarFileCacheEntry e ;
+	e.path = path ;
+	e.used = st.st_atime ;
+	e.size = st.st_size ;
+	entries.push_back( e ) ;
+	total += e.size ;
+    }
+    closedir( d ) ;
+}
+
+/** @brief remove the copies read least recently until the cache is no
+ * larger than its size
+ *
+ * A copy still being read is only removed from the directory, the
+ * request reading it keeps it open.
+ */
+void
+CedarFileCache::purge()
+{
+    vector<CedarFileCacheEntry> entries ;
+    unsigned long long total = 0 ;
+    list_copies( _dir, entries, total ) ;
+    if( total <= _size )
+	return ;
+
+    sort( entries.begin(), entries.end() ) ;
+    for( size_t i = 0; i < entries.size() && total > _size; i++ )
+    {
+	if( unlink( entries[i].path.c_str() ) == 0 )
+	    total -= entries[i].size ;
+    }
+}
+
+/** @brief the file cache, configured from Cedar.FileCache.Dir,
+ * Cedar.FileCache.Size and Cedar.FileCache.Validate
+ *
+ * @return the cache, or null if Cedar.FileCache.Dir is not set
+ * @throws BESInternalError if the cache directory can not be used
+ */
+CedarFileCache *
+CedarFileCache::TheCache()
+{
+    if( _configured )
+	return _the_cache ;
+    _configured = true ;
+
+    bool found = false ;
+    string dir ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.FileCache.Dir", dir, found ) ;
+    if( !found || dir.empty() )
+	return 0 ;
+    while( dir.length() > 1 && dir[dir.length() - 1] == '/' )
+	dir.erase( dir.length() - 1 ) ;
+
+    unsigned long long size = CEDAR_FILE_CACHE_SIZE ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.FileCache.Size", value, found ) ;
+    if( found && !value.empty() )
+	size = strtoull( value.c_str(), 0, 10 ) ;
+
+    time_t validate = CEDAR_FILE_CACHE_VALIDATE ;
+    value = "" ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.FileCache.Validate", value,
+				      found ) ;
+    if( found && !value.empty() )
+	validate = strtol( value.c_str(), 0, 10 ) ;
+
+    if( mkdir( dir.c_str(), 0755 ) != 0 && errno != EEXIST )
+    {
+	string err = (string)"Failed to create the file cache directory "
+		     + dir + ": " + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    if( access( dir.c_str(), R_OK|W_OK|X_OK ) != 0 )
+    {
+	string err = (string)"Can not use the file cache directory " + dir
+		     + ": " + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+
+    BESDEBUG( "cedar", "CedarFileCache::TheCache - " << dir << ", "
+		       << size << " MB, validated every " << validate
+		       << " seconds" << endl ) ;
+    _the_cache = new CedarFileCache( dir, size * 1024 * 1024, validate ) ;
+    return _the_cache ;
+}
+
+/** @brief the path to read the cedar file origin from, its copy in the
+ * file cache if there is one
+ */
+string
+CedarFileCache::get_file( const string &origin )
+{
+    CedarFileCache *cache = TheCache() ;
+    if( !cache )
+	return origin ;
+    return cache->get( origin ) ;
+}
@@ -0,0 +1,101 @@
+// CedarFileCache.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarFileCache_h
+#define I_CedarFileCache_h 1
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <string>
+#include <map>
+
+using std::string ;
+using std::map ;
+
+/** @brief a size bounded copy on local disk of the cedar files read from
+ * slow shared storage
+ *
+ * The copy of a file is kept below the cache directory at the path of the
+ * file, so /data/cedar/mfp920504a.cbf is kept as
+ * dir/data/cedar/mfp920504a.cbf, with the modification time of the
+ * original. The first request for a file reads the original and starts
+ * copying it in the background, on a thread of its own so the request
+ * does not wait for the copy. Later requests read the copy.
+ *
+ * A copy is good while the original has the same modification time and
+ * size. The original is only looked at again once validate seconds have
+ * passed since it was last found unchanged, in between a file read often
+ * never touches the shared storage. A copy found out of date is removed
+ * and copied again.
+ *
+ * The copy is written into a .part file, locked while it is written, and
+ * renamed into place once whole, so only one thread or process copies a
+ * file and a copy is never read half written. A copy cut short because
+ * its process ended leaves its .part file unlocked, the next request for
+ * the file removes it and copies again. Reading a copy touches its access
+ * time, when the cache grows past its size the copies read least recently
+ * are removed.
+ */
+class CedarFileCache
+{
+private:
+    string			_dir ;
+    unsigned long long		_size ;
+    time_t			_validate ;
+    map<string,time_t>		_validated ;
+
+    static CedarFileCache *	_the_cache ;
+    static bool			_configured ;
+
+    int				claim( const string &path ) const ;
+    bool			fill( const string &origin, int fd,
+				      const string &path ) const ;
+    void			start( const string &origin,
+				       const struct stat &st ) ;
+    static void *		run_copy( void *arg ) ;
+public:
+    				CedarFileCache( const string &dir,
+						unsigned long long size,
+						time_t validate ) ;
+    virtual			~CedarFileCache() {}
+
+    const string &		get_dir() const { return _dir ; }
+    unsigned long long		get_size() const { return _size ; }
+    time_t			get_validate() const { return _validate ; }
+
+    string			get_path( const string &origin ) const ;
+    virtual string		get( const string &origin ) ;
+    virtual bool		copy( const string &origin ) ;
+    virtual void		purge() ;
+
+    static CedarFileCache *	TheCache() ;
+    static string		get_file( const string &origin ) ;
+} ;
+
+#endif // I_CedarFileCache_h
@@ -82,6 +82,41 @@ void CedarFilter::set_response(const string &r) throw(Error)
 	d_response = (DODSFilter::Response)CedarFilter::INFO_Response;
 	d_action = INFO_RESPONSE ;
     }
+    else if (r == "CBF" || r == "cbf")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::CBF_Response;
+	d_action = CBF_RESPONSE ;
+    }
+    else if (r == "NETCDF" || r == "netcdf")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::NETCDF_Response;
+	d_action = NETCDF_RESPONSE ;
+    }
+    else if (r == "ARROW" || r == "arrow")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::ARROW_Response;
+	d_action = ARROW_RESPONSE ;
+    }
+    else if (r == "CSV" || r == "csv")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::CSV_Response;
+	d_action = CSV_RESPONSE ;
+    }
+    else if (r == "JSONL" || r == "jsonl")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::JSONL_Response;
+	d_action = JSONL_RESPONSE ;
+    }
+    else if (r == "SIZE" || r == "size")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::SIZE_Response;
+	d_action = SIZE_RESPONSE ;
+    }
+    else if (r == "ARCHIVE" || r == "archive")
+    {
+	d_response = (DODSFilter::Response)CedarFilter::ARCHIVE_Response;
+	d_action = ARCHIVE_RESPONSE ;
+    }
     else
 	DODSFilter::set_response( r ) ;
 }
@@ -53,7 +53,14 @@ public:
 	TAB_Response = DODSFilter::Version_Response + 1,
 	FLAT_Response,
 	STREAM_Response,
-	INFO_Response
+	INFO_Response,
+	CBF_Response,
+	NETCDF_Response,
+	ARROW_Response,
+	CSV_Response,
+	JSONL_Response,
+	SIZE_Response,
+	ARCHIVE_Response
     };
 
 public:
@@ -31,6 +31,7 @@
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
 #include <iostream>
+#include <stdio.h>
 
 using std::cout ;
 
@@ -39,9 +40,13 @@ using std::cout ;
 #endif
 
 #include "CedarFlat.h"
+#include "CedarRawOutput.h"
 
 CedarFlat::CedarFlat( bool is_http, ostream *strm )
-    : BESTextInfo( "Cedar.Flat.Buffered", strm, false, is_http )
+    : BESTextInfo( "Cedar.Flat.Buffered", strm, false, false ),
+      _is_http( is_http ),
+      _header( false ),
+      _length( (unsigned long long)-1 )
 {
 }
 
@@ -49,6 +54,54 @@ CedarFlat::~CedarFlat()
 {
 }
 
+/** @brief write the HTTP header once, with the Content-Length if it has
+ * been set
+ */
+void
+CedarFlat::write_header( ostream &strm )
+{
+    if( _is_http && !_header )
+    {
+	strm << CedarRawOutput::get_http_header( "text/plain", "", "", false,
+						 _length, _range ) ;
+	_header = true ;
+    }
+}
+
+/** @brief only bytes first through last of the total bytes of the
+ * product are sent
+ */
+void
+CedarFlat::set_range( unsigned long long first, unsigned long long last,
+                      unsigned long long total )
+{
+    char range[80] ;
+    snprintf( range, sizeof range, "bytes %llu-%llu/%llu",
+	      first, last, total ) ;
+    _range = range ;
+    _length = last - first + 1 ;
+}
+
+/** @brief an unbuffered product is written as it is added, after the
+ * header
+ */
+void
+CedarFlat::add_data( const string &s )
+{
+    if( !_buffered )
+	write_header( _strm ? *_strm : cout ) ;
+    BESTextInfo::add_data( s ) ;
+}
+
+/** @brief a buffered product is written now, after the header
+ */
+void
+CedarFlat::print( ostream &strm )
+{
+    write_header( strm ) ;
+    BESTextInfo::print( strm ) ;
+}
+
 /** @brief dumps information about this object
  *
  * Displays the pointer value of this instance and calls dump on the parent
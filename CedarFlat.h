@@ -35,11 +35,37 @@
 
 #include "BESTextInfo.h"
 
+/** @brief the flat product
+ *
+ * The HTTP header is written here rather than by BESTextInfo so that it
+ * can carry the Content-Length of the product when that is known before
+ * the product is formatted, and the Content-Range when only part of it
+ * is sent.
+ */
 class CedarFlat : public BESTextInfo {
+private:
+    bool		_is_http ;
+    bool		_header ;
+    unsigned long long	_length ;
+    string		_range ;
+
+    void		write_header( ostream &strm ) ;
 public:
   			CedarFlat( bool is_http, ostream *strm ) ;
     virtual 		~CedarFlat() ;
 
+    bool		is_http() const { return _is_http ; }
+    void		set_length( unsigned long long length )
+			{
+			    _length = length ;
+			}
+    virtual void	set_range( unsigned long long first,
+				   unsigned long long last,
+				   unsigned long long total ) ;
+
+    virtual void	add_data( const string &s ) ;
+    virtual void	print( ostream &strm ) ;
+
     virtual void	dump( ostream &strm ) const ;
 };
 
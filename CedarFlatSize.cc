@@ -0,0 +1,132 @@
+// CedarFlatSize.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdio.h>
+
+#include "CedarFlatSize.h"
+#include "CedarTextFormat.h"
+#include "CedarRawFile.h"
+#include "CedarRecordSelection.h"
+#include "CedarReadParcods.h"
+#include "CedarException.h"
+#include "cedar_read_descriptors.h"
+
+// prologue words and NROWS that start every line of the flat product
+#define FLAT_PROLOGUE_COLUMNS 11
+
+/** @brief make sure the name, scale and units of a parameter fit in a
+ * column of the flat product
+ *
+ * @throws CedarException if one does not
+ */
+void
+CedarFlatSize::check( int code )
+{
+    if( _checked.find( code ) != _checked.end() )
+	return ;
+    _checked.insert( code ) ;
+
+    string name ;
+    get_name_for_parameter( name, code ) ;
+    int par = code < 0 ? -code : code ;
+    string labels[3] = { name,
+			 CedarReadParcods::Get_Scale( par ),
+			 CedarReadParcods::Get_Unit_Label( par ) } ;
+    for( int i = 0; i < 3; i++ )
+    {
+	if( labels[i].length() > PRINTING_BLOCK_SIZE )
+	{
+	    char errs[256] ;
+	    snprintf( errs, sizeof errs, "%s %d\n%s %s\n",
+		      "Trying to print block larger than",
+		      PRINTING_BLOCK_SIZE,
+		      "Current block is ", labels[i].c_str() ) ;
+	    throw CedarException( 0, errs ) ;
+	}
+    }
+}
+
+/** @brief bytes in each line of the block of a record, the prologue and
+ * selected parameter columns and the newline
+ */
+unsigned long long
+CedarFlatSize::line_bytes( const CedarRecordSelection &sel )
+{
+    unsigned long long cols = FLAT_PROLOGUE_COLUMNS + sel.get_jpar().size()
+			      + sel.get_mpar().size() ;
+    return cols * PRINTING_BLOCK_SIZE + 1 ;
+}
+
+/** @brief size the flat product of the records of the files that
+ * satisfy qa
+ */
+void
+CedarFlatSize::read( const vector<string> &files,
+                     CedarConstraintEvaluator &qa )
+{
+    _open = false ;
+    _bytes = 0 ;
+    _records = 0 ;
+    _rows = 0 ;
+    CedarRecordReader::read( files, qa ) ;
+    // the blank lines that end the last block of a compact product
+    if( _open )
+	_bytes += 2 ;
+}
+
+void
+CedarFlatSize::data_record( const CedarRawRecord &rec,
+                            const CedarRecordSelection &sel )
+{
+    const vector<int> &jpar = sel.get_jpar() ;
+    const vector<int> &mpar = sel.get_mpar() ;
+    unsigned long long line = line_bytes( sel ) ;
+
+    bool header = true ;
+    if( _compact )
+	header = schema_changed( rec, sel ) ;
+    if( header )
+    {
+	size_t i = 0 ;
+	for( i = 0; i < jpar.size(); i++ )
+	    check( rec.get_jpar_code( jpar[i] ) ) ;
+	for( i = 0; i < mpar.size(); i++ )
+	    check( rec.get_mpar_code( mpar[i] ) ) ;
+	// names, scales, units and codes
+	_bytes += 4 * line ;
+	if( _compact && _open )
+	    _bytes += 2 ;
+	_open = _compact ;
+    }
+
+    unsigned int rows = sel.get_selected_rows() ;
+    _bytes += rows * line ;
+    if( !_compact )
+	_bytes += 2 ;
+    _records++ ;
+    _rows += rows ;
+}
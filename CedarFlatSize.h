@@ -0,0 +1,83 @@
+// CedarFlatSize.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarFlatSize_h
+#define I_CedarFlatSize_h 1
+
+#include <set>
+
+using std::set ;
+
+#include "CedarRecordReader.h"
+
+/** @brief the exact size of the flat product, found without formatting it
+ *
+ * Every column of the flat product is PRINTING_BLOCK_SIZE characters wide
+ * and every line of a record has a column for each prologue word and
+ * selected parameter, so the size follows from the number of selected
+ * parameters and rows of each record. The names, scales and units of the
+ * parameters are checked to fit their columns, as the flat product would
+ * fail on them.
+ */
+class CedarFlatSize : public CedarRecordReader
+{
+private:
+    bool			_compact ;
+    bool			_open ;
+    unsigned long long		_bytes ;
+    unsigned long		_records ;
+    unsigned long		_rows ;
+    set<int>			_checked ;
+
+    void			check( int code ) ;
+public:
+    				CedarFlatSize( bool compact = false )
+				    : _compact( compact ),
+				      _open( false ),
+				      _bytes( 0 ),
+				      _records( 0 ),
+				      _rows( 0 ) {}
+    virtual			~CedarFlatSize() {}
+
+    virtual void		read( const vector<string> &files,
+				      CedarConstraintEvaluator &qa ) ;
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) ;
+    /** @brief sizing a record costs less than handing it to a thread */
+    virtual bool		is_staged() const { return false ; }
+
+    static unsigned long long	line_bytes( const CedarRecordSelection &sel ) ;
+
+    /** @brief bytes in the flat product */
+    unsigned long long		get_bytes() const { return _bytes ; }
+    /** @brief records in the flat product */
+    unsigned long		get_records() const { return _records ; }
+    /** @brief rows in the flat product */
+    unsigned long		get_rows() const { return _rows ; }
+} ;
+
+#endif // I_CedarFlatSize_h
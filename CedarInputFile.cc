@@ -0,0 +1,917 @@
+// CedarInputFile.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <utime.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <algorithm>
+
+using std::endl ;
+using std::sort ;
+
+#include "CedarInputFile.h"
+#include "CedarStageQueue.h"
+#include "CedarCache.h"
+#include "BESInternalError.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+// compressed bytes read from the file at a time
+#define CEDAR_INPUT_CHUNK 65536
+
+// data deflate can refer back to, kept with every gzip checkpoint
+#define CEDAR_INPUT_WINDOW 32768
+
+// megabytes of decompressed copies kept when Cedar.Compressed.Size is not
+// set
+#define CEDAR_PLAIN_FILE_SIZE 1024
+
+/** @brief open filename and find how it is compressed
+ *
+ * @throws BESInternalError if the file can not be opened, or is
+ * compressed in a way the module was built without
+ */
+CedarInputFile::CedarInputFile( const string &filename )
+    : _filename( filename ),
+      _fd( -1 ),
+      _compression( PLAIN ),
+      _in( 0 ),
+      _out( 0 ),
+      _end( false ),
+      _points( 0 ),
+      _span( 0 )
+#ifdef HAVE_LIBZ
+      , _z_open( false ),
+      _raw( false ),
+      _win_pos( 0 ),
+      _avail_pos( 0 ),
+      _avail_end( 0 ),
+      _inflated( 0 )
+#endif
+#ifdef HAVE_ZSTD
+      , _zds( 0 ),
+      _frame( false )
+#endif
+      , _ahead( 0 ),
+      _reading( false ),
+      _chunk_pos( 0 ),
+      _pos( 0 ),
+      _moved( false )
+{
+    _fd = open( filename.c_str(), O_RDONLY ) ;
+    if( _fd < 0 )
+    {
+	string err = "can not open file " + filename ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+
+    unsigned char magic[4] ;
+    ssize_t got = 0 ;
+    while( ( got = pread( _fd, magic, sizeof magic, 0 ) ) < 0
+	   && errno == EINTR ) ;
+    if( got >= 2 && magic[0] == 0x1f && magic[1] == 0x8b )
+	_compression = GZIP ;
+    else if( got == 4 && magic[0] == 0x28 && magic[1] == 0xb5
+	     && magic[2] == 0x2f && magic[3] == 0xfd )
+	_compression = ZSTD ;
+
+    string err ;
+    if( _compression == GZIP )
+    {
+#ifdef HAVE_LIBZ
+	_window.resize( CEDAR_INPUT_WINDOW ) ;
+	start_gzip( 0 ) ;
+#else
+	err = "can not read file " + filename
+	      + ", the module was built without gzip support" ;
+#endif
+    }
+    else if( _compression == ZSTD )
+    {
+#ifdef HAVE_ZSTD
+	_zds = ZSTD_createDStream() ;
+	if( !_zds )
+	    err = "failed to start zstd decompression of " + filename ;
+	else
+	    start_zstd( 0 ) ;
+#else
+	err = "can not read file " + filename
+	      + ", the module was built without zstd support" ;
+#endif
+    }
+    if( !err.empty() )
+    {
+	close( _fd ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    if( _compression != PLAIN )
+	_buf.resize( CEDAR_INPUT_CHUNK ) ;
+    BESDEBUG( "cedar", "CedarInputFile - " << filename << " is "
+		       << ( _compression == GZIP ? "gzip compressed"
+			    : _compression == ZSTD ? "zstd compressed"
+			    : "not compressed" ) << endl ) ;
+}
+
+CedarInputFile::~CedarInputFile()
+{
+    read_ahead( 0 ) ;
+#ifdef HAVE_LIBZ
+    if( _z_open )
+	inflateEnd( &_z ) ;
+#endif
+#ifdef HAVE_ZSTD
+    if( _zds )
+	ZSTD_freeDStream( _zds ) ;
+#endif
+    close( _fd ) ;
+}
+
+void
+CedarInputFile::corrupted( const string &why ) const
+{
+    string err = (string)"Failure reading data from file " + _filename
+                 + ", " + why ;
+    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+}
+
+/** @brief read the next compressed bytes into the input buffer
+ *
+ * @return bytes read, 0 at the end of the file
+ */
+size_t
+CedarInputFile::fill()
+{
+    ssize_t got = 0 ;
+    while( ( got = ::read( _fd, &_buf[0], _buf.size() ) ) < 0
+	   && errno == EINTR ) ;
+    if( got < 0 )
+	corrupted( strerror( errno ) ) ;
+    _in += got ;
+    return got ;
+}
+
+/** @brief read up to len bytes of the decompressed data
+ *
+ * @return bytes read, fewer than len only at the end of the data
+ * @throws BESInternalError if the file can not be read or does not
+ * decompress
+ */
+size_t
+CedarInputFile::read( char *buf, size_t len )
+{
+    if( !_ahead )
+    {
+	resume() ;
+	return read_input( buf, len ) ;
+    }
+
+#ifdef HAVE_PTHREAD
+    if( !_reading )
+    {
+	resume() ;
+	if( pthread_create( &_thread, 0, start_ahead, this ) != 0 )
+	{
+	    // read as it is needed after all
+	    delete _ahead ;
+	    _ahead = 0 ;
+	    return read_input( buf, len ) ;
+	}
+	_reading = true ;
+    }
+#endif
+
+    size_t done = 0 ;
+    while( done < len )
+    {
+	if( _chunk_pos == _chunk.len )
+	{
+	    _chunk.len = 0 ;
+	    _chunk_pos = 0 ;
+	    if( !_ahead->get( _chunk ) )
+	    {
+		if( !_ahead_error.empty() )
+		    throw BESInternalError( _ahead_error, __FILE__, __LINE__ ) ;
+		break ;
+	    }
+	}
+	size_t n = _chunk.len - _chunk_pos ;
+	if( n > len - done )
+	    n = len - done ;
+	memcpy( buf + done, &_chunk.data[_chunk_pos], n ) ;
+	_chunk_pos += n ;
+	done += n ;
+    }
+    _pos += done ;
+    return done ;
+}
+
+/** @brief read the file ahead, and decompress it, on a thread of its own,
+ * up to chunks blocks of 64K ahead of the data handed out
+ *
+ * The thread starts with the first read and is stopped by seek, to start
+ * again from the new offset. Checkpoints are recorded by the thread, a
+ * table of them is only complete once reading ahead is stopped. Without
+ * threads the file is read as it is needed.
+ *
+ * @param chunks blocks read ahead, 0 to stop reading ahead
+ */
+void
+CedarInputFile::read_ahead( size_t chunks )
+{
+    if( _ahead )
+    {
+	stop_ahead() ;
+	delete _ahead ;
+	_ahead = 0 ;
+	_moved = _out != _pos ;
+    }
+#ifdef HAVE_PTHREAD
+    if( chunks )
+    {
+	_ahead = new CedarStageQueue<Chunk>( chunks ) ;
+	if( !_moved )
+	    _pos = _out ;
+    }
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+void *
+CedarInputFile::start_ahead( void *arg )
+{
+    ((CedarInputFile *)arg)->run_ahead() ;
+    return 0 ;
+}
+#endif
+
+/** @brief the read ahead thread, reads blocks until the end of the data
+ * or until stopped
+ */
+void
+CedarInputFile::run_ahead()
+{
+    Chunk next ;
+    try
+    {
+	for( ;; )
+	{
+	    next.data.resize( CEDAR_INPUT_CHUNK ) ;
+	    next.len = read_input( &next.data[0], next.data.size() ) ;
+	    if( !next.len || !_ahead->put( next ) )
+		break ;
+	}
+    }
+    catch( BESError &e )
+    {
+	_ahead_error = e.get_message() ;
+    }
+    _ahead->close() ;
+}
+
+/** @brief stop the read ahead thread, dropping the data it has read
+ *
+ * The file is left at the offset the thread got to, not at the offset of
+ * the data handed out.
+ */
+void
+CedarInputFile::stop_ahead()
+{
+#ifdef HAVE_PTHREAD
+    if( _reading )
+    {
+	_ahead->stop() ;
+	pthread_join( _thread, 0 ) ;
+	_reading = false ;
+    }
+#endif
+    _ahead->reset() ;
+    _chunk.len = 0 ;
+    _chunk_pos = 0 ;
+    _ahead_error.erase() ;
+}
+
+/** @brief move the file itself back to the data handed out, after it was
+ * read ahead
+ */
+void
+CedarInputFile::resume()
+{
+    if( !_moved )
+	return ;
+    vector<Point> none ;
+    seek_input( _pos, _points ? *_points : none ) ;
+    _moved = false ;
+}
+
+/** @brief read up to len bytes of the decompressed data from the file
+ * itself
+ */
+size_t
+CedarInputFile::read_input( char *buf, size_t len )
+{
+#ifdef HAVE_LIBZ
+    if( _compression == GZIP )
+	return read_gzip( buf, len ) ;
+#endif
+#ifdef HAVE_ZSTD
+    if( _compression == ZSTD )
+	return read_zstd( buf, len ) ;
+#endif
+    size_t done = 0 ;
+    while( done < len )
+    {
+	ssize_t got = ::read( _fd, buf + done, len - done ) ;
+	if( got < 0 && errno == EINTR )
+	    continue ;
+	if( got < 0 )
+	    corrupted( strerror( errno ) ) ;
+	if( got == 0 )
+	    break ;
+	done += got ;
+    }
+    _out += done ;
+    return done ;
+}
+
+/** @brief record checkpoints in points while the file is read from its
+ * start, about every span bytes of the decompressed data
+ *
+ * Nothing is recorded for a file that is not compressed, any offset of it
+ * can be seeked to directly.
+ */
+void
+CedarInputFile::record( vector<Point> *points, unsigned long long span )
+{
+    _points = points ;
+    _span = span ;
+}
+
+/** @brief continue reading at offset of the decompressed data, without
+ * checkpoints
+ */
+void
+CedarInputFile::seek( unsigned long long offset )
+{
+    vector<Point> none ;
+    seek( offset, none ) ;
+}
+
+/** @brief continue reading at offset of the decompressed data
+ *
+ * A compressed file is decompressed from the last of points before
+ * offset, or from where it is now if that is closer, discarding the data
+ * up to offset.
+ *
+ * @throws BESInternalError if offset is past the end of the data
+ */
+void
+CedarInputFile::seek( unsigned long long offset, const vector<Point> &points )
+{
+    if( !_ahead )
+    {
+	seek_input( offset, points ) ;
+	_moved = false ;
+	return ;
+    }
+
+    // a little further on is already read ahead
+    if( offset >= _pos && offset - _pos <= CEDAR_INPUT_CHUNK )
+    {
+	char skip[CEDAR_INPUT_CHUNK] ;
+	size_t want = offset - _pos ;
+	if( read( skip, want ) != want )
+	    corrupted( "seek past the end of the data" ) ;
+	return ;
+    }
+    stop_ahead() ;
+    seek_input( offset, points ) ;
+    _pos = offset ;
+    _moved = false ;
+}
+
+/** @brief continue reading the file itself at offset of the decompressed
+ * data
+ */
+void
+CedarInputFile::seek_input( unsigned long long offset,
+                            const vector<Point> &points )
+{
+    if( _compression == PLAIN )
+    {
+	if( lseek( _fd, offset, SEEK_SET ) == (off_t)-1 )
+	    corrupted( strerror( errno ) ) ;
+	_out = offset ;
+	_end = false ;
+	return ;
+    }
+
+    const Point *best = 0 ;
+    for( size_t i = 0; i < points.size() && points[i].out <= offset; i++ )
+	best = &points[i] ;
+    if( offset < _out || ( best && best->out > _out ) )
+	restart( best ) ;
+
+    char skip[CEDAR_INPUT_CHUNK] ;
+    while( _out < offset )
+    {
+	unsigned long long want = offset - _out ;
+	if( want > sizeof skip )
+	    want = sizeof skip ;
+	if( read_input( skip, want ) != want )
+	    corrupted( "seek past the end of the data" ) ;
+    }
+}
+
+/** @brief start decompressing again at p, or at the start of the file
+ * if p is null
+ */
+void
+CedarInputFile::restart( const Point *p )
+{
+    BESDEBUG( "cedar", "CedarInputFile::restart - " << _filename << " at "
+		       << ( p ? p->out : 0 ) << endl ) ;
+    off_t at = p ? p->in - ( p->bits ? 1 : 0 ) : 0 ;
+    if( lseek( _fd, at, SEEK_SET ) == (off_t)-1 )
+	corrupted( strerror( errno ) ) ;
+    _in = at ;
+    _out = p ? p->out : 0 ;
+    _end = false ;
+#ifdef HAVE_LIBZ
+    if( _compression == GZIP )
+	start_gzip( p ) ;
+#endif
+#ifdef HAVE_ZSTD
+    if( _compression == ZSTD )
+	start_zstd( p ) ;
+#endif
+}
+
+#ifdef HAVE_LIBZ
+/** @brief start inflating at p, or a gzip stream at the start of the file
+ * if p is null
+ *
+ * A checkpoint is in the middle of the deflate data, which is inflated raw
+ * from there with the window kept with the checkpoint as its dictionary.
+ */
+void
+CedarInputFile::start_gzip( const Point *p )
+{
+    if( _z_open )
+	inflateEnd( &_z ) ;
+    memset( &_z, 0, sizeof _z ) ;
+    _raw = ( p != 0 ) ;
+    // 15 + 32 looks for a gzip or zlib header
+    if( inflateInit2( &_z, _raw ? -15 : 15 + 32 ) != Z_OK )
+	corrupted( "failed to start gzip decompression" ) ;
+    _z_open = true ;
+    _win_pos = 0 ;
+    _avail_pos = 0 ;
+    _avail_end = 0 ;
+    _inflated = _out ;
+    if( !p )
+	return ;
+
+    if( p->bits )
+    {
+	unsigned char c = 0 ;
+	if( ::read( _fd, &c, 1 ) != 1 )
+	    corrupted( "the file is truncated" ) ;
+	_in++ ;
+	inflatePrime( &_z, p->bits, c >> ( 8 - p->bits ) ) ;
+    }
+    inflateSetDictionary( &_z, (const Bytef *)&p->window[0],
+			  p->window.size() ) ;
+    memcpy( &_window[0], &p->window[0], _window.size() ) ;
+}
+
+/** @brief keep a checkpoint at the end of the deflate block just inflated
+ *
+ * The window is the 32K inflated last, oldest first.
+ */
+void
+CedarInputFile::add_gzip_point()
+{
+    if( !_points->empty() && _inflated < _points->back().out + _span )
+	return ;
+    Point p ;
+    p.out = _inflated ;
+    p.in = _in - _z.avail_in ;
+    p.bits = _z.data_type & 7 ;
+    p.window.reserve( _window.size() ) ;
+    p.window.insert( p.window.end(), _window.begin() + _win_pos,
+		     _window.end() ) ;
+    p.window.insert( p.window.end(), _window.begin(),
+		     _window.begin() + _win_pos ) ;
+    _points->push_back( p ) ;
+}
+
+/** @brief inflate into the window, a deflate block at a time, handing out
+ * what is inflated
+ *
+ * Files made of several gzip members, as by cat, are read through.
+ */
+size_t
+CedarInputFile::read_gzip( char *buf, size_t len )
+{
+    size_t done = 0 ;
+    while( done < len )
+    {
+	if( _avail_pos < _avail_end )
+	{
+	    size_t n = _avail_end - _avail_pos ;
+	    if( n > len - done )
+		n = len - done ;
+	    memcpy( buf + done, &_window[_avail_pos], n ) ;
+	    _avail_pos += n ;
+	    done += n ;
+	    _out += n ;
+	    continue ;
+	}
+	if( _end )
+	    break ;
+
+	if( _z.avail_in == 0 )
+	{
+	    _z.avail_in = fill() ;
+	    _z.next_in = (Bytef *)&_buf[0] ;
+	    if( _z.avail_in == 0 )
+		corrupted( "the file is truncated" ) ;
+	}
+	if( _win_pos == _window.size() )
+	    _win_pos = 0 ;
+	_z.next_out = (Bytef *)&_window[_win_pos] ;
+	_z.avail_out = _window.size() - _win_pos ;
+	int ret = inflate( &_z, Z_BLOCK ) ;
+	if( ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR )
+	    corrupted( "the file does not decompress" ) ;
+	size_t made = ( _window.size() - _win_pos ) - _z.avail_out ;
+	_avail_pos = _win_pos ;
+	_avail_end = _win_pos + made ;
+	_win_pos += made ;
+	_inflated += made ;
+
+	if( ret == Z_STREAM_END )
+	{
+	    // inflating raw stops short of the trailer of the member
+	    size_t trailer = _raw ? 8 : 0 ;
+	    while( trailer )
+	    {
+		if( _z.avail_in == 0 )
+		{
+		    _z.avail_in = fill() ;
+		    _z.next_in = (Bytef *)&_buf[0] ;
+		    if( _z.avail_in == 0 )
+			corrupted( "the file is truncated" ) ;
+		}
+		size_t n = _z.avail_in < trailer ? _z.avail_in : trailer ;
+		_z.next_in += n ;
+		_z.avail_in -= n ;
+		trailer -= n ;
+	    }
+	    if( _z.avail_in == 0 )
+	    {
+		_z.avail_in = fill() ;
+		_z.next_in = (Bytef *)&_buf[0] ;
+	    }
+	    if( _z.avail_in == 0 )
+	    {
+		_end = true ;
+		continue ;
+	    }
+	    // another member follows
+	    Bytef *next = _z.next_in ;
+	    uInt avail = _z.avail_in ;
+	    inflateEnd( &_z ) ;
+	    memset( &_z, 0, sizeof _z ) ;
+	    _z_open = false ;
+	    if( inflateInit2( &_z, 15 + 32 ) != Z_OK )
+		corrupted( "failed to start gzip decompression" ) ;
+	    _z_open = true ;
+	    _raw = false ;
+	    _z.next_in = next ;
+	    _z.avail_in = avail ;
+	}
+	else if( _points && ( _z.data_type & 128 )
+		 && !( _z.data_type & 64 ) )
+	{
+	    add_gzip_point() ;
+	}
+    }
+    return done ;
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/** @brief start decompressing a zstd frame at p, or at the start of the
+ * file if p is null
+ */
+void
+CedarInputFile::start_zstd( const Point * )
+{
+    ZSTD_initDStream( _zds ) ;
+    _zin.src = _buf.empty() ? 0 : &_buf[0] ;
+    _zin.size = 0 ;
+    _zin.pos = 0 ;
+    _frame = false ;
+}
+
+/** @brief decompress straight into buf, keeping a checkpoint at the end
+ * of a frame
+ */
+size_t
+CedarInputFile::read_zstd( char *buf, size_t len )
+{
+    size_t done = 0 ;
+    while( done < len && !_end )
+    {
+	if( _zin.pos == _zin.size )
+	{
+	    _zin.src = &_buf[0] ;
+	    _zin.size = fill() ;
+	    _zin.pos = 0 ;
+	    if( _zin.size == 0 )
+	    {
+		if( _frame )
+		    corrupted( "the file is truncated" ) ;
+		_end = true ;
+		break ;
+	    }
+	}
+	ZSTD_outBuffer out = { buf + done, len - done, 0 } ;
+	size_t ret = ZSTD_decompressStream( _zds, &out, &_zin ) ;
+	if( ZSTD_isError( ret ) )
+	    corrupted( (string)"the file does not decompress, "
+		       + ZSTD_getErrorName( ret ) ) ;
+	done += out.pos ;
+	_out += out.pos ;
+	_frame = ( ret != 0 ) ;
+	if( !_frame && _points
+	    && ( _points->empty() || _out >= _points->back().out + _span ) )
+	{
+	    Point p ;
+	    p.out = _out ;
+	    p.in = _in - ( _zin.size - _zin.pos ) ;
+	    p.bits = 0 ;
+	    _points->push_back( p ) ;
+	}
+    }
+    return done ;
+}
+#endif
+
+/** @brief true if filename is named as a gzip or zstd compressed file
+ */
+bool
+CedarInputFile::is_compressed( const string &filename )
+{
+    return strip( filename ) != filename ;
+}
+
+/** @brief filename without the .gz or .zst of a compressed file
+ */
+string
+CedarInputFile::strip( const string &filename )
+{
+    string::size_type dot = filename.rfind( '.' ) ;
+    if( dot != string::npos )
+    {
+	string ext = filename.substr( dot ) ;
+	if( ext == ".gz" || ext == ".zst" )
+	    return filename.substr( 0, dot ) ;
+    }
+    return filename ;
+}
+
+/** @brief the path to read filename from, its decompressed copy if it is
+ * compressed
+ *
+ * The copy kept by an earlier request is used if there is one, otherwise
+ * the file is decompressed and the copy kept. Decompressing it records
+ * the checkpoints of the decompression in points, if given, about every
+ * span bytes of the decompressed data, see CedarInputFile::record.
+ *
+ * @throws BESInternalError if the scratch file can not be written or the
+ * file does not decompress
+ */
+CedarPlainFile::CedarPlainFile( const string &filename,
+				vector<CedarInputFile::Point> *points,
+				unsigned long long span )
+    : _path( filename ),
+      _scratch( false )
+{
+    if( !CedarInputFile::is_compressed( filename ) )
+	return ;
+
+    bool found = false ;
+    string dir ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Compressed.Scratch", dir,
+				      found ) ;
+    if( !found || dir.empty() )
+	dir = "/tmp" ;
+
+    // a file that can not be looked at has no key, and no copy is kept
+    string key = CedarCache::get_key( filename, CEDAR_PLAIN_FILE_PRODUCT,
+				      "" ) ;
+    if( !key.empty() )
+	_copy = dir + "/cedar" + key + CEDAR_PLAIN_FILE_SUFFIX ;
+
+    if( !_copy.empty() )
+    {
+	// the link is named for the process, one left by a process that
+	// went away with the same id is replaced
+	static unsigned long links = 0 ;
+	char id[64] ;
+	snprintf( id, sizeof id, ".%ld.%lu", (long)getpid(), links++ ) ;
+	string mine = _copy + id ;
+	unlink( mine.c_str() ) ;
+	if( link( _copy.c_str(), mine.c_str() ) == 0 )
+	{
+	    _path = mine ;
+	    _scratch = true ;
+	    // the access time orders the copies for removal
+	    utime( _copy.c_str(), 0 ) ;
+	    BESDEBUG( "cedar", "CedarPlainFile - " << filename
+			       << " read from " << _copy << endl ) ;
+	    return ;
+	}
+    }
+    decompress( filename, dir, points, span ) ;
+}
+
+/** @brief decompress filename into a scratch file of the request, and
+ * keep it as the copy for later requests
+ *
+ * @throws BESInternalError if the scratch file can not be written
+ */
+void
+CedarPlainFile::decompress( const string &filename, const string &dir,
+			    vector<CedarInputFile::Point> *points,
+			    unsigned long long span )
+{
+    string tmp = ( _copy.empty() ? dir + "/cedar" : _copy ) + ".XXXXXX" ;
+    vector<char> name( tmp.begin(), tmp.end() ) ;
+    name.push_back( '\0' ) ;
+    int fd = mkstemp( &name[0] ) ;
+    if( fd < 0 )
+    {
+	string err = (string)"Failed to create a scratch file in " + dir
+		     + ": " + strerror( errno ) ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    _path = &name[0] ;
+    _scratch = true ;
+
+    try
+    {
+	CedarInputFile in( filename ) ;
+	if( points )
+	    in.record( points, span ) ;
+	char buf[CEDAR_INPUT_CHUNK] ;
+	size_t got = 0 ;
+	while( ( got = in.read( buf, sizeof buf ) ) > 0 )
+	{
+	    for( size_t done = 0; done < got; )
+	    {
+		ssize_t w = write( fd, buf + done, got - done ) ;
+		if( w < 0 && errno == EINTR )
+		    continue ;
+		if( w < 0 )
+		{
+		    string err = (string)"Failed to write the scratch file "
+				 + _path + ": " + strerror( errno ) ;
+		    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+		}
+		done += w ;
+	    }
+	}
+    }
+    catch( ... )
+    {
+	close( fd ) ;
+	unlink( _path.c_str() ) ;
+	_scratch = false ;
+	if( points )
+	    points->clear() ;
+	throw ;
+    }
+    close( fd ) ;
+    BESDEBUG( "cedar", "CedarPlainFile - " << filename
+		       << " decompressed to " << _path << endl ) ;
+
+    // whole, so it can be kept. A request that decompressed the file at
+    // the same time may have kept its copy first, which is as good
+    if( !_copy.empty() )
+    {
+	if( link( _path.c_str(), _copy.c_str() ) == 0 )
+	    purge( dir ) ;
+	else if( errno != EEXIST )
+	    _copy.erase() ;
+    }
+}
+
+struct CedarPlainCopy
+{
+    string			path ;
+    time_t			used ;
+    unsigned long long		size ;
+
+    bool operator<( const CedarPlainCopy &c ) const { return used < c.used ; }
+} ;
+
+/** @brief remove the copies in dir read least recently until they are no
+ * larger than Cedar.Compressed.Size
+ *
+ * The links of the requests reading a copy are left, so only the copy
+ * itself is removed.
+ */
+void
+CedarPlainFile::purge( const string &dir )
+{
+    unsigned long long size = CEDAR_PLAIN_FILE_SIZE ;
+    bool found = false ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Compressed.Size", value,
+				      found ) ;
+    if( found && !value.empty() )
+	size = strtoull( value.c_str(), 0, 10 ) ;
+    size *= 1024 * 1024 ;
+
+    DIR *d = opendir( dir.c_str() ) ;
+    if( !d )
+	return ;
+    vector<CedarPlainCopy> copies ;
+    unsigned long long total = 0 ;
+    string suffix = CEDAR_PLAIN_FILE_SUFFIX ;
+    struct dirent *ent = 0 ;
+    while( ( ent = readdir( d ) ) )
+    {
+	string name = ent->d_name ;
+	if( name.compare( 0, 5, "cedar" ) != 0
+	    || name.length() <= suffix.length()
+	    || name.compare( name.length() - suffix.length(),
+			     suffix.length(), suffix ) != 0 )
+	{
+	    continue ;
+	}
+	CedarPlainCopy c ;
+	c.path = dir + "/" + name ;
+	struct stat st ;
+	if( lstat( c.path.c_str(), &st ) != 0 || !S_ISREG( st.st_mode ) )
+	    continue ;
+	c.used = st.st_atime ;
+	c.size = st.st_size ;
+	copies.push_back( c ) ;
+	total += c.size ;
+    }
+    closedir( d ) ;
+    if( total <= size )
+	return ;
+
+    sort( copies.begin(), copies.end() ) ;
+    for( size_t i = 0; i < copies.size() && total > size; i++ )
+    {
+	BESDEBUG( "cedar", "CedarPlainFile::purge - " << copies[i].path
+			   << endl ) ;
+	if( unlink( copies[i].path.c_str() ) == 0 )
+	    total -= copies[i].size ;
+    }
+}
+
+CedarPlainFile::~CedarPlainFile()
+{
+    if( _scratch )
+	unlink( _path.c_str() ) ;
+}
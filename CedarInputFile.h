@@ -0,0 +1,234 @@
+// CedarInputFile.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarInputFile_h
+#define I_CedarInputFile_h 1
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+#include "config_cedar.h"
+
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+template <class T> class CedarStageQueue ;
+
+/** @brief reads a cedar file that may be gzip or zstd compressed
+ *
+ * The compression is found from the first bytes of the file, whatever it
+ * is named, and the file is decompressed as it is read. A file that is
+ * not compressed is read as it is.
+ *
+ * Reading a compressed file from its start can record checkpoints, places
+ * decompression can start again from, about every span bytes of the
+ * decompressed data. For gzip a checkpoint is the end of a deflate block,
+ * kept with the 32K of data before it. For zstd it is the end of a frame,
+ * so only files written as several frames, as pzstd and the zstd seekable
+ * format do, have checkpoints past the start. Seeking with the checkpoints
+ * decompresses from the last checkpoint before the offset rather than from
+ * the start of the file.
+ *
+ * The file can be read ahead, and decompressed, on a thread of its own
+ * while the data read before is decoded, see read_ahead.
+ */
+class CedarInputFile
+{
+public:
+    typedef enum
+    {
+	PLAIN,
+	GZIP,
+	ZSTD
+    } Compression ;
+
+    /** @brief a place decompression can start again from */
+    typedef struct _cedar_input_point
+    {
+	unsigned long long out ;
+	unsigned long long in ;
+	int bits ;
+	vector<char> window ;
+    } Point ;
+
+    /** @brief a block of the data read ahead */
+    class Chunk
+    {
+    public:
+	vector<char>		data ;
+	size_t			len ;
+
+				Chunk() : len( 0 ) {}
+	void			swap( Chunk &other )
+				{
+				    data.swap( other.data ) ;
+				    size_t l = len ;
+				    len = other.len ;
+				    other.len = l ;
+				}
+    } ;
+private:
+    string			_filename ;
+    int				_fd ;
+    Compression			_compression ;
+    unsigned long long		_in ;
+    unsigned long long		_out ;
+    bool			_end ;
+    vector<char>		_buf ;
+    vector<Point> *		_points ;
+    unsigned long long		_span ;
+
+#ifdef HAVE_LIBZ
+    z_stream			_z ;
+    bool			_z_open ;
+    bool			_raw ;
+    vector<char>		_window ;
+    size_t			_win_pos ;
+    size_t			_avail_pos ;
+    size_t			_avail_end ;
+    unsigned long long		_inflated ;
+
+    size_t			read_gzip( char *buf, size_t len ) ;
+    void			start_gzip( const Point *p ) ;
+    void			add_gzip_point() ;
+#endif
+#ifdef HAVE_ZSTD
+    ZSTD_DStream *		_zds ;
+    ZSTD_inBuffer		_zin ;
+    bool			_frame ;
+
+    size_t			read_zstd( char *buf, size_t len ) ;
+    void			start_zstd( const Point *p ) ;
+#endif
+
+    // read ahead, _pos is the offset of the next byte handed out, the
+    // file itself is past it while _moved once reading ahead is stopped
+    CedarStageQueue<Chunk> *	_ahead ;
+    bool			_reading ;
+    Chunk			_chunk ;
+    size_t			_chunk_pos ;
+    unsigned long long		_pos ;
+    bool			_moved ;
+    string			_ahead_error ;
+#ifdef HAVE_PTHREAD
+    pthread_t			_thread ;
+
+    static void *		start_ahead( void *arg ) ;
+#endif
+    void			run_ahead() ;
+    void			stop_ahead() ;
+    void			resume() ;
+
+    size_t			read_input( char *buf, size_t len ) ;
+    void			seek_input( unsigned long long offset,
+					    const vector<Point> &points ) ;
+    size_t			fill() ;
+    void			restart( const Point *p ) ;
+    void			corrupted( const string &why ) const ;
+public:
+    				CedarInputFile( const string &filename ) ;
+    virtual			~CedarInputFile() ;
+
+    Compression			get_compression() const { return _compression ; }
+    /** @brief offset in the decompressed data of the next byte read */
+    unsigned long long		tell() const
+				{
+				    return _ahead || _moved ? _pos : _out ;
+				}
+
+    virtual size_t		read( char *buf, size_t len ) ;
+    virtual void		seek( unsigned long long offset ) ;
+    virtual void		seek( unsigned long long offset,
+				      const vector<Point> &points ) ;
+    virtual void		record( vector<Point> *points,
+					unsigned long long span ) ;
+    virtual void		read_ahead( size_t chunks ) ;
+
+    static bool			is_compressed( const string &filename ) ;
+    static string		strip( const string &filename ) ;
+} ;
+
+// product name of the decompressed copy of a file, for its cache key
+#define CEDAR_PLAIN_FILE_PRODUCT "plain"
+
+// the decompressed copies kept, named cedar<key>.plain
+#define CEDAR_PLAIN_FILE_SUFFIX ".plain"
+
+/** @brief a path the Cedar library, and the raw readers, can open for a
+ * cedar file
+ *
+ * The Cedar library only reads files that are not compressed. A compressed
+ * file is decompressed once into a copy in Cedar.Compressed.Scratch, named
+ * for the cache key of the file so it changes with the file, and the copy
+ * is kept for the requests after. Each request reads a link of its own to
+ * the copy, removed again once it is done, so the copy being removed
+ * meanwhile does not take the file from under it. When the copies grow
+ * past Cedar.Compressed.Size the copies read least recently are removed.
+ * Any other file is used where it is.
+ *
+ * The checkpoints of the decompression can be recorded while the copy is
+ * made, so a seek table built alongside lets later requests seek in the
+ * compressed file itself, see CedarRecordIndex::replay.
+ */
+class CedarPlainFile
+{
+private:
+    string			_path ;
+    string			_copy ;
+    bool			_scratch ;
+
+    void			decompress( const string &filename,
+					    const string &dir,
+					    vector<CedarInputFile::Point> *points,
+					    unsigned long long span ) ;
+    static void			purge( const string &dir ) ;
+public:
+    				CedarPlainFile( const string &filename,
+						vector<CedarInputFile::Point> *
+						    points = 0,
+						unsigned long long span = 0 ) ;
+    virtual			~CedarPlainFile() ;
+
+    /** @brief the path to read */
+    const string &		get_path() const { return _path ; }
+    /** @brief the decompressed copy kept for later requests, empty if
+     * none is kept
+     */
+    const string &		get_copy() const { return _copy ; }
+} ;
+
+#endif // I_CedarInputFile_h
@@ -0,0 +1,63 @@
+// CedarJSONL.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+
+using std::cout ;
+
+#ifdef __GNUG__
+#pragma implementation
+#endif
+
+#include "CedarJSONL.h"
+
+CedarJSONL::CedarJSONL( bool ishttp, ostream *strm )
+    : BESTextInfo( "Cedar.JSONL.Buffered", strm, false, ishttp )
+{
+}
+
+CedarJSONL::~CedarJSONL()
+{
+}
+
+/** @brief dumps information about this object
+ *
+ * Displays the pointer value of this instance and calls dump on the parent
+ * class
+ *
+ * @param strm C++ i/o stream to dump the information to
+ */
+void
+CedarJSONL::dump( ostream &strm ) const
+{
+    strm << BESIndent::LMarg << "CedarJSONL::dump - ("
+			     << (void *)this << ")" << endl ;
+    BESIndent::Indent() ;
+    BESTextInfo::dump( strm ) ;
+    BESIndent::UnIndent() ;
+}
+
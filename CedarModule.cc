@@ -41,6 +41,12 @@ using std::endl ;
 #include "FlatResponseHandler.h"
 #include "TabResponseHandler.h"
 #include "StreamResponseHandler.h"
+#include "CBFResponseHandler.h"
+#include "NetCDFResponseHandler.h"
+#include "ArrowResponseHandler.h"
+#include "CSVResponseHandler.h"
+#include "JSONLResponseHandler.h"
+#include "SizeResponseHandler.h"
 #include "InfoResponseHandler.h"
 #include <BESResponseNames.h>
 #include <BESTransmitterNames.h>
@@ -50,6 +56,11 @@ using std::endl ;
 #include <BESInterface.h>
 #include <BESExceptionManager.h>
 #include "CedarAuthenticateException.h"
+#include "CedarNotModifiedException.h"
+#include "CedarCatalog.h"
+#include "CedarReadKinst.h"
+#include "CedarReadParcods.h"
+#include "CedarDASCache.h"
 #include "ContainerStorageCedar.h"
 #include <BESContainerStorageList.h>
 #include "CedarMySQLDB.h"
@@ -84,6 +95,20 @@ CedarModule::initialize( const string &modname )
 			      INFO_DESCRIPT, BASIC_TRANSMITTER ) ;
     registry->add_to_service( CEDAR_SERVICE, STREAM_SERVICE,
 			      STREAM_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, CBF_SERVICE,
+			      CBF_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, NETCDF_SERVICE,
+			      NETCDF_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, ARROW_SERVICE,
+			      ARROW_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, CSV_SERVICE,
+			      CSV_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, JSONL_SERVICE,
+			      JSONL_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, SIZE_SERVICE,
+			      SIZE_DESCRIPT, BASIC_TRANSMITTER ) ;
+    registry->add_to_service( CEDAR_SERVICE, ARCHIVE_SERVICE,
+			      ARCHIVE_DESCRIPT, BASIC_TRANSMITTER ) ;
     registry->handles_service( modname, CEDAR_SERVICE ) ;
 
     BESDEBUG( "cedar", "    adding " << modname <<
@@ -102,16 +127,52 @@ CedarModule::initialize( const string &modname )
 		       << " response handler" << endl ) ;
     BESResponseHandlerList::TheList()->add_handler( STREAM_RESPONSE, StreamResponseHandler::StreamResponseBuilder ) ;
 
+    BESDEBUG( "cedar", "    adding " << CBF_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( CBF_RESPONSE, CBFResponseHandler::CBFResponseBuilder ) ;
+
+    BESDEBUG( "cedar", "    adding " << NETCDF_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( NETCDF_RESPONSE, NetCDFResponseHandler::NetCDFResponseBuilder ) ;
+
+    BESDEBUG( "cedar", "    adding " << ARROW_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( ARROW_RESPONSE, ArrowResponseHandler::ArrowResponseBuilder ) ;
+
+    BESDEBUG( "cedar", "    adding " << CSV_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( CSV_RESPONSE, CSVResponseHandler::CSVResponseBuilder ) ;
+
+    BESDEBUG( "cedar", "    adding " << JSONL_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( JSONL_RESPONSE, JSONLResponseHandler::JSONLResponseBuilder ) ;
+
+    BESDEBUG( "cedar", "    adding " << SIZE_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( SIZE_RESPONSE, SizeResponseHandler::SizeResponseBuilder ) ;
+
     BESDEBUG( "cear", "    adding " << INFO_RESPONSE
 		      << " response handler" << endl ) ;
     BESResponseHandlerList::TheList()->add_handler( INFO_RESPONSE, InfoResponseHandler::InfoResponseBuilder ) ;
 
+    BESDEBUG( "cedar", "    adding " << ARCHIVE_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->add_handler( ARCHIVE_RESPONSE, InfoResponseHandler::InfoResponseBuilder ) ;
+
     BESDEBUG( "cedar", "    adding Cedar reporter" << endl ) ;
     BESReporterList::TheList()->add_reporter( modname, new CedarReporter ) ;
 
     BESDEBUG( "cedar", "    adding Cedar auth exception callback" << endl ) ;
     BESExceptionManager::TheEHM()->add_ehm_callback( CedarAuthenticateException::handleAuthException ) ;
 
+    BESDEBUG( "cedar", "    adding Cedar not modified exception callback" << endl ) ;
+    BESExceptionManager::TheEHM()->add_ehm_callback( CedarNotModifiedException::handleNotModified ) ;
+
+    BESDEBUG( "cedar", "    adding Cedar catalog refresh callbacks" << endl ) ;
+    CedarCatalog::add_refresh( CedarReadKinst::Clear ) ;
+    CedarCatalog::add_refresh( CedarReadParcods::Clear ) ;
+    CedarCatalog::add_refresh( CedarDASCache::Clear ) ;
+
     BESDEBUG( "cedar", "    adding Cedar Persistence" << endl ) ;
     ContainerStorageCedar *cpf = new ContainerStorageCedar( "Cedar" ) ;
     BESContainerStorageList::TheList()->add_persistence( cpf ) ;
@@ -137,9 +198,30 @@ CedarModule::terminate( const string &modname )
     BESDEBUG( "cedar", "    removing " << STREAM_RESPONSE
 		       << " response handler" << endl ) ;
     BESResponseHandlerList::TheList()->remove_handler( STREAM_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << CBF_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( CBF_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << NETCDF_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( NETCDF_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << ARROW_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( ARROW_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << CSV_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( CSV_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << JSONL_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( JSONL_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << SIZE_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( SIZE_RESPONSE ) ;
     BESDEBUG( "cedar", "    removing " << INFO_RESPONSE
 		       << " response handler" << endl ) ;
     BESResponseHandlerList::TheList()->remove_handler( INFO_RESPONSE ) ;
+    BESDEBUG( "cedar", "    removing " << ARCHIVE_RESPONSE
+		       << " response handler" << endl ) ;
+    BESResponseHandlerList::TheList()->remove_handler( ARCHIVE_RESPONSE ) ;
 
     BESDEBUG( "cedar", "    removing Cedar reporter" << endl ) ;
     BESReporter *r = BESReporterList::TheList()->remove_reporter( modname ) ;
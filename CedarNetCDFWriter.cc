@@ -0,0 +1,341 @@
+// CedarNetCDFWriter.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <string.h>
+
+#include "CedarNetCDFWriter.h"
+#include "CedarRawOutput.h"
+#include "BESInternalError.h"
+
+// tags of the lists in the header
+#define NC_DIMENSION	0x0A
+#define NC_VARIABLE	0x0B
+#define NC_ATTRIBUTE	0x0C
+
+// default fill values
+#define NC_FILL_SHORT	-32767
+#define NC_FILL_INT	-2147483647
+
+// largest file, or number of records, a classic file can describe
+#define NC_CLASSIC_MAX	0x7FFFFFFFUL
+
+static void
+put_int( string &buf, unsigned long v )
+{
+    char b[4] ;
+    b[0] = ( v >> 24 ) & 0xFF ;
+    b[1] = ( v >> 16 ) & 0xFF ;
+    b[2] = ( v >> 8 ) & 0xFF ;
+    b[3] = v & 0xFF ;
+    buf.append( b, 4 ) ;
+}
+
+static void
+put_int64( string &buf, unsigned long long v )
+{
+    put_int( buf, ( v >> 32 ) & 0xFFFFFFFFUL ) ;
+    put_int( buf, v & 0xFFFFFFFFUL ) ;
+}
+
+static void
+pad( string &buf )
+{
+    while( buf.length() % 4 )
+	buf += '\0' ;
+}
+
+static void
+put_name( string &buf, const string &name )
+{
+    put_int( buf, name.length() ) ;
+    buf += name ;
+    pad( buf ) ;
+}
+
+CedarNetCDFWriter::CedarNetCDFWriter( CedarRawOutput &out,
+                                      const string &dimension )
+    : _out( out ),
+      _dimension( dimension ),
+      _recsize( 0 ),
+      _numrecs( 0 ),
+      _written( 0 ),
+      _started( false )
+{
+}
+
+/** @brief add a global text attribute
+ */
+void
+CedarNetCDFWriter::add_attribute( const string &name, const string &value )
+{
+    NCAttribute att ;
+    att.name = name ;
+    att.type = CEDAR_NC_CHAR ;
+    att.nelems = value.length() ;
+    att.values = value ;
+    _attributes.push_back( att ) ;
+}
+
+/** @brief add a record variable
+ *
+ * @param name name of the variable, must be unique
+ * @param type CEDAR_NC_SHORT or CEDAR_NC_INT
+ * @return the index of the variable, used to add attributes and set values
+ */
+int
+CedarNetCDFWriter::add_variable( const string &name, int type )
+{
+    if( _started )
+    {
+	throw BESInternalError( "netcdf variable added after the header",
+				__FILE__, __LINE__ ) ;
+    }
+    NCVariable var ;
+    var.name = name ;
+    var.type = type ;
+    // every scalar record variable takes 4 bytes of a record
+    var.offset = _recsize ;
+    _recsize += 4 ;
+    _variables.push_back( var ) ;
+
+    string fill ;
+    if( type == CEDAR_NC_SHORT )
+    {
+	char b[2] ;
+	short v = NC_FILL_SHORT ;
+	b[0] = ( v >> 8 ) & 0xFF ;
+	b[1] = v & 0xFF ;
+	fill.append( b, 2 ) ;
+	fill.append( 2, '\0' ) ;
+    }
+    else
+    {
+	put_int( fill, (unsigned long)(long)NC_FILL_INT ) ;
+    }
+    _fill += fill ;
+
+    return _variables.size() - 1 ;
+}
+
+bool
+CedarNetCDFWriter::has_variable( const string &name ) const
+{
+    vector<NCVariable>::const_iterator i = _variables.begin() ;
+    vector<NCVariable>::const_iterator e = _variables.end() ;
+    for( ; i != e; i++ )
+    {
+	if( (*i).name == name )
+	    return true ;
+    }
+    return false ;
+}
+
+void
+CedarNetCDFWriter::add_attribute( int var, const string &name,
+                                  const string &value )
+{
+    NCAttribute att ;
+    att.name = name ;
+    att.type = CEDAR_NC_CHAR ;
+    att.nelems = value.length() ;
+    att.values = value ;
+    _variables[var].attributes.push_back( att ) ;
+}
+
+void
+CedarNetCDFWriter::add_attribute( int var, const string &name, short value )
+{
+    NCAttribute att ;
+    att.name = name ;
+    att.type = CEDAR_NC_SHORT ;
+    att.nelems = 1 ;
+    att.values += (char)( ( value >> 8 ) & 0xFF ) ;
+    att.values += (char)( value & 0xFF ) ;
+    _variables[var].attributes.push_back( att ) ;
+}
+
+void
+CedarNetCDFWriter::add_attribute( int var, const string &name, double value )
+{
+    NCAttribute att ;
+    att.name = name ;
+    att.type = CEDAR_NC_DOUBLE ;
+    att.nelems = 1 ;
+    unsigned long long bits = 0 ;
+    memcpy( &bits, &value, sizeof bits ) ;
+    put_int64( att.values, bits ) ;
+    _variables[var].attributes.push_back( att ) ;
+}
+
+void
+CedarNetCDFWriter::put_attributes( string &buf,
+                                   const vector<NCAttribute> &atts )
+{
+    if( atts.empty() )
+    {
+	// ABSENT
+	put_int( buf, 0 ) ;
+	put_int( buf, 0 ) ;
+	return ;
+    }
+    put_int( buf, NC_ATTRIBUTE ) ;
+    put_int( buf, atts.size() ) ;
+    vector<NCAttribute>::const_iterator i = atts.begin() ;
+    vector<NCAttribute>::const_iterator e = atts.end() ;
+    for( ; i != e; i++ )
+    {
+	put_name( buf, (*i).name ) ;
+	put_int( buf, (*i).type ) ;
+	put_int( buf, (*i).nelems ) ;
+	buf += (*i).values ;
+	pad( buf ) ;
+    }
+}
+
+/** @brief encode the header
+ *
+ * @param version 1 for the classic format, 2 for 64 bit offsets
+ * @param begin offset of the first record in the file
+ */
+string
+CedarNetCDFWriter::build_header( int version, unsigned long long begin )
+{
+    string buf = "CDF" ;
+    buf += (char)version ;
+    put_int( buf, _numrecs ) ;
+
+    // the one, unlimited, dimension
+    put_int( buf, NC_DIMENSION ) ;
+    put_int( buf, 1 ) ;
+    put_name( buf, _dimension ) ;
+    put_int( buf, 0 ) ;
+
+    put_attributes( buf, _attributes ) ;
+
+    put_int( buf, NC_VARIABLE ) ;
+    put_int( buf, _variables.size() ) ;
+    vector<NCVariable>::const_iterator i = _variables.begin() ;
+    vector<NCVariable>::const_iterator e = _variables.end() ;
+    for( ; i != e; i++ )
+    {
+	put_name( buf, (*i).name ) ;
+	put_int( buf, 1 ) ;
+	put_int( buf, 0 ) ;
+	put_attributes( buf, (*i).attributes ) ;
+	put_int( buf, (*i).type ) ;
+	put_int( buf, 4 ) ;
+	if( version == 1 )
+	    put_int( buf, begin + (*i).offset ) ;
+	else
+	    put_int64( buf, begin + (*i).offset ) ;
+    }
+    return buf ;
+}
+
+/** @brief write the header for a file of numrecs records
+ */
+void
+CedarNetCDFWriter::write_header( unsigned long numrecs )
+{
+    if( numrecs > NC_CLASSIC_MAX )
+    {
+	throw BESInternalError( "too many rows for a netcdf file",
+				__FILE__, __LINE__ ) ;
+    }
+    _numrecs = numrecs ;
+    _started = true ;
+
+    // the size of the header does not depend on the offsets in it
+    int version = 1 ;
+    unsigned long long hsize = build_header( version, 0 ).length() ;
+    if( hsize + (unsigned long long)numrecs * _recsize > NC_CLASSIC_MAX )
+    {
+	version = 2 ;
+	hsize = build_header( version, 0 ).length() ;
+    }
+    string header = build_header( version, hsize ) ;
+    _out.write( header.data(), header.length() ) ;
+
+    _record = _fill ;
+}
+
+/** @brief set every value of the record buffer back to the fill value
+ */
+void
+CedarNetCDFWriter::clear_record()
+{
+    _record = _fill ;
+}
+
+void
+CedarNetCDFWriter::set_value( int var, int value )
+{
+    const NCVariable &v = _variables[var] ;
+    char *p = &_record[v.offset] ;
+    if( v.type == CEDAR_NC_SHORT )
+    {
+	p[0] = ( value >> 8 ) & 0xFF ;
+	p[1] = value & 0xFF ;
+    }
+    else
+    {
+	p[0] = ( value >> 24 ) & 0xFF ;
+	p[1] = ( value >> 16 ) & 0xFF ;
+	p[2] = ( value >> 8 ) & 0xFF ;
+	p[3] = value & 0xFF ;
+    }
+}
+
+/** @brief write the record buffer out as the next record
+ *
+ * The buffer is left as it is, so values shared by several records need
+ * only be set once.
+ */
+void
+CedarNetCDFWriter::write_record()
+{
+    if( _written == _numrecs )
+    {
+	throw BESInternalError( "more netcdf records than in the header",
+				__FILE__, __LINE__ ) ;
+    }
+    _out.write( _record.data(), _record.length() ) ;
+    _written++ ;
+}
+
+/** @brief make sure the number of records written matches the header
+ */
+void
+CedarNetCDFWriter::finish()
+{
+    if( _written != _numrecs )
+    {
+	throw BESInternalError( "fewer netcdf records than in the header",
+				__FILE__, __LINE__ ) ;
+    }
+}
+
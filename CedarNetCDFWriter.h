@@ -0,0 +1,115 @@
+// CedarNetCDFWriter.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarNetCDFWriter_h
+#define I_CedarNetCDFWriter_h 1
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+class CedarRawOutput ;
+
+// netcdf external data types used by the writer
+#define CEDAR_NC_CHAR	2
+#define CEDAR_NC_SHORT	3
+#define CEDAR_NC_INT	4
+#define CEDAR_NC_DOUBLE	6
+
+/** @brief writes a netcdf classic file made of record variables, streamed
+ * out a record at a time
+ *
+ * Every variable is a scalar along the single, unlimited, dimension. The
+ * number of records must be known when the header is written so that the
+ * file can be sent without going back to fill in the header. The 64 bit
+ * offset format is used when the file would be larger than 2GiB.
+ *
+ * Record buffers start out holding the default netcdf fill values, the
+ * same as the missing value used in cedar files, so only the values a
+ * record actually has need to be set.
+ */
+class CedarNetCDFWriter
+{
+private:
+    typedef struct _nc_attribute
+    {
+	string name ;
+	int type ;
+	unsigned int nelems ;
+	string values ;
+    } NCAttribute ;
+
+    typedef struct _nc_variable
+    {
+	string name ;
+	int type ;
+	vector<NCAttribute> attributes ;
+	unsigned int offset ;
+    } NCVariable ;
+
+    CedarRawOutput &		_out ;
+    string			_dimension ;
+    vector<NCAttribute>		_attributes ;
+    vector<NCVariable>		_variables ;
+    unsigned int		_recsize ;
+    string			_fill ;
+    string			_record ;
+    unsigned long		_numrecs ;
+    unsigned long		_written ;
+    bool			_started ;
+
+    static void			put_attributes( string &buf,
+					   const vector<NCAttribute> &atts ) ;
+    string			build_header( int version,
+					      unsigned long long begin ) ;
+public:
+    				CedarNetCDFWriter( CedarRawOutput &out,
+						   const string &dimension ) ;
+    virtual			~CedarNetCDFWriter() {}
+
+    virtual void		add_attribute( const string &name,
+					       const string &value ) ;
+    virtual int			add_variable( const string &name, int type ) ;
+    virtual void		add_attribute( int var, const string &name,
+					       const string &value ) ;
+    virtual void		add_attribute( int var, const string &name,
+					       short value ) ;
+    virtual void		add_attribute( int var, const string &name,
+					       double value ) ;
+    virtual bool		has_variable( const string &name ) const ;
+
+    virtual void		write_header( unsigned long numrecs ) ;
+    virtual void		clear_record() ;
+    virtual void		set_value( int var, int value ) ;
+    virtual void		write_record() ;
+    virtual void		finish() ;
+} ;
+
+#endif // I_CedarNetCDFWriter_h
+
@@ -0,0 +1,78 @@
+// CedarNotModifiedException.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarNotModifiedException.h"
+#include "CedarValidators.h"
+#include "CedarInfo.h"
+#include "BESInfo.h"
+#include "BESInfoList.h"
+
+/** @brief answer a request for a product the client already has
+ *
+ * Over HTTP the response is a 304 Not Modified header with the validators
+ * of the product and no body. Otherwise the validators are returned in the
+ * response information so the front end can answer its client.
+ */
+int
+CedarNotModifiedException::handleNotModified( BESError &e,
+					      BESDataHandlerInterface &dhi )
+{
+    CedarNotModifiedException *nme =
+	dynamic_cast<CedarNotModifiedException*>(&e);
+
+    if( nme )
+    {
+	string last_modified =
+	    CedarValidators::http_date( nme->get_last_modified() ) ;
+	if( dhi.transmit_protocol == "HTTP" )
+	{
+	    ostream &strm = dhi.get_output_stream() ;
+	    strm << "HTTP/1.0 304 Not Modified\r\n"
+		 << "Date: " << CedarValidators::http_date( time( 0 ) )
+		 << "\r\n" ;
+	    if( !nme->get_etag().empty() )
+		strm << "ETag: " << nme->get_etag() << "\r\n" ;
+	    strm << "Last-Modified: " << last_modified << "\r\n"
+		 << "\r\n" ;
+
+	    // the header is the whole response
+	    dhi.error_info = new CedarInfo( false, &strm ) ;
+	}
+	else
+	{
+	    dhi.error_info = BESInfoList::TheList()->build_info() ;
+	    if( dhi.error_info )
+	    {
+		dhi.error_info->add_tag( "NotModified", "" ) ;
+		dhi.error_info->add_tag( "ETag", nme->get_etag() ) ;
+		dhi.error_info->add_tag( "Last-Modified", last_modified ) ;
+	    }
+	}
+	return CEDAR_NOT_MODIFIED_EXCEPTION ;
+    }
+    return 0 ;
+}
@@ -0,0 +1,69 @@
+// CedarNotModifiedException.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef CedarNotModifiedException_h_
+#define CedarNotModifiedException_h_ 1
+
+#include <time.h>
+
+#include "BESError.h"
+#include "BESDataHandlerInterface.h"
+
+#define CEDAR_NOT_MODIFIED_EXCEPTION 14
+
+/** @brief exception thrown if the client already has the product it asked
+ * for
+ *
+ * Not an error, it stops the request before any work is done. The
+ * callback answers with 304 Not Modified and the validators of the product.
+ */
+class CedarNotModifiedException: public BESError
+{
+private:
+      string		_etag ;
+      time_t		_last_modified ;
+protected:
+      			CedarNotModifiedException() {}
+public:
+      			CedarNotModifiedException( const string &etag,
+						   time_t last_modified,
+			                           const string &file,
+						   int line )
+			    : BESError( "Not Modified", BES_INTERNAL_ERROR,
+					file, line ),
+			      _etag( etag ),
+			      _last_modified( last_modified ) {}
+      virtual		~CedarNotModifiedException() {}
+
+      const string &	get_etag() const { return _etag ; }
+      time_t		get_last_modified() const { return _last_modified ; }
+
+      static int	handleNotModified( BESError &e,
+					   BESDataHandlerInterface &dhi ) ;
+};
+
+#endif // CedarNotModifiedException_h_
@@ -0,0 +1,551 @@
+// CedarPipeline.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <iostream>
+#include <new>
+
+using std::endl ;
+using std::bad_alloc ;
+
+#include "CedarPipeline.h"
+#include "CedarRecordReader.h"
+#include "CedarException.h"
+#include "BESInternalError.h"
+#include "TheBESKeys.h"
+#include "BESDebug.h"
+
+/** @brief swap the records and product of two batches */
+void
+CedarPipeline::Batch::swap( Batch &other )
+{
+    recs.swap( other.recs ) ;
+    marks.swap( other.marks ) ;
+    out.swap( other.out ) ;
+    size_t c = count ;
+    count = other.count ;
+    other.count = c ;
+    unsigned long s = seq ;
+    seq = other.seq ;
+    other.seq = s ;
+}
+
+/** @brief start the format stage of reader's product
+ *
+ * No stage is started if depth is 0, if the reader is not staged or is
+ * already attached to a pipeline, or if no thread can be created, the
+ * records are then formatted and written as they are delivered. If
+ * threads is more than 1 and the reader makes workers the format stage is
+ * a pool of that many workers, otherwise a single thread.
+ *
+ * @param reader the reader whose data_record and write are run
+ * @param depth the records queued for the format stage
+ * @param threads the workers formatting the records
+ */
+CedarPipeline::CedarPipeline( CedarRecordReader &reader, size_t depth,
+                              size_t threads )
+    : _reader( reader ),
+      _records( depth ),
+      _batches( threads ),
+      _output( depth ),
+      _working( 0 ),
+      _sent( 0 ),
+      _turn( 0 ),
+      _formatting( false ),
+      _writing( false ),
+      _stopped( false )
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init( &_lock, 0 ) ;
+    pthread_cond_init( &_turn_cond, 0 ) ;
+    if( !depth || _reader._pipeline || !_reader.is_staged() )
+	return ;
+    if( threads > 1 )
+	start_workers( threads ) ;
+    if( !_workers.empty() )
+    {
+	BESDEBUG( "cedar", "CedarPipeline - formatting on " << _working
+			   << " workers, " << CEDAR_PIPELINE_BATCH
+			   << " records a batch" << endl ) ;
+    }
+    else if( pthread_create( &_format_thread, 0, start_format, this ) == 0 )
+    {
+	BESDEBUG( "cedar", "CedarPipeline - formatting and writing on "
+			   << "stages of their own, " << depth
+			   << " records queued" << endl ) ;
+    }
+    else
+    {
+	return ;
+    }
+    _formatting = true ;
+    _reader._pipeline = this ;
+#endif
+}
+
+CedarPipeline::~CedarPipeline()
+{
+    if( _formatting )
+    {
+	stop() ;
+	join() ;
+    }
+#ifdef HAVE_PTHREAD
+    pthread_cond_destroy( &_turn_cond ) ;
+    pthread_mutex_destroy( &_lock ) ;
+#endif
+}
+
+/** @brief start a worker on a thread of its own for each of threads
+ *
+ * No worker is started if the reader does not make them. As many are
+ * started as threads can be created for.
+ */
+void
+CedarPipeline::start_workers( size_t threads )
+{
+#ifdef HAVE_PTHREAD
+    CedarRecordReader *first = _reader.make_worker() ;
+    if( !first )
+	return ;
+    _workers.resize( threads ) ;
+    _workers[0].reader = first ;
+    for( size_t w = 0; w < _workers.size(); w++ )
+    {
+	Worker &worker = _workers[w] ;
+	if( !worker.reader )
+	    worker.reader = _reader.make_worker() ;
+	worker.pipeline = this ;
+	_working++ ;
+	if( pthread_create( &worker.thread, 0, start_work, &worker ) != 0 )
+	{
+	    _working-- ;
+	    break ;
+	}
+    }
+    for( size_t w = _working; w < _workers.size(); w++ )
+	delete _workers[w].reader ;
+    _workers.resize( _working ) ;
+#endif
+}
+
+#ifdef HAVE_PTHREAD
+void *
+CedarPipeline::start_format( void *arg )
+{
+    ((CedarPipeline *)arg)->format() ;
+    return 0 ;
+}
+
+void *
+CedarPipeline::start_work( void *arg )
+{
+    Worker *worker = (Worker *)arg ;
+    worker->pipeline->work( *worker->reader ) ;
+    return 0 ;
+}
+
+void *
+CedarPipeline::start_write( void *arg )
+{
+    ((CedarPipeline *)arg)->write() ;
+    return 0 ;
+}
+#endif
+
+/** @brief the format stage, data_record for each record put until the
+ * reader is done
+ */
+void
+CedarPipeline::format()
+{
+    Record next ;
+    try
+    {
+	while( _records.get( next ) )
+	{
+	    _reader.data_record( next.rec, next.sel ) ;
+	    if( _reader.is_done() )
+	    {
+		_records.stop() ;
+		break ;
+	    }
+	}
+    }
+    catch( BESError &e )
+    {
+	fail( e.get_message() ) ;
+    }
+    catch( CedarException &e )
+    {
+	fail( e.get_description() ) ;
+    }
+    catch( bad_alloc & )
+    {
+	fail( "There has been a memory allocation error." ) ;
+    }
+    catch( ... )
+    {
+	fail( "Unknown exception formatting the product." ) ;
+    }
+    _output.close() ;
+}
+
+/** @brief a worker of the format stage, formats the batches it takes
+ * into a buffer of its own and hands the buffer on in turn
+ *
+ * The last worker to end ends the product.
+ */
+void
+CedarPipeline::work( CedarRecordReader &worker )
+{
+    Batch batch ;
+    try
+    {
+	while( _batches.get( batch ) )
+	{
+	    batch.out.erase() ;
+	    for( size_t r = 0; r < batch.count; r++ )
+	    {
+		worker.format_record( batch.recs[r].rec, batch.recs[r].sel,
+				      batch.marks[r], batch.out ) ;
+	    }
+	    sequence( batch ) ;
+	}
+    }
+    catch( BESError &e )
+    {
+	fail( e.get_message() ) ;
+    }
+    catch( CedarException &e )
+    {
+	fail( e.get_description() ) ;
+    }
+    catch( bad_alloc & )
+    {
+	fail( "There has been a memory allocation error." ) ;
+    }
+    catch( ... )
+    {
+	fail( "Unknown exception formatting the product." ) ;
+    }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+#endif
+    bool last = ( --_working == 0 ) ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock( &_lock ) ;
+#endif
+    if( last )
+	_output.close() ;
+}
+
+/** @brief wait for the batches before batch to be output, then output it
+ *
+ * Batches are taken from the queue in order, so the batch whose turn it
+ * is has already been taken by a worker that is not waiting.
+ */
+void
+CedarPipeline::sequence( Batch &batch )
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+    while( batch.seq != _turn && !_stopped )
+	pthread_cond_wait( &_turn_cond, &_lock ) ;
+    bool stopped = _stopped ;
+    pthread_mutex_unlock( &_lock ) ;
+    if( stopped )
+	return ;
+#endif
+    if( !batch.out.empty() )
+	output( batch.out ) ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+    _turn++ ;
+    pthread_cond_broadcast( &_turn_cond ) ;
+    pthread_mutex_unlock( &_lock ) ;
+#endif
+}
+
+/** @brief the write stage, write for each piece of the product output
+ */
+void
+CedarPipeline::write()
+{
+    string data ;
+    try
+    {
+	while( _output.get( data ) )
+	{
+	    _reader.write( data ) ;
+	    data.erase() ;
+	}
+    }
+    catch( BESError &e )
+    {
+	fail( e.get_message() ) ;
+    }
+    catch( ... )
+    {
+	fail( "Unknown exception writing the product." ) ;
+    }
+}
+
+/** @brief stop every stage, including the workers waiting their turn
+ */
+void
+CedarPipeline::stop()
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+    _stopped = true ;
+    pthread_cond_broadcast( &_turn_cond ) ;
+    pthread_mutex_unlock( &_lock ) ;
+#endif
+    _records.stop() ;
+    _batches.stop() ;
+    _output.stop() ;
+}
+
+/** @brief keep the first error of a stage and stop every stage
+ */
+void
+CedarPipeline::fail( const string &why )
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+#endif
+    if( _error.empty() )
+	_error = why ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock( &_lock ) ;
+#endif
+    stop() ;
+}
+
+/** @brief throw the error of a stage that failed
+ *
+ * @throws BESInternalError if a stage failed
+ */
+void
+CedarPipeline::check()
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock( &_lock ) ;
+#endif
+    string err = _error ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock( &_lock ) ;
+#endif
+    if( !err.empty() )
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+}
+
+/** @brief wait for the stages to end and detach from the reader
+ */
+void
+CedarPipeline::join()
+{
+#ifdef HAVE_PTHREAD
+    if( _workers.empty() )
+	pthread_join( _format_thread, 0 ) ;
+    for( size_t w = 0; w < _workers.size(); w++ )
+	pthread_join( _workers[w].thread, 0 ) ;
+    // only the format stage starts the write stage, it has ended
+    if( _writing )
+	pthread_join( _write_thread, 0 ) ;
+#endif
+    for( size_t w = 0; w < _workers.size(); w++ )
+	delete _workers[w].reader ;
+    _workers.clear() ;
+    _formatting = false ;
+    _writing = false ;
+    _reader._pipeline = 0 ;
+}
+
+/** @brief hand a copy of a selected record to the format stage
+ *
+ * Waits while the format stage is a full queue behind. A record put once
+ * the format stage is done is dropped. For a pool of workers the record
+ * is marked and added to the batch being filled, which is handed on once
+ * full.
+ *
+ * @throws BESInternalError if a stage has failed
+ */
+void
+CedarPipeline::put( const CedarRawRecord &rec,
+                    const CedarRecordSelection &sel )
+{
+    if( _workers.empty() )
+    {
+	_next.rec = rec ;
+	_next.sel = sel ;
+	if( !_records.put( _next ) )
+	    check() ;
+	return ;
+    }
+
+    // batches come back through the queue, some never filled before
+    if( _batch.recs.size() < CEDAR_PIPELINE_BATCH )
+    {
+	_batch.recs.resize( CEDAR_PIPELINE_BATCH ) ;
+	_batch.marks.resize( CEDAR_PIPELINE_BATCH ) ;
+    }
+    Record &next = _batch.recs[_batch.count] ;
+    next.rec = rec ;
+    next.sel = sel ;
+    _batch.marks[_batch.count++] = _reader.mark_record( rec, sel ) ;
+    if( _batch.count == CEDAR_PIPELINE_BATCH )
+	send() ;
+}
+
+/** @brief hand the batch being filled to the workers
+ *
+ * @throws BESInternalError if a stage has failed
+ */
+void
+CedarPipeline::send()
+{
+    _batch.seq = _sent++ ;
+    bool sent = _batches.put( _batch ) ;
+    _batch.count = 0 ;
+    if( !sent )
+	check() ;
+}
+
+/** @brief hand a piece of the formatted product to the write stage,
+ * called on the format stage
+ *
+ * The write stage is started by the first piece. data is left empty.
+ *
+ * @throws BESInternalError if the write stage has failed
+ */
+void
+CedarPipeline::output( string &data )
+{
+#ifdef HAVE_PTHREAD
+    if( !_writing
+	&& pthread_create( &_write_thread, 0, start_write, this ) == 0 )
+    {
+	_writing = true ;
+    }
+#endif
+    if( !_writing )
+	_reader.write( data ) ;
+    else if( !_output.put( data ) )
+	check() ;
+    data.erase() ;
+}
+
+/** @brief wait for every record put to be formatted and written
+ *
+ * @throws BESInternalError if a stage failed
+ */
+void
+CedarPipeline::finish()
+{
+    if( !_formatting )
+	return ;
+    if( _workers.empty() )
+    {
+	_records.close() ;
+    }
+    else
+    {
+	if( _batch.count )
+	    send() ;
+	_batches.close() ;
+    }
+    join() ;
+    check() ;
+}
+
+/** @brief records queued between stages, Cedar.Pipeline.Depth, 0 if
+ * reads are not pipelined
+ */
+size_t
+CedarPipeline::get_depth()
+{
+#ifdef HAVE_PTHREAD
+    size_t depth = CEDAR_PIPELINE_DEPTH ;
+    bool found = false ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Pipeline.Depth", value, found ) ;
+    if( found && !value.empty() )
+	depth = strtoul( value.c_str(), 0, 10 ) ;
+    return depth ;
+#else
+    return 0 ;
+#endif
+}
+
+/** @brief workers formatting the records of a reader that makes them,
+ * Cedar.Pipeline.Threads, 0 or unset for as many as there are processors
+ */
+size_t
+CedarPipeline::get_threads()
+{
+#ifdef HAVE_PTHREAD
+    size_t threads = 0 ;
+    bool found = false ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Pipeline.Threads", value,
+				      found ) ;
+    if( found && !value.empty() )
+	threads = strtoul( value.c_str(), 0, 10 ) ;
+    if( !threads )
+    {
+	long cpus = sysconf( _SC_NPROCESSORS_ONLN ) ;
+	threads = cpus > 0 ? cpus : 1 ;
+    }
+    return threads ;
+#else
+    return 1 ;
+#endif
+}
+
+/** @brief 64K blocks of a file read ahead, Cedar.Pipeline.ReadAhead, 0 if
+ * files are not read ahead
+ */
+size_t
+CedarPipeline::get_read_ahead()
+{
+#ifdef HAVE_PTHREAD
+    size_t blocks = CEDAR_PIPELINE_READ_AHEAD ;
+    bool found = false ;
+    string value ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Pipeline.ReadAhead", value,
+				      found ) ;
+    if( found && !value.empty() )
+	blocks = strtoul( value.c_str(), 0, 10 ) ;
+    return blocks ;
+#else
+    return 0 ;
+#endif
+}
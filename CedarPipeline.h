@@ -0,0 +1,198 @@
+// CedarPipeline.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarPipeline_h
+#define I_CedarPipeline_h 1
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+#include "config_cedar.h"
+#include "CedarStageQueue.h"
+#include "CedarRawFile.h"
+#include "CedarRecordSelection.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+class CedarRecordReader ;
+
+// records, and pieces of formatted product, queued between stages
+#define CEDAR_PIPELINE_DEPTH 64
+
+// 64K blocks of a file read ahead of the records being decoded
+#define CEDAR_PIPELINE_READ_AHEAD 16
+
+// records handed to a worker of the format stage at a time
+#define CEDAR_PIPELINE_BATCH 32
+
+/** @brief formats and writes the product of a record reader on threads of
+ * their own while the records are read and decoded
+ *
+ * A read runs as four stages joined by bounded queues: reading the blocks
+ * of the file ahead, see CedarInputFile::read_ahead, decoding the logical
+ * records and selecting the rows that satisfy the constraint, formatting
+ * the selected records, and writing the formatted product to the
+ * response. Decoding stays on the thread of the request, as the Cedar
+ * library hands out a logical record that is only good until the next is
+ * read. With the stages overlapped a read takes about as long as its
+ * slowest stage rather than the time of all of them added up.
+ *
+ * Records are formatted and written in the order they are read. A client
+ * slow to take the response fills the queue of the write stage, which in
+ * turn holds back the formatting, the decoding and the reading.
+ *
+ * A reader that makes workers, see CedarRecordReader::make_worker, is
+ * formatted by a pool of them, one thread each. The request marks each
+ * record in order and hands the records to the pool in batches, whichever
+ * worker is free takes the next batch and formats it into a buffer of its
+ * own, and the buffers are handed to the write stage in the order of the
+ * batches, a worker that finishes ahead of its turn waiting for the
+ * batches before it. Formatting then runs on as many cores as there are
+ * workers rather than on one.
+ *
+ * While a pipeline is attached to a reader data_record and is_done are
+ * called on the format stage, format_record on the workers, and write on
+ * the write stage. An error in any stage is thrown on the thread of the
+ * request by the next deliver or by finish. A pipeline destroyed before
+ * finish abandons the records not yet formatted.
+ */
+class CedarPipeline
+{
+public:
+    /** @brief a selected record handed to the format stage */
+    class Record
+    {
+    public:
+	CedarRawRecord		rec ;
+	CedarRecordSelection	sel ;
+
+	void			swap( Record &other )
+				{
+				    rec.swap( other.rec ) ;
+				    sel.swap( other.sel ) ;
+				}
+    } ;
+
+    /** @brief records handed to a worker together, and their product */
+    class Batch
+    {
+    public:
+	vector<Record>		recs ;
+	vector<int>		marks ;
+	size_t			count ;
+	unsigned long		seq ;
+	string			out ;
+
+				Batch() : count( 0 ), seq( 0 ) {}
+
+	void			swap( Batch &other ) ;
+    } ;
+
+    /** @brief a worker of the format stage and the thread it runs on */
+    class Worker
+    {
+    public:
+	CedarPipeline *		pipeline ;
+	CedarRecordReader *	reader ;
+#ifdef HAVE_PTHREAD
+	pthread_t		thread ;
+#endif
+
+				Worker() : pipeline( 0 ), reader( 0 ) {}
+    } ;
+private:
+    CedarRecordReader &		_reader ;
+    CedarStageQueue<Record>	_records ;
+    CedarStageQueue<Batch>	_batches ;
+    CedarStageQueue<string>	_output ;
+    Record			_next ;
+    Batch			_batch ;
+    vector<Worker>		_workers ;
+    size_t			_working ;
+    unsigned long		_sent ;
+    unsigned long		_turn ;
+    bool			_formatting ;
+    bool			_writing ;
+    bool			_stopped ;
+    string			_error ;
+#ifdef HAVE_PTHREAD
+    pthread_t			_format_thread ;
+    pthread_t			_write_thread ;
+    pthread_mutex_t		_lock ;
+    pthread_cond_t		_turn_cond ;
+
+    static void *		start_format( void *arg ) ;
+    static void *		start_work( void *arg ) ;
+    static void *		start_write( void *arg ) ;
+#endif
+
+    void			start_workers( size_t threads ) ;
+    void			format() ;
+    void			work( CedarRecordReader &worker ) ;
+    void			sequence( Batch &batch ) ;
+    void			write() ;
+    void			send() ;
+    void			stop() ;
+    void			fail( const string &why ) ;
+    void			check() ;
+    void			join() ;
+public:
+    				CedarPipeline( CedarRecordReader &reader,
+					       size_t depth = get_depth(),
+					       size_t threads = get_threads() ) ;
+    virtual			~CedarPipeline() ;
+
+    /** @brief true if the product is formatted on a stage of its own */
+    bool			is_running() const { return _formatting ; }
+    /** @brief the workers formatting the records, 0 if the records are
+     * formatted in turn
+     */
+    size_t			get_workers() const { return _workers.size() ; }
+    /** @brief true once the format stage wants no more records */
+    bool			is_done()
+				{
+				    return _workers.empty()
+					   ? _records.is_stopped()
+					   : _batches.is_stopped() ;
+				}
+
+    virtual void		put( const CedarRawRecord &rec,
+				     const CedarRecordSelection &sel ) ;
+    virtual void		output( string &data ) ;
+    virtual void		finish() ;
+
+    static size_t		get_depth() ;
+    static size_t		get_threads() ;
+    static size_t		get_read_ahead() ;
+} ;
+
+#endif // I_CedarPipeline_h
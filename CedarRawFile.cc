@@ -0,0 +1,546 @@
+// CedarRawFile.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+#include <cstring>
+
+using std::endl ;
+
+#include "CedarRawFile.h"
+#include "CedarDataRecord.h"
+#include "BESInternalError.h"
+#include "BESDebug.h"
+
+// number of 16 bit words in each physical record of a madrigal file
+#define MADRIGAL_PHYS_WORDS 6720
+
+// cray control word types found in cbf files
+#define COS_BCW 0x0
+#define COS_RCW 0x8
+#define COS_EOF 0xE
+#define COS_EOD 0xF
+
+// files a process keeps the seek tables of
+#define CEDAR_SEEK_TABLE_FILES 256
+
+map<string,CedarSeekTable *> CedarSeekTable::_tables ;
+
+/** @brief the last point at or before the record with ordinal
+ *
+ * @return the point, null if there is none before the record
+ */
+const CedarSeekTable::Point *
+CedarSeekTable::find( unsigned long ordinal ) const
+{
+    size_t lo = 0 ;
+    size_t hi = points.size() ;
+    while( lo < hi )
+    {
+	size_t mid = ( lo + hi ) / 2 ;
+	if( points[mid].ordinal <= ordinal )
+	    lo = mid + 1 ;
+	else
+	    hi = mid ;
+    }
+    return lo ? &points[lo - 1] : 0 ;
+}
+
+/** @brief the seek table kept for key, null if there is none
+ */
+const CedarSeekTable *
+CedarSeekTable::get( const string &key )
+{
+    if( key.empty() )
+	return 0 ;
+    map<string,CedarSeekTable *>::iterator i = _tables.find( key ) ;
+    if( i == _tables.end() )
+	return 0 ;
+    return i->second ;
+}
+
+/** @brief keep the seek table of a file
+ *
+ * @param key the cache key of the file's seek table
+ * @param table the seek table, owned by the cache from now on
+ */
+void
+CedarSeekTable::add( const string &key, CedarSeekTable *table )
+{
+    if( key.empty() || get( key ) )
+    {
+	delete table ;
+	return ;
+    }
+    if( _tables.size() >= CEDAR_SEEK_TABLE_FILES )
+	Clear() ;
+    BESDEBUG( "cedar", "CedarSeekTable::add - " << key << " with "
+		       << table->points.size() << " points, "
+		       << table->input.size() << " checkpoints" << endl ) ;
+    _tables[key] = table ;
+}
+
+/** @brief forget every seek table
+ */
+void
+CedarSeekTable::Clear()
+{
+    map<string,CedarSeekTable *>::iterator i = _tables.begin() ;
+    for( ; i != _tables.end(); i++ )
+	delete i->second ;
+    _tables.clear() ;
+}
+
+/** @brief returns the kind of logical record, the same value returned by
+ * CedarLogicalRecord::get_type
+ *
+ * @return 1 for data records, 2 for catalog records, 3 for header records,
+ * 0 if the KREC is not recognized
+ */
+int
+CedarRawRecord::get_type() const
+{
+    int krec = get_krec() ;
+    switch( krec / 1000 )
+    {
+	case 1:
+	case 2:
+	case 3:
+	    return krec / 1000 ;
+    }
+    return 0 ;
+}
+
+/** @brief determines if the prologue counts of a data record describe a
+ * record that fits in the words that were read
+ */
+bool
+CedarRawRecord::is_valid_data() const
+{
+    if( get_type() != 1 || get_word_count() <= CEDAR_RAW_NROW )
+	return false ;
+    int lprol = get_lprol() ;
+    int jpar = get_jpar() ;
+    int mpar = get_mpar() ;
+    int nrows = get_nrows() ;
+    if( lprol <= CEDAR_RAW_NROW || jpar < 0 || mpar < 0 || nrows < 0 )
+	return false ;
+    unsigned long needed = lprol + 2*jpar + mpar
+                           + (unsigned long)nrows*mpar ;
+    return needed <= get_word_count() ;
+}
+
+CedarRawFile::CedarRawFile( const string &filename )
+    : _filename( filename ),
+      _file( filename ),
+      _format( CBF_FORMAT ),
+      _eod( false ),
+      _ordinal( 0 ),
+      _table( 0 ),
+      _phys_pos( 0 ),
+      _phys_end( 0 ),
+      _pending( 0 ),
+      _phys_offset( 0 ),
+      _phys_pending( 0 ),
+      _block_pos( 0 ),
+      _block_end( 0 ),
+      _block_offset( 0 )
+{
+    unsigned char head[8] ;
+    if( _file.read( (char *)head, sizeof head ) != sizeof head )
+    {
+	corrupted( "the file is too short" ) ;
+    }
+    _file.seek( 0 ) ;
+
+    // a cbf file starts with the block control word of block 0, all zero
+    // except for the forward index. A madrigal file starts with the length
+    // of the first physical record.
+    if( !head[0] && !head[1] && !head[2] && !head[3] && !head[4] && !head[5]
+        && !( head[6] & 0xFE ) )
+    {
+	_format = CBF_FORMAT ;
+    }
+    else if( ( ( head[0] << 8 ) | head[1] ) == MADRIGAL_PHYS_WORDS )
+    {
+	_format = MADRIGAL_FORMAT ;
+	_block.resize( MADRIGAL_PHYS_WORDS * 2 ) ;
+    }
+    else
+    {
+	corrupted( "not a cbf or madrigal file" ) ;
+    }
+    BESDEBUG( "cedar", "CedarRawFile - " << filename << " is a "
+                       << (_format == CBF_FORMAT ? "cbf" : "madrigal")
+		       << " file" << endl ) ;
+}
+
+CedarRawFile::~CedarRawFile()
+{
+}
+
+void
+CedarRawFile::corrupted( const string &why )
+{
+    string err = (string)"Failure reading data from file " + _filename
+                 + ", " + why ;
+    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+}
+
+/** @brief XOR of nwords big endian 16 bit words, the checksum stored at
+ * the end of every physical record
+ */
+unsigned short
+CedarRawFile::checksum( const char *buf, size_t nwords )
+{
+    unsigned short sum = 0 ;
+    const unsigned char *p = (const unsigned char *)buf ;
+    for( size_t i = 0; i < nwords; i++, p += 2 )
+    {
+	sum ^= ( p[0] << 8 ) | p[1] ;
+    }
+    return sum ;
+}
+
+/** @brief read the next logical record from the file
+ *
+ * @param rec filled in with the bytes of the next logical record
+ * @return true if a record was read, false at the end of the data
+ * @throws BESInternalError if the file is truncated or corrupted
+ */
+bool
+CedarRawFile::next_record( CedarRawRecord &rec )
+{
+    if( _table )
+	add_point() ;
+    bool found = false ;
+    if( _format == CBF_FORMAT )
+	found = next_cbf_record( rec ) ;
+    else
+	found = next_madrigal_record( rec ) ;
+    if( found )
+    {
+	rec._ordinal = _ordinal++ ;
+    }
+    return found ;
+}
+
+/** @brief add the points of the file to table as it is read
+ *
+ * Called before the first record is read, the table then holds the
+ * points of the records read.
+ */
+void
+CedarRawFile::record( CedarSeekTable *table )
+{
+    _table = table ;
+    _file.record( &table->input, table->input_span ) ;
+}
+
+/** @brief add a point for the next record to the table if it is far
+ * enough from the last
+ *
+ * Only a record starting in the physical record read last gets a point.
+ */
+void
+CedarRawFile::add_point()
+{
+    CedarSeekTable::Point p ;
+    p.ordinal = _ordinal ;
+    if( _format == CBF_FORMAT )
+    {
+	if( _phys.empty() || _phys_pos + 2 > _phys_end )
+	    return ;
+	p.offset = _phys_offset ;
+	p.pending = _phys_pending ;
+	p.pos = _phys_pos ;
+    }
+    else
+    {
+	if( !_block_end )
+	    return ;
+	p.offset = _block_offset ;
+	p.pending = 0 ;
+	p.pos = _block_pos ;
+    }
+    vector<CedarSeekTable::Point> &points = _table->points ;
+    if( !points.empty() && ( p.ordinal <= points.back().ordinal
+			     || p.offset < points.back().offset
+					   + _table->span ) )
+    {
+	return ;
+    }
+    points.push_back( p ) ;
+}
+
+/** @brief go on reading from the last point of table before the record
+ * with ordinal
+ *
+ * @return false, leaving the reader where it was, if the table has no
+ * point before the record
+ * @throws BESInternalError if the file does not match the table
+ */
+bool
+CedarRawFile::seek( const CedarSeekTable &table, unsigned long ordinal )
+{
+    const CedarSeekTable::Point *p = table.find( ordinal ) ;
+    if( !p || p->ordinal <= _ordinal )
+	return false ;
+
+    BESDEBUG( "cedar", "CedarRawFile::seek - " << _filename << " record "
+		       << p->ordinal << " at " << p->offset << endl ) ;
+    _table = 0 ;
+    _eod = false ;
+    _file.seek( p->offset, table.input ) ;
+    if( _format == CBF_FORMAT )
+    {
+	_pending = p->pending ;
+	if( !read_cbf_physical() || p->pos + 2 > _phys_end )
+	    corrupted( "the seek table does not match the file" ) ;
+	_phys_pos = p->pos ;
+    }
+    else
+    {
+	_block_pos = 0 ;
+	_block_end = 0 ;
+	if( !read_madrigal_block() || p->pos > _block_end )
+	    corrupted( "the seek table does not match the file" ) ;
+	_block_pos = p->pos ;
+    }
+    _ordinal = p->ordinal ;
+    return true ;
+}
+
+/** @brief read the next logical record, the one the Cedar library returned
+ * as lr
+ *
+ * @throws BESInternalError if the record read does not match lr, meaning
+ * this reader and the Cedar library do not agree about the file
+ */
+void
+CedarRawFile::next_record( CedarRawRecord &rec, const CedarLogicalRecord &lr )
+{
+    if( !next_record( rec ) )
+    {
+	corrupted( "raw reader ran out of records before the Cedar library" ) ;
+    }
+    bool same = ( rec.get_type() == lr.get_type() ) ;
+    if( same && rec.get_type() == 1 )
+    {
+	const CedarDataRecord &dr = (const CedarDataRecord &)lr ;
+	same = ( rec.get_kinst() == dr.get_record_kind_instrument()
+	         && rec.get_kindat() == dr.get_record_kind_data()
+		 && rec.get_nrows() == dr.get_nrows() ) ;
+    }
+    if( !same )
+    {
+	corrupted( "raw reader and Cedar library disagree about a record" ) ;
+    }
+}
+
+/** @brief read the next cray record, one cedar physical record, into _phys
+ *
+ * Every 4096 byte block starts with a block control word and every cray
+ * record ends with a record control word. The forward index of each
+ * control word is the number of data words before the next control word.
+ */
+bool
+CedarRawFile::read_cbf_physical()
+{
+    _phys.clear() ;
+    _phys_pos = 0 ;
+    _phys_end = 0 ;
+    _phys_offset = _file.tell() ;
+    _phys_pending = _pending ;
+    bool done = false ;
+    while( !done && !_eod )
+    {
+	if( _pending )
+	{
+	    size_t old = _phys.size() ;
+	    size_t len = _pending * 8 ;
+	    _phys.resize( old + len ) ;
+	    if( _file.read( &_phys[old], len ) != len )
+	    {
+		corrupted( "the file is truncated" ) ;
+	    }
+	    _pending = 0 ;
+	}
+
+	unsigned char cw[8] ;
+	if( _file.read( (char *)cw, sizeof cw ) != sizeof cw )
+	{
+	    // no end of data control word, the end of the file will do
+	    _eod = true ;
+	    break ;
+	}
+	_pending = ( ( cw[6] & 0x01 ) << 8 ) | cw[7] ;
+	switch( cw[0] >> 4 )
+	{
+	    case COS_BCW:
+		break ;
+	    case COS_RCW:
+		done = !_phys.empty() ;
+		break ;
+	    case COS_EOF:
+		// more than one cos file can be packed in the dataset, keep
+		// going until the end of data
+		break ;
+	    case COS_EOD:
+		_eod = true ;
+		_pending = 0 ;
+		break ;
+	    default:
+		corrupted( "unknown control word" ) ;
+	}
+    }
+    if( _phys.size() < 4 )
+    {
+	return false ;
+    }
+
+    size_t nwords = ( (unsigned char)_phys[0] << 8 ) | (unsigned char)_phys[1] ;
+    if( nwords < 2 || nwords * 2 > _phys.size() )
+    {
+	corrupted( "bad physical record length" ) ;
+    }
+    // skip the length word, stop short of the checksum word
+    _phys_pos = 2 ;
+    _phys_end = ( nwords - 1 ) * 2 ;
+    return true ;
+}
+
+bool
+CedarRawFile::next_cbf_record( CedarRawRecord &rec )
+{
+    for( ;; )
+    {
+	while( _phys_pos + 2 > _phys_end )
+	{
+	    if( !read_cbf_physical() )
+		return false ;
+	}
+	const unsigned char *p = (const unsigned char *)&_phys[_phys_pos] ;
+	short ltot = (short)( ( p[0] << 8 ) | p[1] ) ;
+	if( ltot <= 0 )
+	{
+	    // padding at the end of the physical record
+	    _phys_pos = _phys_end ;
+	    continue ;
+	}
+	size_t len = ltot * 2 ;
+	if( _phys_pos + len > _phys_end )
+	{
+	    corrupted( "logical record crosses a physical record" ) ;
+	}
+	rec._bytes.assign( _phys.begin() + _phys_pos,
+	                   _phys.begin() + _phys_pos + len ) ;
+	_phys_pos += len ;
+	return true ;
+    }
+}
+
+/** @brief copy len bytes of the madrigal logical record stream into buf
+ *
+ * Logical records in a madrigal file span physical records. Each physical
+ * record is made of a length word, two words pointing at the first and
+ * last logical record starting in it, the data words, and the checksum as
+ * the last used word. The logical record stream is the concatenation of
+ * the data words.
+ */
+bool
+CedarRawFile::read_madrigal_words( char *buf, size_t len )
+{
+    while( len )
+    {
+	if( _block_pos == _block_end )
+	{
+	    if( !read_madrigal_block() )
+		return false ;
+	    continue ;
+	}
+	size_t n = _block_end - _block_pos ;
+	if( n > len ) n = len ;
+	memcpy( buf, &_block[_block_pos], n ) ;
+	_block_pos += n ;
+	buf += n ;
+	len -= n ;
+    }
+    return true ;
+}
+
+/** @brief read the next physical record of a madrigal file into _block
+ *
+ * @return false at the end of the file
+ */
+bool
+CedarRawFile::read_madrigal_block()
+{
+    if( _eod )
+	return false ;
+    _block_offset = _file.tell() ;
+    size_t got = _file.read( &_block[0], _block.size() ) ;
+    if( got < 8 )
+    {
+	_eod = true ;
+	return false ;
+    }
+    size_t nwords = ( (unsigned char)_block[0] << 8 )
+		    | (unsigned char)_block[1] ;
+    if( nwords < 4 || nwords * 2 > got )
+    {
+	corrupted( "bad physical record length" ) ;
+    }
+    _block_pos = 6 ;
+    _block_end = ( nwords - 1 ) * 2 ;
+    return true ;
+}
+
+bool
+CedarRawFile::next_madrigal_record( CedarRawRecord &rec )
+{
+    char lbuf[2] ;
+    if( !read_madrigal_words( lbuf, 2 ) )
+	return false ;
+    short ltot = (short)( ( (unsigned char)lbuf[0] << 8 )
+                          | (unsigned char)lbuf[1] ) ;
+    if( ltot <= 0 )
+    {
+	// the rest of the last physical record is unused
+	_eod = true ;
+	_block_pos = _block_end ;
+	return false ;
+    }
+    rec._bytes.resize( ltot * 2 ) ;
+    rec._bytes[0] = lbuf[0] ;
+    rec._bytes[1] = lbuf[1] ;
+    if( ltot > 1 && !read_madrigal_words( &rec._bytes[2], ( ltot - 1 ) * 2 ) )
+    {
+	corrupted( "the last logical record is truncated" ) ;
+    }
+    return true ;
+}
+
@@ -0,0 +1,294 @@
+// CedarRawFile.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarRawFile_h
+#define I_CedarRawFile_h 1
+
+#include <string>
+#include <vector>
+#include <map>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+
+#include "CedarInputFile.h"
+
+class CedarLogicalRecord ;
+
+// product name used for the cache key of a file's seek table
+#define CEDAR_SEEK_TABLE_PRODUCT "seek"
+
+// bytes of the file between the points of a seek table
+#define CEDAR_SEEK_SPAN 65536
+
+// bytes of the decompressed data between checkpoints of a compressed file
+#define CEDAR_SEEK_INPUT_SPAN 1048576
+
+// prologue word positions of a logical record
+#define CEDAR_RAW_LTOT		0
+#define CEDAR_RAW_KREC		1
+#define CEDAR_RAW_KINST		2
+#define CEDAR_RAW_KINDAT	3
+#define CEDAR_RAW_IBYRT		4
+#define CEDAR_RAW_IBDTT		5
+#define CEDAR_RAW_IBHMT		6
+#define CEDAR_RAW_IBCST		7
+#define CEDAR_RAW_IEYRT		8
+#define CEDAR_RAW_IEDTT		9
+#define CEDAR_RAW_IEHMT		10
+#define CEDAR_RAW_IECST		11
+#define CEDAR_RAW_LPROL		12
+#define CEDAR_RAW_JPAR		13
+#define CEDAR_RAW_MPAR		14
+#define CEDAR_RAW_NROW		15
+
+// value used in cedar files for a missing parameter value
+#define CEDAR_RAW_MISSING	-32767
+
+/** @brief a single logical record exactly as it is stored in a cedar file
+ *
+ * The record is kept as the big endian 16 bit words read from the file so
+ * that it can be written back out verbatim. Accessors are provided for the
+ * prologue words and for the parameter codes and values of data records.
+ */
+class CedarRawRecord
+{
+private:
+    vector<char>		_bytes ;
+    unsigned long		_ordinal ;
+
+    friend class		CedarRawFile ;
+    friend class		CedarAggregate ;
+public:
+    				CedarRawRecord() : _ordinal( 0 ) {}
+    virtual			~CedarRawRecord() {}
+
+    /** @brief number of bytes in the record, always twice the LTOT */
+    size_t			get_size() const { return _bytes.size() ; }
+    const char *		get_bytes() const { return &_bytes[0] ; }
+    unsigned int		get_word_count() const
+				{
+				    return _bytes.size() / 2 ;
+				}
+    /** @brief position of the record in the file, starting at 0 */
+    unsigned long		get_ordinal() const { return _ordinal ; }
+
+    void			swap( CedarRawRecord &other )
+				{
+				    _bytes.swap( other._bytes ) ;
+				    unsigned long o = _ordinal ;
+				    _ordinal = other._ordinal ;
+				    other._ordinal = o ;
+				}
+
+    /** @brief signed value of the 16 bit word at position i */
+    int				get_word( unsigned int i ) const
+				{
+				    return (short)
+					( ( (unsigned char)_bytes[2*i] << 8 ) |
+					  (unsigned char)_bytes[2*i+1] ) ;
+				}
+
+    int				get_krec() const
+				{
+				    return get_word( CEDAR_RAW_KREC ) ;
+				}
+    int				get_type() const ;
+    int				get_kinst() const
+				{
+				    return get_word( CEDAR_RAW_KINST ) ;
+				}
+    int				get_kindat() const
+				{
+				    return get_word( CEDAR_RAW_KINDAT ) ;
+				}
+
+    // these are only meaningful for data records, get_type() == 1
+    int				get_lprol() const
+				{
+				    return get_word( CEDAR_RAW_LPROL ) ;
+				}
+    int				get_jpar() const
+				{
+				    return get_word( CEDAR_RAW_JPAR ) ;
+				}
+    int				get_mpar() const
+				{
+				    return get_word( CEDAR_RAW_MPAR ) ;
+				}
+    int				get_nrows() const
+				{
+				    return get_word( CEDAR_RAW_NROW ) ;
+				}
+    int				get_jpar_code( int j ) const
+				{
+				    return get_word( get_lprol() + j ) ;
+				}
+    int				get_jpar_value( int j ) const
+				{
+				    return get_word( get_lprol() + get_jpar() + j ) ;
+				}
+    int				get_mpar_code( int m ) const
+				{
+				    return get_word( get_lprol() + 2*get_jpar() + m ) ;
+				}
+    int				get_mpar_value( int row, int m ) const
+				{
+				    return get_word( get_lprol() + 2*get_jpar()
+						     + get_mpar()
+						     + row*get_mpar() + m ) ;
+				}
+    bool			is_valid_data() const ;
+} ;
+
+/** @brief where the logical records of a cedar file start, so reading
+ * can start in the middle of the file
+ *
+ * A point is kept about every span bytes of the file, at the start of a
+ * logical record, with what the reader needs to go on from there: the
+ * offset of the physical record the logical record is in, the words of it
+ * before the next cray control word, and the position of the logical
+ * record in it. Offsets are into the decompressed data, so a table holds
+ * for a compressed file and for its decompressed copy alike. The
+ * checkpoints of the decompression are kept as well, about every
+ * input_span bytes of the decompressed data, see CedarInputFile, recorded
+ * while the file is read from its start or while its copy is made, see
+ * CedarPlainFile. Replay seeks in the compressed file through them.
+ *
+ * Seek tables are built alongside a read of every record of a file and
+ * kept keyed by the cache key of the file, so they change with the file.
+ */
+class CedarSeekTable
+{
+public:
+    typedef struct _cedar_seek_point
+    {
+	unsigned long ordinal ;
+	unsigned long long offset ;
+	unsigned int pending ;
+	size_t pos ;
+    } Point ;
+private:
+    static map<string,CedarSeekTable *> _tables ;
+public:
+    vector<Point>		points ;
+    vector<CedarInputFile::Point> input ;
+    unsigned long long		span ;
+    unsigned long long		input_span ;
+
+    				CedarSeekTable( unsigned long long s =
+						    CEDAR_SEEK_SPAN,
+						unsigned long long is =
+						    CEDAR_SEEK_INPUT_SPAN )
+				    : span( s ), input_span( is ) {}
+    virtual			~CedarSeekTable() {}
+
+    const Point *		find( unsigned long ordinal ) const ;
+
+    static const CedarSeekTable *get( const string &key ) ;
+    static void			add( const string &key,
+				     CedarSeekTable *table ) ;
+    static void			Clear() ;
+} ;
+
+/** @brief sequential reader of the logical records of a cedar file
+ *
+ * Reads the logical records of both the Cray blocked cbf files and the
+ * fixed length physical record files used by Madrigal (.001) without
+ * decoding them, so that the bytes of a record can be copied out
+ * untouched. The format is determined from the first bytes of the file.
+ * Files compressed with gzip or zstd are decompressed as they are read.
+ *
+ * The Cedar library remains the authority on what a record means and on
+ * whether it satisfies a constraint. Readers that need the raw bytes walk
+ * a CedarFile and a CedarRawFile in step, using the next_record method
+ * that takes the CedarLogicalRecord to make sure the two stay in sync.
+ */
+class CedarRawFile
+{
+public:
+    typedef enum
+    {
+	CBF_FORMAT,
+	MADRIGAL_FORMAT
+    } Format ;
+private:
+    string			_filename ;
+    CedarInputFile		_file ;
+    Format			_format ;
+    bool			_eod ;
+    unsigned long		_ordinal ;
+    CedarSeekTable *		_table ;
+
+    // cbf, the physical record being handed out and the data words that
+    // follow the last control word read
+    vector<char>		_phys ;
+    size_t			_phys_pos ;
+    size_t			_phys_end ;
+    unsigned int		_pending ;
+    unsigned long long		_phys_offset ;
+    unsigned int		_phys_pending ;
+
+    // madrigal, the physical record currently being read from
+    vector<char>		_block ;
+    size_t			_block_pos ;
+    size_t			_block_end ;
+    unsigned long long		_block_offset ;
+
+    void			add_point() ;
+    bool			read_cbf_physical() ;
+    bool			read_madrigal_block() ;
+    bool			next_cbf_record( CedarRawRecord &rec ) ;
+    bool			read_madrigal_words( char *buf, size_t len ) ;
+    bool			next_madrigal_record( CedarRawRecord &rec ) ;
+    void			corrupted( const string &why ) ;
+public:
+    				CedarRawFile( const string &filename ) ;
+    virtual			~CedarRawFile() ;
+
+    Format			get_format() const { return _format ; }
+
+    virtual bool		next_record( CedarRawRecord &rec ) ;
+    virtual void		next_record( CedarRawRecord &rec,
+					     const CedarLogicalRecord &lr ) ;
+    virtual void		record( CedarSeekTable *table ) ;
+    /** @brief read up to blocks 64K blocks of the file ahead on a thread
+     * of their own, 0 to stop, see CedarInputFile::read_ahead
+     */
+    void			read_ahead( size_t blocks )
+				{
+				    _file.read_ahead( blocks ) ;
+				}
+    virtual bool		seek( const CedarSeekTable &table,
+				      unsigned long ordinal ) ;
+
+    static unsigned short	checksum( const char *buf, size_t nwords ) ;
+} ;
+
+#endif // I_CedarRawFile_h
+
@@ -0,0 +1,298 @@
+// CedarRawOutput.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdio.h>
+
+#include "CedarRawOutput.h"
+#include "CedarValidators.h"
+#include "BESInternalError.h"
+
+CedarByteRange::CedarByteRange()
+    : _set( false ),
+      _suffix( false ),
+      _open( false ),
+      _first( 0 ),
+      _last( 0 )
+{
+}
+
+/** @brief parse a range specification such as bytes=100-199
+ *
+ * @param spec the range specification
+ * @return true if the specification was understood, false otherwise in
+ * which case the whole product should be sent
+ */
+bool
+CedarByteRange::parse( const string &spec )
+{
+    _set = _suffix = _open = false ;
+    _first = _last = 0 ;
+
+    string::size_type eq = spec.find( '=' ) ;
+    if( eq == string::npos || spec.substr( 0, eq ) != "bytes" )
+	return false ;
+    string r = spec.substr( eq + 1 ) ;
+    string::size_type dash = r.find( '-' ) ;
+    if( dash == string::npos || r.find( ',' ) != string::npos )
+	return false ;
+    string first = r.substr( 0, dash ) ;
+    string last = r.substr( dash + 1 ) ;
+    if( first.empty() && last.empty() )
+	return false ;
+    if( first.find_first_not_of( "0123456789" ) != string::npos
+        || last.find_first_not_of( "0123456789" ) != string::npos )
+	return false ;
+
+    if( first.empty() )
+    {
+	_suffix = true ;
+	_last = strtoull( last.c_str(), 0, 10 ) ;
+	if( _last == 0 )
+	    return false ;
+    }
+    else
+    {
+	_first = strtoull( first.c_str(), 0, 10 ) ;
+	if( last.empty() )
+	{
+	    _open = true ;
+	}
+	else
+	{
+	    _last = strtoull( last.c_str(), 0, 10 ) ;
+	    if( _last < _first )
+		return false ;
+	}
+    }
+    _set = true ;
+    return true ;
+}
+
+/** @brief the first and last byte positions of the range in a product of
+ * total bytes
+ *
+ * @return false if the range can not be satisfied
+ */
+bool
+CedarByteRange::resolve( unsigned long long total,
+                         unsigned long long &first,
+			 unsigned long long &last ) const
+{
+    if( !_set || total == 0 )
+	return false ;
+    if( _suffix )
+    {
+	first = ( _last >= total ) ? 0 : total - _last ;
+	last = total - 1 ;
+	return true ;
+    }
+    if( _first >= total )
+	return false ;
+    first = _first ;
+    last = ( _open || _last >= total ) ? total - 1 : _last ;
+    return true ;
+}
+
+/** @brief the first and last byte positions of the range when the size
+ * of the product is not yet known
+ *
+ * @return false for a suffix range, which needs the size of the product
+ */
+bool
+CedarByteRange::resolve( unsigned long long &first,
+                         unsigned long long &last ) const
+{
+    if( !_set || _suffix )
+	return false ;
+    first = _first ;
+    last = _open ? (unsigned long long)-1 : _last ;
+    return true ;
+}
+
+CedarRawOutput::CedarRawOutput( int fd )
+    : _fd( fd ),
+      _strm( 0 ),
+      _pos( 0 ),
+      _first( 0 ),
+      _last( 0 ),
+      _ranged( false )
+{
+}
+
+CedarRawOutput::CedarRawOutput( ostream &strm )
+    : _fd( -1 ),
+      _strm( &strm ),
+      _pos( 0 ),
+      _first( 0 ),
+      _last( 0 ),
+      _ranged( false )
+{
+}
+
+/** @brief the HTTP response header for a product
+ *
+ * @param content_type mime type of the product
+ * @param filename name suggested to the client for saving the product,
+ * none if empty
+ * @param encoding content encoding of the product, none if empty
+ * @param vary true if the encoding was chosen from the Accept-Encoding of
+ * the request
+ * @param length size of the product in bytes, not sent if -1
+ * @param content_range the part of the product sent, such as
+ * bytes 0-99/1000, in which case the status is 206 Partial Content
+ *
+ * The ETag and Last-Modified of the product being built are included if
+ * it has them, see CedarValidators.
+ */
+string
+CedarRawOutput::get_http_header( const string &content_type,
+                                 const string &filename,
+				 const string &encoding, bool vary,
+				 unsigned long long length,
+				 const string &content_range )
+{
+    string header = content_range.empty() ? "HTTP/1.0 200 OK\r\n"
+					  : "HTTP/1.0 206 Partial Content\r\n" ;
+    header += "Date: " + CedarValidators::http_date( time( 0 ) ) + "\r\n" ;
+    header += CedarValidators::get_http_header( encoding ) ;
+    header += "Content-Type: " + content_type + "\r\n" ;
+    if( !encoding.empty() )
+	header += "Content-Encoding: " + encoding + "\r\n" ;
+    if( vary )
+	header += "Vary: Accept-Encoding\r\n" ;
+    if( length != (unsigned long long)-1 )
+    {
+	char len[32] ;
+	snprintf( len, sizeof len, "%llu", length ) ;
+	header += (string)"Content-Length: " + len + "\r\n" ;
+    }
+    if( !content_range.empty() )
+	header += "Content-Range: " + content_range + "\r\n" ;
+    if( !filename.empty() )
+    {
+	header += "Content-Disposition: attachment; filename=\"" + filename
+		  + "\"\r\n" ;
+    }
+    header += "\r\n" ;
+    return header ;
+}
+
+/** @brief write the HTTP response header for a binary product
+ *
+ * The header is not part of the product, it does not count against the
+ * byte range.
+ *
+ * @param content_type mime type of the product
+ * @param filename name suggested to the client for saving the product
+ */
+void
+CedarRawOutput::set_mime( const string &content_type, const string &filename )
+{
+    string header = get_http_header( content_type, filename, "", false ) ;
+
+    unsigned long long pos = _pos ;
+    bool ranged = _ranged ;
+    _ranged = false ;
+    write( header.data(), header.length() ) ;
+    _ranged = ranged ;
+    _pos = pos ;
+}
+
+void
+CedarRawOutput::set_range( unsigned long long first, unsigned long long last )
+{
+    _first = first ;
+    _last = last ;
+    _ranged = true ;
+}
+
+/** @brief write the part of buf that falls within the range
+ *
+ * @throws BESInternalError if the write fails
+ */
+void
+CedarRawOutput::write( const char *buf, size_t len )
+{
+    unsigned long long start = _pos ;
+    _pos += len ;
+    if( ( _fd < 0 && !_strm ) || len == 0 )
+	return ;
+    if( _ranged )
+    {
+	if( _pos <= _first || start > _last )
+	    return ;
+	if( start < _first )
+	{
+	    buf += _first - start ;
+	    len -= _first - start ;
+	    start = _first ;
+	}
+	if( start + len - 1 > _last )
+	{
+	    len = _last - start + 1 ;
+	}
+    }
+    if( _strm )
+    {
+	_strm->write( buf, len ) ;
+	if( !(*_strm) )
+	{
+	    throw BESInternalError( "Failed to write the response",
+				    __FILE__, __LINE__ ) ;
+	}
+	return ;
+    }
+    while( len > 0 )
+    {
+	ssize_t written = ::write( _fd, buf, len ) ;
+	if( written < 0 )
+	{
+	    if( errno == EINTR )
+		continue ;
+	    string err = (string)"Failed to write the response: "
+	                 + strerror( errno ) ;
+	    throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	}
+	buf += written ;
+	len -= written ;
+    }
+}
+
+/** @brief true if every byte of the range has been written, nothing more
+ * needs to be generated
+ */
+bool
+CedarRawOutput::is_done() const
+{
+    return _ranged && _pos > _last ;
+}
+
@@ -0,0 +1,107 @@
+// CedarRawOutput.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarRawOutput_h
+#define I_CedarRawOutput_h 1
+
+#include <string>
+#include <iostream>
+
+using std::string ;
+using std::ostream ;
+
+/** @brief a byte range requested by the client, as in an HTTP Range header
+ *
+ * Understands a single range of the forms bytes=first-last, bytes=first-
+ * and bytes=-suffix. Lists of ranges are not supported.
+ */
+class CedarByteRange
+{
+private:
+    bool			_set ;
+    bool			_suffix ;
+    bool			_open ;
+    unsigned long long		_first ;
+    unsigned long long		_last ;
+public:
+    				CedarByteRange() ;
+    virtual			~CedarByteRange() {}
+
+    virtual bool		parse( const string &spec ) ;
+
+    bool			is_set() const { return _set ; }
+    bool			is_suffix() const { return _suffix ; }
+    virtual bool		resolve( unsigned long long total,
+					 unsigned long long &first,
+					 unsigned long long &last ) const ;
+    virtual bool		resolve( unsigned long long &first,
+					 unsigned long long &last ) const ;
+} ;
+
+/** @brief writes raw bytes to a file descriptor, optionally only the bytes
+ * that fall within a range
+ *
+ * The position is advanced for every byte handed to write whether or not
+ * it falls within the range, so a product can be generated from the start
+ * and only the requested part of it sent. An output created without a
+ * file descriptor or stream only counts bytes, which is how the size of a
+ * generated product is found.
+ */
+class CedarRawOutput
+{
+private:
+    int				_fd ;
+    ostream *			_strm ;
+    unsigned long long		_pos ;
+    unsigned long long		_first ;
+    unsigned long long		_last ;
+    bool			_ranged ;
+public:
+    				CedarRawOutput( int fd = -1 ) ;
+    				CedarRawOutput( ostream &strm ) ;
+    virtual			~CedarRawOutput() {}
+
+    virtual void		set_mime( const string &content_type,
+					  const string &filename ) ;
+
+    virtual void		set_range( unsigned long long first,
+					   unsigned long long last ) ;
+    virtual void		write( const char *buf, size_t len ) ;
+    virtual bool		is_done() const ;
+    unsigned long long		get_position() const { return _pos ; }
+
+    static string		get_http_header( const string &content_type,
+						 const string &filename,
+						 const string &encoding,
+						 bool vary,
+						 unsigned long long length =
+						     (unsigned long long)-1,
+						 const string &content_range = "" ) ;
+} ;
+
+#endif // I_CedarRawOutput_h
+
@@ -292,3 +292,12 @@ CedarReadKinst::Get_Altitude_as_String( int kinst )
     return strm.str() ;
 }
 
+/** @brief forget the stored instruments, they are read again from the
+ * Catalog database when next asked for
+ */
+void
+CedarReadKinst::Clear()
+{
+    CedarReadKinst::stored_list.clear() ;
+}
+
@@ -73,6 +73,8 @@ public:
     static string		Get_Latitude_as_String( int kinst ) ;
     static double		Get_Altitude( int kinst ) ;
     static string		Get_Altitude_as_String( int kinst ) ;
+
+    static void			Clear() ;
 };
 
 #endif // CedarReadKinst_h_
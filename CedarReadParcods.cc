@@ -30,6 +30,8 @@
 //      pwest       Patrick West <pwest@ucar.edu>
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
+#include "config_cedar.h"
+
 #include <sstream>
 #include <iostream>
 #include <cstdlib>
@@ -37,6 +39,10 @@
 using std::ostringstream ;
 using std::atoi ;
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "CedarReadParcods.h"
 #include "CedarDB.h"
 #include "CedarDBResult.h"
@@ -44,6 +50,30 @@ using std::atoi ;
 
 map<int,CedarReadParcods::CedarParameter> CedarReadParcods::stored_list ;
 
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t parcods_lock = PTHREAD_MUTEX_INITIALIZER ;
+#endif
+
+/** @brief holds the stored list to one thread while in scope, the
+ * products are formatted by several at once
+ */
+class ParcodsLock
+{
+public:
+    			ParcodsLock()
+			{
+#ifdef HAVE_PTHREAD
+			    pthread_mutex_lock( &parcods_lock ) ;
+#endif
+			}
+    			~ParcodsLock()
+			{
+#ifdef HAVE_PTHREAD
+			    pthread_mutex_unlock( &parcods_lock ) ;
+#endif
+			}
+} ;
+
 /** @brief given an parameter id load the information from the database
  *
  * Loads the information about the given parameter specified by the
@@ -115,6 +145,7 @@ CedarReadParcods::Load_Parameter( int param_id )
 string
 CedarReadParcods::Get_Code_as_String( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -132,6 +163,7 @@ CedarReadParcods::Get_Code_as_String( int param_id )
 string
 CedarReadParcods::Get_Shortname( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -147,6 +179,7 @@ CedarReadParcods::Get_Shortname( int param_id )
 string
 CedarReadParcods::Get_Longname( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -162,6 +195,7 @@ CedarReadParcods::Get_Longname( int param_id )
 string
 CedarReadParcods::Get_Madrigalname( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -177,6 +211,7 @@ CedarReadParcods::Get_Madrigalname( int param_id )
 string
 CedarReadParcods::Get_Scale( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -192,6 +227,7 @@ CedarReadParcods::Get_Scale( int param_id )
 string
 CedarReadParcods::Get_Unit_Label( int param_id )
 {
+    ParcodsLock lock ;
     CedarReadParcods::Load_Parameter( param_id ) ;
     map<int,CedarReadParcods::CedarParameter>::iterator iter ;
     iter = CedarReadParcods::stored_list.find( param_id ) ;
@@ -204,3 +240,13 @@ CedarReadParcods::Get_Unit_Label( int param_id )
     return iter->second.units ;
 }
 
+/** @brief forget the stored parameters, they are read again from the
+ * Catalog database when next asked for
+ */
+void
+CedarReadParcods::Clear()
+{
+    ParcodsLock lock ;
+    CedarReadParcods::stored_list.clear() ;
+}
+
@@ -63,6 +63,8 @@ public:
     static string		Get_Madrigalname( int param_id ) ;
     static string		Get_Scale( int param_id ) ;
     static string		Get_Unit_Label( int param_id ) ;
+
+    static void			Clear() ;
 };
 
 #endif // CedarReadParcods_h_
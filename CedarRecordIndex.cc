@@ -0,0 +1,210 @@
+// CedarRecordIndex.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <ctype.h>
+
+#include <memory>
+
+using std::auto_ptr ;
+
+#include "CedarRecordIndex.h"
+#include "cedar_read_descriptors.h"
+#include "CedarRawFile.h"
+#include "CedarInputFile.h"
+#include "CedarAggregate.h"
+#include "CedarCache.h"
+#include "CedarPipeline.h"
+
+const CedarPrologueWord cedar_prologue_words[CEDAR_PROLOGUE_WORDS] =
+{
+    { "KINST", CEDAR_RAW_KINST, "", false },
+    { "KINDAT", CEDAR_RAW_KINDAT, "", false },
+    { "IBYRT", CEDAR_RAW_IBYRT, "yr", false },
+    { "IBDTT", CEDAR_RAW_IBDTT, "mmdd", false },
+    { "IBHMT", CEDAR_RAW_IBHMT, "hhmm", false },
+    { "IBCST", CEDAR_RAW_IBCST, "s", true },
+    { "IEYRT", CEDAR_RAW_IEYRT, "yr", false },
+    { "IEDTT", CEDAR_RAW_IEDTT, "mmdd", false },
+    { "IEHMT", CEDAR_RAW_IEHMT, "hhmm", false },
+    { "IECST", CEDAR_RAW_IECST, "s", true }
+} ;
+
+/** @brief index the records of the files that satisfy qa
+ *
+ * @param files the cedar files
+ * @param qa the parsed constraint
+ * @throws BESInternalError if a file can not be read
+ */
+void
+CedarRecordIndex::build( const vector<string> &files,
+                         CedarConstraintEvaluator &qa )
+{
+    _records.clear() ;
+    _jpars.clear() ;
+    _mpars.clear() ;
+    _jseen.clear() ;
+    _mseen.clear() ;
+    _nrows = 0 ;
+    read( files, qa ) ;
+}
+
+/** @brief add a record to the index if it has any rows in the product
+ */
+void
+CedarRecordIndex::data_record( const CedarRawRecord &rec,
+                               const CedarRecordSelection &sel )
+{
+    unsigned long rows = sel.get_selected_rows() ;
+    // a record without rows still has its prologue and JPARs
+    if( rec.get_nrows() == 0 )
+	rows = 1 ;
+    if( !rows )
+	return ;
+
+    const vector<int> &jpar = sel.get_jpar() ;
+    for( size_t j = 0; j < jpar.size(); j++ )
+    {
+	int code = rec.get_jpar_code( jpar[j] ) ;
+	if( _jseen.insert( code ).second )
+	    _jpars.push_back( code ) ;
+    }
+    const vector<int> &mpar = sel.get_mpar() ;
+    for( size_t m = 0; m < mpar.size(); m++ )
+    {
+	int code = rec.get_mpar_code( mpar[m] ) ;
+	if( _mseen.insert( code ).second )
+	    _mpars.push_back( code ) ;
+    }
+
+    IndexedRecord entry ;
+    entry.ordinal = rec.get_ordinal() ;
+    entry.kindat = rec.get_kindat() ;
+    entry.selection = sel ;
+    _records.push_back( entry ) ;
+    _nrows += rows ;
+}
+
+/** @brief hand the indexed records of the files, in order, to reader
+ *
+ * Only the raw records are read, the decisions were all made while
+ * indexing. The files merge the same way they did then, so the records
+ * have the same ordinals. A compressed file is read from the copy
+ * decompressed while indexing, see CedarPlainFile, and a single file with
+ * a seek table is read from the point before each run of indexed records
+ * rather than from its start, in the compressed file itself if the table
+ * has the checkpoints of its decompression. The records are formatted and
+ * written by the stages of a CedarPipeline.
+ */
+void
+CedarRecordIndex::replay( const vector<string> &files,
+                          CedarRecordReader &reader ) const
+{
+    CedarPipeline stages( reader ) ;
+    if( files.size() == 1 && !_records.empty() )
+    {
+	const CedarSeekTable *table = CedarSeekTable::get(
+	    CedarCache::get_key( files[0], CEDAR_SEEK_TABLE_PRODUCT, "" ) ) ;
+	if( table )
+	{
+	    replay( files[0], *table, reader ) ;
+	    stages.finish() ;
+	    return ;
+	}
+    }
+
+    CedarAggregate merged( files, false ) ;
+    const CedarRawRecord *rec = 0 ;
+    vector<IndexedRecord>::const_iterator i = _records.begin() ;
+    vector<IndexedRecord>::const_iterator e = _records.end() ;
+    while( i != e && merged.next( rec ) )
+    {
+	if( rec->get_ordinal() != (*i).ordinal )
+	    continue ;
+	reader.deliver( *rec, (*i).selection ) ;
+	i++ ;
+    }
+    stages.finish() ;
+}
+
+/** @brief hand the indexed records of filename to reader, seeking to
+ * each run of records far from the one before
+ *
+ * A compressed file is decompressed from the last checkpoint of the table
+ * before each run, so its copy is not needed, and is not made again if it
+ * has been removed. Without checkpoints the copy is read.
+ */
+void
+CedarRecordIndex::replay( const string &filename,
+                          const CedarSeekTable &table,
+                          CedarRecordReader &reader ) const
+{
+    auto_ptr<CedarPlainFile> plain ;
+    string path = filename ;
+    if( table.input.empty() )
+    {
+	plain.reset( new CedarPlainFile( filename ) ) ;
+	path = plain->get_path() ;
+    }
+    CedarRawFile raw( path ) ;
+    raw.read_ahead( CedarPipeline::get_read_ahead() ) ;
+    CedarRawRecord rec ;
+    vector<IndexedRecord>::const_iterator i = _records.begin() ;
+    vector<IndexedRecord>::const_iterator e = _records.end() ;
+    while( i != e )
+    {
+	raw.seek( table, (*i).ordinal ) ;
+	if( !raw.next_record( rec ) )
+	    break ;
+	if( rec.get_ordinal() != (*i).ordinal )
+	    continue ;
+	reader.deliver( rec, (*i).selection ) ;
+	i++ ;
+    }
+}
+
+/** @brief the name of the column for a parameter code
+ *
+ * The madrigal name of the parameter, as used in the DDS, with anything
+ * other than letters, digits and underscores replaced so the name is safe
+ * in binary formats. Names are not guaranteed to be unique.
+ */
+string
+CedarRecordIndex::get_column_name( int code )
+{
+    string name ;
+    get_name_for_parameter( name, code ) ;
+    for( string::size_type i = 0; i < name.length(); i++ )
+    {
+	char c = name[i] ;
+	if( !isalnum( c ) && c != '_' )
+	    name[i] = '_' ;
+    }
+    if( name.empty() || isdigit( name[0] ) )
+	name = "_" + name ;
+    return name ;
+}
+
@@ -0,0 +1,112 @@
+// CedarRecordIndex.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarRecordIndex_h
+#define I_CedarRecordIndex_h 1
+
+#include <string>
+#include <vector>
+#include <set>
+
+using std::string ;
+using std::vector ;
+using std::set ;
+
+#include "CedarRecordSelection.h"
+#include "CedarRecordReader.h"
+
+class CedarSeekTable ;
+
+/** @brief a prologue word written with every row of a binary product
+ */
+typedef struct _cedar_prologue_word
+{
+    const char *name ;
+    int word ;
+    const char *units ;
+    bool centi ;
+} CedarPrologueWord ;
+
+#define CEDAR_PROLOGUE_WORDS 10
+
+extern const CedarPrologueWord cedar_prologue_words[CEDAR_PROLOGUE_WORDS] ;
+
+/** @brief the data records of a cedar file, and the rows and parameters
+ * of each, that satisfy a constraint
+ *
+ * Some products need to know how many rows they hold, and which
+ * parameters, before any data is written. Once the index is built the
+ * indexed records can be replayed to a reader from the raw records alone,
+ * without the Cedar library or the constraint.
+ */
+class CedarRecordIndex : public CedarRecordReader
+{
+public:
+    typedef struct _cedar_indexed_record
+    {
+	unsigned long ordinal ;
+	int kindat ;
+	CedarRecordSelection selection ;
+    } IndexedRecord ;
+private:
+    vector<IndexedRecord>	_records ;
+    vector<int>			_jpars ;
+    vector<int>			_mpars ;
+    set<int>			_jseen ;
+    set<int>			_mseen ;
+    unsigned long		_nrows ;
+
+    void			replay( const string &filename,
+					const CedarSeekTable &table,
+					CedarRecordReader &reader ) const ;
+public:
+    				CedarRecordIndex() : _nrows( 0 ) {}
+    virtual			~CedarRecordIndex() {}
+
+    virtual void		build( const vector<string> &files,
+				       CedarConstraintEvaluator &qa ) ;
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) ;
+    /** @brief indexing a record costs less than handing it to a thread */
+    virtual bool		is_staged() const { return false ; }
+    virtual void		replay( const vector<string> &files,
+					CedarRecordReader &reader ) const ;
+
+    /** @brief the records with rows in the product, in the order read */
+    const vector<IndexedRecord> &get_records() const { return _records ; }
+    /** @brief the JPAR codes of the records, in the order first seen */
+    const vector<int> &		get_jpars() const { return _jpars ; }
+    /** @brief the MPAR codes of the records, in the order first seen */
+    const vector<int> &		get_mpars() const { return _mpars ; }
+    /** @brief rows in the product, a record without rows counts as one */
+    unsigned long		get_nrows() const { return _nrows ; }
+
+    static string		get_column_name( int code ) ;
+} ;
+
+#endif // I_CedarRecordIndex_h
+
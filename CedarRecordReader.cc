@@ -0,0 +1,256 @@
+// CedarRecordReader.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <memory>
+
+using std::auto_ptr ;
+
+#include "CedarRecordReader.h"
+#include "CedarRecordSelection.h"
+#include "CedarFile.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarRawFile.h"
+#include "CedarInputFile.h"
+#include "CedarZoneMap.h"
+#include "CedarCache.h"
+#include "CedarAggregate.h"
+#include "CedarPipeline.h"
+#include "BESInternalError.h"
+
+/** @brief call data_record for every data record of the files that
+ * satisfies qa
+ *
+ * The records of several files are merged in time order, see
+ * CedarAggregate. The records are formatted and written by the stages of
+ * a CedarPipeline.
+ *
+ * @param files the cedar files
+ * @param qa the parsed constraint
+ * @throws BESInternalError if a file can not be read
+ */
+void
+CedarRecordReader::read( const vector<string> &files,
+                         CedarConstraintEvaluator &qa )
+{
+    CedarPipeline stages( *this ) ;
+    if( files.size() == 1 )
+	read_file( files[0], qa ) ;
+    else
+	read_files( files, qa ) ;
+    stages.finish() ;
+}
+
+/** @brief call data_record for every data record of filename that
+ * satisfies qa
+ *
+ * With a value constraint the zone map of the file is used to pass or
+ * fail whole records without checking their rows. It is built during the
+ * first such read of the file and kept once every record has been seen.
+ * The seek table of the file is built the same way during the first read
+ * of it.
+ *
+ * A compressed file is read, by both the Cedar library and the raw
+ * reader, from its decompressed copy, see CedarPlainFile, so it is only
+ * decompressed by the first request for it. The checkpoints of that
+ * decompression go into the seek table being built, so replay can seek
+ * in the compressed file itself. The raw records are read ahead on a
+ * thread of their own, warming the pages of the file for the library
+ * too.
+ *
+ * @param filename the cedar file
+ * @param qa the parsed constraint
+ * @throws BESInternalError if the file can not be read
+ */
+void
+CedarRecordReader::read_file( const string &filename,
+                              CedarConstraintEvaluator &qa )
+{
+    // the table outlives the read ahead filling it
+    string seek_key = CedarCache::get_key( filename, CEDAR_SEEK_TABLE_PRODUCT,
+					   "" ) ;
+    auto_ptr<CedarSeekTable> table ;
+    if( !CedarSeekTable::get( seek_key ) )
+	table.reset( new CedarSeekTable ) ;
+
+    CedarPlainFile plain( filename, table.get() ? &table->input : 0,
+			  table.get() ? table->input_span : 0 ) ;
+    CedarFile file ;
+    file.open_file( plain.get_path().c_str() ) ;
+    CedarRawFile raw( plain.get_path() ) ;
+    CedarRawRecord rec ;
+    CedarRecordSelection sel ;
+    if( table.get() )
+	raw.record( table.get() ) ;
+    raw.read_ahead( CedarPipeline::get_read_ahead() ) ;
+
+    string key ;
+    const CedarZoneMap *zones = 0 ;
+    auto_ptr<CedarZoneMap> building ;
+    if( qa.got_parameter_constraint() )
+    {
+	key = CedarCache::get_key( filename, CEDAR_ZONE_MAP_PRODUCT, "" ) ;
+	zones = CedarZoneMap::get( key ) ;
+	if( !zones )
+	{
+	    building.reset( new CedarZoneMap ) ;
+	    zones = building.get() ;
+	}
+    }
+    CedarZoneFilter filter( qa, zones ) ;
+
+    const CedarLogicalRecord *lr = file.get_first_logical_record() ;
+    if( !lr )
+    {
+	string err = (string)"Failure reading data from file " + filename
+		     + ", corrupted file or not a cbf file." ;
+	throw BESInternalError( err, __FILE__, __LINE__ ) ;
+    }
+    while( lr && !is_stopped() )
+    {
+	raw.next_record( rec, *lr ) ;
+	if( building.get() )
+	    building->add_record( rec ) ;
+	if( rec.get_type() == 1 && rec.is_valid_data()
+	    && qa.validate_record( lr ) )
+	{
+	    sel.select( rec, qa, zones ? &filter : 0 ) ;
+	    deliver( rec, sel ) ;
+	}
+	lr = 0 ;
+	if( !file.end_dataset() )
+	    lr = file.get_next_logical_record() ;
+    }
+    // the read ahead adds no more checkpoints to the table once stopped
+    raw.read_ahead( 0 ) ;
+
+    // a read stopped early has not seen every record
+    if( building.get() && !lr )
+	CedarZoneMap::add( key, building.release() ) ;
+    if( table.get() && !lr )
+	CedarSeekTable::add( seek_key, table.release() ) ;
+}
+
+/** @brief call data_record for every data record of the merged files
+ * that satisfies qa
+ *
+ * The records are numbered as they are merged, so the zone maps of the
+ * files, kept by position in the file, are not used.
+ */
+void
+CedarRecordReader::read_files( const vector<string> &files,
+                               CedarConstraintEvaluator &qa )
+{
+    CedarAggregate merged( files, true ) ;
+    CedarRecordSelection sel ;
+    const CedarLogicalRecord *lr = 0 ;
+    const CedarRawRecord *rec = 0 ;
+    while( !is_stopped() && merged.next( lr, rec ) )
+    {
+	if( rec->get_type() == 1 && rec->is_valid_data()
+	    && qa.validate_record( lr ) )
+	{
+	    sel.select( *rec, qa ) ;
+	    deliver( *rec, sel ) ;
+	}
+    }
+}
+
+/** @brief hand a selected record to data_record, on the format stage if
+ * a pipeline is attached
+ *
+ * @throws BESInternalError if a stage of the pipeline has failed
+ */
+void
+CedarRecordReader::deliver( const CedarRawRecord &rec,
+                            const CedarRecordSelection &sel )
+{
+    if( _pipeline )
+	_pipeline->put( rec, sel ) ;
+    else
+	data_record( rec, sel ) ;
+}
+
+/** @brief hand a piece of the formatted product to write, on the write
+ * stage if a pipeline is attached
+ *
+ * @param data the formatted bytes, left empty
+ */
+void
+CedarRecordReader::output( string &data )
+{
+    if( _pipeline )
+    {
+	_pipeline->output( data ) ;
+    }
+    else
+    {
+	write( data ) ;
+	data.erase() ;
+    }
+}
+
+/** @brief true once no more records are wanted
+ *
+ * is_done asked on the thread decoding the records, or the format stage
+ * being done if a pipeline is attached.
+ */
+bool
+CedarRecordReader::is_stopped() const
+{
+    if( _pipeline )
+	return _pipeline->is_done() ;
+    return is_done() ;
+}
+
+/** @brief true if rec is laid out differently from the record before it
+ *
+ * The layout is the KINDAT, the number of JPARs and MPARs of the record
+ * and the codes of the selected parameters. The first record is always a
+ * change.
+ */
+bool
+CedarRecordReader::schema_changed( const CedarRawRecord &rec,
+                                   const CedarRecordSelection &sel )
+{
+    const vector<int> &jpar = sel.get_jpar() ;
+    const vector<int> &mpar = sel.get_mpar() ;
+    _schema.clear() ;
+    _schema.push_back( rec.get_kindat() ) ;
+    _schema.push_back( rec.get_jpar() ) ;
+    _schema.push_back( rec.get_mpar() ) ;
+    _schema.push_back( jpar.size() ) ;
+    size_t i = 0 ;
+    for( i = 0; i < jpar.size(); i++ )
+	_schema.push_back( rec.get_jpar_code( jpar[i] ) ) ;
+    for( i = 0; i < mpar.size(); i++ )
+	_schema.push_back( rec.get_mpar_code( mpar[i] ) ) ;
+    if( !_last.empty() && _schema == _last )
+	return false ;
+    _last.swap( _schema ) ;
+    return true ;
+}
+
@@ -0,0 +1,136 @@
+// CedarRecordReader.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarRecordReader_h
+#define I_CedarRecordReader_h 1
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+class CedarRawRecord ;
+class CedarRecordSelection ;
+class CedarConstraintEvaluator ;
+class CedarPipeline ;
+
+/** @brief walks the data records of a cedar file, or of several merged in
+ * time order, that satisfy a constraint, handing each to data_record along
+ * with the parameters and rows selected from it
+ *
+ * This is the one record loop shared by the products. The Cedar library
+ * decides which records satisfy the constraint while the values are taken
+ * from the raw record read alongside, so a product only has to format the
+ * words it is given.
+ *
+ * The records are delivered to a CedarPipeline that formats them, and
+ * writes the product, on threads of their own while the next records are
+ * read, see CedarPipeline.
+ */
+class CedarRecordReader
+{
+private:
+    vector<int>			_schema ;
+    vector<int>			_last ;
+    CedarPipeline *		_pipeline ;
+
+    friend class		CedarPipeline ;
+
+    void			read_file( const string &filename,
+					   CedarConstraintEvaluator &qa ) ;
+    void			read_files( const vector<string> &files,
+					    CedarConstraintEvaluator &qa ) ;
+public:
+    				CedarRecordReader() : _pipeline( 0 ) {}
+    virtual			~CedarRecordReader() {}
+
+    virtual void		read( const vector<string> &files,
+				      CedarConstraintEvaluator &qa ) ;
+
+    /** @brief called for each data record satisfying the constraint
+     *
+     * @param rec the raw record
+     * @param sel the parameters and rows of the record that were selected
+     */
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) = 0 ;
+
+    /** @brief called with each piece of the formatted product
+     *
+     * @param data the next bytes of the product
+     */
+    virtual void		write( const string & ) {}
+
+    void			deliver( const CedarRawRecord &rec,
+					 const CedarRecordSelection &sel ) ;
+    void			output( string &data ) ;
+    bool			is_stopped() const ;
+
+    virtual bool		schema_changed( const CedarRawRecord &rec,
+						const CedarRecordSelection &sel ) ;
+
+    /** @brief true if the records are formatted on a stage of their own
+     * when a pipeline is started for the reader
+     */
+    virtual bool		is_staged() const { return true ; }
+
+    /** @brief a copy of the reader for a worker of the pipeline to format
+     * records with, 0 if the records must all be formatted by this reader
+     * in turn
+     *
+     * The records of a reader that makes workers are each marked by
+     * mark_record, in order, then formatted by format_record on whichever
+     * worker is free. is_done is not asked. The pipeline deletes the
+     * workers.
+     */
+    virtual CedarRecordReader *	make_worker() const { return 0 ; }
+
+    /** @brief the part of formatting a record that depends on the records
+     * before it, called for each record in order
+     *
+     * @return what format_record needs to know of the records before
+     */
+    virtual int			mark_record( const CedarRawRecord &,
+					     const CedarRecordSelection & )
+				{
+				    return 0 ;
+				}
+
+    /** @brief format a record marked by mark_record onto the end of out,
+     * called on a worker
+     */
+    virtual void		format_record( const CedarRawRecord &,
+					       const CedarRecordSelection &,
+					       int, string & ) {}
+
+    /** @brief true once the reader needs no more records */
+    virtual bool		is_done() const { return false ; }
+} ;
+
+#endif // I_CedarRecordReader_h
+
@@ -0,0 +1,95 @@
+// CedarRecordSelection.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarRecordSelection.h"
+#include "CedarRawFile.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarParameter.h"
+#include "CedarZoneMap.h"
+
+/** @brief select the parameters and rows of rec that satisfy qa
+ *
+ * @param rec a valid data record
+ * @param qa the parsed constraint
+ * @param zones zones of the record's parameters, the rows of every
+ * parameter with a value constraint are checked if null
+ */
+void
+CedarRecordSelection::select( const CedarRawRecord &rec,
+                              CedarConstraintEvaluator &qa,
+			      CedarZoneFilter *zones )
+{
+    _jpar.clear() ;
+    int jpar = rec.get_jpar() ;
+    for( int j = 0; j < jpar; j++ )
+    {
+	if( qa.validate_parameter( rec.get_jpar_code( j ) ) )
+	    _jpar.push_back( j ) ;
+    }
+
+    _mpar.clear() ;
+    int mpar = rec.get_mpar() ;
+    for( int m = 0; m < mpar; m++ )
+    {
+	if( qa.validate_parameter( rec.get_mpar_code( m ) ) )
+	    _mpar.push_back( m ) ;
+    }
+
+    int nrows = rec.get_nrows() ;
+    _rows.assign( nrows, true ) ;
+    _nselected = nrows ;
+    if( !qa.got_parameter_constraint() )
+	return ;
+
+    // a parameter at a time, so each parameter is looked up only once
+    vector<int>::const_iterator i = _mpar.begin() ;
+    vector<int>::const_iterator e = _mpar.end() ;
+    for( ; i != e && _nselected; i++ )
+    {
+	CedarZoneFilter::Match match = CedarZoneFilter::SOME ;
+	if( zones )
+	    match = zones->match( rec, *i ) ;
+	if( match == CedarZoneFilter::ALL )
+	    continue ;
+	if( match == CedarZoneFilter::NONE )
+	{
+	    _rows.assign( nrows, false ) ;
+	    _nselected = 0 ;
+	    break ;
+	}
+	CedarParameter pp = qa.get_parameter( rec.get_mpar_code( *i ) ) ;
+	for( int row = 0; row < nrows; row++ )
+	{
+	    if( _rows[row] && !pp.validateValue( rec.get_mpar_value( row, *i ) ) )
+	    {
+		_rows[row] = false ;
+		_nselected-- ;
+	    }
+	}
+    }
+}
+
@@ -0,0 +1,87 @@
+// CedarRecordSelection.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarRecordSelection_h
+#define I_CedarRecordSelection_h 1
+
+#include <vector>
+
+using std::vector ;
+
+class CedarRawRecord ;
+class CedarConstraintEvaluator ;
+class CedarZoneFilter ;
+
+/** @brief the parameters and rows of a data record selected by a constraint
+ *
+ * The JPAR and MPAR parameters are selected with validate_parameter. A row
+ * is selected when the values of all of the selected MPAR parameters in
+ * that row pass the value constraint of the parameter, the rule applied
+ * by the flat and tab products. Given a zone filter, a parameter whose
+ * zone in the record passes or fails every row has its rows left alone.
+ */
+class CedarRecordSelection
+{
+private:
+    vector<int>			_jpar ;
+    vector<int>			_mpar ;
+    vector<bool>		_rows ;
+    unsigned int		_nselected ;
+public:
+    				CedarRecordSelection() : _nselected( 0 ) {}
+    virtual			~CedarRecordSelection() {}
+
+    virtual void		select( const CedarRawRecord &rec,
+					CedarConstraintEvaluator &qa,
+					CedarZoneFilter *zones = 0 ) ;
+
+    /** @brief positions, within the record, of the selected JPARs */
+    const vector<int> &		get_jpar() const { return _jpar ; }
+    /** @brief positions, within the record, of the selected MPARs */
+    const vector<int> &		get_mpar() const { return _mpar ; }
+    bool			is_row_selected( int row ) const
+				{
+				    return _rows[row] ;
+				}
+    unsigned int		get_selected_rows() const
+				{
+				    return _nselected ;
+				}
+
+    void			swap( CedarRecordSelection &other )
+				{
+				    _jpar.swap( other._jpar ) ;
+				    _mpar.swap( other._mpar ) ;
+				    _rows.swap( other._rows ) ;
+				    unsigned int n = _nselected ;
+				    _nselected = other._nselected ;
+				    other._nselected = n ;
+				}
+} ;
+
+#endif // I_CedarRecordSelection_h
+
@@ -50,14 +50,33 @@
 #include "cedar_read_flat.h"
 #include "CedarFlat.h"
 #include "cedar_read_stream.h"
+#include "cedar_read_cbf.h"
+#include "cedar_read_netcdf.h"
+#include "cedar_read_arrow.h"
+#include "cedar_read_csv.h"
+#include "CedarCSV.h"
+#include "cedar_read_jsonl.h"
+#include "CedarJSONL.h"
+#include "cedar_read_size.h"
+#include "CedarCache.h"
+#include "CedarCacheProducers.h"
+#include "CedarRawOutput.h"
+#include "CedarValidators.h"
 #include <BESVersionInfo.h>
 #include "cedar_read_info.h"
+#include "cedar_read_archive.h"
+#include "CedarArchive.h"
+#include "CedarAggregate.h"
 #include "CedarVersion.h"
 #include "CedarAuthenticate.h"
 #include <TheBESKeys.h>
+#include <BESContextManager.h>
 #include <BESDebug.h>
 #include <BESServiceRegistry.h>
 #include "config_cedar.h"
+#include <BaseTypeFactory.h>
+
+#include <unistd.h>
 
 CedarRequestHandler::CedarRequestHandler( string name )
     : BESRequestHandler( name )
@@ -67,8 +86,15 @@ CedarRequestHandler::CedarRequestHandler( string name )
     add_handler( DATA_RESPONSE, CedarRequestHandler::cedar_build_data ) ;
     add_handler( FLAT_RESPONSE, CedarRequestHandler::cedar_build_flat ) ;
     add_handler( STREAM_RESPONSE, CedarRequestHandler::cedar_build_stream ) ;
+    add_handler( CBF_RESPONSE, CedarRequestHandler::cedar_build_cbf ) ;
+    add_handler( NETCDF_RESPONSE, CedarRequestHandler::cedar_build_netcdf ) ;
+    add_handler( ARROW_RESPONSE, CedarRequestHandler::cedar_build_arrow ) ;
+    add_handler( CSV_RESPONSE, CedarRequestHandler::cedar_build_csv ) ;
+    add_handler( JSONL_RESPONSE, CedarRequestHandler::cedar_build_jsonl ) ;
+    add_handler( SIZE_RESPONSE, CedarRequestHandler::cedar_build_size ) ;
     add_handler( TAB_RESPONSE, CedarRequestHandler::cedar_build_tab ) ;
     add_handler( INFO_RESPONSE, CedarRequestHandler::cedar_build_info ) ;
+    add_handler( ARCHIVE_RESPONSE, CedarRequestHandler::cedar_build_archive ) ;
     add_handler( VERS_RESPONSE, CedarRequestHandler::cedar_build_vers ) ;
     add_handler( HELP_RESPONSE, CedarRequestHandler::cedar_build_help ) ;
 }
@@ -94,11 +120,261 @@ CedarRequestHandler::dump( ostream &strm ) const
     BESIndent::UnIndent() ;
 }
 
+/** @brief the product a cache key is made for, with what else the
+ * product depends on
+ */
+static string
+cedar_cache_product( const string &product, const string &more )
+{
+    return more.empty() ? product : product + " " + more ;
+}
+
+/** @brief the constraint the attributes of filename depend on, only
+ * those of an aggregate do
+ */
+static string
+cedar_attributes_query( const string &filename, const string &query )
+{
+    return CedarAggregate::is_aggregate( filename ) ? query : "" ;
+}
+
+/** @brief read the attributes of a cedar file, from the cache if there is
+ * one
+ */
+static void
+cedar_attributes( DAS &das, const string &filename, const string &query )
+{
+    string constraint = cedar_attributes_query( filename, query ) ;
+    CedarDASProducer producer( filename, constraint ) ;
+    int fd = CedarCache::get_product( filename, DAS_RESPONSE, constraint,
+				      producer ) ;
+    if( fd >= 0 )
+    {
+	try
+	{
+	    das.parse( fd ) ;
+	}
+	catch( ... )
+	{
+	    close( fd ) ;
+	    throw ;
+	}
+	close( fd ) ;
+	return ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_attributes( das, filename, constraint, cedar_error ) )
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+}
+
+/** @brief read the descriptors of the records of a cedar file satisfying
+ * the constraint, from the cache if there is one
+ *
+ * The cached DDS is parsed with a factory of its own and its variables
+ * copied to dds.
+ */
+static void
+cedar_descriptors( DDS &dds, const string &filename, const string &name,
+                   const string &query )
+{
+    CedarDDSProducer producer( filename, name, query ) ;
+    int fd = CedarCache::get_product( filename,
+				      cedar_cache_product( DDS_RESPONSE,
+							   name ),
+				      query, producer ) ;
+    if( fd >= 0 )
+    {
+	BaseTypeFactory factory ;
+	DDS cached( &factory ) ;
+	try
+	{
+	    cached.parse( fd ) ;
+	}
+	catch( ... )
+	{
+	    close( fd ) ;
+	    throw ;
+	}
+	close( fd ) ;
+	dds.set_dataset_name( cached.get_dataset_name() ) ;
+	for( DDS::Vars_iter i = cached.var_begin(); i != cached.var_end(); i++ )
+	    dds.add_var( *i ) ;
+	return ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_descriptors( dds, filename, name, query, cedar_error ) )
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+}
+
+/** @brief add a text product to the response from the cache, generating
+ * it first if it is not cached
+ *
+ * If another request is generating the product it is followed, added to
+ * the response as it is written.
+ *
+ * @return false if there is no cache, the product is to be formatted into
+ * the response as usual
+ */
+static bool
+cedar_send_cached( BESInfo &info, const string &product,
+                   const string &filename, const string &query,
+		   bool compact = false )
+{
+    CedarTextProducer producer( product, filename, query, compact ) ;
+    bool partial = false ;
+    int fd = CedarCache::get_product( filename,
+				      cedar_cache_product( product,
+				          compact ? "compact" : "" ),
+				      query, producer, partial ) ;
+    if( fd < 0 )
+	return false ;
+    try
+    {
+	if( partial )
+	    CedarCache::follow( fd, info ) ;
+	else
+	    CedarCache::send( fd, info, 0, CedarCache::get_length( fd ) ) ;
+    }
+    catch( ... )
+    {
+	close( fd ) ;
+	throw ;
+    }
+    close( fd ) ;
+    return true ;
+}
+
+/** @brief send a netcdf or arrow product from the cache, generating it
+ * first if it is not cached
+ *
+ * If another request is generating the product it is followed, sent as
+ * it is written and without a Content-Length.
+ *
+ * @return false if there is no cache, the product is to be written as
+ * usual
+ */
+static bool
+cedar_send_cached( ostream &strm, bool is_http, const string &product,
+                   const string &filename, const string &name,
+		   const string &query, const string &content_type,
+		   const string &suffix )
+{
+    CedarBinaryProducer producer( product, filename, name, query ) ;
+    bool partial = false ;
+    int fd = CedarCache::get_product( filename,
+				      cedar_cache_product( product, name ),
+				      query, producer, partial ) ;
+    if( fd < 0 )
+	return false ;
+    try
+    {
+	unsigned long long length = partial ? (unsigned long long)-1
+					    : CedarCache::get_length( fd ) ;
+	if( is_http )
+	{
+	    strm << CedarRawOutput::get_http_header( content_type,
+						     name + suffix, "",
+						     false, length ) ;
+	}
+	if( partial )
+	    CedarCache::follow( fd, strm ) ;
+	else
+	    CedarCache::send( fd, strm, 0, length ) ;
+    }
+    catch( ... )
+    {
+	close( fd ) ;
+	throw ;
+    }
+    close( fd ) ;
+    return true ;
+}
+
+/** @brief add the flat product, or the requested range of it, to the
+ * response from the cache, generating it first if it is not cached
+ *
+ * If another request is generating the product the whole product is
+ * followed, added to the response as it is written and without a
+ * Content-Length. A range waits for the product to be finished.
+ *
+ * @return false if there is no cache, the product is to be formatted into
+ * the response as usual
+ */
+static bool
+cedar_send_cached_flat( CedarFlat &flat, const string &filename,
+                        const string &query, const string &range,
+			bool compact )
+{
+    CedarTextProducer producer( FLAT_RESPONSE, filename, query, compact ) ;
+    string product = cedar_cache_product( FLAT_RESPONSE,
+					  compact ? "compact" : "" ) ;
+    bool partial = false ;
+    int fd = -1 ;
+    if( range.empty() )
+	fd = CedarCache::get_product( filename, product, query, producer,
+				      partial ) ;
+    else
+	fd = CedarCache::get_product( filename, product, query, producer ) ;
+    if( fd < 0 )
+	return false ;
+    if( partial )
+    {
+	try
+	{
+	    CedarCache::follow( fd, flat ) ;
+	}
+	catch( ... )
+	{
+	    close( fd ) ;
+	    throw ;
+	}
+	close( fd ) ;
+	return true ;
+    }
+    try
+    {
+	unsigned long long total = CedarCache::get_length( fd ) ;
+	unsigned long long first = 0 ;
+	unsigned long long last = total - 1 ;
+	CedarByteRange br ;
+	if( !range.empty() && br.parse( range ) )
+	{
+	    if( !br.resolve( total, first, last ) )
+	    {
+		string err = "The requested range can not be satisfied for file "
+			     + filename ;
+		throw BESInternalError( err, __FILE__, __LINE__ ) ;
+	    }
+	    flat.set_range( first, last, total ) ;
+	}
+	else
+	{
+	    flat.set_length( total ) ;
+	}
+	if( total )
+	    CedarCache::send( fd, flat, first, last - first + 1 ) ;
+    }
+    catch( ... )
+    {
+	close( fd ) ;
+	throw ;
+    }
+    close( fd ) ;
+    return true ;
+}
+
 bool
 CedarRequestHandler::cedar_build_das( BESDataHandlerInterface &dhi )
 {
     BESDEBUG( "cedar", "building cedar das response:" << endl ) ;
 
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(), DAS_RESPONSE,
+			    cedar_attributes_query( dhi.container->access(),
+					dhi.container->get_constraint() ) ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -113,12 +389,8 @@ CedarRequestHandler::cedar_build_das( BESDataHandlerInterface &dhi )
 
     try
     {
-	string cedar_error ;
 	string container = dhi.container->access() ;
-	if( !cedar_read_attributes( *das, container, cedar_error ) )
-	{
-	    throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
-	}
+	cedar_attributes( *das, container, dhi.container->get_constraint() ) ;
 	Ancillary::read_ancillary_das( *das, container ) ;
     }
     catch( BESError &e ) {
@@ -151,6 +423,12 @@ CedarRequestHandler::cedar_build_dds( BESDataHandlerInterface &dhi )
 {
     bool ret = true ;
 
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( DDS_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -163,24 +441,15 @@ CedarRequestHandler::cedar_build_dds( BESDataHandlerInterface &dhi )
 
     try
     {
-	string cedar_error ;
 	string accessed = dhi.container->access() ;
-	if( !cedar_read_descriptors( *dds, accessed,
-				     dhi.container->get_symbolic_name(),
-				     dhi.container->get_constraint(),
-				     cedar_error ) )
-	{
-	    throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
-	}
+	cedar_descriptors( *dds, accessed, dhi.container->get_symbolic_name(),
+			   dhi.container->get_constraint() ) ;
 	Ancillary::read_ancillary_dds( *dds, accessed ) ;
 
 	// The dds now includes attribute information. Read the attributes,
 	// including any ancillary attributes
 	DAS das ;
-	if( !cedar_read_attributes( das, accessed, cedar_error ) )
-	{
-	    throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
-	}
+	cedar_attributes( das, accessed, dhi.container->get_constraint() ) ;
 	Ancillary::read_ancillary_das( das, accessed ) ;
 
 	// transfer the attributes to the dds.
@@ -212,6 +481,12 @@ CedarRequestHandler::cedar_build_dds( BESDataHandlerInterface &dhi )
 bool
 CedarRequestHandler::cedar_build_data( BESDataHandlerInterface &dhi )
 {
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( DATA_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -238,10 +513,7 @@ CedarRequestHandler::cedar_build_data( BESDataHandlerInterface &dhi )
 	// The dds now includes attribute information. Read the attributes,
 	// including any ancillary attributes
 	DAS das ;
-	if( !cedar_read_attributes( das, accessed, cedar_error ) )
-	{
-	    throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
-	}
+	cedar_attributes( das, accessed, dhi.container->get_constraint() ) ;
 	Ancillary::read_ancillary_das( das, accessed ) ;
 
 	// transfer the attributes to the dds.
@@ -270,11 +542,31 @@ CedarRequestHandler::cedar_build_data( BESDataHandlerInterface &dhi )
     return true ;
 }
 
+/** @brief true if the request asks for the compact flat or tab product,
+ * with header lines only where the layout of the records changes
+ */
+static bool
+cedar_is_compact()
+{
+    bool found = false ;
+    string compact =
+	BESContextManager::TheManager()->get_context( CEDAR_COMPACT_CONTEXT,
+						      found ) ;
+    return found && ( compact == "yes" || compact == "on"
+		      || compact == "true" ) ;
+}
+
 bool
 CedarRequestHandler::cedar_build_flat( BESDataHandlerInterface &dhi )
 {
     bool ret = true ;
 
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( FLAT_RESPONSE,
+				    cedar_is_compact() ? "compact" : "" ),
+			    dhi.container->get_constraint() ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -283,9 +575,24 @@ CedarRequestHandler::cedar_build_flat( BESDataHandlerInterface &dhi )
     if( !flat )
 	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
 
+    // a byte range, used to resume an interrupted download or to page
+    // through the product
+    bool found = false ;
+    string range =
+	BESContextManager::TheManager()->get_context( CEDAR_RANGE_CONTEXT,
+						      found ) ;
+
+    if( cedar_send_cached_flat( *flat, dhi.container->access(),
+				dhi.container->get_constraint(), range,
+				cedar_is_compact() ) )
+    {
+	return ret ;
+    }
+
     string cedar_error ;
     if( !cedar_read_flat( *flat, dhi.container->access(),
-			  dhi.container->get_constraint(), cedar_error ) )
+			  dhi.container->get_constraint(), range,
+			  cedar_is_compact(), cedar_error ) )
     {
 	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
     }
@@ -296,8 +603,89 @@ bool
 CedarRequestHandler::cedar_build_stream( BESDataHandlerInterface &dhi )
 {
     bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(), STREAM_RESPONSE,
+			    dhi.container->get_constraint() ) ;
+
+    // a byte range, used to resume an interrupted download
+    bool found = false ;
+    string range =
+	BESContextManager::TheManager()->get_context( CEDAR_RANGE_CONTEXT,
+						      found ) ;
+    string protocol =
+	BESContextManager::TheManager()->get_context( "transmit_protocol",
+						      found ) ;
+
     string cedar_error ;
-    if( !cedar_read_stream( dhi.container->access(),
+    if( !cedar_read_stream( protocol == "HTTP", dhi.container->access(),
+			    dhi.container->get_constraint(), range,
+			    cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
+bool
+CedarRequestHandler::cedar_build_cbf( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(), CBF_RESPONSE,
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    bool found = false ;
+    string range =
+	BESContextManager::TheManager()->get_context( CEDAR_RANGE_CONTEXT,
+						      found ) ;
+
+    string cedar_error ;
+    if( !cedar_read_cbf( dhi.container->access(),
+			 dhi.container->get_constraint(), range,
+			 cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
+bool
+CedarRequestHandler::cedar_build_netcdf( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( NETCDF_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    bool found = false ;
+    string protocol =
+	BESContextManager::TheManager()->get_context( "transmit_protocol",
+						      found ) ;
+
+    if( cedar_send_cached( dhi.get_output_stream(), protocol == "HTTP",
+			   NETCDF_RESPONSE, dhi.container->access(),
+			   dhi.container->get_symbolic_name(),
+			   dhi.container->get_constraint(),
+			   "application/x-netcdf", ".nc" ) )
+    {
+	return ret ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_netcdf( dhi.get_output_stream(), protocol == "HTTP",
+			    dhi.container->access(),
+			    dhi.container->get_symbolic_name(),
 			    dhi.container->get_constraint(), cedar_error ) )
     {
 	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
@@ -305,11 +693,149 @@ CedarRequestHandler::cedar_build_stream( BESDataHandlerInterface &dhi )
     return ret ;
 }
 
+bool
+CedarRequestHandler::cedar_build_arrow( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( ARROW_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    bool found = false ;
+    string protocol =
+	BESContextManager::TheManager()->get_context( "transmit_protocol",
+						      found ) ;
+
+    if( cedar_send_cached( dhi.get_output_stream(), protocol == "HTTP",
+			   ARROW_RESPONSE, dhi.container->access(),
+			   dhi.container->get_symbolic_name(),
+			   dhi.container->get_constraint(),
+			   "application/vnd.apache.arrow.stream", ".arrows" ) )
+    {
+	return ret ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_arrow( dhi.get_output_stream(), protocol == "HTTP",
+			   dhi.container->access(),
+			   dhi.container->get_symbolic_name(),
+			   dhi.container->get_constraint(), cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
+bool
+CedarRequestHandler::cedar_build_size( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( SIZE_RESPONSE,
+				    cedar_is_compact() ? "compact" : "" ),
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    BESInfo *info =
+	dynamic_cast<BESInfo *>(dhi.response_handler->get_response_object());
+    if( !info )
+	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
+
+    string cedar_error ;
+    if( !cedar_read_size( *info, dhi.container->access(),
+			  dhi.container->get_constraint(), cedar_is_compact(),
+			  cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
+bool
+CedarRequestHandler::cedar_build_csv( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(), CSV_RESPONSE,
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    BESResponseObject *response = dhi.response_handler->get_response_object() ;
+    CedarCSV *csv = dynamic_cast < CedarCSV * >(response) ;
+    if( !csv )
+	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
+
+    if( cedar_send_cached( *csv, CSV_RESPONSE, dhi.container->access(),
+			   dhi.container->get_constraint() ) )
+    {
+	return ret ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_csv( *csv, dhi.container->access(),
+			 dhi.container->get_constraint(), cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
+bool
+CedarRequestHandler::cedar_build_jsonl( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(), JSONL_RESPONSE,
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    BESResponseObject *response = dhi.response_handler->get_response_object() ;
+    CedarJSONL *jsonl = dynamic_cast < CedarJSONL * >(response) ;
+    if( !jsonl )
+	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
+
+    if( cedar_send_cached( *jsonl, JSONL_RESPONSE, dhi.container->access(),
+			   dhi.container->get_constraint() ) )
+    {
+	return ret ;
+    }
+
+    string cedar_error ;
+    if( !cedar_read_jsonl( *jsonl, dhi.container->access(),
+			   dhi.container->get_constraint(), cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
 bool
 CedarRequestHandler::cedar_build_tab( BESDataHandlerInterface &dhi )
 {
     bool ret = true ;
 
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( TAB_RESPONSE,
+				    cedar_is_compact() ? "compact" : "" ),
+			    dhi.container->get_constraint() ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -318,9 +844,17 @@ CedarRequestHandler::cedar_build_tab( BESDataHandlerInterface &dhi )
     if( !dtab )
 	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
 
+    if( cedar_send_cached( *dtab, TAB_RESPONSE, dhi.container->access(),
+			   dhi.container->get_constraint(),
+			   cedar_is_compact() ) )
+    {
+	return ret ;
+    }
+
     string cedar_error ;
     if( !cedar_read_tab( *dtab, dhi.container->access(),
-			 dhi.container->get_constraint(), cedar_error ) )
+			 dhi.container->get_constraint(), cedar_is_compact(),
+			 cedar_error ) )
     {
 	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
     }
@@ -332,6 +866,12 @@ CedarRequestHandler::cedar_build_info( BESDataHandlerInterface &dhi )
 {
     bool ret = true ;
 
+    // stop here if the client already has the product
+    CedarValidators::check( dhi.container->access(),
+			    cedar_cache_product( INFO_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
     // make sure the user is authenticated to receive cedar data
     CedarAuthenticate::authenticate( dhi ) ;
 
@@ -351,6 +891,42 @@ CedarRequestHandler::cedar_build_info( BESDataHandlerInterface &dhi )
     return ret ;
 }
 
+/** @brief list the files of the archive index matching the constraint
+ *
+ * The container is either the archive container, standing for the whole
+ * index, or a cedar file whose entry in the index is wanted. The list
+ * changes with the index, not with the file.
+ */
+bool
+CedarRequestHandler::cedar_build_archive( BESDataHandlerInterface &dhi )
+{
+    bool ret = true ;
+
+    // stop here if the client already has the product
+    CedarValidators::check( CedarArchive::get_index(),
+			    cedar_cache_product( ARCHIVE_RESPONSE,
+				dhi.container->get_symbolic_name() ),
+			    dhi.container->get_constraint() ) ;
+
+    // make sure the user is authenticated to receive cedar data
+    CedarAuthenticate::authenticate( dhi ) ;
+
+    BESInfo *info =
+	dynamic_cast<BESInfo *>(dhi.response_handler->get_response_object());
+    if( !info )
+	throw BESInternalError( "cast error", __FILE__, __LINE__ ) ;
+
+    string cedar_error ;
+    if( !cedar_read_archive( *info, dhi.container->access(),
+			     dhi.container->get_symbolic_name(),
+			     dhi.container->get_constraint(),
+			     cedar_error ) )
+    {
+	throw BESInternalError( cedar_error, __FILE__, __LINE__ ) ;
+    }
+    return ret ;
+}
+
 bool
 CedarRequestHandler::cedar_build_vers( BESDataHandlerInterface &dhi )
 {
@@ -47,8 +47,15 @@ public:
     static bool		cedar_build_data( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_flat( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_stream( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_cbf( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_netcdf( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_arrow( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_csv( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_jsonl( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_size( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_tab( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_info( BESDataHandlerInterface &dhi ) ;
+    static bool		cedar_build_archive( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_vers( BESDataHandlerInterface &dhi ) ;
     static bool		cedar_build_help( BESDataHandlerInterface &dhi ) ;
 };
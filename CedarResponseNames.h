@@ -48,6 +48,37 @@
 #define TAB_RESPONSE "get.tab"
 #define TAB_SERVICE "tab"
 #define TAB_DESCRIPT "CEDAR Ascii Tab delimited response"
+#define CBF_RESPONSE "get.cbf"
+#define CBF_SERVICE "cbf"
+#define CBF_DESCRIPT "CEDAR cbf file of the records matching the constraint"
+#define NETCDF_RESPONSE "get.netcdf"
+#define NETCDF_SERVICE "netcdf"
+#define NETCDF_DESCRIPT "CEDAR netcdf file of the rows matching the constraint"
+#define ARROW_RESPONSE "get.arrow"
+#define ARROW_SERVICE "arrow"
+#define ARROW_DESCRIPT "CEDAR Arrow IPC stream of the rows matching the constraint"
+#define CSV_RESPONSE "get.csv"
+#define CSV_SERVICE "csv"
+#define CSV_DESCRIPT "CEDAR comma separated values, a line per row matching the constraint"
+#define JSONL_RESPONSE "get.jsonl"
+#define JSONL_SERVICE "jsonl"
+#define JSONL_DESCRIPT "CEDAR JSON lines, an object per row matching the constraint"
+#define SIZE_RESPONSE "get.size"
+#define SIZE_SERVICE "size"
+#define SIZE_DESCRIPT "CEDAR size of the flat response, found without formatting it"
+#define ARCHIVE_RESPONSE "get.archive"
+#define ARCHIVE_SERVICE "archive"
+#define ARCHIVE_DESCRIPT "CEDAR files of the archive index matching the constraint"
+
+// container standing for the whole archive index
+#define CEDAR_ARCHIVE_CONTAINER "archive"
+
+#define CEDAR_RANGE_CONTEXT "cedar_range"
+#define CEDAR_ACCEPT_ENCODING_CONTEXT "cedar_accept_encoding"
+#define CEDAR_COMPACT_CONTEXT "cedar_compact"
+#define CEDAR_IF_NONE_MATCH_CONTEXT "cedar_if_none_match"
+#define CEDAR_IF_MODIFIED_SINCE_CONTEXT "cedar_if_modified_since"
+#define CEDAR_CONTAINERS_PAGE_CONTEXT "cedar_containers_page"
 
 #endif // E_CedarResponseNames_H
 
@@ -0,0 +1,118 @@
+// CedarScratch.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarScratch.h"
+#include "CedarDataRecord.h"
+
+/** @brief add c to the end of the string
+ */
+CedarStringBuf::int_type
+CedarStringBuf::overflow( int_type c )
+{
+    if( traits_type::eq_int_type( c, traits_type::eof() ) )
+	return traits_type::not_eof( c ) ;
+    *_str += traits_type::to_char_type( c ) ;
+    return c ;
+}
+
+/** @brief add the n characters at s to the end of the string
+ */
+streamsize
+CedarStringBuf::xsputn( const char *s, streamsize n )
+{
+    _str->append( s, n ) ;
+    return n ;
+}
+
+/** @brief load the JPAR and MPAR codes of rec into jpar_codes and
+ * mpar_codes
+ */
+void
+CedarScratch::load_codes( CedarDataRecord &rec )
+{
+    jpar_codes.resize( rec.get_jpar() ) ;
+    rec.load_JPAR_vars( jpar_codes ) ;
+    mpar_codes.resize( rec.get_mpar() ) ;
+    rec.load_MPAR_vars( mpar_codes ) ;
+}
+
+/** @brief load the JPAR codes and values of rec into jpar_codes and
+ * jpar_values
+ */
+void
+CedarScratch::load_jpar( CedarDataRecord &rec )
+{
+    jpar_values.resize( rec.get_jpar() ) ;
+    rec.load_JPAR_data( jpar_values ) ;
+    jpar_codes.resize( rec.get_jpar() ) ;
+    rec.load_JPAR_vars( jpar_codes ) ;
+}
+
+/** @brief load the MPAR codes and values of rec into mpar_codes and
+ * mpar_values, row after row, and size column for a row of each
+ */
+void
+CedarScratch::load_mpar( CedarDataRecord &rec )
+{
+    int mpar = rec.get_mpar() ;
+    int nrows = rec.get_nrows() ;
+    mpar_codes.resize( mpar ) ;
+    rec.load_MPAR_vars( mpar_codes ) ;
+    mpar_values.resize( nrows * mpar ) ;
+    rec.load_MPAR_data( mpar_values ) ;
+    column.resize( nrows ) ;
+}
+
+/** @brief copy the values of the MPAR at index m from mpar_values into
+ * column, loaded by load_mpar
+ */
+void
+CedarScratch::load_column( int m )
+{
+    size_t mpar = mpar_codes.size() ;
+    for( size_t row = 0; row < column.size(); row++ )
+	column[row] = mpar_values[m + row * mpar] ;
+}
+
+/** @brief save the text of rec into text, a blank line and its prologue
+ * and data for a catalog or header record, nothing for any other
+ */
+void
+CedarScratch::save_text( const CedarLogicalRecord &rec )
+{
+    text.erase() ;
+    switch( rec.get_type() )
+    {
+	case 2:
+	case 3:
+	    text += '\n' ;
+	    rec.save_prologue_header( &text_buf ) ;
+	    rec.save_prologue( &text_buf ) ;
+	    rec.save_data_buffer( &text_buf ) ;
+	    break ;
+    }
+}
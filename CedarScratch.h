@@ -0,0 +1,96 @@
+// CedarScratch.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarScratch_h
+#define I_CedarScratch_h 1
+
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using std::streambuf ;
+using std::streamsize ;
+using std::string ;
+using std::vector ;
+
+class CedarLogicalRecord ;
+class CedarDataRecord ;
+
+/** @brief a streambuf that writes onto the end of a string
+ *
+ * The Cedar library saves the text of a record to a streambuf. Saved to
+ * one of these the text lands in a string that is erased, not freed,
+ * between records.
+ */
+class CedarStringBuf : public streambuf
+{
+private:
+    string *			_str ;
+protected:
+    virtual int_type		overflow( int_type c ) ;
+    virtual streamsize		xsputn( const char *s, streamsize n ) ;
+public:
+    				CedarStringBuf( string &str ) : _str( &str ) {}
+    virtual			~CedarStringBuf() {}
+} ;
+
+/** @brief buffers a request reuses from one record to the next
+ *
+ * A request keeps a single CedarScratch and hands it to the code loading
+ * or formatting each record, rather than each record allocating its own
+ * buffers for the parameter codes and values, the names and the text.
+ * The buffers are resized and erased but keep their capacity, so once
+ * they have grown to the largest record of the file the records are
+ * handled without allocating. The load and save methods fill the buffers
+ * from a record for load_dds, load_das and route_buffer.
+ */
+class CedarScratch
+{
+private:
+    				CedarScratch( const CedarScratch & ) ;
+    CedarScratch &		operator=( const CedarScratch & ) ;
+public:
+    vector<short int>		jpar_codes ;
+    vector<short int>		jpar_values ;
+    vector<short int>		mpar_codes ;
+    vector<short int>		mpar_values ;
+    vector<short int>		column ;
+    string			name ;
+    string			text ;
+    CedarStringBuf		text_buf ;
+
+    				CedarScratch() : text_buf( text ) {}
+    virtual			~CedarScratch() {}
+
+    void			load_codes( CedarDataRecord &rec ) ;
+    void			load_jpar( CedarDataRecord &rec ) ;
+    void			load_mpar( CedarDataRecord &rec ) ;
+    void			load_column( int m ) ;
+    void			save_text( const CedarLogicalRecord &rec ) ;
+} ;
+
+#endif // I_CedarScratch_h
@@ -0,0 +1,189 @@
+// CedarStageQueue.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarStageQueue_h
+#define I_CedarStageQueue_h 1
+
+#include <vector>
+
+using std::vector ;
+
+#include "config_cedar.h"
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+/** @brief a bounded queue handing items, in order, from one stage of a
+ * pipeline to the stage after it
+ *
+ * put waits while the queue is full, so a stage that falls behind holds
+ * back the stages before it. Items are swapped in and out rather than
+ * copied, the item a stage is left with after put or get is one handed
+ * through the queue before, so its buffers are used again rather than
+ * allocated for every item. T needs a swap member.
+ *
+ * The stage putting items closes the queue when it has no more, the
+ * stage getting them stops the queue when it wants no more.
+ */
+template <class T>
+class CedarStageQueue
+{
+private:
+    vector<T>			_slots ;
+    size_t			_head ;
+    size_t			_count ;
+    bool			_closed ;
+    bool			_stopped ;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t		_lock ;
+    pthread_cond_t		_cond ;
+#endif
+
+    void			lock()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_lock( &_lock ) ;
+#endif
+				}
+    void			unlock()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_unlock( &_lock ) ;
+#endif
+				}
+    void			wait()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_wait( &_cond, &_lock ) ;
+#endif
+				}
+    void			wake()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_broadcast( &_cond ) ;
+#endif
+				}
+public:
+    				CedarStageQueue( size_t depth )
+				    : _slots( depth ? depth : 1 ),
+				      _head( 0 ),
+				      _count( 0 ),
+				      _closed( false ),
+				      _stopped( false )
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_mutex_init( &_lock, 0 ) ;
+				    pthread_cond_init( &_cond, 0 ) ;
+#endif
+				}
+    				~CedarStageQueue()
+				{
+#ifdef HAVE_PTHREAD
+				    pthread_cond_destroy( &_cond ) ;
+				    pthread_mutex_destroy( &_lock ) ;
+#endif
+				}
+
+    /** @brief add item to the back of the queue, waiting for room
+     *
+     * @return false, with item left as it was, if the queue is stopped
+     */
+    bool			put( T &item )
+				{
+				    lock() ;
+				    while( _count == _slots.size()
+					   && !_stopped )
+					wait() ;
+				    bool ok = !_stopped ;
+				    if( ok )
+				    {
+					size_t i = ( _head + _count )
+						   % _slots.size() ;
+					_slots[i].swap( item ) ;
+					_count++ ;
+					wake() ;
+				    }
+				    unlock() ;
+				    return ok ;
+				}
+
+    /** @brief take the item at the front of the queue, waiting for one
+     *
+     * @return false once the queue is closed and empty, or stopped
+     */
+    bool			get( T &item )
+				{
+				    lock() ;
+				    while( !_count && !_closed && !_stopped )
+					wait() ;
+				    bool ok = _count && !_stopped ;
+				    if( ok )
+				    {
+					_slots[_head].swap( item ) ;
+					_head = ( _head + 1 ) % _slots.size() ;
+					_count-- ;
+					wake() ;
+				    }
+				    unlock() ;
+				    return ok ;
+				}
+
+    void			close()
+				{
+				    lock() ;
+				    _closed = true ;
+				    wake() ;
+				    unlock() ;
+				}
+    void			stop()
+				{
+				    lock() ;
+				    _stopped = true ;
+				    wake() ;
+				    unlock() ;
+				}
+    bool			is_stopped()
+				{
+				    lock() ;
+				    bool stopped = _stopped ;
+				    unlock() ;
+				    return stopped ;
+				}
+    /** @brief empty the queue for use again, once no stage is using it */
+    void			reset()
+				{
+				    lock() ;
+				    _head = 0 ;
+				    _count = 0 ;
+				    _closed = false ;
+				    _stopped = false ;
+				    unlock() ;
+				}
+} ;
+
+#endif // I_CedarStageQueue_h
@@ -0,0 +1,145 @@
+// CedarTextFormat.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdio.h>
+
+#include "CedarTextFormat.h"
+#include "cedar_read_descriptors.h"
+#include "CedarException.h"
+#include "BESInfo.h"
+
+/** @brief format v in decimal into buf
+ *
+ * @param buf room for at least 12 characters, no null terminator is
+ * written
+ * @return the number of characters written
+ */
+size_t
+CedarTextFormat::format_int( char *buf, int v )
+{
+    char digits[12] ;
+    size_t n = 0 ;
+    unsigned int u = v < 0 ? -(unsigned int)v : v ;
+    do
+    {
+	digits[n++] = '0' + u % 10 ;
+	u /= 10 ;
+    } while( u ) ;
+
+    size_t len = 0 ;
+    if( v < 0 )
+	buf[len++] = '-' ;
+    while( n )
+	buf[len++] = digits[--n] ;
+    return len ;
+}
+
+/** @brief append s right justified in a flat column
+ *
+ * @throws CedarException if s does not fit in a column
+ */
+void
+CedarTextFormat::append_blocked( const string &s )
+{
+    int l = s.length() ;
+    if( l > PRINTING_BLOCK_SIZE )
+    {
+	char errs[256] ;
+	sprintf( errs, "%s %d\n%s %s\n",
+	         "Trying to print block larger than",
+		 PRINTING_BLOCK_SIZE,
+		 "Current block is ", s.c_str() ) ;
+	throw CedarException( 0, errs ) ;
+    }
+    _buf.append( PRINTING_BLOCK_SIZE - l, ' ' ) ;
+    _buf += s ;
+}
+
+void
+CedarTextFormat::append_blocked( int v )
+{
+    char tmp[16] ;
+    size_t l = format_int( tmp, v ) ;
+    _buf.append( PRINTING_BLOCK_SIZE - l, ' ' ) ;
+    _buf.append( tmp, l ) ;
+}
+
+/** @brief the name of a parameter as used in the DDS, e_ prefixed for
+ * error codes
+ */
+const string &
+CedarTextFormat::get_name( int code )
+{
+    map<int,string>::iterator i = _names.find( code ) ;
+    if( i == _names.end() )
+    {
+	string name ;
+	get_name_for_parameter( name, code ) ;
+	i = _names.insert( make_pair( code, name ) ).first ;
+    }
+    return i->second ;
+}
+
+/** @brief mark rec and format it, then add it to the response
+ */
+void
+CedarTextFormat::data_record( const CedarRawRecord &rec,
+                              const CedarRecordSelection &sel )
+{
+    format( rec, sel, mark_record( rec, sel ) ) ;
+    flush() ;
+}
+
+/** @brief format rec onto the end of out, on a worker of the pipeline
+ */
+void
+CedarTextFormat::format_record( const CedarRawRecord &rec,
+                                const CedarRecordSelection &sel,
+				int mark, string &out )
+{
+    _buf.swap( out ) ;
+    format( rec, sel, mark ) ;
+    _buf.swap( out ) ;
+}
+
+/** @brief add what has been formatted so far to the response
+ */
+void
+CedarTextFormat::flush()
+{
+    if( !_buf.empty() )
+	output( _buf ) ;
+}
+
+/** @brief add a piece of the product to the response
+ */
+void
+CedarTextFormat::write( const string &data )
+{
+    _info.add_data( data ) ;
+}
+
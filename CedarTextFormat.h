@@ -0,0 +1,110 @@
+// CedarTextFormat.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarTextFormat_h
+#define I_CedarTextFormat_h 1
+
+#include <string>
+#include <map>
+
+using std::string ;
+using std::map ;
+
+#include "CedarRecordReader.h"
+
+class BESInfo ;
+
+// width of a column of the flat product
+#define PRINTING_BLOCK_SIZE 9
+
+// mark of a record that starts with the header lines
+#define CEDAR_MARK_HEAD 1
+
+/** @brief base of the text products, formats the records it is given
+ * into a buffer that is added to the response a record at a time
+ *
+ * Integers are formatted directly into the buffer rather than through a
+ * stream, and the names, scales and units of the parameters are looked up
+ * once per code.
+ *
+ * In compact mode a product writes its header lines only when the layout
+ * of the records changes rather than for every record. Whether a record
+ * starts with the header lines is decided by mark_record, in order, so
+ * that format can format any record on its own. A product is then
+ * formatted by a pool of workers copied from it, see CedarPipeline.
+ *
+ * What is flushed is added to the response on the write stage of the
+ * pipeline, if there is one, while the next records are formatted.
+ */
+class CedarTextFormat : public CedarRecordReader
+{
+private:
+    BESInfo &			_info ;
+    map<int,string>		_names ;
+    bool			_compact ;
+protected:
+    string			_buf ;
+
+    /** @brief format rec into the buffer as marked by mark_record */
+    virtual void		format( const CedarRawRecord &rec,
+					const CedarRecordSelection &sel,
+					int mark ) = 0 ;
+public:
+    				CedarTextFormat( BESInfo &info,
+						 bool compact = false )
+				    : _info( info ),
+				      _compact( compact ) {}
+    virtual			~CedarTextFormat() {}
+
+    bool			is_compact() const { return _compact ; }
+
+    void			append( const string &s ) { _buf += s ; }
+    void			append( const char *s ) { _buf += s ; }
+    void			append( char c ) { _buf += c ; }
+    void			append_int( int v )
+				{
+				    char tmp[16] ;
+				    _buf.append( tmp, format_int( tmp, v ) ) ;
+				}
+    virtual void		append_blocked( const string &s ) ;
+    virtual void		append_blocked( int v ) ;
+
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) ;
+    virtual void		format_record( const CedarRawRecord &rec,
+					       const CedarRecordSelection &sel,
+					       int mark, string &out ) ;
+
+    virtual const string &	get_name( int code ) ;
+    virtual void		flush() ;
+    virtual void		write( const string &data ) ;
+
+    static size_t		format_int( char *buf, int v ) ;
+} ;
+
+#endif // I_CedarTextFormat_h
+
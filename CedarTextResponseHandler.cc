@@ -0,0 +1,94 @@
+// CedarTextResponseHandler.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include "CedarTextResponseHandler.h"
+#include "CedarCompressStream.h"
+#include "CedarTransmitter.h"
+#include "BESInfo.h"
+#include "BESContextManager.h"
+#include "BESDataHandlerInterface.h"
+
+CedarTextResponseHandler::CedarTextResponseHandler( const string &name )
+    : BESResponseHandler( name ),
+      _compress( 0 )
+{
+}
+
+CedarTextResponseHandler::~CedarTextResponseHandler()
+{
+    // the response writes to the compressing stream, if there is one
+    if( _response )
+    {
+	delete _response ;
+	_response = 0 ;
+    }
+    if( _compress )
+	delete _compress ;
+}
+
+/** @brief the stream to make the product on
+ *
+ * @param dhi the request
+ * @param compress false if the product is not to be compressed, such as
+ * a byte range of it
+ * @param is_http set to true if the product is sent over HTTP and writes
+ * its own header, false if it is not or the compressing stream writes it
+ * @return the compressing stream, or the response stream if the product
+ * is sent as is
+ */
+ostream *
+CedarTextResponseHandler::open_text( BESDataHandlerInterface &dhi,
+				     bool compress, bool &is_http )
+{
+    bool found = false ;
+    string context = "transmit_protocol" ;
+    string protocol = BESContextManager::TheManager()->get_context( context,
+								    found ) ;
+    is_http = ( protocol == "HTTP" ) ;
+    if( compress )
+    {
+	_compress = CedarCompressStream::for_request( dhi.get_output_stream(),
+						      is_http ) ;
+    }
+    if( !_compress )
+	return &(dhi.get_output_stream()) ;
+    is_http = false ;
+    return _compress ;
+}
+
+void
+CedarTextResponseHandler::transmit( BESTransmitter *transmitter,
+				    BESDataHandlerInterface &dhi )
+{
+    if( !_response )
+	return ;
+    if( _compress )
+	CedarTransmitter::send_compressed( *((BESInfo *)_response),
+					   *_compress ) ;
+    else
+	transmitter->send_text( *((BESInfo *)_response), dhi ) ;
+}
@@ -31,8 +31,17 @@
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
 #include <iostream>
+#include <sstream>
+
+using std::ostringstream ;
+
+#include <mime_util.h>
+
+using namespace libdap ;
 
 #include "CedarTransmitter.h"
+#include "CedarCompressStream.h"
+#include "CedarValidators.h"
 #include <BESInfo.h>
 #include <BESReturnManager.h>
 #include <BESTransmitterNames.h>
@@ -74,6 +83,54 @@ CedarTransmitter::send_html( BESInfo &info,
     get_transmitter( dhi )->send_html( info, dhi ) ;
 }
 
+/** @brief send a text product through the stream compressing it
+ *
+ * An unbuffered product has already been written to the stream as it
+ * was formatted, a buffered one is written now. Either way the compressed
+ * stream is then ended.
+ */
+void
+CedarTransmitter::send_compressed( BESInfo &info, CedarCompressStream &strm )
+{
+    info.print( strm ) ;
+    strm.finish() ;
+}
+
+/** @brief the HTTP response header of a text product sent through a
+ * CedarCompressStream
+ *
+ * The header is the one BES writes for a text product, from
+ * set_mime_text, with the Content-Encoding of the product, its ETag if
+ * it has one, see CedarValidators, and Vary added, since the encoding
+ * was chosen from the Accept-Encoding of the request.
+ *
+ * @param encoding content encoding of the product, none if empty
+ */
+string
+CedarTransmitter::get_text_header( const string &encoding )
+{
+    ostringstream strm ;
+    set_mime_text( strm, unknown_type, x_plain,
+		   CedarValidators::get_last_modified() ) ;
+    string header = strm.str() ;
+
+    string more ;
+    string etag = CedarValidators::get_etag( encoding ) ;
+    if( !etag.empty() )
+	more += "ETag: " + etag + "\r\n" ;
+    if( !encoding.empty() )
+	more += "Content-Encoding: " + encoding + "\r\n" ;
+    more += "Vary: Accept-Encoding\r\n" ;
+
+    // before the blank line that ends the header
+    string::size_type end = header.rfind( "\r\n\r\n" ) ;
+    if( end == string::npos )
+	header += more + "\r\n" ;
+    else
+	header.insert( end + 2, more ) ;
+    return header ;
+}
+
 /** @brief dumps information about this object
  *
  * Displays the pointer value of this instance
@@ -35,6 +35,8 @@
 
 #include "BESTransmitter.h"
 
+class CedarCompressStream ;
+
 class CedarTransmitter : public BESTransmitter
 {
 private:
@@ -50,6 +52,10 @@ public:
     				   BESDataHandlerInterface &dhi) ;
 
     virtual void	dump( ostream &strm ) const ;
+
+    static void		send_compressed( BESInfo &info,
+					 CedarCompressStream &strm ) ;
+    static string	get_text_header( const string &encoding ) ;
 } ;
 
 #endif // A_CedarTransmitter_h
@@ -0,0 +1,226 @@
+// CedarValidators.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <string.h>
+
+#include "CedarValidators.h"
+#include "CedarNotModifiedException.h"
+#include "CedarCache.h"
+#include "CedarResponseNames.h"
+#include "BESContextManager.h"
+#include "BESDebug.h"
+
+string CedarValidators::_key ;
+time_t CedarValidators::_last_modified = 0 ;
+
+/** @brief find the validators of a product and stop if the client already
+ * has it
+ *
+ * Only the cedar file's status is looked at. If it can not be found the
+ * validators are cleared and the error is left to the product.
+ *
+ * @param filename the cedar file
+ * @param product the product, with anything else that changes it such as
+ * the container name
+ * @param constraint the constraint of the product
+ * @throws CedarNotModifiedException if the client has the product
+ */
+void
+CedarValidators::check( const string &filename, const string &product,
+                        const string &constraint )
+{
+    clear() ;
+
+    struct stat st ;
+    if( stat( filename.c_str(), &st ) != 0 )
+	return ;
+    _key = CedarCache::get_key( filename, product, constraint ) ;
+    if( _key.empty() )
+	return ;
+    _last_modified = st.st_mtime ;
+
+    // If-Modified-Since is ignored when If-None-Match is sent
+    bool found = false ;
+    string if_none_match =
+	BESContextManager::TheManager()->get_context(
+					CEDAR_IF_NONE_MATCH_CONTEXT, found ) ;
+    if( found && !if_none_match.empty() )
+    {
+	string etag ;
+	if( matches( if_none_match, _key, etag ) )
+	{
+	    BESDEBUG( "cedar", "not modified " << product << " " << etag
+			       << endl ) ;
+	    throw CedarNotModifiedException( etag, _last_modified,
+					     __FILE__, __LINE__ ) ;
+	}
+	return ;
+    }
+
+    found = false ;
+    string if_modified_since =
+	BESContextManager::TheManager()->get_context(
+				    CEDAR_IF_MODIFIED_SINCE_CONTEXT, found ) ;
+    time_t since = 0 ;
+    if( found && parse_http_date( if_modified_since, since )
+	&& _last_modified <= since )
+    {
+	BESDEBUG( "cedar", "not modified since " << if_modified_since
+			   << " " << product << endl ) ;
+	throw CedarNotModifiedException( get_etag(), _last_modified,
+					 __FILE__, __LINE__ ) ;
+    }
+}
+
+void
+CedarValidators::clear()
+{
+    _key = "" ;
+    _last_modified = 0 ;
+}
+
+/** @brief the ETag of the product, empty if there is none
+ *
+ * @param encoding content encoding the product is sent with, if any
+ */
+string
+CedarValidators::get_etag( const string &encoding )
+{
+    if( _key.empty() )
+	return "" ;
+    if( encoding.empty() )
+	return "\"" + _key + "\"" ;
+    return "\"" + _key + "-" + encoding + "\"" ;
+}
+
+/** @brief the ETag and Last-Modified lines of an HTTP response header,
+ * empty if there are no validators
+ */
+string
+CedarValidators::get_http_header( const string &encoding )
+{
+    if( _key.empty() )
+	return "" ;
+    return "ETag: " + get_etag( encoding ) + "\r\n"
+	   + "Last-Modified: " + http_date( _last_modified ) + "\r\n" ;
+}
+
+/** @brief true if an If-None-Match list holds the ETag of the product
+ *
+ * The weak comparison is used, as it is for If-None-Match, and the ETag
+ * of the product with any content encoding matches.
+ *
+ * @param if_none_match the list of entity tags, or *
+ * @param key the cache key of the product
+ * @param etag set to the entity tag that matched
+ */
+bool
+CedarValidators::matches( const string &if_none_match, const string &key,
+                          string &etag )
+{
+    string::size_type pos = 0 ;
+    while( pos < if_none_match.length() )
+    {
+	string::size_type comma = if_none_match.find( ',', pos ) ;
+	if( comma == string::npos )
+	    comma = if_none_match.length() ;
+	string tag = if_none_match.substr( pos, comma - pos ) ;
+	pos = comma + 1 ;
+
+	string::size_type b = tag.find_first_not_of( " \t" ) ;
+	string::size_type e = tag.find_last_not_of( " \t" ) ;
+	if( b == string::npos )
+	    continue ;
+	tag = tag.substr( b, e - b + 1 ) ;
+	if( tag == "*" )
+	{
+	    etag = "\"" + key + "\"" ;
+	    return true ;
+	}
+	string opaque = tag ;
+	if( opaque.substr( 0, 2 ) == "W/" )
+	    opaque = opaque.substr( 2 ) ;
+	if( opaque.length() < 2 || opaque[0] != '"'
+	    || opaque[opaque.length()-1] != '"' )
+	{
+	    continue ;
+	}
+	opaque = opaque.substr( 1, opaque.length() - 2 ) ;
+	if( opaque == key
+	    || ( opaque.length() > key.length() + 1
+	         && opaque.compare( 0, key.length(), key ) == 0
+		 && opaque[key.length()] == '-' ) )
+	{
+	    etag = tag ;
+	    return true ;
+	}
+    }
+    return false ;
+}
+
+/** @brief parse an HTTP date in any of the three forms allowed
+ *
+ * Sun, 06 Nov 1994 08:49:37 GMT, Sunday, 06-Nov-94 08:49:37 GMT and
+ * Sun Nov  6 08:49:37 1994, all in GMT.
+ *
+ * @return false if the date is not understood
+ */
+bool
+CedarValidators::parse_http_date( const string &date, time_t &t )
+{
+    static const char *formats[] = { "%a, %d %b %Y %H:%M:%S GMT",
+				     "%A, %d-%b-%y %H:%M:%S GMT",
+				     "%a %b %e %H:%M:%S %Y",
+				     0 } ;
+    for( int i = 0; formats[i]; i++ )
+    {
+	struct tm tm ;
+	memset( &tm, 0, sizeof tm ) ;
+	const char *end = strptime( date.c_str(), formats[i], &tm ) ;
+	if( end && *end == '\0' )
+	{
+	    t = timegm( &tm ) ;
+	    return t != (time_t)-1 ;
+	}
+    }
+    return false ;
+}
+
+/** @brief the HTTP form of a time, such as Sun, 06 Nov 1994 08:49:37 GMT
+ */
+string
+CedarValidators::http_date( time_t t )
+{
+    char date[64] ;
+    struct tm gmt ;
+    gmtime_r( &t, &gmt ) ;
+    strftime( date, sizeof date, "%a, %d %b %Y %H:%M:%S GMT", &gmt ) ;
+    return date ;
+}
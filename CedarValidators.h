@@ -0,0 +1,76 @@
+// CedarValidators.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarValidators_h
+#define I_CedarValidators_h 1
+
+#include <time.h>
+
+#include <string>
+
+using std::string ;
+
+/** @brief the cache validators, ETag and Last-Modified, of the product
+ * being built
+ *
+ * The ETag of a product is its cache key, so it changes whenever the cedar
+ * file, the product, the constraint or the module version does. It is a
+ * strong validator, a product sent with a content encoding gets the
+ * encoding added to its ETag. The Last-Modified time is that of the cedar
+ * file.
+ *
+ * check is called at the start of every product, before the user is
+ * authenticated and before the cedar file is opened. It remembers the
+ * validators for the HTTP headers written later and, if the client sent
+ * If-None-Match or If-Modified-Since in the cedar_if_none_match or
+ * cedar_if_modified_since context and already has the product, throws
+ * CedarNotModifiedException so that nothing else is done.
+ */
+class CedarValidators
+{
+private:
+    static string		_key ;
+    static time_t		_last_modified ;
+public:
+    static void			check( const string &filename,
+				       const string &product,
+				       const string &constraint ) ;
+    static void			clear() ;
+
+    static string		get_etag( const string &encoding = "" ) ;
+    static time_t		get_last_modified() { return _last_modified ; }
+    static string		get_http_header( const string &encoding ) ;
+
+    static bool			matches( const string &if_none_match,
+					 const string &key,
+					 string &etag ) ;
+    static bool			parse_http_date( const string &date,
+						 time_t &t ) ;
+    static string		http_date( time_t t ) ;
+} ;
+
+#endif // I_CedarValidators_h
@@ -0,0 +1,242 @@
+// CedarZoneMap.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+
+using std::endl ;
+
+#include "CedarZoneMap.h"
+#include "CedarRawFile.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarParameter.h"
+#include "BESDebug.h"
+
+// files whose zone map is kept, all are dropped when there are more
+#define CEDAR_ZONE_MAP_FILES 256
+
+map<string,CedarZoneMap *> CedarZoneMap::_maps ;
+
+/** @brief add the zones of the next record of the file
+ *
+ * Records have to be added in file order, every record including those
+ * that are not data records. A record out of order leaves the zone map
+ * incomplete, it is then not kept.
+ */
+void
+CedarZoneMap::add_record( const CedarRawRecord &rec )
+{
+    if( _broken )
+	return ;
+    if( rec.get_ordinal() != _start.size() )
+    {
+	_broken = true ;
+	return ;
+    }
+    _start.push_back( _zones.size() ) ;
+    if( rec.get_type() != 1 || !rec.is_valid_data() )
+	return ;
+
+    int mpar = rec.get_mpar() ;
+    int nrows = rec.get_nrows() ;
+    for( int m = 0; m < mpar; m++ )
+    {
+	Zone zone ;
+	zone.min = 32767 ;
+	zone.max = -32768 ;
+	zone.nulls = 0 ;
+	for( int row = 0; row < nrows; row++ )
+	{
+	    int value = rec.get_mpar_value( row, m ) ;
+	    if( value == CEDAR_RAW_MISSING )
+	    {
+		zone.nulls++ ;
+		continue ;
+	    }
+	    if( value < zone.min ) zone.min = value ;
+	    if( value > zone.max ) zone.max = value ;
+	}
+	_zones.push_back( zone ) ;
+    }
+}
+
+/** @brief the zones of the MPARs of rec, in the order of the MPARs
+ *
+ * @return null if the record has not been added or was not a data record
+ * with the same number of MPARs
+ */
+const CedarZoneMap::Zone *
+CedarZoneMap::get_zones( const CedarRawRecord &rec ) const
+{
+    unsigned long ordinal = rec.get_ordinal() ;
+    if( ordinal >= _start.size() )
+	return 0 ;
+    unsigned long first = _start[ordinal] ;
+    unsigned long end = ( ordinal + 1 < _start.size() ) ? _start[ordinal+1]
+							: _zones.size() ;
+    if( end == first || end - first != (unsigned long)rec.get_mpar() )
+	return 0 ;
+    return &_zones[first] ;
+}
+
+/** @brief the zone map kept for key, null if there is none
+ */
+const CedarZoneMap *
+CedarZoneMap::get( const string &key )
+{
+    if( key.empty() )
+	return 0 ;
+    map<string,CedarZoneMap *>::iterator i = _maps.find( key ) ;
+    if( i == _maps.end() )
+	return 0 ;
+    return i->second ;
+}
+
+/** @brief keep the zone map of a file
+ *
+ * @param key the cache key of the file's zone map
+ * @param zones the zone map, owned by the cache from now on
+ */
+void
+CedarZoneMap::add( const string &key, CedarZoneMap *zones )
+{
+    if( key.empty() || !zones->is_complete() || get( key ) )
+    {
+	delete zones ;
+	return ;
+    }
+    if( _maps.size() >= CEDAR_ZONE_MAP_FILES )
+	Clear() ;
+    BESDEBUG( "cedar", "CedarZoneMap::add - " << key << " with "
+		       << zones->get_records() << " records" << endl ) ;
+    _maps[key] = zones ;
+}
+
+void
+CedarZoneMap::Clear()
+{
+    map<string,CedarZoneMap *>::iterator i = _maps.begin() ;
+    for( ; i != _maps.end(); i++ )
+	delete i->second ;
+    _maps.clear() ;
+}
+
+/** @brief the runs of values passing the constraint of a parameter
+ */
+const CedarZoneFilter::Runs &
+CedarZoneFilter::get_runs( int code )
+{
+    map<int,Runs>::iterator i = _runs.find( code ) ;
+    if( i != _runs.end() )
+	return i->second ;
+
+    Runs &runs = _runs[code] ;
+    CedarParameter pp = _qa.get_parameter( code ) ;
+    bool in = false ;
+    for( int value = -32768; value <= 32767; value++ )
+    {
+	bool pass = pp.validateValue( value ) ;
+	if( pass && !in )
+	    runs.push_back( pair<int,int>( value, value ) ) ;
+	if( pass )
+	    runs.back().second = value ;
+	in = pass ;
+    }
+    return runs ;
+}
+
+/** @brief whether none, some or all of the rows of rec pass the value
+ * constraint of its MPAR at position m
+ *
+ * SOME is returned whenever the zone can not tell, the rows then have to
+ * be checked.
+ */
+CedarZoneFilter::Match
+CedarZoneFilter::match( const CedarRawRecord &rec, int m )
+{
+    if( !_zones )
+	return SOME ;
+    const CedarZoneMap::Zone *zones = _zones->get_zones( rec ) ;
+    if( !zones )
+	return SOME ;
+    return match( zones[m], rec.get_nrows(),
+		  get_runs( rec.get_mpar_code( m ) ) ) ;
+}
+
+/** @brief true if value is in one of the runs
+ */
+bool
+CedarZoneFilter::passes( const Runs &runs, int value )
+{
+    // the runs are in order and do not overlap
+    size_t lo = 0 ;
+    size_t hi = runs.size() ;
+    while( lo < hi )
+    {
+	size_t mid = ( lo + hi ) / 2 ;
+	if( runs[mid].second < value )
+	    lo = mid + 1 ;
+	else
+	    hi = mid ;
+    }
+    return lo < runs.size() && runs[lo].first <= value ;
+}
+
+/** @brief whether none, some or all of nrows values described by zone
+ * are in the runs
+ */
+CedarZoneFilter::Match
+CedarZoneFilter::match( const CedarZoneMap::Zone &zone, int nrows,
+			const Runs &runs )
+{
+    int values = nrows - zone.nulls ;
+    bool missing = passes( runs, CEDAR_RAW_MISSING ) ;
+
+    // the first run ending at or after min is the only one that can hold
+    // all of the values, and if it starts after max none can be held
+    size_t lo = 0 ;
+    size_t hi = runs.size() ;
+    while( values > 0 && lo < hi )
+    {
+	size_t mid = ( lo + hi ) / 2 ;
+	if( runs[mid].second < zone.min )
+	    lo = mid + 1 ;
+	else
+	    hi = mid ;
+    }
+    bool any_value = values > 0 && lo < runs.size()
+		     && runs[lo].first <= zone.max ;
+    bool all_values = values <= 0 || ( any_value
+				       && runs[lo].first <= zone.min
+				       && runs[lo].second >= zone.max ) ;
+
+    if( !( zone.nulls && missing ) && !any_value )
+	return NONE ;
+    if( ( !zone.nulls || missing ) && all_values )
+	return ALL ;
+    return SOME ;
+}
+
@@ -0,0 +1,130 @@
+// CedarZoneMap.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_CedarZoneMap_h
+#define I_CedarZoneMap_h 1
+
+#include <string>
+#include <vector>
+#include <map>
+#include <utility>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::pair ;
+
+class CedarRawRecord ;
+class CedarConstraintEvaluator ;
+
+// product name used for the cache key of a file's zone map
+#define CEDAR_ZONE_MAP_PRODUCT "zones"
+
+/** @brief the range of values of every MPAR parameter in every data
+ * record of a cedar file
+ *
+ * For each MPAR of a data record the zone map holds the smallest and
+ * largest value in the rows of the record, leaving out missing values,
+ * and the number of rows where the value is missing. A value constraint
+ * can then fail a whole record, or pass all of its rows, without looking
+ * at the rows. JPAR values are not subject to value constraints and have
+ * no zones.
+ *
+ * Zone maps are built alongside the first read of a file with a value
+ * constraint and kept keyed by the cache key of the file, so they change
+ * with the file.
+ */
+class CedarZoneMap
+{
+public:
+    typedef struct _cedar_zone
+    {
+	short min ;
+	short max ;
+	unsigned short nulls ;
+    } Zone ;
+private:
+    vector<unsigned long>	_start ;
+    vector<Zone>		_zones ;
+    bool			_broken ;
+
+    static map<string,CedarZoneMap *> _maps ;
+public:
+    				CedarZoneMap() : _broken( false ) {}
+    virtual			~CedarZoneMap() {}
+
+    virtual void		add_record( const CedarRawRecord &rec ) ;
+    virtual const Zone *	get_zones( const CedarRawRecord &rec ) const ;
+
+    /** @brief records added, false if one was out of order */
+    bool			is_complete() const { return !_broken ; }
+    unsigned long		get_records() const { return _start.size() ; }
+
+    static const CedarZoneMap *	get( const string &key ) ;
+    static void			add( const string &key, CedarZoneMap *zones ) ;
+    static void			Clear() ;
+} ;
+
+/** @brief decides, from its zone, whether a record can have rows that
+ * satisfy the value constraint of a parameter
+ *
+ * The values passing the constraint of a parameter are found once per
+ * request by trying every 16 bit value against it, and kept as runs of
+ * consecutive passing values. This makes no assumption about the shape of
+ * the constraint.
+ */
+class CedarZoneFilter
+{
+public:
+    typedef enum
+    {
+	NONE,
+	SOME,
+	ALL
+    } Match ;
+    typedef vector< pair<int,int> > Runs ;
+private:
+    CedarConstraintEvaluator &	_qa ;
+    const CedarZoneMap *	_zones ;
+    map<int,Runs>		_runs ;
+
+    const Runs &		get_runs( int code ) ;
+public:
+    				CedarZoneFilter( CedarConstraintEvaluator &qa,
+						 const CedarZoneMap *zones )
+				    : _qa( qa ), _zones( zones ) {}
+    virtual			~CedarZoneFilter() {}
+
+    virtual Match		match( const CedarRawRecord &rec, int m ) ;
+
+    static bool			passes( const Runs &runs, int value ) ;
+    static Match		match( const CedarZoneMap::Zone &zone,
+				       int nrows, const Runs &runs ) ;
+} ;
+
+#endif // I_CedarZoneMap_h
+
@@ -34,11 +34,14 @@
 #include <unistd.h>
 #endif
 
+#include <stdlib.h>
+
 #include <sstream>
 #include <fstream>
 #include <iostream>
 
 using std::stringstream ;
+using std::ostringstream ;
 using std::ifstream ;
 
 #include "ContainerStorageCedar.h"
@@ -49,17 +52,33 @@ using std::ifstream ;
 #include <BESForbiddenError.h>
 #include <BESInfo.h>
 #include <BESServiceRegistry.h>
-#include "CedarFSDir.h"
-#include "CedarFSFile.h"
+#include <BESContextManager.h>
 #include "CedarResponseNames.h"
+#include "CedarArchive.h"
+#include "CedarContainerMap.h"
+#include "CedarFileCache.h"
+
+// seconds between checks of the base directories when
+// Cedar.Containers.Refresh is not set
+#define CEDAR_CONTAINERS_REFRESH 60
+
+// threads reading the base directories when Cedar.Containers.Threads is
+// not set
+#define CEDAR_CONTAINERS_THREADS 4
+
+// containers listed at a time when Cedar.Containers.PageSize is not set
+#define CEDAR_CONTAINERS_PAGE_SIZE 1000
 
 ContainerStorageCedar::ContainerStorageCedar( const string &n )
-    : BESContainerStorage( n )
+    : BESContainerStorage( n ),
+      _containers( 0 ),
+      _page_size( 0 )
 {
+    // more than one base directory can be given, as Cedar.BaseDir+=dir
     string key = "Cedar.BaseDir" ;
     bool found = false ;
-    TheBESKeys::TheKeys()->get_value( key, _cedar_base, found ) ;
-    if( _cedar_base == "" )
+    TheBESKeys::TheKeys()->get_values( key, _cedar_bases, found ) ;
+    if( _cedar_bases.empty() || _cedar_bases[0] == "" )
     {
 	string s = key + " not defined in bes configuration file"
 	           + ", unable to determine Cedar base directory" ;
@@ -67,45 +86,108 @@ ContainerStorageCedar::ContainerStorageCedar( const string &n )
     }
     key = "Madrigal.BaseDir" ;
     found = false ;
-    TheBESKeys::TheKeys()->get_value( key, _madrigal_base, found ) ;
+    TheBESKeys::TheKeys()->get_values( key, _madrigal_bases, found ) ;
+
+    string cedar_layout = get_layout( "Cedar.Layout" ) ;
+    string madrigal_layout = get_layout( "Madrigal.Layout" ) ;
+
+    time_t refresh = CEDAR_CONTAINERS_REFRESH ;
+    string value ;
+    found = false ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Containers.Refresh", value,
+				      found ) ;
+    if( found && !value.empty() )
+	refresh = atol( value.c_str() ) ;
+
+    unsigned int threads = CEDAR_CONTAINERS_THREADS ;
+    found = false ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Containers.Threads", value,
+				      found ) ;
+    if( found && !value.empty() && atoi( value.c_str() ) > 0 )
+	threads = atoi( value.c_str() ) ;
+
+    _page_size = CEDAR_CONTAINERS_PAGE_SIZE ;
+    found = false ;
+    TheBESKeys::TheKeys()->get_value( "Cedar.Containers.PageSize", value,
+				      found ) ;
+    if( found && !value.empty() )
+	_page_size = strtoul( value.c_str(), 0, 10 ) ;
+
+    // cedar files first, then madrigal files, then cedar files kept with
+    // the madrigal files
+    _containers = new CedarContainerMap( refresh, threads ) ;
+    for( size_t i = 0; i < _cedar_bases.size(); i++ )
+	_containers->add_base( _cedar_bases[i], "cbf", cedar_layout ) ;
+    for( size_t i = 0; i < _madrigal_bases.size(); i++ )
+	_containers->add_base( _madrigal_bases[i], "001", madrigal_layout ) ;
+    for( size_t i = 0; i < _madrigal_bases.size(); i++ )
+	_containers->add_base( _madrigal_bases[i], "cbf", madrigal_layout ) ;
+}
+
+/** @brief the layout of the files below a kind of base directory, empty
+ * if files sit directly in it
+ *
+ * @param key the key giving the layout
+ * @throws BESSyntaxUserError if the layout is not understood
+ */
+string
+ContainerStorageCedar::get_layout( const string &key )
+{
+    string layout ;
+    bool found = false ;
+    TheBESKeys::TheKeys()->get_value( key, layout, found ) ;
+    string error ;
+    if( !CedarContainerMap::check_layout( layout, error ) )
+    {
+	string s = key + ": " + error ;
+	throw BESSyntaxUserError( s, __FILE__, __LINE__ ) ;
+    }
+    return layout ;
 }
 
 ContainerStorageCedar::~ContainerStorageCedar()
 {
+    delete _containers ;
+}
+
+/** @brief the file sym_name stands for
+ *
+ * The files below the base directories are looked up in the container
+ * map, without touching the file system. Otherwise sym_name may name the
+ * archive index.
+ *
+ * @param sym_name the symbolic name of the container
+ * @param real_name set to the path of the file
+ * @return false if there is no such file
+ */
+bool
+ContainerStorageCedar::find_file( const string &sym_name, string &real_name )
+{
+    if( _containers->find( sym_name, real_name ) )
+	return true ;
+    if( sym_name != CEDAR_ARCHIVE_CONTAINER )
+	return false ;
+    const string &index = CedarArchive::get_index() ;
+    if( index.empty() || access( index.c_str(), R_OK ) == -1 )
+	return false ;
+    real_name = index ;
+    return true ;
 }
 
 BESContainer *
 ContainerStorageCedar::look_for( const string &sym_name )
 {
-    // This should be the full path to the file. Make sure it exists. If
-    // it doesn't, then return null and perhaps another container store
-    // can handle it. If not, then an exception will be thrown.
-    string real_name = _cedar_base + "/" + sym_name + ".cbf" ;
-    int is_accessible = access( real_name.c_str(), R_OK ) ;
-    if( is_accessible == -1 && _madrigal_base.empty() )
-    {
-        return 0 ;
-    }
-    else if( is_accessible == -1 && !_madrigal_base.empty() )
-    {
-        real_name = _madrigal_base + "/" + sym_name + ".001" ;
-        is_accessible = access( real_name.c_str(), R_OK ) ;
-        if( is_accessible == -1 )
-        {
-            real_name = _madrigal_base + "/" + sym_name + ".cbf" ;
-            is_accessible = access( real_name.c_str(), R_OK ) ;
-            if( is_accessible == -1 )
-            {
-                // In this case, the file is not accessible or does not exist
-                // using cedar base directory. So return 0 and allow another
-                // container store a chance to get to it.
-                return 0 ;
-            }
-        }
-    }
-    // the file is accessible, let's use it
-    BESContainer *c = new BESFileContainer( sym_name, real_name, "cedar" ) ;
-    return c ;
+    // If the file can not be found, return null and perhaps another
+    // container store can handle it. If not, then an exception will be
+    // thrown.
+    string real_name ;
+    if( !find_file( sym_name, real_name ) )
+	return 0 ;
+
+    // a cedar file is read from its local copy once it has one
+    if( real_name != CedarArchive::get_index() )
+	real_name = CedarFileCache::get_file( real_name ) ;
+    return new BESFileContainer( sym_name, real_name, "cedar" ) ;
 }
 
 void
@@ -144,89 +226,62 @@ bool
 ContainerStorageCedar::isData( const string &inQuestion,
 			       list<string> &provides )
 {
-    bool isit = false ;
-    BESContainer *c = look_for( inQuestion ) ;
-    if( c )
-    {
-	isit = true ;
-	string node_type = c->get_container_type() ;
-	BESServiceRegistry::TheRegistry()->services_handled( node_type,
-							     provides ) ;
-    }
-    return isit ;
+    string real_name ;
+    if( !find_file( inQuestion, real_name ) )
+	return false ;
+    BESServiceRegistry::TheRegistry()->services_handled( "cedar", provides ) ;
+    return true ;
 }
 
+/** @brief list the cedar and madrigal files that can be used as
+ * containers
+ *
+ * The files are listed by symbolic name from the container map, a page
+ * at a time. The page is given as start,count in the
+ * cedar_containers_page context, otherwise the first
+ * Cedar.Containers.PageSize files are listed. A count of 0 lists every
+ * file from start on.
+ *
+ * @param info the informational response to add the containers to
+ */
 void
 ContainerStorageCedar::show_containers( BESInfo &info )
 {
     info.add_data( get_name() ) ;
     info.add_data( "\n" ) ;
 
-    // need to get every file name in the directory and display
-    try
-    {
-	CedarFSDir d( _cedar_base, ".*\\.cbf$" ) ;
-	CedarFSDir::fileIterator i ;
-	for( i = d.beginOfFileList(); i != d.endOfFileList(); i++ )
-	{
-	    string sym = (*i).getBaseName() ;
-	    string real = (*i).getFullPath() ;
-	    show_container( sym, real, CEDAR_NAME, info ) ;
-	}
-    }
-    catch( const string &err_str )
-    {
-	info.add_data( err_str ) ;
-    }
-    catch( ... )
-    {
-	info.add_data( "Failed to retrieve containers for cedar" ) ;
-    }
-
-    try
-    {
-	if( !_madrigal_base.empty() )
-	{
-	    CedarFSDir d( _madrigal_base, ".*\\.001$" ) ;
-	    CedarFSDir::fileIterator i ;
-	    for( i = d.beginOfFileList(); i != d.endOfFileList(); i++ )
-	    {
-		string sym = (*i).getBaseName() ;
-		string real = (*i).getFullPath() ;
-		show_container( sym, real, CEDAR_NAME, info ) ;
-	    }
-	}
-    }
-    catch( const string &err_str )
-    {
-	info.add_data( err_str ) ;
-    }
-    catch( ... )
+    unsigned long start = 0 ;
+    unsigned long count = _page_size ;
+    bool found = false ;
+    string page =
+	BESContextManager::TheManager()->get_context(
+					CEDAR_CONTAINERS_PAGE_CONTEXT, found ) ;
+    if( found && !page.empty() )
     {
-	info.add_data( "Failed to retrieve containers for cedar" ) ;
+	char *end = 0 ;
+	start = strtoul( page.c_str(), &end, 10 ) ;
+	if( end && *end == ',' )
+	    count = strtoul( end + 1, 0, 10 ) ;
     }
 
-    try
+    _containers->check() ;
+    const map<string,string> &paths = _containers->get_paths() ;
+    map<string,string>::const_iterator i = paths.begin() ;
+    for( unsigned long n = 0; n < start && i != paths.end(); n++ )
+	i++ ;
+    for( unsigned long n = 0; i != paths.end(); n++, i++ )
     {
-	if( !_madrigal_base.empty() )
+	if( count && n == count )
 	{
-	    CedarFSDir d( _madrigal_base, ".*\\.cbf$" ) ;
-	    CedarFSDir::fileIterator i ;
-	    for( i = d.beginOfFileList(); i != d.endOfFileList(); i++ )
-	    {
-		string sym = (*i).getBaseName() ;
-		string real = (*i).getFullPath() ;
-		show_container( sym, real, CEDAR_NAME, info ) ;
-	    }
+	    ostringstream more ;
+	    more << paths.size() - ( start + count ) << " more containers, "
+		 << "set the " << CEDAR_CONTAINERS_PAGE_CONTEXT << " context "
+		 << "to " << start + count << "," << count
+		 << " for the next page\n" ;
+	    info.add_data( more.str() ) ;
+	    break ;
 	}
-    }
-    catch( const string &err_str )
-    {
-	info.add_data( err_str ) ;
-    }
-    catch( ... )
-    {
-	info.add_data( "Failed to retrieve containers for cedar" ) ;
+	show_container( i->first, i->second, CEDAR_NAME, info ) ;
     }
 }
 
@@ -243,7 +298,12 @@ ContainerStorageCedar::dump( ostream &strm ) const
     strm << BESIndent::LMarg << "ContainerStorageCedar::dump - ("
 			     << (void *)this << ")" << endl ;
     BESIndent::Indent() ;
-    strm << BESIndent::LMarg << "Cedar base directory: " << _cedar_base << endl;
+    for( size_t i = 0; i < _cedar_bases.size(); i++ )
+	strm << BESIndent::LMarg << "Cedar base directory: "
+	     << _cedar_bases[i] << endl ;
+    for( size_t i = 0; i < _madrigal_bases.size(); i++ )
+	strm << BESIndent::LMarg << "Madrigal base directory: "
+	     << _madrigal_bases[i] << endl ;
     BESIndent::UnIndent() ;
 }
 
@@ -34,16 +34,26 @@
 #define I_ContainerStorageCedar_h_ 1
 
 #include <string>
+#include <vector>
 
 using std::string ;
+using std::vector ;
 
 #include "BESContainerStorage.h"
 
+class CedarContainerMap ;
+
 class ContainerStorageCedar : public BESContainerStorage
 {
 private:
-    string			_cedar_base ;
-    string			_madrigal_base ;
+    vector<string>		_cedar_bases ;
+    vector<string>		_madrigal_bases ;
+    CedarContainerMap *		_containers ;
+    unsigned long		_page_size ;
+
+    bool			find_file( const string &sym_name,
+					   string &real_name ) ;
+    static string		get_layout( const string &key ) ;
 public:
     				ContainerStorageCedar( const string &n);
     virtual			~ContainerStorageCedar() ;
@@ -34,9 +34,10 @@
 #include "CedarFlat.h"
 #include "BESRequestHandlerList.h"
 #include "BESContextManager.h"
+#include "CedarResponseNames.h"
 
 FlatResponseHandler::FlatResponseHandler( const string &name )
-    : BESResponseHandler( name )
+    : CedarTextResponseHandler( name )
 {
 }
 
@@ -47,23 +48,17 @@ FlatResponseHandler::~FlatResponseHandler( )
 void
 FlatResponseHandler::execute( BESDataHandlerInterface &dhi )
 {
+    // a byte range is of the product as formatted, it is not compressed
     bool found = false ;
-    string context = "transmit_protocol" ;
-    string protocol = BESContextManager::TheManager()->get_context( context,
-								    found ) ;
-    _response = new CedarFlat( protocol == "HTTP",
-			       &(dhi.get_output_stream()) ) ;
+    string range =
+	BESContextManager::TheManager()->get_context( CEDAR_RANGE_CONTEXT,
+						      found ) ;
+    bool is_http = false ;
+    ostream *strm = open_text( dhi, range.empty(), is_http ) ;
+    _response = new CedarFlat( is_http, strm ) ;
     BESRequestHandlerList::TheList()->execute_each( dhi ) ;
 }
 
-void
-FlatResponseHandler::transmit( BESTransmitter *transmitter,
-                               BESDataHandlerInterface &dhi )
-{
-    if( _response )
-	transmitter->send_text( *((CedarFlat *)_response), dhi ) ;
-}
-
 /** @brief dumps information about this object
  *
  * Displays the pointer value of this instance and calls dump on the parent
@@ -33,16 +33,14 @@
 #ifndef I_FLATRESPONSEHANDLER_H
 #define I_FLATRESPONSEHANDLER_H
 
-#include "BESResponseHandler.h"
+#include "CedarTextResponseHandler.h"
 
-class FlatResponseHandler : public BESResponseHandler {
+class FlatResponseHandler : public CedarTextResponseHandler {
 public:
 				FlatResponseHandler( const string &name ) ;
     virtual			~FlatResponseHandler(void) ;
 
     virtual void		execute( BESDataHandlerInterface &r ) ;
-    virtual void		transmit( BESTransmitter *transmitter,
-                                          BESDataHandlerInterface &r ) ;
 
     virtual void		dump( ostream &strm ) const ;
 
@@ -33,10 +33,9 @@
 #include "InfoResponseHandler.h"
 #include "CedarInfo.h"
 #include "BESRequestHandlerList.h"
-#include "BESContextManager.h"
 
 InfoResponseHandler::InfoResponseHandler( const string &name )
-    : BESResponseHandler( name )
+    : CedarTextResponseHandler( name )
 {
 }
 
@@ -47,23 +46,12 @@ InfoResponseHandler::~InfoResponseHandler( )
 void
 InfoResponseHandler::execute( BESDataHandlerInterface &dhi )
 {
-    bool found = false ;
-    string context = "transmit_protocol" ;
-    string protocol = BESContextManager::TheManager()->get_context( context,
-								    found ) ;
-    _response = new CedarInfo( protocol == "HTTP",
-			       &(dhi.get_output_stream()) ) ;
+    bool is_http = false ;
+    ostream *strm = open_text( dhi, true, is_http ) ;
+    _response = new CedarInfo( is_http, strm ) ;
     BESRequestHandlerList::TheList()->execute_each( dhi ) ;
 }
 
-void
-InfoResponseHandler::transmit( BESTransmitter *transmitter,
-                               BESDataHandlerInterface &dhi )
-{
-    if( _response )
-	transmitter->send_text( *((BESInfo *)_response), dhi ) ;
-}
-
 /** @brief dumps information about this object
  *
  * Displays the pointer value of this instance and calls dump on the parent
@@ -33,16 +33,14 @@
 #ifndef I_InfoResponseHandler_h
 #define I_InfoResponseHandler_h 1
 
-#include "BESResponseHandler.h"
+#include "CedarTextResponseHandler.h"
 
-class InfoResponseHandler : public BESResponseHandler {
+class InfoResponseHandler : public CedarTextResponseHandler {
 public:
 				InfoResponseHandler( const string &name ) ;
     virtual			~InfoResponseHandler( void ) ;
 
     virtual void		execute( BESDataHandlerInterface &r ) ;
-    virtual void		transmit( BESTransmitter *transmitter,
-                                          BESDataHandlerInterface &r ) ;
 
     virtual void		dump( ostream &strm ) const ;
 
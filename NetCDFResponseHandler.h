@@ -0,0 +1,48 @@
+// NetCDFResponseHandler.h
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#ifndef I_NETCDFRESPONSEHANDLER_H
+#define I_NETCDFRESPONSEHANDLER_H
+
+#include "BESResponseHandler.h"
+
+class NetCDFResponseHandler : public BESResponseHandler {
+public:
+				NetCDFResponseHandler( const string &name ) ;
+    virtual			~NetCDFResponseHandler(void) ;
+
+    virtual void		execute( BESDataHandlerInterface &r ) ;
+    virtual void		transmit( BESTransmitter *transmitter,
+                                          BESDataHandlerInterface &r ) ;
+
+    virtual void		dump( ostream &strm ) const ;
+
+    static BESResponseHandler *NetCDFResponseBuilder( const string &name ) ;
+};
+
+#endif // I_NETCDFRESPONSEHANDLER_H
+
@@ -33,10 +33,9 @@
 #include "TabResponseHandler.h"
 #include "CedarTab.h"
 #include "BESRequestHandlerList.h"
-#include "BESContextManager.h"
 
 TabResponseHandler::TabResponseHandler( const string &name )
-    : BESResponseHandler( name )
+    : CedarTextResponseHandler( name )
 {
 }
 
@@ -47,23 +46,12 @@ TabResponseHandler::~TabResponseHandler( )
 void
 TabResponseHandler::execute( BESDataHandlerInterface &dhi )
 {
-    bool found = false ;
-    string context = "transmit_protocol" ;
-    string protocol = BESContextManager::TheManager()->get_context( context,
-								    found ) ;
-    _response = new CedarTab( protocol == "HTTP",
-			      &(dhi.get_output_stream()) ) ;
+    bool is_http = false ;
+    ostream *strm = open_text( dhi, true, is_http ) ;
+    _response = new CedarTab( is_http, strm ) ;
     BESRequestHandlerList::TheList()->execute_each( dhi ) ;
 }
 
-void
-TabResponseHandler::transmit( BESTransmitter *transmitter,
-                              BESDataHandlerInterface &dhi )
-{
-    if( _response )
-	transmitter->send_text( *((CedarTab *)_response), dhi ) ;
-}
-
 /** @brief dumps information about this object
  *
  * Displays the pointer value of this instance and calls dump on the parent
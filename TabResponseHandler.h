@@ -33,16 +33,14 @@
 #ifndef I_TABRESPONSEHANDLER_H
 #define I_TABRESPONSEHANDLER_H
 
-#include "BESResponseHandler.h"
+#include "CedarTextResponseHandler.h"
 
-class TabResponseHandler : public BESResponseHandler {
+class TabResponseHandler : public CedarTextResponseHandler {
 public:
 				TabResponseHandler( const string &name ) ;
     virtual			~TabResponseHandler(void) ;
 
     virtual void		execute( BESDataHandlerInterface &r ) ;
-    virtual void		transmit( BESTransmitter *transmitter,
-                                          BESDataHandlerInterface &r ) ;
 
     virtual void		dump( ostream &strm ) const ;
 
@@ -0,0 +1,120 @@
+// cedar_read_archive.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+using std::string ;
+using std::vector ;
+
+#include "cedar_read_archive.h"
+#include "CedarArchive.h"
+#include "BESError.h"
+
+static string
+format_stamp( long long stamp )
+{
+    // yyyymmddhhmmss
+    char buf[32] ;
+    snprintf( buf, sizeof buf, "%04lld/%02lld/%02lld %02lld:%02lld:%02lld",
+	      stamp / 10000000000LL, stamp / 100000000LL % 100,
+	      stamp / 1000000LL % 100, stamp / 10000LL % 100,
+	      stamp / 100LL % 100, stamp % 100 ) ;
+    return buf ;
+}
+
+/** @brief list the files of the archive index satisfying query
+ *
+ * @param info the response to add the list to
+ * @param filename the file of the container, the archive index itself to
+ * look through every file, otherwise only the entry of that file is listed
+ * @param name the symbolic name of the container
+ * @param query the constraint, see CedarArchiveQuery
+ * @param error set if the index can not be read or the query not parsed
+ */
+bool
+cedar_read_archive( BESInfo &info, const string &filename,
+		    const string &name, const string &query, string &error )
+{
+    CedarArchiveQuery q ;
+    if( !q.parse( query, error ) )
+	return false ;
+
+    vector<const CedarArchiveFile *> found ;
+    try
+    {
+	CedarArchive *archive = CedarArchive::TheArchive() ;
+	if( !archive )
+	{
+	    error = "There is no archive index, Cedar.Archive.Index is not set" ;
+	    return false ;
+	}
+	archive->find( q, found ) ;
+    }
+    catch( BESError &e )
+    {
+	error = e.get_message() ;
+	return false ;
+    }
+
+    bool whole = ( filename == CedarArchive::get_index() ) ;
+    info.add_data( "ARCHIVE FILES CORRESPONDING TO: " ) ;
+    info.add_data( name ) ;
+    info.add_data( "\n\n" ) ;
+    info.add_data( "NAME\tBEGIN\tEND\tRECORD_TYPES\tPARAMETERS\n" ) ;
+    for( size_t i = 0; i < found.size(); i++ )
+    {
+	const CedarArchiveFile &f = *(found[i]) ;
+	if( !whole && f.path != filename )
+	    continue ;
+	string line = f.name + "\t" ;
+	if( f.record_types.empty() )
+	    line += "N/A\tN/A\t" ;
+	else
+	    line += format_stamp( f.begin ) + "\t" + format_stamp( f.end ) + "\t" ;
+	char num[32] ;
+	size_t j = 0 ;
+	for( j = 0; j < f.record_types.size(); j++ )
+	{
+	    snprintf( num, sizeof num, "%s%d/%d", j ? "," : "",
+		      f.record_types[j].first, f.record_types[j].second ) ;
+	    line += num ;
+	}
+	line += "\t" ;
+	for( j = 0; j < f.parameters.size(); j++ )
+	{
+	    snprintf( num, sizeof num, "%s%d", j ? "," : "",
+		      f.parameters[j] ) ;
+	    line += num ;
+	}
+	line += "\n" ;
+	info.add_data( line ) ;
+    }
+    return true ;
+}
@@ -0,0 +1,275 @@
+// cedar_read_arrow.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <new>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::endl ;
+using std::bad_alloc ;
+
+#include "cedar_read_arrow.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarException.h"
+#include "CedarStringConversions.h"
+#include "CedarReadParcods.h"
+#include "CedarRawFile.h"
+#include "CedarRawOutput.h"
+#include "CedarRecordIndex.h"
+#include "CedarAggregate.h"
+#include "CedarArrowWriter.h"
+#include "BESInternalError.h"
+#include "BESDebug.h"
+
+// largest record batch, a batch is only ended between records
+#define ARROW_BATCH_ROWS 65536
+
+/** @brief add the column for a parameter code along with its metadata
+ * from the parameter code table
+ */
+static int
+add_parameter( CedarArrowWriter &writer, int code )
+{
+    char tmp[100] ;
+    string name = CedarRecordIndex::get_column_name( code ) ;
+    if( writer.has_column( name ) )
+    {
+	CedarStringConversions::ltoa( code < 0 ? -code : code, tmp, 10 ) ;
+	name = name + "_" + tmp ;
+    }
+    int col = writer.add_column( name, 16, true ) ;
+
+    int par = code < 0 ? -code : code ;
+    CedarStringConversions::ltoa( code, tmp, 10 ) ;
+    writer.add_metadata( col, "code", tmp ) ;
+    string long_name = CedarReadParcods::Get_Longname( par ) ;
+    if( code < 0 )
+	long_name = "error in " + long_name ;
+    writer.add_metadata( col, "long_name", long_name ) ;
+    string units = CedarReadParcods::Get_Unit_Label( par ) ;
+    if( !units.empty() )
+	writer.add_metadata( col, "units", units ) ;
+    string scale = CedarReadParcods::Get_Scale( par ) ;
+    if( !scale.empty() )
+	writer.add_metadata( col, "scale", scale ) ;
+    return col ;
+}
+
+/** @brief adds a row to the record batch for each selected row of the
+ * records it is given
+ *
+ * A batch holds the rows of consecutive records of the same KINDAT, so
+ * every batch has the layout of a single kind of data.
+ */
+class ArrowRows : public CedarRecordReader
+{
+private:
+    CedarArrowWriter &		_writer ;
+    int				_record_col ;
+    vector<int>			_prologue ;
+    map<int,int>		_jcols ;
+    map<int,int>		_mcols ;
+    int				_kindat ;
+public:
+    				ArrowRows( CedarArrowWriter &writer )
+				    : _writer( writer ),
+				      _record_col( -1 ),
+				      _kindat( 0 ) {}
+    virtual			~ArrowRows() {}
+
+    virtual void		add_columns( const CedarRecordIndex &index ) ;
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) ;
+} ;
+
+/** @brief add the columns for the record number, the prologue and the
+ * parameters of the indexed records
+ */
+void
+ArrowRows::add_columns( const CedarRecordIndex &index )
+{
+    _record_col = _writer.add_column( "record", 32, false ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	int col = _writer.add_column( cedar_prologue_words[p].name, 16,
+				      false ) ;
+	if( cedar_prologue_words[p].units[0] != '\0' )
+	{
+	    _writer.add_metadata( col, "units",
+				  cedar_prologue_words[p].units ) ;
+	}
+	if( cedar_prologue_words[p].centi )
+	    _writer.add_metadata( col, "scale", "0.01" ) ;
+	_prologue.push_back( col ) ;
+    }
+    const vector<int> &jpars = index.get_jpars() ;
+    for( size_t j = 0; j < jpars.size(); j++ )
+	_jcols[jpars[j]] = add_parameter( _writer, jpars[j] ) ;
+    const vector<int> &mpars = index.get_mpars() ;
+    for( size_t m = 0; m < mpars.size(); m++ )
+	_mcols[mpars[m]] = add_parameter( _writer, mpars[m] ) ;
+}
+
+void
+ArrowRows::data_record( const CedarRawRecord &rec,
+                        const CedarRecordSelection &sel )
+{
+    if( rec.get_kindat() != _kindat
+	|| _writer.get_batch_rows() >= ARROW_BATCH_ROWS )
+    {
+	_writer.flush() ;
+	_kindat = rec.get_kindat() ;
+    }
+
+    _writer.clear_row() ;
+    _writer.set_value( _record_col, (int)rec.get_ordinal() ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	_writer.set_value( _prologue[p],
+			   rec.get_word( cedar_prologue_words[p].word ) ) ;
+    }
+    const vector<int> &jpar = sel.get_jpar() ;
+    for( size_t j = 0; j < jpar.size(); j++ )
+    {
+	_writer.set_value( _jcols[rec.get_jpar_code( jpar[j] )],
+			   rec.get_jpar_value( jpar[j] ) ) ;
+    }
+
+    int nrows = rec.get_nrows() ;
+    if( nrows == 0 )
+    {
+	_writer.end_row() ;
+    }
+    const vector<int> &mpar = sel.get_mpar() ;
+    vector<int> cols( mpar.size() ) ;
+    for( size_t m = 0; m < mpar.size(); m++ )
+    {
+	cols[m] = _mcols[rec.get_mpar_code( mpar[m] )] ;
+    }
+    for( int row = 0; row < nrows; row++ )
+    {
+	if( !sel.is_row_selected( row ) )
+	    continue ;
+	for( size_t m = 0; m < mpar.size(); m++ )
+	{
+	    _writer.set_value( cols[m], rec.get_mpar_value( row, mpar[m] ) ) ;
+	}
+	_writer.end_row() ;
+    }
+}
+
+/** @brief send the rows of the cedar file that satisfy the constraint as
+ * an Arrow IPC stream
+ *
+ * The schema has a column for the record number, the prologue and each
+ * of the parameters of the selected records, parameters a record does not
+ * have and missing values are null. The values are copied from the 16 bit
+ * words of the records without any conversion to text. Record batches
+ * never mix records of different KINDATs.
+ *
+ * @param strm stream to write the Arrow stream to
+ * @param is_http true if the response is sent over HTTP
+ * @param filename the cedar file
+ * @param name name of the dataset, used to name the stream
+ * @param query the constraint, may be empty
+ * @param error set if there is a problem writing the stream
+ * @return true if successful, false otherwise
+ */
+bool
+cedar_read_arrow( ostream &strm, bool is_http, const string &filename,
+                  const string &name, const string &query, string &error )
+{
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return false ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarRecordIndex index ;
+	index.build( files, qa ) ;
+	BESDEBUG( "cedar", "cedar_read_arrow - "
+			   << index.get_records().size() << " records, "
+			   << index.get_nrows() << " rows" << endl ) ;
+
+	CedarRawOutput out( strm ) ;
+	CedarArrowWriter writer( out ) ;
+	writer.add_metadata( "source", name ) ;
+	if( !query.empty() )
+	    writer.add_metadata( "constraint", query ) ;
+
+	ArrowRows rows( writer ) ;
+	rows.add_columns( index ) ;
+
+	if( is_http )
+	{
+	    out.set_mime( "application/vnd.apache.arrow.stream",
+			  name + ".arrows" ) ;
+	}
+	writer.write_schema() ;
+	index.replay( files, rows ) ;
+	writer.finish() ;
+    }
+    catch( CedarException &cedarex )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += cedarex.get_description() + (string)"\n" ;
+	return false ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return false ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return false ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception\n" ;
+	return false ;
+    }
+
+    return true ;
+}
+
@@ -37,39 +37,82 @@
 #include <string>
 #include <new>
 #include <memory>
+#include <set>
 
 using std::string ;
 using std::bad_alloc ;
 using std::auto_ptr ;
+using std::set ;
+using std::pair ;
+using std::make_pair ;
 
 #include "CedarReadKinst.h"
 #include "CedarReadParcods.h"
 #include "cedar_read_attributes.h"
 #include "CedarException.h"
 #include "CedarFile.h"
+#include "CedarInputFile.h"
+#include "CedarDASCache.h"
+#include "CedarCache.h"
+#include "CedarAggregate.h"
 #include "BESError.h"
+#include <BESDapNames.h>
 
 static const char STRING[]="String";
 static const char BYTE[]="Byte";
 static const char INT16[]="Int16";
 static const char FLOAT64[]="Float64";
 
-bool cedar_read_attributes( DAS &das, const string &filename, string &error )
+/** @brief add the tables of the data records of filename not already in
+ * build to das
+ *
+ * @return false if the file has no records
+ */
+static bool
+load_file_das( DAS &das, const string &filename, CedarDASBuild &build )
+{
+    CedarPlainFile plain( filename ) ;
+    CedarFile file;
+    file.open_file (plain.get_path().c_str());
+    const CedarLogicalRecord* lr=file.get_first_logical_record();
+    if(!lr)
+	return false ;
+    if(lr->get_type()==1) load_das(das, (CedarDataRecord*)lr, build);
+    while (!file.end_dataset())
+    {
+	lr=file.get_next_logical_record();
+	if(lr) 
+	    if(lr->get_type()==1) load_das(das, (CedarDataRecord*)lr, build);
+    }
+    return true ;
+}
+
+bool cedar_read_attributes( DAS &das, const string &filename,
+                            const string &query, string &error )
 {
     try
     {
-	CedarFile file;
-	file.open_file (filename.c_str());
-	const CedarLogicalRecord* lr=file.get_first_logical_record();
-	if(lr)
+	// an aggregate has a table for each KINST and KINDAT of the files
+	// the constraint selects
+	if( CedarAggregate::is_aggregate( filename ) )
+	{
+	    vector<string> files ;
+	    CedarAggregate::get_files( filename, query, files ) ;
+	    CedarDASBuild build ;
+	    for( size_t f = 0; f < files.size(); f++ )
+		load_file_das( das, files[f], build ) ;
+	    return true ;
+	}
+
+	// a file whose DAS was built before is not opened
+	string key = CedarCache::get_key( filename, DAS_RESPONSE, "" ) ;
+	if( CedarDASCache::get_das( das, key ) )
+	    return true ;
+
+	CedarDASBuild build ;
+	if( load_file_das( das, filename, build ) )
 	{
-	    if(lr->get_type()==1) load_das(das, (CedarDataRecord*)lr);
-	    while (!file.end_dataset())
-	    {
-		lr=file.get_next_logical_record();
-		if(lr) 
-		    if(lr->get_type()==1) load_das(das, (CedarDataRecord*)lr);
-	    }
+	    CedarDASCache::add_das( key, build.names, build.signatures ) ;
 	    return true;
 	}
 	else
@@ -105,202 +148,132 @@ bool cedar_read_attributes( DAS &das, const string &filename, string &error )
 
 }
 
-int logged(int dat)
+/** @brief add the attributes of a parameter list to a descriptor table
+ *
+ * For each parameter there is a container, named prefix followed by its
+ * position, holding its code, short and long names, scale and units.
+ */
+static void
+add_parameters( AttrTable *at, const string &prefix,
+		const vector<short int> &codes )
 {
-    static CedarArray<field>reg(1,0);
-    int max_elem=reg.get_size();
-    for (int i=0; i<max_elem-1;i++)
+    char tmp[100];
+    string type = "String" ;
+    string info = "" ;
+    for (size_t i=0; i<codes.size(); i++)
     {
-	if (dat==reg[i])
-	    return 1;
+	string nm=prefix;
+	CedarStringConversions::ltoa(i,tmp,10);
+	nm+=tmp;
+	AttrTable *t1=at->append_container(nm);
+
+	int code = codes[i] ;
+
+	// get the parameter code
+	string scode = CedarReadParcods::Get_Code_as_String( code ) ;
+	info = "\"" + scode + "\"" ;
+	t1->append_attr( "CODE", type, info ) ;
+
+	// short name
+	string sname = CedarReadParcods::Get_Shortname( code ) ;
+	info = "\"" + sname + "\"" ;
+	t1->append_attr( "SHORTNAME", type, info ) ;
+
+	// long name
+	string lname = CedarReadParcods::Get_Longname( code ) ;
+	info = "\"" + lname + "\"" ;
+	t1->append_attr( "LONGNAME", type, info ) ;
+
+	// scale
+	string scale = CedarReadParcods::Get_Scale( code ) ;
+	info = "\"" + scale + "\"" ;
+	t1->append_attr( "SCALE", type, info ) ;
+
+	// units
+	string unit = CedarReadParcods::Get_Unit_Label( code ) ;
+	info = "\"" + unit + "\"" ;
+	t1->append_attr( "UNIT", type, info ) ;
     }
-    reg.set_size(max_elem+1);
-    reg[max_elem-1]=dat;
-    return 0;
 }
 
-void load_das(DAS &das,CedarDataRecord *dr)
+/** @brief build the Data_Descriptor_for_KINDAT table of an instrument and
+ * its parameters, looking them up in the catalog
+ */
+static AttrTable *
+build_descriptor( int kinst, const vector<short int> &jpars,
+		  const vector<short int> &mpars )
 {
-    if (!logged(dr->get_record_kind_data()))
-    { 
-	char tmp[100];
-	string name = "" ;
-	string info = "" ;
-	string type = "String" ;
-	string str = "Data_Descriptor_for_KINDAT_" ;
-	CedarStringConversions::ltoa(dr->get_record_kind_data(),tmp,10);
-	str+=tmp;
-	str+="_KINST_";
-	CedarStringConversions::ltoa(dr->get_record_kind_instrument(),tmp,10);
-	str+=tmp;
-	AttrTable *at=new AttrTable(); 
-	AttrTable *t1;
-	t1=at->append_container("KINST"); 
-	// The KINST attribute table will contain the KINST, INST_NAME,
-	// PREFIX, LATITUDE, LONGITUDE, and ALTITUDE.
-
-	// KINST
-	int kinst = dr->get_record_kind_instrument() ;
-	string skinst = CedarReadKinst::Get_Kinst_as_String( kinst ) ;
-	info="\"" + skinst + "\"" ;
-	t1->append_attr( "KINST", type, info ) ;
-
-	// instrument name
-	info = "\"" + CedarReadKinst::Get_Name( kinst ) + "\"" ;
-	t1->append_attr( "NAME", type, info ) ;
-
-	// instrument prefix
-	info = "\"" + CedarReadKinst::Get_Prefix( kinst ) + "\"" ;
-	t1->append_attr( "PREFIX", type, info ) ;
-
-	// latitude
-	info = "\"" + CedarReadKinst::Get_Latitude_as_String( kinst ) + "\"" ;
-	t1->append_attr( "LATITUDE", type, info ) ;
-
-	// longitude
-	info = "\"" + CedarReadKinst::Get_Longitude_as_String( kinst ) + "\"" ;
-	t1->append_attr( "LONGITUDE", type, info ) ;
-
-	// altitude
-	info = "\"" + CedarReadKinst::Get_Altitude_as_String( kinst ) + "\"" ;
-	t1->append_attr( "ALTITUDE", type, info ) ;
-
-	// get jpar attributes
-	int njpar=dr->get_jpar();
-	auto_ptr<vector<short int> > jparvars( new vector<short int>(njpar));
-	if (jparvars.get())
-	{
-	    // For each of the jpar parameters there will be the code,
-	    // longname, scale, and units.
-	    dr->load_JPAR_vars(*jparvars);
-	    for (int i=0; i<njpar; i++)
-	    {
-		string nm="JPAR_";
-		CedarStringConversions::ltoa(i,tmp,10);
-		nm+=tmp;
-		t1=at->append_container(nm);
-
-		int code = (*jparvars.get())[i] ;
-
-		// get the parameter code
-		string scode = CedarReadParcods::Get_Code_as_String( code ) ;
-		info = "\"" + scode + "\"" ;
-		t1->append_attr( "CODE", type, info ) ;
-
-		// short name
-		string sname = CedarReadParcods::Get_Shortname( code ) ;
-		info = "\"" + sname + "\"" ;
-		t1->append_attr( "SHORTNAME", type, info ) ;
-
-		// long name
-		string lname = CedarReadParcods::Get_Longname( code ) ;
-		info = "\"" + lname + "\"" ;
-		t1->append_attr( "LONGNAME", type, info ) ;
-
-		// scale
-		string scale = CedarReadParcods::Get_Scale( code ) ;
-		info = "\"" + scale + "\"" ;
-		t1->append_attr( "SCALE", type, info ) ;
-
-		// units
-		string unit = CedarReadParcods::Get_Unit_Label( code ) ;
-		info = "\"" + unit + "\"" ;
-		t1->append_attr( "UNIT", type, info ) ;
-
-		/*
-		int val;
-		if ((*jparvars.get())[i]<0)
-		{
-		    val=(*jparvars.get())[i]*-1;
-		    info="\"Error in ";
-		    name="ERROR_IN_PARAMETER_CODE_";
-		}
-		else
-		{
-		    val=(*jparvars.get())[i];
-		    info="\"";
-		    name="PARAMETER_CODE_";
-		}
-		info+=CedarReadParcods::Get_Longname(val);
-		info+=" ";
-		info+=CedarReadParcods::Get_Scale(val);
-		info+=" ";
-		info+=CedarReadParcods::Get_Unit_Label(val);
-		info+="\"";
-		CedarStringConversions::ltoa(val,tmp,10);
-		name+=tmp;
-		t1->append_attr(name, type,info);
-		*/
-	    }
-	}
-
-	// mpar parameter attributes
-	int nmpar=dr->get_mpar();
-	auto_ptr<vector<short int> > mparvars( new vector<short int>(nmpar) );
-	if (mparvars.get())
-	{
-	    dr->load_MPAR_vars(*mparvars);
-	    for (int i=0; i<nmpar; i++)
-	    {
-		string nm="MPAR_";
-		CedarStringConversions::ltoa(i,tmp,10);
-		nm+=tmp;
-		t1=at->append_container(nm);
-
-		int code = (*mparvars.get())[i] ;
-
-		// get the parameter code
-		string scode = CedarReadParcods::Get_Code_as_String( code ) ;
-		info = "\"" + scode + "\"" ;
-		t1->append_attr( "CODE", type, info ) ;
-
-		// short name
-		string sname = CedarReadParcods::Get_Shortname( code ) ;
-		info = "\"" + sname + "\"" ;
-		t1->append_attr( "SHORTNAME", type, info ) ;
-
-		// long name
-		string lname = CedarReadParcods::Get_Longname( code ) ;
-		info = "\"" + lname + "\"" ;
-		t1->append_attr( "LONGNAME", type, info ) ;
-
-		// scale
-		string scale = CedarReadParcods::Get_Scale( code ) ;
-		info = "\"" + scale + "\"" ;
-		t1->append_attr( "SCALE", type, info ) ;
-
-		// units
-		string unit = CedarReadParcods::Get_Unit_Label( code ) ;
-		info = "\"" + unit + "\"" ;
-		t1->append_attr( "UNIT", type, info ) ;
+    string info = "" ;
+    string type = "String" ;
+    auto_ptr<AttrTable> at( new AttrTable() ) ;
+    AttrTable *t1;
+    t1=at->append_container("KINST"); 
+    // The KINST attribute table will contain the KINST, INST_NAME,
+    // PREFIX, LATITUDE, LONGITUDE, and ALTITUDE.
+
+    // KINST
+    string skinst = CedarReadKinst::Get_Kinst_as_String( kinst ) ;
+    info="\"" + skinst + "\"" ;
+    t1->append_attr( "KINST", type, info ) ;
+
+    // instrument name
+    info = "\"" + CedarReadKinst::Get_Name( kinst ) + "\"" ;
+    t1->append_attr( "NAME", type, info ) ;
+
+    // instrument prefix
+    info = "\"" + CedarReadKinst::Get_Prefix( kinst ) + "\"" ;
+    t1->append_attr( "PREFIX", type, info ) ;
+
+    // latitude
+    info = "\"" + CedarReadKinst::Get_Latitude_as_String( kinst ) + "\"" ;
+    t1->append_attr( "LATITUDE", type, info ) ;
+
+    // longitude
+    info = "\"" + CedarReadKinst::Get_Longitude_as_String( kinst ) + "\"" ;
+    t1->append_attr( "LONGITUDE", type, info ) ;
+
+    // altitude
+    info = "\"" + CedarReadKinst::Get_Altitude_as_String( kinst ) + "\"" ;
+    t1->append_attr( "ALTITUDE", type, info ) ;
+
+    // For each of the jpar and mpar parameters there will be the code,
+    // longname, scale, and units.
+    add_parameters( at.get(), "JPAR_", jpars ) ;
+    add_parameters( at.get(), "MPAR_", mpars ) ;
+    return at.release() ;
+}
 
-		/*
-		int val;
-		if ((*mparvars.get())[i]<0)
-		{
-		    val=(*mparvars.get())[i]*-1;
-		    info="\"Error in ";
-		    name="ERROR_IN_PARAMETER_CODE_";
-		}
-		else
-		{
-		    val=(*mparvars.get())[i];
-		    info="\"";
-		    name="PARAMETER_CODE_";
-		}
-		info+=CedarReadParcods::Get_Longname(val);
-		info+=" ";
-		info+=CedarReadParcods::Get_Scale(val);
-		info+=" ";
-		info+=CedarReadParcods::Get_Unit_Label(val);
-		info+="\"";
-		CedarStringConversions::ltoa(val,tmp,10);
-		name+=tmp;
-		t1->append_attr(name, type,info);
-		*/
-	    }
-	}
-	das.add_table(str, at);
+void load_das(DAS &das,CedarDataRecord *dr,CedarDASBuild &build)
+{
+    int kinst = dr->get_record_kind_instrument() ;
+    int kindat = dr->get_record_kind_data() ;
+    if (!build.seen.insert(make_pair(kinst,kindat)).second)
+	return ;
+
+    char tmp[100];
+    string str = "Data_Descriptor_for_KINDAT_" ;
+    CedarStringConversions::ltoa(kindat,tmp,10);
+    str+=tmp;
+    str+="_KINST_";
+    CedarStringConversions::ltoa(kinst,tmp,10);
+    str+=tmp;
+
+    build.scratch.load_codes(*dr);
+    vector<short int> &jpars = build.scratch.jpar_codes ;
+    vector<short int> &mpars = build.scratch.mpar_codes ;
+
+    // the table is built once for an instrument and parameters, later
+    // requests copy it
+    string signature = CedarDASCache::get_signature( kinst, kindat,
+						     jpars, mpars ) ;
+    const AttrTable *at = CedarDASCache::get_fragment( signature ) ;
+    if( !at )
+    {
+	at = CedarDASCache::add_fragment( signature,
+				build_descriptor( kinst, jpars, mpars ) ) ;
     }
+    das.add_table(str, new AttrTable(*at));
+    build.names.push_back( str ) ;
+    build.signatures.push_back( signature ) ;
 }
 
@@ -34,8 +34,17 @@
 #define cedar_read_attributes_h_ 1
 
 
+#include <set>
+#include <vector>
+#include <utility>
+
+using std::set ;
+using std::vector ;
+using std::pair ;
+
 #include "DAS.h"
 #include "CedarDataRecord.h"
+#include "CedarScratch.h"
 
 using namespace libdap ;
 
@@ -50,12 +59,30 @@ using namespace libdap ;
 
   @param das: reference the the DAS object to be loaded with the attribute data.
   @param filename: full qualify path to the cbf file where the data resides.
+  @param query: the constraint, only used to select the files of an aggregate.
   @param error: Pointer to string object where a error string can be loaded indicating the reason for failure of this function.
   @return bool: True if the process have not problem loading the data, false otherwise.
   @see load_das
   */
 bool cedar_read_attributes( DAS &das, const string &filename,
-                            string &cedar_error ) ;
+                            const string &query, string &cedar_error ) ;
+
+/** @brief the tables added to the DAS of one file
+ *
+ * A KINST and KINDAT combination gets a single table in the DAS, built
+ * from the first data record with it. seen holds the combinations added
+ * so far in this request, names and signatures the tables added, so the
+ * DAS of the file can be kept, see CedarDASCache. The parameter codes of
+ * each record are loaded into scratch.
+ */
+class CedarDASBuild
+{
+public:
+    set< pair<int,int> >	seen ;
+    vector<string>		names ;
+    vector<string>		signatures ;
+    CedarScratch		scratch ;
+} ;
 
 /**
   loads a single data record into a DAS object.
@@ -67,35 +94,15 @@ bool cedar_read_attributes( DAS &das, const string &filename,
   as read_descriptors and load_dds (in fact we tried to keep the function
   prototypes very similar) inside they are substantially different because
   of the nature of the data they manipulate.
+
+  Only the first data record of a KINST and KINDAT combination is loaded,
+  the table built for it is kept and copied for later requests.
   @param das: A reference to the DDS object where to load the data.
   @param my_data_record: A reference to a CedarDataRecord object which contains the data to be loaded.
+  @param build: the tables added so far for this file.
   @return void: At this point no return value is present until a more firm policy exist about what to do with corrupted data records. The idea is that if this function returns false then its master user (read_attributes) will spoil the whole dataset just because one record.
   @see read_attributes
   */
-void load_das(DAS &das,CedarDataRecord *dr);
-
-/**
-  Mantains records about which data records has been used to build the
-  DAS object.
-  
-  This method is used by load_das.
-
-  Everytime a data record is extracted from a cbf file, it is parse in
-  order to extract its attributes into an Attribute table. However from
-  attributes point of view two data records are considered the same if
-  they have the same KINDAT. In order to improve speed a static data
-  structure is mantained by this function in which KINDATs are stored if
-  their corresponding data records have been parsed. 
-
-  This method will return 0 (false) if the KINDAT which is passed has not
-  been logged, therefore giving a green light to load_das to parse the
-  data record and add it to the DAS object.
-
-  @param dat: the KINDAT value for the corresponding data record which is about to be parse by load_das.
-  @returns: 0 (false) if the KINDAT is not already logged. 1 (true) if the KINDAT is already logged.
-  @see load_das
-  */
-int logged(int dat);
+void load_das(DAS &das,CedarDataRecord *dr,CedarDASBuild &build);
 
 #endif // cedar_read_attributes_h_
-
@@ -0,0 +1,162 @@
+// cedar_read_cbf.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+#include <string>
+#include <new>
+#include <stdio.h>
+
+using std::string ;
+using std::endl ;
+using std::bad_alloc ;
+
+#include "cedar_read_cbf.h"
+#include "CedarFile.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarException.h"
+#include "CedarRawFile.h"
+#include "CedarRawOutput.h"
+#include "CedarCBFWriter.h"
+#include "CedarAggregate.h"
+#include "BESError.h"
+#include "BESSyntaxUserError.h"
+#include "BESDebug.h"
+
+/** @brief write the logical records of the files that satisfy the
+ * constraint out as a cbf file
+ *
+ * The Cedar library decides which records satisfy the constraint, the
+ * bytes of those records are copied out as they are in the file. The
+ * records of several files are merged in time order, see CedarAggregate.
+ */
+void
+cedar_write_cbf( CedarRawOutput &out, const vector<string> &files,
+                 CedarConstraintEvaluator &qa )
+{
+    CedarAggregate merged( files, true ) ;
+    CedarCBFWriter writer( out ) ;
+    const CedarLogicalRecord *lr = 0 ;
+    const CedarRawRecord *rec = 0 ;
+    while( !out.is_done() && merged.next( lr, rec ) )
+    {
+	if( qa.validate_record( lr ) )
+	    writer.add_record( *rec ) ;
+    }
+    writer.finish() ;
+}
+
+/** @brief send a cbf file made of the logical records of the cedar file
+ * that satisfy the constraint to standard output
+ *
+ * The bytes of the matching records are copied as they are in the file,
+ * nothing is decoded and encoded again. Madrigal files are sent in cbf
+ * format as well.
+ *
+ * @param filename the cedar file to subset
+ * @param query the constraint, may be empty in which case all records
+ * are sent
+ * @param range byte range of the form bytes=first-last, bytes=first- or
+ * bytes=-suffix, may be empty
+ * @param error set if there is a problem sending the records
+ * @return true if successful, false otherwise
+ */
+bool cedar_read_cbf( const string &filename, const string &query,
+                     const string &range, string &error )
+{
+    CedarByteRange br ;
+    if( !range.empty() && !br.parse( range ) )
+    {
+	BESDEBUG( "cedar", "cedar_read_cbf - ignoring range "
+			   << range << endl ) ;
+    }
+
+    CedarRawOutput out( fileno( stdout ) ) ;
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return false ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	if( br.is_set() )
+	{
+	    unsigned long long first = 0 ;
+	    unsigned long long last = 0 ;
+	    if( !br.resolve( first, last ) )
+	    {
+		// a suffix range needs the size of the subset first
+		CedarRawOutput counter ;
+		cedar_write_cbf( counter, files, qa ) ;
+		if( !br.resolve( counter.get_position(), first, last ) )
+		{
+		    string err = "The requested range can not be "
+				 "satisfied for file " + filename ;
+		    throw BESSyntaxUserError( err, __FILE__, __LINE__ ) ;
+		}
+	    }
+	    out.set_range( first, last ) ;
+	}
+	cedar_write_cbf( out, files, qa ) ;
+    }
+    catch( CedarException &cedarex )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += cedarex.get_description() + (string)"\n" ;
+	return false ;
+    }
+    catch( BESSyntaxUserError & )
+    {
+	throw ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return false ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return false ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception\n" ;
+	return false ;
+    }
+
+    return true ;
+}
+
@@ -0,0 +1,259 @@
+// cedar_read_csv.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <new>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::set ;
+using std::bad_alloc ;
+
+#include "CedarCSV.h"
+#include "cedar_read_csv.h"
+#include "CedarException.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarStringConversions.h"
+#include "CedarRawFile.h"
+#include "CedarRecordIndex.h"
+#include "CedarAggregate.h"
+#include "CedarTextFormat.h"
+#include "BESError.h"
+
+/** @brief formats a line of the csv product for each selected row of the
+ * records it is given
+ *
+ * The columns are the record number, the prologue and every parameter of
+ * the indexed records, JPARs first. The record number, prologue and JPARs
+ * of a record are repeated on each of its rows. Parameters the record
+ * does not have and missing values are left empty.
+ */
+class CSVFormat : public CedarTextFormat
+{
+private:
+    map<int,size_t>		_jcols ;
+    map<int,size_t>		_mcols ;
+    vector<int>			_values ;
+    string			_prefix ;
+
+    void			append_field( const string &s ) ;
+protected:
+    virtual void		format( const CedarRawRecord &rec,
+					const CedarRecordSelection &sel,
+					int mark ) ;
+public:
+    				CSVFormat( CedarCSV &csv )
+				    : CedarTextFormat( csv ) {}
+    virtual			~CSVFormat() {}
+
+    virtual void		add_header( const CedarRecordIndex &index ) ;
+} ;
+
+/** @brief append s as a field, quoted if it holds a separator or a quote
+ */
+void
+CSVFormat::append_field( const string &s )
+{
+    if( s.find_first_of( ",\"\r\n" ) == string::npos )
+    {
+	append( s ) ;
+	return ;
+    }
+    append( '"' ) ;
+    for( string::size_type i = 0; i < s.length(); i++ )
+    {
+	if( s[i] == '"' )
+	    append( '"' ) ;
+	append( s[i] ) ;
+    }
+    append( '"' ) ;
+}
+
+/** @brief the header line, a column name for the record number, each
+ * prologue word and each parameter of the indexed records
+ *
+ * A parameter whose name has already been used is given its code as a
+ * suffix.
+ */
+void
+CSVFormat::add_header( const CedarRecordIndex &index )
+{
+    set<string> used ;
+    append( "record" ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	append( ',' ) ;
+	append( cedar_prologue_words[p].name ) ;
+	used.insert( cedar_prologue_words[p].name ) ;
+    }
+
+    const vector<int> &jpars = index.get_jpars() ;
+    const vector<int> &mpars = index.get_mpars() ;
+    vector<int> codes( jpars ) ;
+    codes.insert( codes.end(), mpars.begin(), mpars.end() ) ;
+    for( size_t c = 0; c < codes.size(); c++ )
+    {
+	string name = get_name( codes[c] ) ;
+	if( used.find( name ) != used.end() )
+	{
+	    char tmp[100] ;
+	    CedarStringConversions::ltoa( codes[c] < 0 ? -codes[c] : codes[c],
+					  tmp, 10 ) ;
+	    name = name + "_" + tmp ;
+	}
+	used.insert( name ) ;
+	append( ',' ) ;
+	append_field( name ) ;
+	if( c < jpars.size() )
+	    _jcols[codes[c]] = c ;
+	else
+	    _mcols[codes[c]] = c - jpars.size() ;
+    }
+    append( '\n' ) ;
+    _values.resize( mpars.size() ) ;
+    flush() ;
+}
+
+void
+CSVFormat::format( const CedarRawRecord &rec,
+                   const CedarRecordSelection &sel, int )
+{
+    // the fields shared by every row of the record are formatted once and
+    // kept in _prefix
+    _buf.swap( _prefix ) ;
+    _buf.erase() ;
+    append_int( rec.get_ordinal() ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	append( ',' ) ;
+	append_int( rec.get_word( cedar_prologue_words[p].word ) ) ;
+    }
+    vector<int> jvalues( _jcols.size(), CEDAR_RAW_MISSING ) ;
+    const vector<int> &jpar = sel.get_jpar() ;
+    size_t j = 0 ;
+    for( j = 0; j < jpar.size(); j++ )
+    {
+	jvalues[_jcols[rec.get_jpar_code( jpar[j] )]] =
+	    rec.get_jpar_value( jpar[j] ) ;
+    }
+    for( j = 0; j < jvalues.size(); j++ )
+    {
+	append( ',' ) ;
+	if( jvalues[j] != CEDAR_RAW_MISSING )
+	    append_int( jvalues[j] ) ;
+    }
+    _buf.swap( _prefix ) ;
+
+    const vector<int> &mpar = sel.get_mpar() ;
+    vector<size_t> cols( mpar.size() ) ;
+    size_t m = 0 ;
+    for( m = 0; m < mpar.size(); m++ )
+	cols[m] = _mcols[rec.get_mpar_code( mpar[m] )] ;
+
+    int nrows = rec.get_nrows() ;
+    for( int row = 0; row < nrows || ( row == 0 && nrows == 0 ); row++ )
+    {
+	if( nrows && !sel.is_row_selected( row ) )
+	    continue ;
+	_values.assign( _values.size(), CEDAR_RAW_MISSING ) ;
+	if( nrows )
+	{
+	    for( m = 0; m < mpar.size(); m++ )
+		_values[cols[m]] = rec.get_mpar_value( row, mpar[m] ) ;
+	}
+	append( _prefix ) ;
+	for( m = 0; m < _values.size(); m++ )
+	{
+	    append( ',' ) ;
+	    if( _values[m] != CEDAR_RAW_MISSING )
+		append_int( _values[m] ) ;
+	}
+	append( '\n' ) ;
+    }
+}
+
+/** @brief send the rows of the cedar file that satisfy the constraint as
+ * comma separated values
+ *
+ * The file is read twice, once to find the parameters of the records that
+ * satisfy the constraint so the header line can name every column, then
+ * again to write a line for each selected row.
+ */
+int cedar_read_csv( CedarCSV &csv, const string &filename,
+                    const string &query, string &error )
+{
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return 0 ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarRecordIndex index ;
+	index.build( files, qa ) ;
+	CSVFormat format( csv ) ;
+	format.add_header( index ) ;
+	index.replay( files, format ) ;
+    }
+    catch( CedarException &cedarex )
+    {
+	error = "The requested dataset produces the following exception " ;
+	error += cedarex.get_description() + (string)"\n" ;
+	return 0 ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return 0 ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return 0 ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception.\n" ;
+	return 0 ;
+    }
+
+    return 1 ;
+}
+
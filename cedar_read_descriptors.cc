@@ -46,6 +46,8 @@ using std::vector ;
 #include "UInt16.h"
 
 #include "cedar_read_descriptors.h"
+#include "CedarAggregate.h"
+#include "CedarScratch.h"
 
 #include "CedarException.h"
 #include "BESError.h"
@@ -71,33 +73,20 @@ bool cedar_read_descriptors( DDS &dds, const string &filename,
 
     try
     {
-	CedarFile file;
-	file.open_file (filename.c_str());
-	const CedarLogicalRecord* lr=file.get_first_logical_record();
-	if(lr)
+	// the records of an aggregate are merged in time order
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarAggregate merged( files, true ) ;
+	const CedarLogicalRecord *lr = 0 ;
+	const CedarRawRecord *rec = 0 ;
+	CedarScratch scratch ;
+	while( merged.next( lr, rec ) )
 	{
 	    if( lr->get_type() == 1 )
 	    {
-		load_dds( *(container.get()), (CedarDataRecord*)lr, qa, i ) ;
+		load_dds( *(container.get()), (CedarDataRecord*)lr, qa, i,
+			  scratch ) ;
 	    }
-	    while (!file.end_dataset())
-	    {
-		lr = file.get_next_logical_record();
-		if(lr) 
-		{
-		    if( lr->get_type() == 1 )
-		    {
-			load_dds( *(container.get()), (CedarDataRecord*)lr, qa, i ) ;
-		    }
-		}
-	    }
-	}
-	else
-	{
-	    error = "Can not connect to file-> " ;
-	    error += filename ;
-	    error += " .Non existent file or no a cbf file.\n" ;
-	    return false ;
 	}
     }
     catch (CedarException &cedarex)
@@ -151,15 +140,14 @@ void get_name_for_parameter(string &str, int par)
 }
   
 void load_dds( Structure &container, CedarDataRecord *my_data_record,
-	       CedarConstraintEvaluator &qa, int &i )
+	       CedarConstraintEvaluator &qa, int &i, CedarScratch &scratch )
 {
     if( qa.validate_record( my_data_record ) )
     {
 	i++;
-	char stuyo [5];
+	// room for any long, aggregated files number past 9999 records
+	char stuyo [32];
 	CedarStringConversions::ltoa(i,stuyo,10);
-	string record_name = "data_record_";
-	record_name+=stuyo;
 
 	// BEGIN HERE LOADING PROLOGUE
 	auto_ptr<Int16> pKINST (new Int16("KINST"));
@@ -199,22 +187,20 @@ void load_dds( Structure &container, CedarDataRecord *my_data_record,
 	// END HERE LOADING PROLOGUE
 
 	// BEGIN HERE LOADING JPAR SECTION
+	// the codes, values and names are loaded into the scratch buffers
+	// of the request rather than buffers allocated for each record
 	unsigned int jpar_value=my_data_record->get_jpar();
-	auto_ptr<vector<dods_int16> > pJparData(new vector<dods_int16>(jpar_value));
-	my_data_record->load_JPAR_data(*pJparData);
-	auto_ptr<vector<dods_int16> > pJparVars(new vector<dods_int16>(jpar_value));
-	my_data_record->load_JPAR_vars(*pJparVars);
+	scratch.load_jpar(*my_data_record);
 	auto_ptr<Structure>  pJPARstructure (new Structure ("JPAR"));
-	string JparVarName;
 	int is_JPAR_empty=1;
 	for (unsigned int w=0; w<jpar_value; w++)
 	{ 
-	    if (qa.validate_parameter((*pJparVars.get())[w]))
+	    if (qa.validate_parameter(scratch.jpar_codes[w]))
 	    {
 		is_JPAR_empty=0;
-		get_name_for_parameter(JparVarName,(*pJparVars.get())[w]);
-		auto_ptr<Int16> pjpardata (new Int16 (JparVarName));
-		pjpardata->set_value((*pJparData.get())[w]);
+		get_name_for_parameter(scratch.name,scratch.jpar_codes[w]);
+		auto_ptr<Int16> pjpardata (new Int16 (scratch.name));
+		pjpardata->set_value(scratch.jpar_values[w]);
 		pJPARstructure->add_var(pjpardata.get());
 	    }
 	}
@@ -227,34 +213,28 @@ void load_dds( Structure &container, CedarDataRecord *my_data_record,
 	int is_MPAR_empty=1;
 	if ((mpar_value>0) && (nrow_value>0))
 	{
-	    auto_ptr<vector<dods_int16> > pMparVars (new vector<dods_int16>(mpar_value));
-	    my_data_record->load_MPAR_vars(*pMparVars);
-	    auto_ptr<vector<dods_int16> > pMparData (new vector<dods_int16>(nrow_value*mpar_value));
-	    auto_ptr<vector<dods_int16> > pPartialMparData (new vector<dods_int16>(nrow_value));
-	    my_data_record->load_MPAR_data(*pMparData);
-	    string MparVarName;
+	    scratch.load_mpar(*my_data_record);
 	    for (int j=0; j<mpar_value;j++)
 	    {
-		if (qa.validate_parameter((*pMparVars.get())[j]))
+		if (qa.validate_parameter(scratch.mpar_codes[j]))
 		{
 		    is_MPAR_empty=0;
-		    get_name_for_parameter(MparVarName,(*pMparVars.get())[j]);
-		    BaseType *pMparvar = new Int16( MparVarName ); 
-		    auto_ptr<Array> pmpararray( new Array( MparVarName, pMparvar ) ) ;
+		    get_name_for_parameter(scratch.name,scratch.mpar_codes[j]);
+		    BaseType *pMparvar = new Int16( scratch.name ); 
+		    auto_ptr<Array> pmpararray( new Array( scratch.name, pMparvar ) ) ;
 		    delete pMparvar ; pMparvar = 0 ;
 		    pmpararray->append_dim(nrow_value);
-		    for (int w=0; w<nrow_value;w++)
-		    {
-			(*pPartialMparData)[w]=(*pMparData)[j+(w*mpar_value)];
-		    }
-		    pmpararray->set_value(*pPartialMparData,nrow_value);
+		    scratch.load_column(j);
+		    pmpararray->set_value(scratch.column,nrow_value);
 		    pMPARstructure -> add_var(pmpararray.get());
 		}
 	    }
 	}
 	// END HERE LOADING MPAR SECTION
 
-	auto_ptr<Structure> precord (new Structure(record_name));
+	scratch.name = "data_record_";
+	scratch.name += stuyo;
+	auto_ptr<Structure> precord (new Structure(scratch.name));
 	precord -> add_var (pPROLOGUEstructure.get());
 	if (!is_JPAR_empty)
 	    precord->add_var(pJPARstructure.get());
@@ -42,13 +42,15 @@ using namespace libdap ;
 
 class libdap::Structure ;
 class CedarConstraintEvaluator ;
+class CedarScratch ;
 
 bool cedar_read_descriptors( DDS &dds, const string &filename,
                              const string &name, const string &query,
 			     string &cedar_error ) ;
 
 void load_dds( Structure &, CedarDataRecord *my_data_record,
-	       CedarConstraintEvaluator &qa, int &index ) ;
+	       CedarConstraintEvaluator &qa, int &index,
+	       CedarScratch &scratch ) ;
 
 void get_name_for_parameter( string &str, int par ) ;
 
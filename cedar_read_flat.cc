@@ -30,306 +30,353 @@
 //      pwest       Patrick West <pwest@ucar.edu>
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
-#include <sstream>
-#include <memory>
+#include <iostream>
+#include <new>
+#include <stdlib.h>
 
-using std::ostringstream ;
-using std::auto_ptr ;
+using std::cerr ;
+using std::bad_alloc ;
+using std::endl ;
 
-#include "CedarBlock.h"
-#include "CedarFile.h"
 #include "CedarFlat.h"
 #include "cedar_read_flat.h"
 #include "CedarException.h"
-#include "CedarStringConversions.h"
 #include "CedarConstraintEvaluator.h"
-#include "cedar_read_descriptors.h"
-#include "CedarParameter.h"
 #include "CedarReadParcods.h"
+#include "CedarRawFile.h"
+#include "CedarRecordSelection.h"
+#include "CedarTextFormat.h"
+#include "CedarFlatSize.h"
+#include "CedarRawOutput.h"
+#include "CedarAggregate.h"
 #include "BESError.h"
+#include "BESSyntaxUserError.h"
+#include "BESDebug.h"
 
-// This is the size to right format string and pad them with blanks up to seven chars.
-#define PRINTING_BLOCK_SIZE 9 
+// mark of a record whose header lines end the block before it
+#define FLAT_MARK_CLOSE 2
 
-void print_blocked(ostringstream &oss, string s)
+/** @brief formats each record as a block of the flat product
+ *
+ * Each block has lines with the names, scales and units of the prologue
+ * and the selected parameters, a line with the parameter codes and a line
+ * for each selected row holding the prologue, the JPAR values and the
+ * MPAR values of the row, all in fixed width columns.
+ *
+ * In compact mode a block holds the rows of consecutive records laid out
+ * the same way, a new block is only started when the KINDAT or the
+ * selected parameters change.
+ *
+ * Given a byte range only the rows it covers are formatted. Every line of
+ * a block is as long as the others, so the position of each row is known
+ * without formatting the records before it, and the records after the
+ * range are not read at all.
+ *
+ * Without a range the records are formatted by a pool of workers copied
+ * from the product. A range is followed from one record to the next, so
+ * the records of a ranged product are formatted in turn.
+ */
+class FlatFormat : public CedarTextFormat
 {
-    int l=s.length();
-    if (l>PRINTING_BLOCK_SIZE)
+private:
+    bool		_open ;
+    bool		_ranged ;
+    unsigned long long	_first ;
+    unsigned long long	_last ;
+    unsigned long long	_pos ;
+    string		_prologue ;
+
+    void		header( const CedarRawRecord &rec,
+				const CedarRecordSelection &sel,
+				const string &prologue ) ;
+    bool		covers( unsigned long long bytes ) const ;
+    void		skip( unsigned long long bytes ) ;
+protected:
+    virtual void	format( const CedarRawRecord &rec,
+				const CedarRecordSelection &sel,
+				int mark ) ;
+public:
+    			FlatFormat( CedarFlat &cf, bool compact )
+			    : CedarTextFormat( cf, compact ),
+			      _open( false ),
+			      _ranged( false ),
+			      _first( 0 ),
+			      _last( 0 ),
+			      _pos( 0 ) {}
+    virtual		~FlatFormat() {}
+
+    void		set_range( unsigned long long first,
+				   unsigned long long last )
+			{
+			    _first = first ;
+			    _last = last ;
+			    _ranged = true ;
+			}
+
+    virtual void	read( const vector<string> &files,
+			      CedarConstraintEvaluator &qa ) ;
+    virtual CedarRecordReader *make_worker() const
+			{
+			    return _ranged ? 0 : new FlatFormat( *this ) ;
+			}
+    virtual int		mark_record( const CedarRawRecord &rec,
+				     const CedarRecordSelection &sel ) ;
+    virtual void	flush() ;
+    virtual bool	is_done() const { return _ranged && _pos > _last ; }
+} ;
+
+/** @brief the names, scales, units and codes lines that start a block
+ */
+void
+FlatFormat::header( const CedarRawRecord &rec,
+                    const CedarRecordSelection &sel,
+		    const string &prologue )
+{
+    const vector<int> &jpar = sel.get_jpar() ;
+    const vector<int> &mpar = sel.get_mpar() ;
+    size_t j = 0 ;
+    size_t m = 0 ;
+
+    append_blocked( "KINST" ) ;
+    append_blocked( "KINDAT" ) ;
+    append_blocked( "IBYRT" ) ;
+    append_blocked( "IBDTT" ) ;
+    append_blocked( "IBHMT" ) ;
+    append_blocked( "IBCST" ) ;
+    append_blocked( "IEYRT" ) ;
+    append_blocked( "IEDTT" ) ;
+    append_blocked( "IEHMT" ) ;
+    append_blocked( "IECST" ) ;
+    append_blocked( "NROWS" ) ;
+    for( j = 0; j < jpar.size(); j++ )
+	append_blocked( get_name( rec.get_jpar_code( jpar[j] ) ) ) ;
+    for( m = 0; m < mpar.size(); m++ )
+	append_blocked( get_name( rec.get_mpar_code( mpar[m] ) ) ) ;
+    append( '\n' ) ;
+
+    append_blocked( "N/A" ) ;
+    append_blocked( "N/A" ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1.E-02" ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1." ) ;
+    append_blocked( "1.E-02" ) ;
+    append_blocked( "1." ) ;
+    for( j = 0; j < jpar.size(); j++ )
     {
-	char errs[256] ;
-	sprintf( errs, "%s %d\n%s %s\n",
-	         "Trying to print block larger than",
-		 PRINTING_BLOCK_SIZE,
-		 "Current block is ", s.c_str() ) ;
-	throw CedarException( 0, errs ) ;
+	int code = abs( rec.get_jpar_code( jpar[j] ) ) ;
+	append_blocked( CedarReadParcods::Get_Scale( code ) ) ;
     }
-    for (int q=0; q<(PRINTING_BLOCK_SIZE-l); q++)
-	oss<<" ";
-    oss<<s<<flush;
-}
+    for( m = 0; m < mpar.size(); m++ )
+    {
+	int code = abs( rec.get_mpar_code( mpar[m] ) ) ;
+	append_blocked( CedarReadParcods::Get_Scale( code ) ) ;
+    }
+    append( '\n' ) ;
 
-void print_blocked(ostringstream &oss, long l)
-{
-    char temp[100];
-    CedarStringConversions::ltoa(l,temp, 10);
-    string s(temp);
-    int len=s.length();
-    if (len>PRINTING_BLOCK_SIZE)
+    append_blocked( "N/A" ) ;
+    append_blocked( "N/A" ) ;
+    append_blocked( "yr" ) ;
+    append_blocked( "mmdd" ) ;
+    append_blocked( "hhmm" ) ;
+    append_blocked( "s" ) ;
+    append_blocked( "yr" ) ;
+    append_blocked( "mmdd" ) ;
+    append_blocked( "hhmm" ) ;
+    append_blocked( "s" ) ;
+    append_blocked( " " ) ;
+    for( j = 0; j < jpar.size(); j++ )
+    {
+	int code = abs( rec.get_jpar_code( jpar[j] ) ) ;
+	append_blocked( CedarReadParcods::Get_Unit_Label( code ) ) ;
+    }
+    for( m = 0; m < mpar.size(); m++ )
     {
-	char errs[256] ;
-	sprintf( errs, "%s %d\n%s %s\n",
-	         "Trying to print block larger than",
-		 PRINTING_BLOCK_SIZE,
-		 "Current block is ", s.c_str() ) ;
-	throw CedarException( 0, errs ) ;
+	int code = abs( rec.get_mpar_code( mpar[m] ) ) ;
+	append_blocked( CedarReadParcods::Get_Unit_Label( code ) ) ;
     }
-    for (int q=0; q<(PRINTING_BLOCK_SIZE-len); q++)
-	oss<<" ";
-    oss<<s<<flush;
+    append( '\n' ) ;
+
+    append( prologue ) ;
+    for( j = 0; j < jpar.size(); j++ )
+	append_blocked( rec.get_jpar_code( jpar[j] ) ) ;
+    for( m = 0; m < mpar.size(); m++ )
+	append_blocked( rec.get_mpar_code( mpar[m] ) ) ;
+    append( '\n' ) ;
 }
-      
-void send_flat_data(CedarFlat &cf, CedarDataRecord &dr,CedarConstraintEvaluator &qa)
+
+/** @brief true if the next bytes of the product fall within the range
+ */
+bool
+FlatFormat::covers( unsigned long long bytes ) const
 {
-    if (qa.validate_record(dr))
+    if( !_ranged )
+	return true ;
+    unsigned long long start = _pos + _buf.length() ;
+    return start + bytes > _first && start <= _last ;
+}
+
+/** @brief add what has been formatted so far, then move past bytes of
+ * the product that are not formatted
+ */
+void
+FlatFormat::skip( unsigned long long bytes )
+{
+    flush() ;
+    _pos += bytes ;
+}
+
+/** @brief add the part of what has been formatted that falls within the
+ * range to the response
+ */
+void
+FlatFormat::flush()
+{
+    if( _ranged && !_buf.empty() )
     {
-	ostringstream oss;
-	unsigned int w = 0 ;
-	int y,z = 0 ;
-	CedarDate bdate,edate;
-	dr.get_record_begin_date(bdate);
-	dr.get_record_end_date(edate);
-	print_blocked(oss, "KINST");
-	print_blocked(oss, "KINDAT");
-	print_blocked(oss, "IBYRT");
-	print_blocked(oss, "IBDTT");
-	print_blocked(oss, "IBHMT");
-	print_blocked(oss, "IBCST");
-	print_blocked(oss, "IEYRT");
-	print_blocked(oss, "IEDTT");
-	print_blocked(oss, "IEHMT");
-	print_blocked(oss, "IECST");
-	print_blocked(oss, "NROWS");
-
-	unsigned int jpar_value=dr.get_jpar();
-	auto_ptr<vector<short int> > pJparVars( new vector<short int>(jpar_value) ) ;
-	if( !pJparVars.get() )
+	unsigned long long start = _pos ;
+	_pos += _buf.length() ;
+	if( _pos <= _first || start > _last )
 	{
-	    throw bad_alloc() ;
+	    _buf.erase() ;
+	    return ;
 	}
-	dr.load_JPAR_vars(*pJparVars);
+	if( _pos - 1 > _last )
+	    _buf.erase( _last - start + 1 ) ;
+	if( start < _first )
+	    _buf.erase( 0, _first - start ) ;
+    }
+    CedarTextFormat::flush() ;
+}
 
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    string JparVarName="";
-	    string the_var="";
-	    if (qa.validate_parameter((*pJparVars)[w]))
-	    {
-		int val;
-		if ((*pJparVars)[w]<0)
-		{
-		    val=(*pJparVars)[w]*-1;
-		    the_var+="e_";
-		}
-		else
-		{
-		    val=(*pJparVars)[w];
-		}
-		get_name_for_parameter(JparVarName,val);
-		the_var+=JparVarName;
-		print_blocked(oss, the_var);
-	    }
-	}
+/** @brief format the records, then end the last block of a compact
+ * product
+ */
+void
+FlatFormat::read( const vector<string> &files,
+                  CedarConstraintEvaluator &qa )
+{
+    CedarTextFormat::read( files, qa ) ;
+    if( _open )
+    {
+	append( "\n\n" ) ;
+	flush() ;
+    }
+}
 
-	int mpar_value=dr.get_mpar();
-	auto_ptr<vector<short int> > pMparVars ;
-	if (mpar_value > 0 )
-	{
-	    pMparVars.reset( new vector<short int>(mpar_value) ) ;
-	    dr.load_MPAR_vars(*pMparVars);
-	    for (y=0; y<mpar_value;y++)
-	    {
-		string MparVarName="";
-		string the_var="";
-		if (qa.validate_parameter((*pMparVars)[y]))
-		{
-		    int val;
-		    if ((*pMparVars)[y]<0)
-		    {
-			val=(*pMparVars)[y]*-1;
-			the_var+="e_";
-		    }
-		    else
-		    {
-			val=(*pMparVars)[y];
-		    }
-		    get_name_for_parameter(MparVarName,val);
-		    the_var+=MparVarName;
-		    print_blocked(oss, the_var);
-		}
-	    }
-	}
-	else if(mpar_value < 0 )
-	{
-	    cerr<<__FILE__<<":"<<__LINE__<<": found a negative MPAR value."<<endl;
-	    throw CedarException(0,"negative MPAR value");
-	}
-	oss<<endl;
-
-	print_blocked(oss, "N/A");
-	print_blocked(oss, "N/A");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.E-02");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.");
-	print_blocked(oss, "1.E-02");
-	print_blocked(oss, "1.");
-
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    if (qa.validate_parameter(abs((*pJparVars)[w])))
-	    {
-		string element =
-		(string)CedarReadParcods::Get_Scale((*pJparVars)[w]);// + string(" ") + (string) CedarReadParcods::Get_Unit_Label(pJparVars[w]);
-		print_blocked(oss, element);
-	    }
-	}
-	for (y=0; y<mpar_value; y++)
-	{ 
-	    if (qa.validate_parameter((*pMparVars)[y]))
-	    {
-		string element =
-		(string)CedarReadParcods::Get_Scale(abs((*pMparVars)[y]));// + string(" ") + (string) CedarReadParcods::Get_Unit_Label(pMparVars[y]);
-		print_blocked(oss, element);
-	    }
-	}
-	oss<<endl;
-
-	print_blocked(oss, "N/A");
-	print_blocked(oss, "N/A");
-	print_blocked(oss, "yr");
-	print_blocked(oss, "mmdd");
-	print_blocked(oss, "hhmm");
-	print_blocked(oss, "s");
-	print_blocked(oss, "yr");
-	print_blocked(oss, "mmdd");
-	print_blocked(oss, "hhmm");
-	print_blocked(oss, "s");
-	print_blocked(oss, " ");
-
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    if (qa.validate_parameter((*pJparVars)[w]))
-	    {
-		string element = (string) CedarReadParcods::Get_Unit_Label(abs((*pJparVars)[w]));
-		print_blocked(oss, element);
-	    }
-	}
-	for (y=0; y<mpar_value; y++)
-	{ 
-	    if (qa.validate_parameter((*pMparVars)[y]))
-	    {
-		string element = (string) CedarReadParcods::Get_Unit_Label(abs((*pMparVars)[y]));
-		print_blocked(oss, element);
-	    }
-	}
-	oss<<endl;
-
-	print_blocked(oss, dr.get_record_kind_instrument());
-	print_blocked(oss, dr.get_record_kind_data());
-	print_blocked(oss, bdate.get_year());
-	print_blocked(oss, bdate.get_month_day());
-	print_blocked(oss, bdate.get_hour_min());
-	print_blocked(oss, bdate.get_second_centisecond());
-	print_blocked(oss, edate.get_year());
-	print_blocked(oss, edate.get_month_day());
-	print_blocked(oss, edate.get_hour_min());
-	print_blocked(oss, edate.get_second_centisecond());
-	print_blocked(oss, dr.get_nrows());
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    if (qa.validate_parameter((*pJparVars)[w]))
-		print_blocked(oss, (*pJparVars)[w]);
-	}
-	for (y=0; y<mpar_value;y++)
-	{
-	    if (qa.validate_parameter((*pMparVars)[y]))
-		print_blocked(oss, (*pMparVars)[y]);
-	}
-	oss<<endl;
+/** @brief the header lines start every record, or in compact mode a
+ * record laid out differently from the one before, ending the block that
+ * was open
+ */
+int
+FlatFormat::mark_record( const CedarRawRecord &rec,
+                         const CedarRecordSelection &sel )
+{
+    if( is_compact() && !schema_changed( rec, sel ) )
+	return 0 ;
+    int mark = CEDAR_MARK_HEAD ;
+    if( _open )
+	mark |= FLAT_MARK_CLOSE ;
+    _open = is_compact() ;
+    return mark ;
+}
 
-	int nrow_value=dr.get_nrows();
+void
+FlatFormat::format( const CedarRawRecord &rec,
+                    const CedarRecordSelection &sel, int mark )
+{
+    const vector<int> &jpar = sel.get_jpar() ;
+    const vector<int> &mpar = sel.get_mpar() ;
+    size_t j = 0 ;
+    size_t m = 0 ;
 
-	auto_ptr<vector<short int> > pJparData( new vector<short int>(jpar_value) ) ;
-	if (!pJparData.get())
-	{
-	    throw bad_alloc();
-	}
-	dr.load_JPAR_data(*pJparData);
-	auto_ptr<vector<short int> > pMparData( new vector<short int>(nrow_value*mpar_value) ) ;
-	if (!pMparData.get())
-	{
-	    throw bad_alloc();
-	}
-	dr.load_MPAR_data(*pMparData);
+    bool head = ( mark & CEDAR_MARK_HEAD ) ;
+    unsigned long long line = CedarFlatSize::line_bytes( sel ) ;
 
-	CedarParameter pp ;
-	for (int o=0; o<nrow_value; o++)
+    // a record that ends before the range is only counted
+    if( _ranged )
+    {
+	unsigned long long bytes = sel.get_selected_rows() * line ;
+	if( head )
+	    bytes += 4 * line + ( mark & FLAT_MARK_CLOSE ? 2 : 0 ) ;
+	if( !is_compact() )
+	    bytes += 2 ;
+	if( _pos + bytes <= _first )
 	{
-	    bool print_row = true ;
-	    if( qa.got_parameter_constraint() )
-	    {
-		for( z = 0; z < mpar_value; z++ )
-		{
-		    if( qa.validate_parameter( (*pMparVars)[z] ) )
-		    {
-			pp = qa.get_parameter( (*pMparVars)[z] ) ;
-			if( !pp.validateValue( (*pMparData)[z+(o*mpar_value)] ) )
-			{
-			    print_row = false ;
-			}
-		    }
-		}
-	    }
-	    if( print_row )
-	    {
-		print_blocked(oss, dr.get_record_kind_instrument());
-		print_blocked(oss, dr.get_record_kind_data());
-		print_blocked(oss, bdate.get_year());
-		print_blocked(oss, bdate.get_month_day());
-		print_blocked(oss, bdate.get_hour_min());
-		print_blocked(oss, bdate.get_second_centisecond());
-		print_blocked(oss, edate.get_year());
-		print_blocked(oss, edate.get_month_day());
-		print_blocked(oss, edate.get_hour_min());
-		print_blocked(oss, edate.get_second_centisecond());
-		print_blocked(oss, dr.get_nrows());
-		for (w=0; w<jpar_value; w++)
-		{ 
-		    if (qa.validate_parameter((*pJparVars)[w]))
-			print_blocked(oss, (*pJparData)[w]);
-		}
-		for (y=0; y<mpar_value;y++)
-		{
-		    if (qa.validate_parameter((*pMparVars)[y]))
-			print_blocked(oss, (*pMparData)[y+(o*mpar_value)]);
-		}
-		oss<<endl;
-	    }
+	    skip( bytes ) ;
+	    return ;
 	}
+    }
 
-	oss<<'\n'<<endl;
+    // the prologue, which starts the code line and every row, is built in
+    // a buffer kept from one record to the next
+    _prologue.erase() ;
+    _prologue.swap( _buf ) ;
+    for( int w = CEDAR_RAW_KINST; w <= CEDAR_RAW_IECST; w++ )
+	append_blocked( rec.get_word( w ) ) ;
+    append_blocked( rec.get_nrows() ) ;
+    _prologue.swap( _buf ) ;
 
-	//oss<<'\0'<<"kaka";
-	cf.add_data(oss.str());
+    if( head )
+    {
+	if( mark & FLAT_MARK_CLOSE )
+	    append( "\n\n" ) ;
+	header( rec, sel, _prologue ) ;
     }
+
+    // and with the JPAR values every row
+    _prologue.swap( _buf ) ;
+    for( j = 0; j < jpar.size(); j++ )
+	append_blocked( rec.get_jpar_value( jpar[j] ) ) ;
+    _prologue.swap( _buf ) ;
+
+    int nrows = rec.get_nrows() ;
+    for( int row = 0; row < nrows; row++ )
+    {
+	if( !sel.is_row_selected( row ) )
+	    continue ;
+	if( !covers( line ) )
+	{
+	    skip( line ) ;
+	    continue ;
+	}
+	append( _prologue ) ;
+	for( m = 0; m < mpar.size(); m++ )
+	    append_blocked( rec.get_mpar_value( row, mpar[m] ) ) ;
+	append( '\n' ) ;
+    }
+
+    if( !is_compact() )
+	append( "\n\n" ) ;
 }
 
+/** @brief format the records of the cedar file that satisfy the
+ * constraint as the flat product
+ *
+ * @param cf the response to add the product to
+ * @param filename the cedar file
+ * @param query the constraint, may be empty
+ * @param range byte range of the form bytes=first-last, bytes=first- or
+ * bytes=-suffix, may be empty
+ * @param compact true to write the header lines only when the layout of
+ * the records changes
+ * @param error set if there is a problem
+ * @return 1 if successful, 0 otherwise
+ */
 int cedar_read_flat( CedarFlat &cf, const string &filename,
-                     const string &query, string &error )
+                     const string &query, const string &range,
+		     bool compact, string &error )
 {
+    CedarByteRange br ;
+    if( !range.empty() && !br.parse( range ) )
+    {
+	BESDEBUG( "cedar", "cedar_read_flat - ignoring range "
+			   << range << endl ) ;
+    }
+
     CedarConstraintEvaluator qa;
     try
     {
@@ -342,37 +389,37 @@ int cedar_read_flat( CedarFlat &cf, const string &filename,
 	return 0;
     }
 
-    CedarFile file;
     try
     {
-	file.open_file (filename.c_str());
-	const CedarLogicalRecord *lr =file.get_first_logical_record();
-
-	if(lr)
+	// the size of the product is found first so that it can be sent
+	// ahead of the product and a range resolved against it
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	FlatFormat flat( cf, compact ) ;
+	if( cf.is_http() || br.is_set() )
 	{
-	    if((lr->get_type()==1))
-	    {
-		send_flat_data(cf, *(CedarDataRecord*)lr,qa);
-	    }
-	    while (!file.end_dataset())
+	    CedarFlatSize size( compact ) ;
+	    size.read( files, qa ) ;
+	    unsigned long long total = size.get_bytes() ;
+	    if( br.is_set() )
 	    {
-		lr=file.get_next_logical_record();
-		if(lr)
+		unsigned long long first = 0 ;
+		unsigned long long last = 0 ;
+		if( !br.resolve( total, first, last ) )
 		{
-		    if((lr->get_type()==1))
-		    {
-			send_flat_data(cf, *(CedarDataRecord*)lr,qa);
-		    }
+		    string err = "The requested range can not be "
+				 "satisfied for file " + filename ;
+		    throw BESSyntaxUserError( err, __FILE__, __LINE__ ) ;
 		}
+		flat.set_range( first, last ) ;
+		cf.set_range( first, last, total ) ;
+	    }
+	    else
+	    {
+		cf.set_length( total ) ;
 	    }
 	}
-	else 
-	{
-	    error = (string)"Failure reading data from file "
-		    + filename
-		    + ", corrupted file or not a cbf file.\n" ;
-	    return false;
-	}
+	flat.read( files, qa ) ;
     }
     catch (CedarException &cedarex)
     {
@@ -380,13 +427,17 @@ int cedar_read_flat( CedarFlat &cf, const string &filename,
 	error+=cedarex.get_description() + (string)"\n";
 	return 0;
     }
+    catch( BESSyntaxUserError & )
+    {
+	throw ;
+    }
     catch( BESError &beserr )
     {
 	error = "The requested dataset produces the following exception: " ;
 	error += beserr.get_message() + (string)"\n" ;
 	return false ;
     }
-    catch (bad_alloc::bad_alloc)
+    catch (bad_alloc &)
     {
 	error="There has been a memory allocation error.\n";
 	return 0;
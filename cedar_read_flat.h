@@ -39,7 +39,8 @@ class CedarFlat ;
 using std::string ;
 
 int cedar_read_flat( CedarFlat &cf, const string &filename,
-                     const string &query, string &error ) ;
+                     const string &query, const string &range,
+		     bool compact, string &error ) ;
 
 #endif // cedar_read_flat_h_
 
@@ -31,60 +31,52 @@
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
 #include <string>
-#include <sstream>
+#include <vector>
 
 using std::string ;
-using std::ostringstream ;
+using std::vector ;
 using std::bad_alloc ;
 
 #include "CedarBlock.h"
 #include "CedarFile.h"
+#include "CedarInputFile.h"
 #include "CedarVersion.h"
 #include "CedarErrorHandler.h"
 #include "cedar_read_info.h"
+#include "CedarAggregate.h"
 #include "CedarException.h"
 #include "CedarConstraintEvaluator.h"
+#include "CedarScratch.h"
 #include "BESError.h"
 
+/** @brief add the text of a catalog or header record to the response
+ *
+ * The text is saved into the scratch text of the request, which keeps its
+ * capacity from one record to the next.
+ */
 void
-route_buffer( const CedarLogicalRecord *pLogRec, BESInfo &info )
+route_buffer( const CedarLogicalRecord *pLogRec, BESInfo &info,
+              CedarScratch &scratch )
 {
-    ostringstream *oss = new ostringstream() ;
-    switch( pLogRec->get_type() )
-    {
-	case 2:
-	    (*oss) << "\n" ;
-	    pLogRec->save_prologue_header( oss->rdbuf() ) ;
-	    pLogRec->save_prologue( oss->rdbuf() ) ;
-	    pLogRec->save_data_buffer( oss->rdbuf() ) ;
-	    break;
-	case 3:
-	    (*oss) << "\n" ;
-	    pLogRec->save_prologue_header( oss->rdbuf() ) ;
-	    pLogRec->save_prologue( oss->rdbuf() ) ;
-	    pLogRec->save_data_buffer( oss->rdbuf() ) ;
-	    break ;
-    }
-    //(*oss) << '\0' ;
-    info.add_data( oss->str() ) ;
-    delete oss ;
+    scratch.save_text( *pLogRec ) ;
+    info.add_data( scratch.text ) ;
 }
 
 inline void
 deal_with_record( CedarBlock &block,
                   CedarConstraintEvaluator &qa,
-		  BESInfo &info )
+		  BESInfo &info, CedarScratch &scratch )
 {
     const CedarLogicalRecord *pLogRec = block.get_first_record() ;
     if( pLogRec )
     {
 	if( qa.validate_record( pLogRec ) )
-	route_buffer( pLogRec, info ) ;
+	route_buffer( pLogRec, info, scratch ) ;
 	pLogRec = block.get_next_record() ;
 	while( pLogRec )
 	{
 	    if( qa.validate_record( pLogRec ) )
-		route_buffer( pLogRec, info ) ;
+		route_buffer( pLogRec, info, scratch ) ;
 	    pLogRec = block.get_next_record() ;
 	}
     }
@@ -105,33 +97,42 @@ cedar_read_info( BESInfo &info, const string &filename,
 	return false ;
     }
 
-    CedarFile file ;
     try
     {
 	info.add_data( "CATALOG AND HEADER RECORD CORRESPONDING TO: " ) ;
 	info.add_data( name ) ;
 	info.add_data( "\n" ) ;
-	file.open_file( filename.c_str() ) ;
-	const CedarLogicalRecord *lr = file.get_first_logical_record() ;
 
-	if( lr )
+	// the records of every file of an aggregate, one file after another
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarScratch scratch ;
+	for( size_t f = 0; f < files.size(); f++ )
 	{
-	    if( qa.validate_record( lr ) )
-		route_buffer( lr, info ) ;
-	    while( !file.end_dataset() )
+	    CedarPlainFile plain( files[f] ) ;
+	    CedarFile file ;
+	    file.open_file( plain.get_path().c_str() ) ;
+	    const CedarLogicalRecord *lr = file.get_first_logical_record() ;
+
+	    if( lr )
 	    {
-		lr = file.get_next_logical_record() ;
-		if( lr )
-		    if( qa.validate_record( lr ) )
-			route_buffer( lr, info ) ;
+		if( qa.validate_record( lr ) )
+		    route_buffer( lr, info, scratch ) ;
+		while( !file.end_dataset() )
+		{
+		    lr = file.get_next_logical_record() ;
+		    if( lr )
+			if( qa.validate_record( lr ) )
+			    route_buffer( lr, info, scratch ) ;
+		}
+	    }
+	    else 
+	    {
+		error = (string)"Failure reading data from file "
+			+ files[f]
+			+ ", corrupted file or not a cbf file.\n" ;
+		return false ;
 	    }
-	}
-	else 
-	{
-	    error = (string)"Failure reading data from file "
-		    + filename
-		    + ", corrupted file or not a cbf file.\n" ;
-	    return false ;
 	}
     }
     catch( CedarException &ex )
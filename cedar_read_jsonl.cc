@@ -0,0 +1,257 @@
+// cedar_read_jsonl.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <new>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::set ;
+using std::bad_alloc ;
+
+#include "CedarJSONL.h"
+#include "cedar_read_jsonl.h"
+#include "CedarException.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarStringConversions.h"
+#include "CedarRawFile.h"
+#include "CedarRecordIndex.h"
+#include "CedarTextFormat.h"
+#include "CedarAggregate.h"
+#include "BESError.h"
+
+/** @brief formats a JSON object on a line of its own for each selected row
+ * of the records it is given
+ *
+ * Each object holds the record number, the prologue, the selected JPARs of
+ * the record and the selected MPARs of the row, keyed by name. Missing
+ * values are null. A record without rows gives a single object without
+ * MPARs.
+ */
+class JSONLFormat : public CedarTextFormat
+{
+private:
+    map<int,string>		_jpar_keys ;
+    map<int,string>		_mpar_keys ;
+    set<string>			_used ;
+    string			_prefix ;
+
+    const string &		get_key( map<int,string> &keys, int code ) ;
+    void			append_value( int v ) ;
+protected:
+    virtual void		format( const CedarRawRecord &rec,
+					const CedarRecordSelection &sel,
+					int mark ) ;
+public:
+    				JSONLFormat( CedarJSONL &jsonl ) ;
+    virtual			~JSONLFormat() {}
+
+    static string		quote( const string &s ) ;
+} ;
+
+JSONLFormat::JSONLFormat( CedarJSONL &jsonl )
+    : CedarTextFormat( jsonl )
+{
+    _used.insert( "record" ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+	_used.insert( cedar_prologue_words[p].name ) ;
+}
+
+/** @brief s as a JSON string, quoted and escaped
+ */
+string
+JSONLFormat::quote( const string &s )
+{
+    static const char *hex = "0123456789abcdef" ;
+    string q = "\"" ;
+    for( string::size_type i = 0; i < s.length(); i++ )
+    {
+	unsigned char c = s[i] ;
+	if( c == '"' || c == '\\' )
+	{
+	    q += '\\' ;
+	    q += c ;
+	}
+	else if( c < 0x20 )
+	{
+	    q += "\\u00" ;
+	    q += hex[c >> 4] ;
+	    q += hex[c & 0xF] ;
+	}
+	else
+	{
+	    q += c ;
+	}
+    }
+    q += '"' ;
+    return q ;
+}
+
+/** @brief the quoted name of a parameter followed by the colon, formatted
+ * once per code
+ *
+ * The JPARs and the MPARs each have keys of their own, as a record may
+ * carry the same code as both. A parameter whose name has already been
+ * used, by another code or by the same code as the other kind of
+ * parameter, is given its code as a suffix, as a csv column is, so no
+ * object has the same key twice.
+ *
+ * @param keys the keys of the JPARs or of the MPARs
+ */
+const string &
+JSONLFormat::get_key( map<int,string> &keys, int code )
+{
+    map<int,string>::iterator i = keys.find( code ) ;
+    if( i == keys.end() )
+    {
+	string name = get_name( code ) ;
+	if( _used.find( name ) != _used.end() )
+	{
+	    char tmp[100] ;
+	    CedarStringConversions::ltoa( code < 0 ? -code : code, tmp, 10 ) ;
+	    name = name + "_" + tmp ;
+	}
+	_used.insert( name ) ;
+	string key = "," + quote( name ) + ":" ;
+	i = keys.insert( make_pair( code, key ) ).first ;
+    }
+    return i->second ;
+}
+
+void
+JSONLFormat::append_value( int v )
+{
+    if( v == CEDAR_RAW_MISSING )
+	append( "null" ) ;
+    else
+	append_int( v ) ;
+}
+
+void
+JSONLFormat::format( const CedarRawRecord &rec,
+                     const CedarRecordSelection &sel, int )
+{
+    // the members shared by every row of the record are formatted once
+    // and kept in _prefix
+    _buf.swap( _prefix ) ;
+    _buf.erase() ;
+    append( "{\"record\":" ) ;
+    append_int( rec.get_ordinal() ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	append( ",\"" ) ;
+	append( cedar_prologue_words[p].name ) ;
+	append( "\":" ) ;
+	append_int( rec.get_word( cedar_prologue_words[p].word ) ) ;
+    }
+    const vector<int> &jpar = sel.get_jpar() ;
+    for( size_t j = 0; j < jpar.size(); j++ )
+    {
+	append( get_key( _jpar_keys, rec.get_jpar_code( jpar[j] ) ) ) ;
+	append_value( rec.get_jpar_value( jpar[j] ) ) ;
+    }
+    _buf.swap( _prefix ) ;
+
+    int nrows = rec.get_nrows() ;
+    if( nrows == 0 )
+    {
+	append( _prefix ) ;
+	append( "}\n" ) ;
+    }
+    const vector<int> &mpar = sel.get_mpar() ;
+    vector<const string *> keys( mpar.size() ) ;
+    size_t m = 0 ;
+    for( m = 0; m < mpar.size(); m++ )
+	keys[m] = &get_key( _mpar_keys, rec.get_mpar_code( mpar[m] ) ) ;
+    for( int row = 0; row < nrows; row++ )
+    {
+	if( !sel.is_row_selected( row ) )
+	    continue ;
+	append( _prefix ) ;
+	for( m = 0; m < mpar.size(); m++ )
+	{
+	    append( *keys[m] ) ;
+	    append_value( rec.get_mpar_value( row, mpar[m] ) ) ;
+	}
+	append( "}\n" ) ;
+    }
+}
+
+/** @brief send the rows of the cedar file that satisfy the constraint as
+ * JSON lines, one self describing object per row
+ */
+int cedar_read_jsonl( CedarJSONL &jsonl, const string &filename,
+                      const string &query, string &error )
+{
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return 0 ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	JSONLFormat format( jsonl ) ;
+	format.read( files, qa ) ;
+    }
+    catch( CedarException &cedarex )
+    {
+	error = "The requested dataset produces the following exception " ;
+	error += cedarex.get_description() + (string)"\n" ;
+	return 0 ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return 0 ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return 0 ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception.\n" ;
+	return 0 ;
+    }
+
+    return 1 ;
+}
+
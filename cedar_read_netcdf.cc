@@ -0,0 +1,274 @@
+// cedar_read_netcdf.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <new>
+#include <stdlib.h>
+
+using std::string ;
+using std::vector ;
+using std::map ;
+using std::endl ;
+using std::bad_alloc ;
+
+#include "cedar_read_netcdf.h"
+#include "CedarConstraintEvaluator.h"
+#include "CedarException.h"
+#include "CedarStringConversions.h"
+#include "CedarReadParcods.h"
+#include "CedarRawFile.h"
+#include "CedarRawOutput.h"
+#include "CedarRecordIndex.h"
+#include "CedarAggregate.h"
+#include "CedarNetCDFWriter.h"
+#include "BESInternalError.h"
+#include "BESDebug.h"
+
+/** @brief the name of the variable for parameter code, unique within
+ * the file
+ */
+static string
+netcdf_name( CedarNetCDFWriter &writer, int code )
+{
+    string name = CedarRecordIndex::get_column_name( code ) ;
+    if( writer.has_variable( name ) )
+    {
+	char tmp[100] ;
+	CedarStringConversions::ltoa( code < 0 ? -code : code, tmp, 10 ) ;
+	name = name + "_" + tmp ;
+    }
+    return name ;
+}
+
+/** @brief add the variable for a parameter code along with its
+ * attributes from the parameter code table
+ */
+static int
+add_parameter( CedarNetCDFWriter &writer, int code )
+{
+    int var = writer.add_variable( netcdf_name( writer, code ),
+				   CEDAR_NC_SHORT ) ;
+    int par = code < 0 ? -code : code ;
+    writer.add_attribute( var, "code", (short)code ) ;
+    string long_name = CedarReadParcods::Get_Longname( par ) ;
+    if( code < 0 )
+	long_name = "error in " + long_name ;
+    writer.add_attribute( var, "long_name", long_name ) ;
+    string units = CedarReadParcods::Get_Unit_Label( par ) ;
+    if( !units.empty() )
+	writer.add_attribute( var, "units", units ) ;
+    string scale = CedarReadParcods::Get_Scale( par ) ;
+    if( !scale.empty() )
+    {
+	char *end = 0 ;
+	double factor = strtod( scale.c_str(), &end ) ;
+	if( end && *end == '\0' && factor != 0.0 && factor != 1.0 )
+	    writer.add_attribute( var, "scale_factor", factor ) ;
+    }
+    writer.add_attribute( var, "_FillValue", (short)CEDAR_RAW_MISSING ) ;
+    return var ;
+}
+
+/** @brief writes a netcdf record for each selected row of the records
+ * it is given
+ */
+class NetCDFRows : public CedarRecordReader
+{
+private:
+    CedarNetCDFWriter &		_writer ;
+    int				_record_var ;
+    vector<int>			_prologue ;
+    map<int,int>		_jvars ;
+    map<int,int>		_mvars ;
+public:
+    				NetCDFRows( CedarNetCDFWriter &writer )
+				    : _writer( writer ),
+				      _record_var( -1 ) {}
+    virtual			~NetCDFRows() {}
+
+    virtual void		add_variables( const CedarRecordIndex &index ) ;
+    virtual void		data_record( const CedarRawRecord &rec,
+					     const CedarRecordSelection &sel ) ;
+} ;
+
+/** @brief add the variables for the record number, the prologue and the
+ * parameters of the indexed records
+ */
+void
+NetCDFRows::add_variables( const CedarRecordIndex &index )
+{
+    _record_var = _writer.add_variable( "record", CEDAR_NC_INT ) ;
+    _writer.add_attribute( _record_var, "long_name",
+			   (string)"logical record number" ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	int var = _writer.add_variable( cedar_prologue_words[p].name,
+					CEDAR_NC_SHORT ) ;
+	if( cedar_prologue_words[p].units[0] != '\0' )
+	{
+	    _writer.add_attribute( var, "units",
+				   (string)cedar_prologue_words[p].units ) ;
+	}
+	if( cedar_prologue_words[p].centi )
+	    _writer.add_attribute( var, "scale_factor", 0.01 ) ;
+	_prologue.push_back( var ) ;
+    }
+    const vector<int> &jpars = index.get_jpars() ;
+    for( size_t j = 0; j < jpars.size(); j++ )
+	_jvars[jpars[j]] = add_parameter( _writer, jpars[j] ) ;
+    const vector<int> &mpars = index.get_mpars() ;
+    for( size_t m = 0; m < mpars.size(); m++ )
+	_mvars[mpars[m]] = add_parameter( _writer, mpars[m] ) ;
+}
+
+void
+NetCDFRows::data_record( const CedarRawRecord &rec,
+                         const CedarRecordSelection &sel )
+{
+    _writer.clear_record() ;
+    _writer.set_value( _record_var, (int)rec.get_ordinal() ) ;
+    for( size_t p = 0; p < CEDAR_PROLOGUE_WORDS; p++ )
+    {
+	_writer.set_value( _prologue[p],
+			   rec.get_word( cedar_prologue_words[p].word ) ) ;
+    }
+    const vector<int> &jpar = sel.get_jpar() ;
+    for( size_t j = 0; j < jpar.size(); j++ )
+    {
+	_writer.set_value( _jvars[rec.get_jpar_code( jpar[j] )],
+			   rec.get_jpar_value( jpar[j] ) ) ;
+    }
+
+    int nrows = rec.get_nrows() ;
+    if( nrows == 0 )
+    {
+	_writer.write_record() ;
+    }
+    const vector<int> &mpar = sel.get_mpar() ;
+    vector<int> vars( mpar.size() ) ;
+    for( size_t m = 0; m < mpar.size(); m++ )
+    {
+	vars[m] = _mvars[rec.get_mpar_code( mpar[m] )] ;
+    }
+    for( int row = 0; row < nrows; row++ )
+    {
+	if( !sel.is_row_selected( row ) )
+	    continue ;
+	for( size_t m = 0; m < mpar.size(); m++ )
+	{
+	    _writer.set_value( vars[m], rec.get_mpar_value( row, mpar[m] ) ) ;
+	}
+	_writer.write_record() ;
+    }
+}
+
+/** @brief send the rows of the cedar file that satisfy the constraint as
+ * a netcdf file
+ *
+ * Every row of every selected data record becomes a record along the
+ * unlimited row dimension, with a variable for the record number, the
+ * prologue and each of the parameters. The file is indexed first, so the
+ * header can be written with the number of rows and the data streamed
+ * after it without a temporary file.
+ *
+ * @param strm stream to write the netcdf file to
+ * @param is_http true if the response is sent over HTTP
+ * @param filename the cedar file
+ * @param name name of the dataset, used to name the netcdf file
+ * @param query the constraint, may be empty
+ * @param error set if there is a problem writing the file
+ * @return true if successful, false otherwise
+ */
+bool
+cedar_read_netcdf( ostream &strm, bool is_http, const string &filename,
+                   const string &name, const string &query, string &error )
+{
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return false ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarRecordIndex index ;
+	index.build( files, qa ) ;
+	BESDEBUG( "cedar", "cedar_read_netcdf - "
+			   << index.get_records().size() << " records, "
+			   << index.get_nrows() << " rows" << endl ) ;
+
+	CedarRawOutput out( strm ) ;
+	CedarNetCDFWriter writer( out, "row" ) ;
+	writer.add_attribute( "source", name ) ;
+	if( !query.empty() )
+	    writer.add_attribute( "constraint", query ) ;
+
+	NetCDFRows rows( writer ) ;
+	rows.add_variables( index ) ;
+
+	if( is_http )
+	    out.set_mime( "application/x-netcdf", name + ".nc" ) ;
+	writer.write_header( index.get_nrows() ) ;
+	index.replay( files, rows ) ;
+	writer.finish() ;
+    }
+    catch( CedarException &cedarex )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += cedarex.get_description() + (string)"\n" ;
+	return false ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return false ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return false ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception\n" ;
+	return false ;
+    }
+
+    return true ;
+}
+
@@ -0,0 +1,108 @@
+// cedar_read_size.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <stdio.h>
+
+#include <new>
+
+using std::bad_alloc ;
+
+#include "cedar_read_size.h"
+#include "CedarFlatSize.h"
+#include "CedarAggregate.h"
+#include "CedarException.h"
+#include "CedarConstraintEvaluator.h"
+#include "BESError.h"
+
+/** @brief report the size of the flat product of the records of the cedar
+ * file that satisfy the constraint, without formatting it
+ *
+ * A line each for the bytes of the flat product and the records and rows
+ * it would hold.
+ *
+ * @param info the response to add the size to
+ * @param filename the cedar file
+ * @param query the constraint, may be empty
+ * @param compact true to size the compact flat product
+ * @param error set if there is a problem
+ * @return true if successful, false otherwise
+ */
+bool
+cedar_read_size( BESInfo &info, const string &filename,
+                 const string &query, bool compact, string &error )
+{
+    CedarConstraintEvaluator qa ;
+    try
+    {
+	qa.parse( query.c_str() ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = ex.get_description() ;
+	return false ;
+    }
+
+    try
+    {
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	CedarFlatSize size( compact ) ;
+	size.read( files, qa ) ;
+
+	char line[64] ;
+	snprintf( line, sizeof line, "flat %llu\n", size.get_bytes() ) ;
+	info.add_data( line ) ;
+	snprintf( line, sizeof line, "records %lu\n", size.get_records() ) ;
+	info.add_data( line ) ;
+	snprintf( line, sizeof line, "rows %lu\n", size.get_rows() ) ;
+	info.add_data( line ) ;
+    }
+    catch( CedarException &ex )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += ex.get_description() + (string)"\n" ;
+	return false ;
+    }
+    catch( BESError &beserr )
+    {
+	error = "The requested dataset produces the following exception: " ;
+	error += beserr.get_message() + (string)"\n" ;
+	return false ;
+    }
+    catch( bad_alloc & )
+    {
+	error = "There has been a memory allocation error.\n" ;
+	return false ;
+    }
+    catch( ... )
+    {
+	error = "The requested dataset produces an unknown exception\n" ;
+	return false ;
+    }
+
+    return true ;
+}
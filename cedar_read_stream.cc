@@ -43,33 +43,127 @@ using std::endl ;
 using std::string ;
 
 #include "cedar_read_stream.h"
+#include "cedar_read_cbf.h"
+#include "CedarRawOutput.h"
+#include "CedarAggregate.h"
+#include "BESError.h"
+#include "BESSyntaxUserError.h"
+#include "BESDebug.h"
 
-bool cedar_read_stream( const string &filename, const string &query,
-                        string &error )
+/** @brief copy the file, or the requested range of bytes of it, to out
+ *
+ * Over HTTP the file is sent after its header, with a 206 status and its
+ * Content-Range if only a range of it is sent.
+ *
+ * @throws BESSyntaxUserError if the range lies past the end of the file
+ */
+static bool
+send_file( CedarRawOutput &out, bool is_http, const string &filename,
+           const CedarByteRange &range, string &error )
 {
-    int bytes=0;
-    ifstream os;
-    os.open (filename.c_str(),ios::binary|ios::in);
-    if (!os)
+    ifstream os ;
+    os.open( filename.c_str(), ios::binary|ios::in ) ;
+    if( !os )
     {
-	error="can not open file " +filename;
-	return false;
+	error = "can not open file " + filename ;
+	return false ;
     }
 
-    int nbytes;
-    char block[4096];
-    os.read(block, sizeof block);
-    while (os)
+    os.seekg( 0, ios::end ) ;
+    unsigned long long total = os.tellg() ;
+    unsigned long long first = 0 ;
+    unsigned long long remaining = total ;
+    string content_range ;
+    if( range.is_set() )
     {
-	nbytes=os.gcount();
-	bytes+=nbytes;
-	write(fileno(stdout),(void*)block, nbytes);
-	os.read(block, sizeof block);
+	unsigned long long last = 0 ;
+	if( !range.resolve( total, first, last ) )
+	{
+	    string err = "The requested range can not be satisfied for file "
+			 + filename ;
+	    throw BESSyntaxUserError( err, __FILE__, __LINE__ ) ;
+	}
+	remaining = last - first + 1 ;
+	char cr[80] ;
+	snprintf( cr, sizeof cr, "bytes %llu-%llu/%llu", first, last, total ) ;
+	content_range = cr ;
     }
-    os.close();
+    os.seekg( first, ios::beg ) ;
 
-    //cerr<<"BYTES TOTAL = "<<bytes<<endl;
+    if( is_http )
+    {
+	string name = filename.substr( filename.rfind( '/' ) + 1 ) ;
+	string header =
+	    CedarRawOutput::get_http_header( "application/octet-stream",
+					     name, "", false, remaining,
+					     content_range ) ;
+	out.write( header.data(), header.length() ) ;
+    }
+
+    char block[4096] ;
+    while( remaining > 0 && os )
+    {
+	size_t want = sizeof block ;
+	if( remaining < want )
+	    want = remaining ;
+	os.read( block, want ) ;
+	size_t nbytes = os.gcount() ;
+	if( nbytes == 0 )
+	    break ;
+	out.write( block, nbytes ) ;
+	remaining -= nbytes ;
+    }
+    os.close() ;
+
+    return true ;
+}
+
+/** @brief stream the cedar file to standard output
+ *
+ * Without a constraint the file is sent as is. With a constraint the cbf
+ * response, made of only the logical records that satisfy the constraint,
+ * is sent instead, as it always is for an aggregate. If a byte range is
+ * given, such as bytes=1000- to resume an interrupted download, only those
+ * bytes are sent.
+ *
+ * @param is_http true if the response is sent over HTTP
+ * @param filename the cedar file to stream
+ * @param query the constraint, may be empty
+ * @param range byte range of the form bytes=first-last, bytes=first- or
+ * bytes=-suffix, may be empty
+ * @param error set if there is a problem streaming the file
+ * @return true if successful, false otherwise
+ * @throws BESSyntaxUserError if the range can not be satisfied
+ */
+bool cedar_read_stream( bool is_http, const string &filename,
+                        const string &query, const string &range,
+			string &error )
+{
+    if( !query.empty() || CedarAggregate::is_aggregate( filename ) )
+    {
+	return cedar_read_cbf( filename, query, range, error ) ;
+    }
 
-    return true;
+    CedarByteRange br ;
+    if( !range.empty() && !br.parse( range ) )
+    {
+	BESDEBUG( "cedar", "cedar_read_stream - ignoring range "
+			   << range << endl ) ;
+    }
+
+    CedarRawOutput out( fileno( stdout ) ) ;
+    try
+    {
+	return send_file( out, is_http, filename, br, error ) ;
+    }
+    catch( BESSyntaxUserError & )
+    {
+	throw ;
+    }
+    catch( BESError &beserr )
+    {
+	error = beserr.get_message() ;
+	return false ;
+    }
 }
 
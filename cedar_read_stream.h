@@ -33,8 +33,9 @@
 #ifndef cedar_read_stream_h_
 #define cedar_read_stream_h_ 1
 
-bool cedar_read_stream( const string &filename, const string &query,
-                        string &error ) ;
+bool cedar_read_stream( bool is_http, const string &filename,
+                        const string &query, const string &range,
+			string &error ) ;
 
 #endif // cedar_read_stream_h_
 
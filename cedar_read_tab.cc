@@ -30,255 +30,226 @@
 //      pwest       Patrick West <pwest@ucar.edu>
 //      jgarcia     Jose Garcia <jgarcia@ucar.edu>
 
-#include <exception>
-#include <cstddef>
-//#include <new>
-#include <sstream>
-#include <memory>
+#include <new>
 
-using std::ostringstream ;
-using std::auto_ptr ;
+using std::bad_alloc ;
 
-#include "CedarFile.h"
 #include "CedarTab.h"
 #include "cedar_read_tab.h"
 #include "CedarException.h"
-#include "cedar_read_descriptors.h"
-#include "cedar_read_tab_support.h"
-#include "CedarParameter.h"
 #include "CedarConstraintEvaluator.h"
+#include "CedarRawFile.h"
+#include "CedarRecordSelection.h"
+#include "CedarTextFormat.h"
+#include "CedarAggregate.h"
 #include "BESError.h"
 
-struct _printable_parameter
+/** @brief formats each record as a block of the tab product
+ *
+ * Each block has a line of prologue names and a line of prologue values,
+ * lines with the names, codes and values of the selected JPARs, then lines
+ * with the names and codes of the selected MPARs followed by a line for
+ * each selected row.
+ *
+ * In compact mode the name and code lines are written only when the
+ * layout of the records changes. Each record is then a line of prologue
+ * values, a line of JPAR values and a line for each selected row,
+ * followed by an empty line.
+ *
+ * Records are formatted by a pool of workers copied from the product.
+ */
+class TabFormat : public CedarTextFormat
 {
-    field par_value;
-    bool is_valid;
-};
+private:
+    bool		_has_rows ;
+
+    void		names( const CedarRawRecord &rec,
+			       const vector<int> &pos, int last, bool jpar ) ;
+    void		codes( const CedarRawRecord &rec,
+			       const vector<int> &pos, int last, bool jpar ) ;
+    void		prologue( const CedarRawRecord &rec ) ;
+    void		jpar_values( const CedarRawRecord &rec,
+				     const vector<int> &jpar ) ;
+    void		rows( const CedarRawRecord &rec,
+			      const CedarRecordSelection &sel ) ;
+protected:
+    virtual void	format( const CedarRawRecord &rec,
+				const CedarRecordSelection &sel,
+				int mark ) ;
+public:
+    			TabFormat( CedarTab &tab, bool compact )
+			    : CedarTextFormat( tab, compact ),
+			      _has_rows( false ) {}
+    virtual		~TabFormat() {}
+
+    virtual CedarRecordReader *make_worker() const
+			{
+			    return new TabFormat( *this ) ;
+			}
+    virtual int		mark_record( const CedarRawRecord &rec,
+				     const CedarRecordSelection &sel ) ;
+} ;
+
+/** @brief a line with the names of the selected parameters
+ *
+ * A tab follows every parameter but the last of the record, whether or
+ * not the last was selected.
+ */
+void
+TabFormat::names( const CedarRawRecord &rec, const vector<int> &pos,
+                  int last, bool jpar )
+{
+    for( size_t i = 0; i < pos.size(); i++ )
+    {
+	int code = jpar ? rec.get_jpar_code( pos[i] )
+			: rec.get_mpar_code( pos[i] ) ;
+	append( get_name( code ) ) ;
+	if( pos[i] < last )
+	    append( '\t' ) ;
+    }
+    append( '\n' ) ;
+}
 
-typedef _printable_parameter printable_parameter;
+void
+TabFormat::codes( const CedarRawRecord &rec, const vector<int> &pos,
+                  int last, bool jpar )
+{
+    for( size_t i = 0; i < pos.size(); i++ )
+    {
+	append_int( jpar ? rec.get_jpar_code( pos[i] )
+			 : rec.get_mpar_code( pos[i] ) ) ;
+	if( pos[i] < last )
+	    append( '\t' ) ;
+    }
+    append( '\n' ) ;
+}
 
-void send_tab_data(CedarTab &tab_object, CedarDataRecord &dr, CedarConstraintEvaluator &qa)
+void
+TabFormat::prologue( const CedarRawRecord &rec )
 {
-    if (qa.validate_record(dr))
+    for( int w = CEDAR_RAW_KINST; w <= CEDAR_RAW_IECST; w++ )
     {
-	ostringstream oss;
-	unsigned int w = 0 ;
-	int y,z = 0 ;
-	CedarDate bdate,edate;
-	dr.get_record_begin_date(bdate);
-	dr.get_record_end_date(edate);
-	oss<<"KINST"<<'\t'<<"KINDAT"<<'\t'<<"IBYRT"<<'\t'<<"IBDTT"<<'\t'<<"IBHMT"<<'\t'<<"IBCST"<<'\t'<<"IEYRT"<<'\t'<<"IEDTT"<<'\t'<<"IEHMT"<<'\t'<<"IECST"<<'\t'<<"JPAR"<<'\t'<<"MPAR"<<'\t'<<"NROWS"<<endl;
-	oss<<dr.get_record_kind_instrument()<<'\t';
-	oss<<dr.get_record_kind_data()<<'\t';
-	oss<< bdate.get_year()<<'\t';
-	oss<<bdate.get_month_day()<<'\t';
-	oss<<bdate.get_hour_min()<<'\t';
-	oss<<bdate.get_second_centisecond()<<'\t';
-	oss<<edate.get_year()<<'\t';
-	oss<<edate.get_month_day()<<'\t';
-	oss<<edate.get_hour_min()<<'\t';
-	oss<<edate.get_second_centisecond()<<'\t';
-	oss<<dr.get_jpar()<<'\t';
-	oss<<dr.get_mpar()<<'\t';
-	oss<<dr.get_nrows()<<endl;
+	append_int( rec.get_word( w ) ) ;
+	append( '\t' ) ;
+    }
+    append_int( rec.get_jpar() ) ;
+    append( '\t' ) ;
+    append_int( rec.get_mpar() ) ;
+    append( '\t' ) ;
+    append_int( rec.get_nrows() ) ;
+    append( '\n' ) ;
+}
 
-	unsigned int jpar_value=dr.get_jpar();
-	auto_ptr<vector<short int> > pJparData( new vector<short int>(jpar_value) );
-	if (!pJparData.get())
-	{
-	    throw bad_alloc();
-	}
-	dr.load_JPAR_data(*pJparData);
+void
+TabFormat::jpar_values( const CedarRawRecord &rec, const vector<int> &jpar )
+{
+    int last = rec.get_jpar() - 1 ;
+    for( size_t j = 0; j < jpar.size(); j++ )
+    {
+	append_int( rec.get_jpar_value( jpar[j] ) ) ;
+	if( jpar[j] < last )
+	    append( '\t' ) ;
+    }
+    append( '\n' ) ;
+}
 
-	auto_ptr<vector<short int> > pJparVars( new vector<short int>(jpar_value) );
-	if (!pJparVars.get())
+void
+TabFormat::rows( const CedarRawRecord &rec, const CedarRecordSelection &sel )
+{
+    const vector<int> &mpar = sel.get_mpar() ;
+    int last = rec.get_mpar() - 1 ;
+    int nrows = rec.get_nrows() ;
+    for( int row = 0; row < nrows; row++ )
+    {
+	if( !sel.is_row_selected( row ) )
+	    continue ;
+	for( size_t m = 0; m < mpar.size(); m++ )
 	{
-	    throw bad_alloc();
+	    append_int( rec.get_mpar_value( row, mpar[m] ) ) ;
+	    if( mpar[m] < last )
+		append( '\t' ) ;
 	}
-	dr.load_JPAR_vars(*pJparVars);
+	append( '\n' ) ;
+    }
+}
 
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    string JparVarName="";
-	    string the_var="";
-	    if (qa.validate_parameter((*pJparVars)[w]))
-	    {
-		int val;
-		if ((*pJparVars)[w]<0)
-		{
-		    val=(*pJparVars)[w]*-1;
-		    the_var+="e_";
-		}
-		else
-		{
-		    val=(*pJparVars)[w];
-		}
-		get_name_for_parameter(JparVarName,val);
-		the_var+=JparVarName;
-		oss<<the_var;
-		if(w<(jpar_value-1))
-		{
-		    oss<<'\t';
-		}
-	    }
-	}
-	oss<<endl;
+/** @brief the name and code lines start every record, or in compact
+ * mode a record laid out differently from the one before
+ */
+int
+TabFormat::mark_record( const CedarRawRecord &rec,
+                        const CedarRecordSelection &sel )
+{
+    if( !is_compact() )
+	return CEDAR_MARK_HEAD ;
+    bool has_rows = ( rec.get_mpar() > 0 && rec.get_nrows() > 0 ) ;
+    bool changed = schema_changed( rec, sel ) ;
+    if( !changed && has_rows == _has_rows )
+	return 0 ;
+    _has_rows = has_rows ;
+    return CEDAR_MARK_HEAD ;
+}
 
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    if (qa.validate_parameter((*pJparVars)[w]))
-	    {
-		oss<<(*pJparVars)[w];
-		if(w<(jpar_value-1))
-		{
-		    oss<<'\t';
-		}
-	    }
-	}
-	oss<<endl;
-	for (w=0; w<jpar_value; w++)
-	{ 
-	    if (qa.validate_parameter((*pJparVars)[w]))
-	    {
-		oss<<(*pJparData)[w];
-		if(w<(jpar_value-1))
-		{
-		    oss<<'\t';
-		}
-	    }
+void
+TabFormat::format( const CedarRawRecord &rec,
+                   const CedarRecordSelection &sel, int mark )
+{
+    static const char *prologue_names =
+	"KINST\tKINDAT\tIBYRT\tIBDTT\tIBHMT\tIBCST\tIEYRT\tIEDTT\tIEHMT\tIECST\tJPAR\tMPAR\tNROWS\n" ;
+    const vector<int> &jpar = sel.get_jpar() ;
+    const vector<int> &mpar = sel.get_mpar() ;
+    int jlast = rec.get_jpar() - 1 ;
+    int mlast = rec.get_mpar() - 1 ;
+    bool has_rows = ( rec.get_mpar() > 0 && rec.get_nrows() > 0 ) ;
+
+    if( !is_compact() )
+    {
+	append( prologue_names ) ;
+	prologue( rec ) ;
+	names( rec, jpar, jlast, true ) ;
+	codes( rec, jpar, jlast, true ) ;
+	jpar_values( rec, jpar ) ;
+	if( has_rows )
+	{
+	    names( rec, mpar, mlast, false ) ;
+	    codes( rec, mpar, mlast, false ) ;
+	    rows( rec, sel ) ;
+	    append( '\n' ) ;
 	}
-	oss<<endl;
+	return ;
+    }
 
-	int mpar_value=dr.get_mpar();
-	int nrow_value=dr.get_nrows();
-	if ((mpar_value>0) && (nrow_value>0))
+    if( mark & CEDAR_MARK_HEAD )
+    {
+	append( prologue_names ) ;
+	names( rec, jpar, jlast, true ) ;
+	codes( rec, jpar, jlast, true ) ;
+	if( has_rows )
 	{
-	    auto_ptr<vector<short int> > pMparVars( new vector<short int>(mpar_value) );
-	    if (!pMparVars.get())
-	    {
-		throw bad_alloc();
-	    }
-	    dr.load_MPAR_vars(*pMparVars);
-
-	    auto_ptr<vector<short int> > pMparData( new vector<short int>(nrow_value*mpar_value) );
-	    if (!pMparData.get())
-	    {
-		throw bad_alloc();
-	    }
-	    dr.load_MPAR_data(*pMparData);
-
-	    for (y=0; y<mpar_value;y++)
-	    {
-		string MparVarName="";
-		string the_var="";
-		if (qa.validate_parameter((*pMparVars)[y]))
-		{
-		    int val;
-		    if ((*pMparVars)[y]<0)
-		    {
-			val=(*pMparVars)[y]*-1;
-			the_var+="e_";
-		    }
-		    else
-		    {
-			val=(*pMparVars)[y];
-		    }
-		    get_name_for_parameter(MparVarName,val);
-		    the_var+=MparVarName;
-		    oss<<the_var;
-		    if(y<(mpar_value-1))
-		    {
-			oss<<'\t';
-		    }
-		}
-	    }
-	    oss<<endl;
-
-	    unsigned int number_of_valid_variables=0;
-
-	    printable_parameter valid_printable_parameters[mpar_value];
-
-	    for (y=0; y<mpar_value;y++)
-	    {
-		valid_printable_parameters[y].is_valid=0;
-	    }
-
-	    for (y=0; y<mpar_value;y++)
-	    {
-		if (qa.validate_parameter((*pMparVars)[y]))
-		{
-		    number_of_valid_variables++;
-		    oss<<(*pMparVars)[y];
-		    if(y<(mpar_value-1))
-		    {
-			oss<<'\t';
-		    }
-		    valid_printable_parameters[y].is_valid=1;
-		    valid_printable_parameters[y].par_value=(*pMparVars)[y];
-		}
-	    }
-	    oss<<endl;
-
-	    // Print the data
-
-	    CedarParameter pp;
-
-	    unsigned int number_of_printable_items;
-
-	    bool print_row;
-
-	    for (y=0; y<nrow_value;y++)
-	    {
-		print_row=1;
-
-		if (qa.got_parameter_constraint())
-		{
-		    number_of_printable_items=0;
-		    for (z=0; z<mpar_value;z++)
-		    {
-			if(valid_printable_parameters[z].is_valid)
-			{
-			    pp=qa.get_parameter(valid_printable_parameters[z].par_value);
-			    if(pp.validateValue((*pMparData)[z+(y*mpar_value)]))
-			    {
-				number_of_printable_items++;
-			    }
-			}
-		    }
-
-		    if(number_of_printable_items!=number_of_valid_variables)
-		    {
-			print_row=0;
-		    }
-		}
-
-		if (print_row)
-		{
-		    for (z=0; z<mpar_value;z++)
-		    {
-			if(valid_printable_parameters[z].is_valid)
-			{
-			    oss<<(*pMparData)[z+(y*mpar_value)];
-
-			    if(z<(mpar_value-1))
-			    {
-				oss<<'\t';
-			    }
-			}
-		    }
-		    oss<<endl;
-		}
-	    }
-
-	    oss<<endl;
+	    names( rec, mpar, mlast, false ) ;
+	    codes( rec, mpar, mlast, false ) ;
 	}
-	//oss<<'\0';
-	tab_object.add_data( oss.str() ) ;
     }
+    prologue( rec ) ;
+    jpar_values( rec, jpar ) ;
+    if( has_rows )
+	rows( rec, sel ) ;
+    append( '\n' ) ;
 }
 
+/** @brief format the records of the cedar file that satisfy the
+ * constraint as the tab product
+ *
+ * @param dt the response to add the product to
+ * @param filename the cedar file
+ * @param query the constraint, may be empty
+ * @param compact true to write the name and code lines only when the
+ * layout of the records changes
+ * @param error set if there is a problem
+ * @return 1 if successful, 0 otherwise
+ */
 int cedar_read_tab( CedarTab &dt, const string &filename,
-                    const string &query, string &error )
+                    const string &query, bool compact, string &error )
 {
     CedarConstraintEvaluator qa;
     try
@@ -291,37 +262,12 @@ int cedar_read_tab( CedarTab &dt, const string &filename,
 	return 0;
     }
 
-    CedarFile file;
     try
     {
-	file.open_file (filename.c_str());
-	const CedarLogicalRecord *lr =file.get_first_logical_record();
-
-	if(lr)
-	{
-	    if((lr->get_type()==1))
-	    {
-		send_tab_data(dt, *(CedarDataRecord*)lr,qa);
-	    }
-	    while (!file.end_dataset())
-	    {
-		lr=file.get_next_logical_record();
-		if(lr)
-		{
-		    if((lr->get_type()==1))
-		    {
-			send_tab_data(dt, *(CedarDataRecord*)lr,qa);
-		    }
-		}
-	    }
-	}
-	else 
-	{
-	    error = (string)"Failure reading data from file "
-		    + filename
-		    + ", corrupted file or not a cbf file.\n" ;
-	    return false;
-	}
+	vector<string> files ;
+	CedarAggregate::get_files( filename, query, files ) ;
+	TabFormat tab( dt, compact ) ;
+	tab.read( files, qa ) ;
     }
     catch (CedarException &cedarex)
     {
@@ -335,7 +281,7 @@ int cedar_read_tab( CedarTab &dt, const string &filename,
 	error += beserr.get_message() + (string)"\n" ;
 	return 0 ;
     }
-    catch (bad_alloc::bad_alloc)
+    catch (bad_alloc &)
     {
 	error="There has been a memory allocation error.\n";
 	return 0;
@@ -40,7 +40,7 @@ using std::string ;
 class CedarTab ;
 
 int cedar_read_tab( CedarTab &dt, const string &filename,
-                    const string &query, string &error ) ;
+                    const string &query, bool compact, string &error ) ;
 
 #endif // cedar_read_tab_h_
 
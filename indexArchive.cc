@@ -0,0 +1,158 @@
+// indexArchive.cc
+
+// This file is part of the OPeNDAP Cedar data handler, providing data
+// access views for CedarWEB data
+
+// Copyright (c) 2026 University Corporation for Atmospheric Research
+//
+// This library is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Lesser General Public
+// License as published by the Free Software Foundation; either
+// version 2.1 of the License, or (at your option) any later version.
+// 
+// This library is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Lesser General Public License for more details.
+// 
+// You should have received a copy of the GNU Lesser General Public
+// License along with this library; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+// You can contact University Corporation for Atmospheric Research at
+// 3080 Center Green Drive, Boulder, CO 80301
+ 
+// (c) COPYRIGHT University Corporation for Atmostpheric Research 2026
+// Please read the full copyright statement in the file COPYRIGHT_UCAR.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cout ;
+using std::cerr ;
+using std::endl ;
+using std::string ;
+using std::vector ;
+
+#include <unistd.h>
+
+#include "CedarArchive.h"
+#include "CedarInputFile.h"
+#include "CedarFSDir.h"
+#include "BESError.h"
+
+static unsigned long files_read = 0 ;
+static unsigned long files_failed = 0 ;
+
+// compressed files are named for the file and the .gz or .zst
+static bool
+is_cedar_file( const string &name, string &base )
+{
+    string plain = CedarInputFile::strip( name ) ;
+    string::size_type dot = plain.rfind( '.' ) ;
+    if( dot == string::npos )
+	return false ;
+    string ext = plain.substr( dot ) ;
+    if( ext != ".cbf" && ext != ".001" )
+	return false ;
+    base = plain.substr( 0, dot ) ;
+    return true ;
+}
+
+/** @brief index the cedar files under dir, named for their path below
+ * the base directory, as the Cedar container storage names them
+ */
+static void
+index_dir( CedarArchive &archive, CedarFSDir &dir, const string &prefix,
+	   vector<string> &paths )
+{
+    CedarFSDir::fileIterator f ;
+    for( f = dir.beginOfFileList(); f != dir.endOfFileList(); f++ )
+    {
+	string base ;
+	if( !is_cedar_file( (*f).getFileName(), base ) )
+	    continue ;
+	string path = (*f).getFullPath() ;
+	bool changed = false ;
+	string error ;
+	if( !archive.update( prefix + base, path, changed, error ) )
+	{
+	    cerr << error << endl ;
+	    files_failed++ ;
+	    continue ;
+	}
+	paths.push_back( path ) ;
+	if( changed )
+	    files_read++ ;
+    }
+
+    CedarFSDir::dirIterator d ;
+    for( d = dir.beginOfDirList(); d != dir.endOfDirList(); d++ )
+    {
+	string name = (*d).getDirName() ;
+	string::size_type slash = name.rfind( '/' ) ;
+	if( slash != string::npos )
+	    name = name.substr( slash + 1 ) ;
+	index_dir( archive, *d, prefix + name + "/", paths ) ;
+    }
+}
+
+int
+main( int argc, char *argv[] )
+{
+    if( argc < 3 )
+    {
+	cerr << "usage: " << argv[0] << " index base_dir [base_dir ...]"
+	     << endl
+	     << "  writes, or brings up to date, the archive index of the"
+	     << endl
+	     << "  cedar files under the base directories" << endl ;
+	return 1 ;
+    }
+
+    string index = argv[1] ;
+    CedarArchive archive ;
+    string error ;
+    if( access( index.c_str(), F_OK ) == 0 && !archive.load( index, error ) )
+    {
+	cerr << error << endl ;
+	return 1 ;
+    }
+
+    vector<string> paths ;
+    try
+    {
+	for( int i = 2; i < argc; i++ )
+	{
+	    CedarFSDir dir( argv[i] ) ;
+	    index_dir( archive, dir, "", paths ) ;
+	}
+    }
+    catch( const string &err )
+    {
+	cerr << err << endl ;
+	return 1 ;
+    }
+    catch( BESError &e )
+    {
+	cerr << e.get_message() << endl ;
+	return 1 ;
+    }
+
+    unsigned long before = archive.get_files().size() ;
+    archive.retain( paths ) ;
+    unsigned long removed = before - archive.get_files().size() ;
+    if( !archive.save( index, error ) )
+    {
+	cerr << error << endl ;
+	return 1 ;
+    }
+
+    cout << index << ": " << archive.get_files().size() << " files, "
+	 << files_read << " read, " << removed << " removed, "
+	 << files_failed << " failed" << endl ;
+
+    return files_failed ? 1 : 0 ;
+}
+
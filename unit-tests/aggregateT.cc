@@ -0,0 +1,163 @@
+// aggregateT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <string.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::string ;
+using std::vector ;
+
+#include "CedarAggregate.h"
+#include "CedarRawFile.h"
+#include "test_config.h"
+
+class aggregateT: public TestFixture {
+private:
+    string data_dir ;
+
+    long long stamp( const CedarRawRecord &rec )
+    {
+        long long s = rec.get_word( CEDAR_RAW_IBYRT ) ;
+        s = s * 10000 + rec.get_word( CEDAR_RAW_IBDTT ) ;
+        s = s * 10000 + rec.get_word( CEDAR_RAW_IBHMT ) ;
+        return s * 10000 + rec.get_word( CEDAR_RAW_IBCST ) ;
+    }
+
+    // records, data records and duplicates of the merged files, checking
+    // the records come out in time order and numbered in turn
+    void merge( const vector<string> &files, unsigned long &records,
+                unsigned long &data, unsigned long &duplicates )
+    {
+        CedarAggregate merged( files, false ) ;
+        const CedarRawRecord *rec = 0 ;
+        records = 0 ;
+        data = 0 ;
+        long long last = 0 ;
+        while( merged.next( rec ) )
+        {
+            CPPUNIT_ASSERT( rec->get_ordinal() == records ) ;
+            records++ ;
+            if( rec->get_type() != 1 )
+                continue ;
+            data++ ;
+            CPPUNIT_ASSERT( stamp( *rec ) >= last ) ;
+            last = stamp( *rec ) ;
+        }
+        duplicates = merged.get_duplicates() ;
+    }
+
+public:
+    aggregateT() {}
+    ~aggregateT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+    }
+
+    void tearDown()
+    {
+    }
+
+    CPPUNIT_TEST_SUITE( aggregateT ) ;
+
+    CPPUNIT_TEST( do_single ) ;
+    CPPUNIT_TEST( do_merge ) ;
+    CPPUNIT_TEST( do_duplicates ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_single()
+    {
+        cerr << "a single file comes out as it is" << endl ;
+        const char *names[] = { "mfp920504a.cbf", "mlh090323g.001" } ;
+        for( int n = 0; n < 2; n++ )
+        {
+            string filename = data_dir + "/" + names[n] ;
+            vector<string> files( 1, filename ) ;
+            CedarAggregate merged( files, false ) ;
+            CedarRawFile raw( filename ) ;
+            CedarRawRecord expected ;
+            const CedarRawRecord *rec = 0 ;
+            while( raw.next_record( expected ) )
+            {
+                CPPUNIT_ASSERT( merged.next( rec ) ) ;
+                CPPUNIT_ASSERT( rec->get_ordinal() == expected.get_ordinal() ) ;
+                CPPUNIT_ASSERT( rec->get_size() == expected.get_size() ) ;
+                CPPUNIT_ASSERT( memcmp( rec->get_bytes(), expected.get_bytes(),
+                                        expected.get_size() ) == 0 ) ;
+            }
+            CPPUNIT_ASSERT( !merged.next( rec ) ) ;
+            CPPUNIT_ASSERT( merged.get_duplicates() == 0 ) ;
+        }
+
+        cerr << "no files" << endl ;
+        vector<string> none ;
+        CedarAggregate empty( none, false ) ;
+        const CedarRawRecord *rec = 0 ;
+        CPPUNIT_ASSERT( !empty.next( rec ) ) ;
+    }
+
+    void do_merge()
+    {
+        cerr << "merge files in time order" << endl ;
+        vector<string> files ;
+        files.push_back( data_dir + "/mfp911104a.cbf" ) ;
+        files.push_back( data_dir + "/mfp920504a.cbf" ) ;
+        files.push_back( data_dir + "/mfp920603a.cbf" ) ;
+        unsigned long records = 0 ;
+        unsigned long data = 0 ;
+        unsigned long duplicates = 0 ;
+        merge( files, records, data, duplicates ) ;
+
+        // mfp911104a runs to the end of June 1992 and holds every record
+        // of mfp920603a, the header records are those of mfp911104a
+        CPPUNIT_ASSERT( data == 144 + 32 ) ;
+        CPPUNIT_ASSERT( duplicates == 26 ) ;
+        CPPUNIT_ASSERT( records == ( 230 - 144 ) + data ) ;
+
+        cerr << "the same files merge the same way" << endl ;
+        unsigned long again = 0 ;
+        merge( files, again, data, duplicates ) ;
+        CPPUNIT_ASSERT( again == records ) ;
+    }
+
+    void do_duplicates()
+    {
+        cerr << "a file merged with itself" << endl ;
+        vector<string> files ;
+        files.push_back( data_dir + "/mfp920504a.cbf" ) ;
+        files.push_back( data_dir + "/mfp920504a.cbf" ) ;
+        unsigned long records = 0 ;
+        unsigned long data = 0 ;
+        unsigned long duplicates = 0 ;
+        merge( files, records, data, duplicates ) ;
+        CPPUNIT_ASSERT( records == 50 ) ;
+        CPPUNIT_ASSERT( data == 32 ) ;
+        CPPUNIT_ASSERT( duplicates == 32 ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( aggregateT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
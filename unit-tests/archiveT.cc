@@ -0,0 +1,269 @@
+// archiveT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <unistd.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::ofstream ;
+using std::string ;
+using std::vector ;
+
+#include "CedarArchive.h"
+#include "test_config.h"
+
+class archiveT: public TestFixture {
+private:
+    string data_dir ;
+    string index ;
+
+    void build( CedarArchive &archive )
+    {
+        const char *names[] = { "mfp920504a", "mfp920603a", "mfp911104a" } ;
+        for( int i = 0; i < 3; i++ )
+        {
+            bool changed = false ;
+            string error ;
+            CPPUNIT_ASSERT( archive.update( names[i], data_dir + "/" + names[i] + ".cbf", changed, error ) ) ;
+            CPPUNIT_ASSERT( changed ) ;
+        }
+        bool changed = false ;
+        string error ;
+        CPPUNIT_ASSERT( archive.update( "mlh090323g", data_dir + "/mlh090323g.001", changed, error ) ) ;
+    }
+
+    vector<string> find( const CedarArchive &archive, const string &query )
+    {
+        CedarArchiveQuery q ;
+        string error ;
+        CPPUNIT_ASSERT( q.parse( query, error ) ) ;
+        vector<const CedarArchiveFile *> found ;
+        archive.find( q, found ) ;
+        vector<string> names ;
+        for( size_t i = 0; i < found.size(); i++ )
+            names.push_back( found[i]->name ) ;
+        return names ;
+    }
+
+public:
+    archiveT() {}
+    ~archiveT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+        index = "./archive.index" ;
+    }
+
+    void tearDown()
+    {
+        unlink( index.c_str() ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( archiveT ) ;
+
+    CPPUNIT_TEST( do_read ) ;
+    CPPUNIT_TEST( do_query ) ;
+    CPPUNIT_TEST( do_save ) ;
+    CPPUNIT_TEST( do_update ) ;
+    CPPUNIT_TEST( do_filter ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_read()
+    {
+        cerr << "summarize a file" << endl ;
+        CedarArchiveFile file ;
+        string error ;
+        CPPUNIT_ASSERT( CedarArchive::read_file( data_dir + "/mfp920504a.cbf", file, error ) ) ;
+        CPPUNIT_ASSERT( file.has_record_type( 5340, 7001 ) ) ;
+        CPPUNIT_ASSERT( file.has_record_type( 5340, 17001 ) ) ;
+        CPPUNIT_ASSERT( !file.has_record_type( 31, 3410 ) ) ;
+        CPPUNIT_ASSERT( file.has_kinst( 5340 ) ) ;
+        CPPUNIT_ASSERT( file.has_kindat( 17001 ) ) ;
+        CPPUNIT_ASSERT( file.begin >= CedarArchiveFile::get_stamp( 1992, 504, 0, 0 ) ) ;
+        CPPUNIT_ASSERT( file.end <= CedarArchiveFile::get_stamp( 1992, 603, 2359, 5999 ) ) ;
+        CPPUNIT_ASSERT( file.begin <= file.end ) ;
+        CPPUNIT_ASSERT( !file.parameters.empty() ) ;
+
+        cerr << "summarize a madrigal file" << endl ;
+        CPPUNIT_ASSERT( CedarArchive::read_file( data_dir + "/mlh090323g.001", file, error ) ) ;
+        CPPUNIT_ASSERT( file.record_types.size() == 1 ) ;
+        CPPUNIT_ASSERT( file.has_record_type( 31, 3410 ) ) ;
+
+        cerr << "summarize a missing file" << endl ;
+        CPPUNIT_ASSERT( !CedarArchive::read_file( data_dir + "/nosuchfile.cbf", file, error ) ) ;
+        CPPUNIT_ASSERT( !error.empty() ) ;
+    }
+
+    void do_query()
+    {
+        CedarArchive archive ;
+        build( archive ) ;
+        CPPUNIT_ASSERT( archive.get_files().size() == 4 ) ;
+
+        cerr << "find by record type, instrument and kindat" << endl ;
+        vector<string> names = find( archive, "record_type(31/3410)" ) ;
+        CPPUNIT_ASSERT( names.size() == 1 && names[0] == "mlh090323g" ) ;
+        CPPUNIT_ASSERT( find( archive, "kinst(31)" ).size() == 1 ) ;
+        CPPUNIT_ASSERT( find( archive, "kinst(5340)" ).size() == 3 ) ;
+        CPPUNIT_ASSERT( find( archive, "kinst(31,5340)" ).size() == 4 ) ;
+        CPPUNIT_ASSERT( find( archive, "kindat(3410)" ).size() == 1 ) ;
+        CPPUNIT_ASSERT( find( archive, "kinst(9999)" ).empty() ) ;
+
+        cerr << "find by period" << endl ;
+        names = find( archive, "date(2009,101,0,0,2009,1231,2359,5999)" ) ;
+        CPPUNIT_ASSERT( names.size() == 1 && names[0] == "mlh090323g" ) ;
+        names = find( archive, "date(1991,1101,0,0,1991,1231,2359,5999);kinst(5340)" ) ;
+        CPPUNIT_ASSERT( names.size() == 1 && names[0] == "mfp911104a" ) ;
+        // mfp911104a runs into June 1992
+        CPPUNIT_ASSERT( find( archive, "date(1992,504,0,0,1992,510,2359,5999)" ).size() == 2 ) ;
+        CPPUNIT_ASSERT( find( archive, "date(1980,101,0,0,1980,1231,2359,5999)" ).empty() ) ;
+
+        cerr << "find by parameter" << endl ;
+        CPPUNIT_ASSERT( find( archive, "parameters(-32000)" ).empty() ) ;
+        CedarArchiveFile file ;
+        string error ;
+        CPPUNIT_ASSERT( CedarArchive::read_file( data_dir + "/mlh090323g.001", file, error ) ) ;
+        CPPUNIT_ASSERT( !file.parameters.empty() ) ;
+        char q[64] ;
+        snprintf( q, sizeof q, "parameters(%d) & kinst(31)", file.parameters[0] ) ;
+        CPPUNIT_ASSERT( find( archive, q ).size() == 1 ) ;
+
+        cerr << "queries not understood" << endl ;
+        CedarArchiveQuery bad ;
+        CPPUNIT_ASSERT( !bad.parse( "nosuch(1)", error ) ) ;
+        CPPUNIT_ASSERT( !bad.parse( "date(1992,504)", error ) ) ;
+        CPPUNIT_ASSERT( !bad.parse( "record_type(5340)", error ) ) ;
+        CPPUNIT_ASSERT( !bad.parse( "kinst(a)", error ) ) ;
+        CPPUNIT_ASSERT( bad.parse( "", error ) ) ;
+    }
+
+    void do_save()
+    {
+        cerr << "write and read the index" << endl ;
+        CedarArchive archive ;
+        build( archive ) ;
+        string error ;
+        CPPUNIT_ASSERT( archive.save( index, error ) ) ;
+
+        CedarArchive loaded ;
+        CPPUNIT_ASSERT( loaded.load( index, error ) ) ;
+        CPPUNIT_ASSERT( loaded.get_files().size() == archive.get_files().size() ) ;
+        map<string,CedarArchiveFile>::const_iterator i = archive.get_files().begin() ;
+        map<string,CedarArchiveFile>::const_iterator j = loaded.get_files().begin() ;
+        for( ; i != archive.get_files().end(); i++, j++ )
+        {
+            CPPUNIT_ASSERT( i->first == j->first ) ;
+            CPPUNIT_ASSERT( i->second.name == j->second.name ) ;
+            CPPUNIT_ASSERT( i->second.mtime == j->second.mtime ) ;
+            CPPUNIT_ASSERT( i->second.begin == j->second.begin ) ;
+            CPPUNIT_ASSERT( i->second.end == j->second.end ) ;
+            CPPUNIT_ASSERT( i->second.record_types == j->second.record_types ) ;
+            CPPUNIT_ASSERT( i->second.parameters == j->second.parameters ) ;
+        }
+
+        cerr << "read a missing index" << endl ;
+        CedarArchive missing ;
+        CPPUNIT_ASSERT( !missing.load( "./no.such.index", error ) ) ;
+    }
+
+    void do_update()
+    {
+        CedarArchive archive ;
+        build( archive ) ;
+
+        cerr << "an unchanged file is not read again" << endl ;
+        bool changed = true ;
+        string error ;
+        CPPUNIT_ASSERT( archive.update( "mfp920504a", data_dir + "/mfp920504a.cbf", changed, error ) ) ;
+        CPPUNIT_ASSERT( !changed ) ;
+
+        cerr << "files no longer found are dropped" << endl ;
+        vector<string> paths ;
+        paths.push_back( data_dir + "/mfp920504a.cbf" ) ;
+        archive.retain( paths ) ;
+        CPPUNIT_ASSERT( archive.get_files().size() == 1 ) ;
+
+        cerr << "a file that can not be read is left out" << endl ;
+        CPPUNIT_ASSERT( !archive.update( "bes", (string)TEST_SRC_DIR + "/bes.conf.in", changed, error ) ) ;
+        CPPUNIT_ASSERT( archive.get_files().size() == 1 ) ;
+    }
+
+    void do_filter()
+    {
+        cerr << "the filter holds every parameter and kindat" << endl ;
+        CedarArchiveFile file ;
+        string error ;
+        CPPUNIT_ASSERT( CedarArchive::read_file( data_dir + "/mfp920504a.cbf", file, error ) ) ;
+        for( size_t i = 0; i < file.parameters.size(); i++ )
+            CPPUNIT_ASSERT( file.may_have_parameter( file.parameters[i] ) ) ;
+        for( size_t i = 0; i < file.record_types.size(); i++ )
+            CPPUNIT_ASSERT( file.may_have_kindat( file.record_types[i].second ) ) ;
+
+        cerr << "and passes over most of what the file does not hold" << endl ;
+        int passed = 0 ;
+        for( int code = 20000; code < 21000; code++ )
+        {
+            if( !file.has_parameter( code ) && file.may_have_parameter( code ) )
+                passed++ ;
+        }
+        CPPUNIT_ASSERT( passed < 100 ) ;
+
+        cerr << "the filter is kept in the index" << endl ;
+        CedarArchive archive ;
+        build( archive ) ;
+        CPPUNIT_ASSERT( archive.save( index, error ) ) ;
+        CedarArchive loaded ;
+        CPPUNIT_ASSERT( loaded.load( index, error ) ) ;
+        map<string,CedarArchiveFile>::const_iterator i = archive.get_files().begin() ;
+        map<string,CedarArchiveFile>::const_iterator j = loaded.get_files().begin() ;
+        for( ; i != archive.get_files().end(); i++, j++ )
+            CPPUNIT_ASSERT( i->second.get_filter() == j->second.get_filter() ) ;
+
+        cerr << "an index without filters has them built" << endl ;
+        {
+            ofstream strm( index.c_str() ) ;
+            strm << "# cedar archive index\n"
+                 << "mfp920504a\t" << file.path << "\t" << file.mtime << "\t"
+                 << file.size << "\t" << file.begin << "\t" << file.end
+                 << "\t5340/7001\t100,110\n" ;
+        }
+        CedarArchive old ;
+        CPPUNIT_ASSERT( old.load( index, error ) ) ;
+        const CedarArchiveFile &f = old.get_files().begin()->second ;
+        CPPUNIT_ASSERT( f.may_have_parameter( 110 ) ) ;
+        CPPUNIT_ASSERT( f.may_have_kindat( 7001 ) ) ;
+        CPPUNIT_ASSERT( find( old, "parameters(110)" ).size() == 1 ) ;
+        CPPUNIT_ASSERT( find( old, "parameters(120)" ).empty() ) ;
+
+        cerr << "a malformed filter" << endl ;
+        CPPUNIT_ASSERT( !file.set_filter( "00ff" ) ) ;
+        CPPUNIT_ASSERT( !file.set_filter( string( CEDAR_ARCHIVE_FILTER_WORDS * 8, 'z' ) ) ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( archiveT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
@@ -0,0 +1,369 @@
+// cacheT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+using std::cerr ;
+using std::endl ;
+using std::ostream ;
+using std::ostringstream ;
+using std::string ;
+
+#include "CedarCache.h"
+#include "BESError.h"
+#include "TheBESKeys.h"
+#include "test_config.h"
+
+class TestProducer : public CedarCacheProducer
+{
+public:
+    string contents ;
+    int calls ;
+    bool fail ;
+
+    TestProducer( const string &c ) : contents( c ), calls( 0 ), fail( false ) {}
+
+    virtual bool produce( ostream &strm, string &error )
+    {
+        calls++ ;
+        if( fail )
+        {
+            strm << contents.substr( 0, contents.length() / 2 ) ;
+            error = "failed" ;
+            return false ;
+        }
+        strm << contents ;
+        return true ;
+    }
+} ;
+
+// writes the first half of the product, waits, then finishes it, fails
+// or dies
+class SlowProducer : public CedarCacheProducer
+{
+public:
+    string contents ;
+    enum end_t { FINISH, FAIL, DIE } end ;
+
+    SlowProducer( const string &c ) : contents( c ), end( FINISH ) {}
+
+    virtual bool produce( ostream &strm, string &error )
+    {
+        strm << contents.substr( 0, contents.length() / 2 ) ;
+        strm.flush() ;
+        sleep( 1 ) ;
+        if( end == DIE )
+            _exit( 0 ) ;
+        if( end == FAIL )
+        {
+            error = "failed" ;
+            return false ;
+        }
+        strm << contents.substr( contents.length() / 2 ) ;
+        return true ;
+    }
+} ;
+
+class cacheT: public TestFixture {
+private:
+    string cache_dir ;
+
+    string read_product( int fd )
+    {
+        ostringstream strm ;
+        CedarCache::send( fd, strm, 0, CedarCache::get_length( fd ) ) ;
+        close( fd ) ;
+        return strm.str() ;
+    }
+
+    int count_files( const string &prefix )
+    {
+        int count = 0 ;
+        DIR *dir = opendir( cache_dir.c_str() ) ;
+        struct dirent *ent = 0 ;
+        while( dir && ( ent = readdir( dir ) ) )
+        {
+            if( string( ent->d_name ).find( prefix ) == 0 )
+                count++ ;
+        }
+        if( dir ) closedir( dir ) ;
+        return count ;
+    }
+
+    // start generating a product in another process and wait for its
+    // .part file
+    pid_t start_slow( const string &key, const string &contents, int end )
+    {
+        pid_t pid = fork() ;
+        if( pid == 0 )
+        {
+            try
+            {
+                CedarCache cache( cache_dir, 1024 * 1024 ) ;
+                SlowProducer producer( contents ) ;
+                producer.end = (SlowProducer::end_t)end ;
+                string error ;
+                int fd = cache.get( key, producer, error ) ;
+                if( fd >= 0 ) close( fd ) ;
+            }
+            catch( BESError &e )
+            {
+            }
+            _exit( 0 ) ;
+        }
+        string part = cache_dir + "/" + key + ".part" ;
+        struct stat st ;
+        for( int i = 0; i < 500 && stat( part.c_str(), &st ) != 0; i++ )
+            usleep( 10000 ) ;
+        return pid ;
+    }
+
+public:
+    cacheT() {}
+    ~cacheT() {}
+
+    void setUp()
+    {
+        TheBESKeys::ConfigFile = (string)TEST_SRC_DIR + "/bes.conf" ;
+        cache_dir = "./cacheT.cache" ;
+        system( ( "rm -rf " + cache_dir ).c_str() ) ;
+        mkdir( cache_dir.c_str(), 0755 ) ;
+    }
+
+    void tearDown()
+    {
+        system( ( "rm -rf " + cache_dir ).c_str() ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( cacheT ) ;
+
+    CPPUNIT_TEST( do_key ) ;
+    CPPUNIT_TEST( do_get ) ;
+    CPPUNIT_TEST( do_concurrent ) ;
+    CPPUNIT_TEST( do_follow ) ;
+    CPPUNIT_TEST( do_purge ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_key()
+    {
+        string data = (string)TEST_SRC_DIR + "/../data/mfp920504a.cbf" ;
+        string other = (string)TEST_SRC_DIR + "/../data/mfp920603a.cbf" ;
+
+        cerr << "normalize constraints" << endl ;
+        CPPUNIT_ASSERT( CedarCache::normalize( "" ) == "" ) ;
+        CPPUNIT_ASSERT( CedarCache::normalize( " parameters( 54, 160 ) " ) == "parameters(54,160)" ) ;
+        CPPUNIT_ASSERT( CedarCache::normalize( "a&date(1,2)&parameters(54)" ) == CedarCache::normalize( "a & parameters(54) & date(1, 2)" ) ) ;
+        CPPUNIT_ASSERT( CedarCache::normalize( "x=\"a b\"" ) == "x=\"a b\"" ) ;
+
+        cerr << "key products" << endl ;
+        string key = CedarCache::get_key( data, "get.tab", "parameters(54)" ) ;
+        CPPUNIT_ASSERT( key.length() == 32 ) ;
+        CPPUNIT_ASSERT( key == CedarCache::get_key( data, "get.tab", " parameters(54)" ) ) ;
+        CPPUNIT_ASSERT( key != CedarCache::get_key( data, "get.flat", "parameters(54)" ) ) ;
+        CPPUNIT_ASSERT( key != CedarCache::get_key( data, "get.tab", "parameters(160)" ) ) ;
+        CPPUNIT_ASSERT( key != CedarCache::get_key( other, "get.tab", "parameters(54)" ) ) ;
+        CPPUNIT_ASSERT( CedarCache::get_key( data + ".missing", "get.tab", "" ) == "" ) ;
+    }
+
+    void do_get()
+    {
+        try
+        {
+            CedarCache cache( cache_dir, 1024 * 1024 ) ;
+            string key = "0123456789abcdef0123456789abcdef" ;
+            string error ;
+
+            cerr << "generate a product once" << endl ;
+            TestProducer producer( "the product\n" ) ;
+            CPPUNIT_ASSERT( cache.open( key ) < 0 ) ;
+            CPPUNIT_ASSERT( read_product( cache.get( key, producer, error ) ) == producer.contents ) ;
+            CPPUNIT_ASSERT( read_product( cache.get( key, producer, error ) ) == producer.contents ) ;
+            CPPUNIT_ASSERT( producer.calls == 1 ) ;
+
+            cerr << "send part of a product" << endl ;
+            int fd = cache.open( key ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            ostringstream part ;
+            CedarCache::send( fd, part, 4, 7 ) ;
+            close( fd ) ;
+            CPPUNIT_ASSERT( part.str() == "product" ) ;
+
+            cerr << "do not cache a failed product" << endl ;
+            string failed = "fedcba9876543210fedcba9876543210" ;
+            TestProducer bad( "never cached" ) ;
+            bad.fail = true ;
+            CPPUNIT_ASSERT( cache.get( failed, bad, error ) < 0 ) ;
+            CPPUNIT_ASSERT( error == "failed" ) ;
+            CPPUNIT_ASSERT( cache.open( failed ) < 0 ) ;
+            CPPUNIT_ASSERT( count_files( failed ) == 0 ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to use the cache" ) ;
+        }
+    }
+
+    void do_concurrent()
+    {
+        cerr << "generate a product asked for by several processes once" << endl ;
+        string key = "00112233445566778899aabbccddeeff" ;
+        string contents( 200000, 'x' ) ;
+        const int nproc = 6 ;
+        for( int i = 0; i < nproc; i++ )
+        {
+            if( fork() == 0 )
+            {
+                int ok = 1 ;
+                try
+                {
+                    CedarCache cache( cache_dir, 1024 * 1024 ) ;
+                    TestProducer producer( contents ) ;
+                    string error ;
+                    ok = read_product( cache.get( key, producer, error ) ) == contents ? 0 : 1 ;
+                    // the number of products generated by this process
+                    ok |= producer.calls << 1 ;
+                }
+                catch( BESError &e )
+                {
+                }
+                _exit( ok ) ;
+            }
+        }
+        int generated = 0 ;
+        for( int i = 0; i < nproc; i++ )
+        {
+            int status = 0 ;
+            wait( &status ) ;
+            CPPUNIT_ASSERT( WIFEXITED( status ) ) ;
+            CPPUNIT_ASSERT( ( WEXITSTATUS( status ) & 1 ) == 0 ) ;
+            generated += WEXITSTATUS( status ) >> 1 ;
+        }
+        CPPUNIT_ASSERT( generated == 1 ) ;
+    }
+
+    void do_follow()
+    {
+        string key = "0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f0f" ;
+        string contents( 300000, 'f' ) ;
+        string error ;
+        CedarCache cache( cache_dir, 1024 * 1024 ) ;
+        TestProducer producer( contents ) ;
+
+        cerr << "follow a product as another process generates it" << endl ;
+        pid_t pid = start_slow( key, contents, SlowProducer::FINISH ) ;
+        bool partial = false ;
+        int fd = cache.get( key, producer, error, partial ) ;
+        CPPUNIT_ASSERT( fd >= 0 ) ;
+        CPPUNIT_ASSERT( partial ) ;
+        ostringstream strm ;
+        CedarCache::follow( fd, strm ) ;
+        close( fd ) ;
+        CPPUNIT_ASSERT( strm.str() == contents ) ;
+        CPPUNIT_ASSERT( producer.calls == 0 ) ;
+        waitpid( pid, 0, 0 ) ;
+        fd = cache.open( key ) ;
+        CPPUNIT_ASSERT( fd >= 0 ) ;
+        close( fd ) ;
+
+        cerr << "fail when the process generating a product fails" << endl ;
+        string failed = "1f1f1f1f1f1f1f1f1f1f1f1f1f1f1f1f" ;
+        pid = start_slow( failed, contents, SlowProducer::FAIL ) ;
+        fd = cache.get( failed, producer, error, partial ) ;
+        CPPUNIT_ASSERT( partial ) ;
+        bool threw = false ;
+        try
+        {
+            CedarCache::follow( fd, strm ) ;
+        }
+        catch( BESError &e )
+        {
+            threw = true ;
+        }
+        close( fd ) ;
+        CPPUNIT_ASSERT( threw ) ;
+        waitpid( pid, 0, 0 ) ;
+
+        cerr << "fail when the process generating a product dies" << endl ;
+        string died = "2f2f2f2f2f2f2f2f2f2f2f2f2f2f2f2f" ;
+        pid = start_slow( died, contents, SlowProducer::DIE ) ;
+        threw = false ;
+        try
+        {
+            fd = cache.get( died, producer, error ) ;
+        }
+        catch( BESError &e )
+        {
+            threw = true ;
+        }
+        CPPUNIT_ASSERT( threw ) ;
+        waitpid( pid, 0, 0 ) ;
+
+        cerr << "generate a product again after a process died" << endl ;
+        CPPUNIT_ASSERT( read_product( cache.get( died, producer, error ) ) == contents ) ;
+        CPPUNIT_ASSERT( producer.calls == 1 ) ;
+        CPPUNIT_ASSERT( count_files( died ) == 1 ) ;
+    }
+
+    void do_purge()
+    {
+        try
+        {
+            cerr << "remove the products read least recently" << endl ;
+            CedarCache cache( cache_dir, 2500 ) ;
+            string keys[3] = { "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa",
+                               "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb",
+                               "cccccccccccccccccccccccccccccccc" } ;
+            string error ;
+            TestProducer producer( string( 1000, 'p' ) ) ;
+            close( cache.get( keys[0], producer, error ) ) ;
+            close( cache.get( keys[1], producer, error ) ) ;
+            sleep( 1 ) ;
+            close( cache.open( keys[0] ) ) ;
+            sleep( 1 ) ;
+            close( cache.get( keys[2], producer, error ) ) ;
+
+            int fd = cache.open( keys[0] ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            close( fd ) ;
+            CPPUNIT_ASSERT( cache.open( keys[1] ) < 0 ) ;
+            fd = cache.open( keys[2] ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            close( fd ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to purge the cache" ) ;
+        }
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( cacheT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
@@ -0,0 +1,140 @@
+// compressB.cc
+
+// Measures the rate and ratio at which the text products are compressed
+// as they are written, a record sized piece at a time as the formatters
+// write them. With no arguments the flat, tab, csv and jsonl baselines of
+// the sample files are used.
+//
+// make compressB && ./compressB [file ...]
+
+#include <stdio.h>
+#include <sys/time.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+using std::cout ;
+using std::cerr ;
+using std::endl ;
+using std::ifstream ;
+using std::ostream ;
+using std::ostringstream ;
+using std::streambuf ;
+using std::string ;
+using std::vector ;
+
+#include "CedarCompressStream.h"
+#include "BESError.h"
+#include "test_config.h"
+
+// bytes handed to the stream at a time, about a record of flat output
+#define BENCH_PIECE 2048
+
+// times each file is compressed at each setting
+#define BENCH_REPEAT 20
+
+/** @brief counts and discards what is written to it
+ */
+class NullBuf : public streambuf
+{
+protected:
+    virtual int_type overflow( int_type c ) { return traits_type::not_eof( c ) ; }
+    virtual std::streamsize xsputn( const char *, std::streamsize n ) { return n ; }
+} ;
+
+static double
+now()
+{
+    struct timeval tv ;
+    gettimeofday( &tv, 0 ) ;
+    return tv.tv_sec + tv.tv_usec / 1e6 ;
+}
+
+static string
+read_file( const string &filename )
+{
+    ifstream in( filename.c_str() ) ;
+    ostringstream strm ;
+    strm << in.rdbuf() ;
+    return strm.str() ;
+}
+
+static void
+bench( const string &name, const string &text, const string &encoding,
+       int level )
+{
+    NullBuf null ;
+    ostream sink( &null ) ;
+    unsigned long long out = 0 ;
+    double start = now() ;
+    for( int r = 0; r < BENCH_REPEAT; r++ )
+    {
+	CedarCompressStream strm( sink, encoding, level, 4096, false ) ;
+	for( size_t i = 0; i < text.length(); i += BENCH_PIECE )
+	{
+	    strm.write( text.data() + i,
+			text.length() - i < BENCH_PIECE ? text.length() - i
+							: BENCH_PIECE ) ;
+	    strm.flush() ;
+	}
+	strm.finish() ;
+	out = strm.get_buf().get_out_bytes() ;
+    }
+    double secs = now() - start ;
+    double mbs = text.length() * (double)BENCH_REPEAT / secs / 1e6 ;
+    printf( "%-40s %-5s %3d %10lu %10llu %7.2f %9.1f\n", name.c_str(),
+	    encoding.c_str(), level, (unsigned long)text.length(), out,
+	    (double)text.length() / out, mbs ) ;
+}
+
+int
+main( int argc, char *argv[] )
+{
+    vector<string> files ;
+    for( int a = 1; a < argc; a++ )
+	files.push_back( argv[a] ) ;
+    if( files.empty() )
+    {
+	string dir = (string)TEST_SRC_DIR + "/../bes-testsuite/cedar/" ;
+	files.push_back( dir + "mfp920504a.flat.bescmd.baseline" ) ;
+	files.push_back( dir + "mfp920504a.tab.bescmd.baseline" ) ;
+	files.push_back( dir + "mfp920504a.csv.bescmd.baseline" ) ;
+	files.push_back( dir + "mfp920504a.jsonl.bescmd.baseline" ) ;
+	files.push_back( dir + "mlh090323g.tab.bescmd.baseline" ) ;
+    }
+
+    const char *encodings[] = { "gzip", "zstd" } ;
+    const int levels[] = { 1, 3, 6, 9 } ;
+    printf( "%-40s %-5s %3s %10s %10s %7s %9s\n", "file", "enc", "lvl",
+	    "bytes", "encoded", "ratio", "MB/s" ) ;
+    try
+    {
+	for( size_t f = 0; f < files.size(); f++ )
+	{
+	    string text = read_file( files[f] ) ;
+	    if( text.empty() )
+	    {
+		cerr << "Unable to read " << files[f] << endl ;
+		return 1 ;
+	    }
+	    string name = files[f].substr( files[f].rfind( '/' ) + 1 ) ;
+	    for( size_t e = 0; e < 2; e++ )
+	    {
+		if( !CedarCompressStream::is_supported( encodings[e] ) )
+		    continue ;
+		for( size_t l = 0; l < sizeof levels / sizeof levels[0]; l++ )
+		    bench( name, text, encodings[e], levels[l] ) ;
+	    }
+	}
+    }
+    catch( BESError &e )
+    {
+	cerr << e.get_message() << endl ;
+	return 1 ;
+    }
+    return 0 ;
+}
@@ -0,0 +1,273 @@
+// containersT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <unistd.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <sys/stat.h>
+
+#include <iostream>
+#include <fstream>
+#include <string>
+
+using std::cerr ;
+using std::endl ;
+using std::ofstream ;
+using std::string ;
+
+#include "CedarContainerMap.h"
+
+class containersT: public TestFixture {
+private:
+    string top ;
+    string cedar ;
+    string madrigal ;
+
+    void touch( const string &path )
+    {
+        ofstream strm( path.c_str() ) ;
+        strm << "x" ;
+    }
+
+public:
+    containersT() {}
+    ~containersT() {}
+
+    void setUp()
+    {
+        char dir[] = "/tmp/containersT.XXXXXX" ;
+        CPPUNIT_ASSERT( mkdtemp( dir ) ) ;
+        top = dir ;
+        cedar = top + "/cedar" ;
+        madrigal = top + "/madrigal" ;
+        mkdir( cedar.c_str(), 0755 ) ;
+        mkdir( madrigal.c_str(), 0755 ) ;
+        mkdir( ( cedar + "/sub" ).c_str(), 0755 ) ;
+        touch( cedar + "/a.cbf" ) ;
+        touch( cedar + "/b.txt" ) ;
+        touch( cedar + "/sub/c.cbf" ) ;
+        touch( madrigal + "/a.001" ) ;
+        touch( madrigal + "/d.001" ) ;
+        touch( madrigal + "/d.cbf" ) ;
+        touch( madrigal + "/e.cbf" ) ;
+    }
+
+    void tearDown()
+    {
+        string cmd = "rm -rf " + top ;
+        system( cmd.c_str() ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( containersT ) ;
+
+    CPPUNIT_TEST( do_find ) ;
+    CPPUNIT_TEST( do_changes ) ;
+    CPPUNIT_TEST( do_threads ) ;
+    CPPUNIT_TEST( do_layout ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_find()
+    {
+        CedarContainerMap containers( 60, 1 ) ;
+        containers.add_base( cedar, "cbf" ) ;
+        containers.add_base( madrigal, "001" ) ;
+        containers.add_base( madrigal, "cbf" ) ;
+        containers.add_base( "", "cbf" ) ;
+
+        cerr << "files by symbolic name, the first base directory first" << endl ;
+        string path ;
+        CPPUNIT_ASSERT( containers.find( "a", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/a.cbf" ) ;
+        CPPUNIT_ASSERT( containers.find( "d", path ) ) ;
+        CPPUNIT_ASSERT( path == madrigal + "/d.001" ) ;
+        CPPUNIT_ASSERT( containers.find( "e", path ) ) ;
+        CPPUNIT_ASSERT( path == madrigal + "/e.cbf" ) ;
+
+        cerr << "files below a base directory" << endl ;
+        CPPUNIT_ASSERT( containers.find( "sub/c", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/sub/c.cbf" ) ;
+
+        cerr << "files that are not there" << endl ;
+        CPPUNIT_ASSERT( !containers.find( "b", path ) ) ;
+        CPPUNIT_ASSERT( !containers.find( "c", path ) ) ;
+        CPPUNIT_ASSERT( !containers.find( "nosuchfile", path ) ) ;
+        CPPUNIT_ASSERT( containers.get_paths().size() == 4 ) ;
+
+        cerr << "a base directory that is not there" << endl ;
+        CedarContainerMap missing( 60, 1 ) ;
+        missing.add_base( top + "/nosuchdir", "cbf" ) ;
+        CPPUNIT_ASSERT( !missing.find( "a", path ) ) ;
+    }
+
+    void do_changes()
+    {
+        CedarContainerMap containers( 60, 1 ) ;
+        containers.add_base( cedar, "cbf" ) ;
+        containers.add_base( madrigal, "001" ) ;
+        string path ;
+        CPPUNIT_ASSERT( !containers.find( "f", path ) ) ;
+
+        touch( cedar + "/sub/f.cbf" ) ;
+        unlink( ( madrigal + "/d.001" ).c_str() ) ;
+        if( containers.is_watching() )
+        {
+            cerr << "changes seen as they are made" << endl ;
+            containers.check() ;
+        }
+        else
+        {
+            cerr << "changes found by scanning again" << endl ;
+            containers.scan() ;
+        }
+        CPPUNIT_ASSERT( containers.find( "sub/f", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/sub/f.cbf" ) ;
+        CPPUNIT_ASSERT( !containers.find( "d", path ) ) ;
+
+        cerr << "a new directory is looked in" << endl ;
+        mkdir( ( madrigal + "/new" ).c_str(), 0755 ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        touch( madrigal + "/new/g.001" ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        else
+            containers.scan() ;
+        CPPUNIT_ASSERT( containers.find( "new/g", path ) ) ;
+
+        cerr << "a directory removed" << endl ;
+        string cmd = "rm -rf " + cedar + "/sub" ;
+        system( cmd.c_str() ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        else
+            containers.scan() ;
+        CPPUNIT_ASSERT( !containers.find( "sub/c", path ) ) ;
+        CPPUNIT_ASSERT( !containers.find( "sub/f", path ) ) ;
+        CPPUNIT_ASSERT( containers.get_dir_count() == 3 ) ;
+
+        cerr << "a file hidden by another comes back when it goes" << endl ;
+        CPPUNIT_ASSERT( containers.find( "a", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/a.cbf" ) ;
+        unlink( ( cedar + "/a.cbf" ).c_str() ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        else
+            containers.scan() ;
+        CPPUNIT_ASSERT( containers.find( "a", path ) ) ;
+        CPPUNIT_ASSERT( path == madrigal + "/a.001" ) ;
+
+        cerr << "nothing changed" << endl ;
+        size_t files = containers.get_paths().size() ;
+        containers.check() ;
+        CPPUNIT_ASSERT( containers.get_paths().size() == files ) ;
+    }
+
+    void do_threads()
+    {
+        cerr << "directories read by several threads" << endl ;
+        for( int i = 0; i < 20; i++ )
+        {
+            char name[32] ;
+            snprintf( name, sizeof name, "/d%02d", i ) ;
+            string dir = cedar + name ;
+            mkdir( dir.c_str(), 0755 ) ;
+            mkdir( ( dir + "/deeper" ).c_str(), 0755 ) ;
+            touch( dir + "/x.cbf" ) ;
+            touch( dir + "/deeper/y.cbf" ) ;
+        }
+        CedarContainerMap one( 60, 1 ) ;
+        CedarContainerMap several( 60, 4 ) ;
+        one.add_base( cedar, "cbf" ) ;
+        several.add_base( cedar, "cbf" ) ;
+        one.add_base( madrigal, "001" ) ;
+        several.add_base( madrigal, "001" ) ;
+        one.scan() ;
+        several.scan() ;
+        // a, sub/c and d besides the new files
+        CPPUNIT_ASSERT( one.get_paths().size() == 3 + 40 ) ;
+        CPPUNIT_ASSERT( one.get_paths() == several.get_paths() ) ;
+        CPPUNIT_ASSERT( several.get_dir_count() == 2 + 1 + 40 ) ;
+        string path ;
+        CPPUNIT_ASSERT( several.find( "d07/deeper/y", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/d07/deeper/y.cbf" ) ;
+    }
+
+    void do_layout()
+    {
+        cerr << "expand layouts" << endl ;
+        string rel ;
+        CPPUNIT_ASSERT( CedarContainerMap::expand_layout( "%p/%Y/%n", "mfp920504a", rel ) ) ;
+        CPPUNIT_ASSERT( rel == "mfp/1992/mfp920504a" ) ;
+        CPPUNIT_ASSERT( CedarContainerMap::expand_layout( "%p/%Y/%m/%n", "mlh090323g", rel ) ) ;
+        CPPUNIT_ASSERT( rel == "mlh/2009/03/mlh090323g" ) ;
+        CPPUNIT_ASSERT( CedarContainerMap::expand_layout( "%y%%/%d-%n", "mfp920504a", rel ) ) ;
+        CPPUNIT_ASSERT( rel == "92%/04-mfp920504a" ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::expand_layout( "%p/%Y/%n", "notdated", rel ) ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::expand_layout( "%p/%n", "920504", rel ) ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::expand_layout( "%p/%n", "mfp/mfp920504a", rel ) ) ;
+
+        string error ;
+        CPPUNIT_ASSERT( CedarContainerMap::check_layout( "", error ) ) ;
+        CPPUNIT_ASSERT( CedarContainerMap::check_layout( "%p/%Y/%n", error ) ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::check_layout( "%p/%Y", error ) ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::check_layout( "%q/%n", error ) ) ;
+        CPPUNIT_ASSERT( !CedarContainerMap::check_layout( "%n%", error ) ) ;
+
+        cerr << "files found where the layout places them" << endl ;
+        string sharded = top + "/sharded" ;
+        mkdir( sharded.c_str(), 0755 ) ;
+        mkdir( ( sharded + "/mfp" ).c_str(), 0755 ) ;
+        mkdir( ( sharded + "/mfp/1992" ).c_str(), 0755 ) ;
+        touch( sharded + "/mfp/1992/mfp920504a.cbf" ) ;
+        touch( sharded + "/mfp/1992/a.cbf" ) ;
+        touch( sharded + "/mfp/mfp911104a.cbf" ) ;
+        CedarContainerMap containers( 60, 1 ) ;
+        containers.add_base( cedar, "cbf" ) ;
+        containers.add_base( sharded, "cbf", "%p/%Y/%n" ) ;
+        string path ;
+        CPPUNIT_ASSERT( containers.find( "mfp920504a", path ) ) ;
+        CPPUNIT_ASSERT( path == sharded + "/mfp/1992/mfp920504a.cbf" ) ;
+        CPPUNIT_ASSERT( containers.find( "mfp/1992/mfp920504a", path ) ) ;
+
+        cerr << "files out of the layout go by their path" << endl ;
+        CPPUNIT_ASSERT( !containers.find( "mfp911104a", path ) ) ;
+        CPPUNIT_ASSERT( containers.find( "mfp/mfp911104a", path ) ) ;
+
+        cerr << "base directories searched in order" << endl ;
+        CPPUNIT_ASSERT( containers.find( "a", path ) ) ;
+        CPPUNIT_ASSERT( path == cedar + "/a.cbf" ) ;
+        CPPUNIT_ASSERT( containers.find( "mfp/1992/a", path ) ) ;
+
+        cerr << "a file added where the layout places it" << endl ;
+        mkdir( ( sharded + "/mfp/1991" ).c_str(), 0755 ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        touch( sharded + "/mfp/1991/mfp911104a.cbf" ) ;
+        if( containers.is_watching() )
+            containers.check() ;
+        else
+            containers.scan() ;
+        CPPUNIT_ASSERT( containers.find( "mfp911104a", path ) ) ;
+        CPPUNIT_ASSERT( path == sharded + "/mfp/1991/mfp911104a.cbf" ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( containersT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
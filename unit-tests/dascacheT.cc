@@ -0,0 +1,169 @@
+// dascacheT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <stdio.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::string ;
+using std::vector ;
+
+#include "CedarDASCache.h"
+#include "CedarCatalog.h"
+#include "TheBESKeys.h"
+#include "test_config.h"
+
+class dascacheT: public TestFixture {
+private:
+    AttrTable *descriptor( const string &kinst )
+    {
+        AttrTable *at = new AttrTable() ;
+        AttrTable *t = at->append_container( "KINST" ) ;
+        t->append_attr( "KINST", "String", "\"" + kinst + "\"" ) ;
+        return at ;
+    }
+
+    void stamp( time_t t )
+    {
+        FILE *f = fopen( "./catalog.stamp", "w" ) ;
+        if( f ) fclose( f ) ;
+        struct utimbuf times ;
+        times.actime = t ;
+        times.modtime = t ;
+        utime( "./catalog.stamp", &times ) ;
+    }
+
+public:
+    dascacheT() {}
+    ~dascacheT() {}
+
+    void setUp()
+    {
+        TheBESKeys::ConfigFile = (string)TEST_SRC_DIR + "/bes.conf" ;
+        CedarDASCache::Clear() ;
+    }
+
+    void tearDown()
+    {
+        CedarDASCache::Clear() ;
+        unlink( "./catalog.stamp" ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( dascacheT ) ;
+
+    CPPUNIT_TEST( do_fragments ) ;
+    CPPUNIT_TEST( do_files ) ;
+    CPPUNIT_TEST( do_refresh ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_fragments()
+    {
+        vector<short int> jpars ;
+        vector<short int> mpars ;
+        jpars.push_back( 110 ) ;
+        mpars.push_back( 120 ) ;
+        mpars.push_back( -120 ) ;
+
+        cerr << "signatures of descriptors" << endl ;
+        string sig = CedarDASCache::get_signature( 5340, 7001, jpars, mpars ) ;
+        CPPUNIT_ASSERT( sig == CedarDASCache::get_signature( 5340, 7001, jpars, mpars ) ) ;
+        CPPUNIT_ASSERT( sig != CedarDASCache::get_signature( 5340, 17001, jpars, mpars ) ) ;
+        CPPUNIT_ASSERT( sig != CedarDASCache::get_signature( 31, 7001, jpars, mpars ) ) ;
+        CPPUNIT_ASSERT( sig != CedarDASCache::get_signature( 5340, 7001, mpars, jpars ) ) ;
+
+        cerr << "keep a descriptor" << endl ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) == 0 ) ;
+        const AttrTable *at = CedarDASCache::add_fragment( sig, descriptor( "5340" ) ) ;
+        CPPUNIT_ASSERT( at != 0 ) ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) == at ) ;
+        CPPUNIT_ASSERT( CedarDASCache::add_fragment( sig, descriptor( "5340" ) ) == at ) ;
+
+        cerr << "drop the descriptors when too many are kept" << endl ;
+        for( int kindat = 1; kindat < 4096; kindat++ )
+        {
+            string other = CedarDASCache::get_signature( 5340, kindat, jpars, mpars ) ;
+            CedarDASCache::add_fragment( other, descriptor( "5340" ) ) ;
+        }
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) != 0 ) ;
+        string last = CedarDASCache::get_signature( 31, 7001, jpars, mpars ) ;
+        at = CedarDASCache::add_fragment( last, descriptor( "31" ) ) ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( last ) == at ) ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) == 0 ) ;
+    }
+
+    void do_files()
+    {
+        vector<short int> pars ;
+        string sig1 = CedarDASCache::get_signature( 5340, 7001, pars, pars ) ;
+        string sig2 = CedarDASCache::get_signature( 5340, 17001, pars, pars ) ;
+        vector<string> names ;
+        names.push_back( "Data_Descriptor_for_KINDAT_7001_KINST_5340" ) ;
+        names.push_back( "Data_Descriptor_for_KINDAT_17001_KINST_5340" ) ;
+        vector<string> sigs ;
+        sigs.push_back( sig1 ) ;
+        sigs.push_back( sig2 ) ;
+
+        cerr << "keep the DAS of a file" << endl ;
+        CedarDASCache::add_fragment( sig1, descriptor( "5340" ) ) ;
+        CedarDASCache::add_fragment( sig2, descriptor( "5340" ) ) ;
+        CedarDASCache::add_das( "file", names, sigs ) ;
+        DAS das ;
+        CPPUNIT_ASSERT( CedarDASCache::get_das( das, "file" ) ) ;
+        CPPUNIT_ASSERT( das.get_table( names[0] ) != 0 ) ;
+        CPPUNIT_ASSERT( das.get_table( names[1] ) != 0 ) ;
+        DAS other ;
+        CPPUNIT_ASSERT( !CedarDASCache::get_das( other, "other file" ) ) ;
+        CPPUNIT_ASSERT( !CedarDASCache::get_das( other, "" ) ) ;
+
+        cerr << "drop the DAS of files" << endl ;
+        CedarDASCache::Clear() ;
+        DAS cleared ;
+        CPPUNIT_ASSERT( !CedarDASCache::get_das( cleared, "file" ) ) ;
+    }
+
+    void do_refresh()
+    {
+        vector<short int> pars ;
+        string sig = CedarDASCache::get_signature( 31, 3410, pars, pars ) ;
+        CedarCatalog::add_refresh( CedarDASCache::Clear ) ;
+
+        cerr << "keep descriptors while the catalog is unchanged" << endl ;
+        stamp( 1000000 ) ;
+        time_t generation = CedarCatalog::get_generation() ;
+        CPPUNIT_ASSERT( generation == 1000000 ) ;
+        CedarDASCache::add_fragment( sig, descriptor( "31" ) ) ;
+        CPPUNIT_ASSERT( CedarCatalog::get_generation() == generation ) ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) != 0 ) ;
+
+        cerr << "drop descriptors when the catalog is refreshed" << endl ;
+        stamp( 2000000 ) ;
+        CPPUNIT_ASSERT( CedarCatalog::get_generation() == 2000000 ) ;
+        CPPUNIT_ASSERT( CedarDASCache::get_fragment( sig ) == 0 ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( dascacheT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
@@ -0,0 +1,224 @@
+// filecacheT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using std::cerr ;
+using std::endl ;
+using std::ifstream ;
+using std::ofstream ;
+using std::ostringstream ;
+using std::string ;
+
+#include "CedarFileCache.h"
+
+class filecacheT: public TestFixture {
+private:
+    string top ;
+    string origin ;
+    string cache ;
+
+    void write( const string &path, const string &contents, time_t mtime )
+    {
+        {
+            ofstream strm( path.c_str() ) ;
+            strm << contents ;
+        }
+        struct utimbuf times ;
+        times.actime = mtime ;
+        times.modtime = mtime ;
+        utime( path.c_str(), &times ) ;
+    }
+
+    string read( const string &path )
+    {
+        ifstream strm( path.c_str() ) ;
+        ostringstream contents ;
+        contents << strm.rdbuf() ;
+        return contents.str() ;
+    }
+
+    bool exists( const string &path )
+    {
+        struct stat st ;
+        return stat( path.c_str(), &st ) == 0 ;
+    }
+
+    // wait for the copy made in the background
+    bool wait_for( const string &path )
+    {
+        for( int i = 0; i < 200; i++ )
+        {
+            if( exists( path ) )
+                return true ;
+            usleep( 25000 ) ;
+        }
+        return false ;
+    }
+
+    void set_used( const string &path, time_t when )
+    {
+        struct stat st ;
+        stat( path.c_str(), &st ) ;
+        struct utimbuf times ;
+        times.actime = when ;
+        times.modtime = st.st_mtime ;
+        utime( path.c_str(), &times ) ;
+    }
+
+public:
+    filecacheT() {}
+    ~filecacheT() {}
+
+    void setUp()
+    {
+        char dir[] = "/tmp/filecacheT.XXXXXX" ;
+        CPPUNIT_ASSERT( mkdtemp( dir ) ) ;
+        top = dir ;
+        origin = top + "/origin" ;
+        cache = top + "/cache" ;
+        mkdir( origin.c_str(), 0755 ) ;
+        mkdir( cache.c_str(), 0755 ) ;
+    }
+
+    void tearDown()
+    {
+        string cmd = "rm -rf " + top ;
+        system( cmd.c_str() ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( filecacheT ) ;
+
+    CPPUNIT_TEST( do_copy ) ;
+    CPPUNIT_TEST( do_validate ) ;
+    CPPUNIT_TEST( do_purge ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_copy()
+    {
+        CedarFileCache files( cache, 1024 * 1024, 60 ) ;
+        string file = origin + "/a.cbf" ;
+        write( file, "the records of a", 1000000000 ) ;
+        string copy = files.get_path( file ) ;
+        CPPUNIT_ASSERT( copy == cache + file ) ;
+
+        cerr << "the original read while it is copied" << endl ;
+        CPPUNIT_ASSERT( files.get( file ) == file ) ;
+        CPPUNIT_ASSERT( wait_for( copy ) ) ;
+
+        cerr << "the copy read once it is made" << endl ;
+        CPPUNIT_ASSERT( files.get( file ) == copy ) ;
+        CPPUNIT_ASSERT( read( copy ) == "the records of a" ) ;
+        struct stat st ;
+        CPPUNIT_ASSERT( stat( copy.c_str(), &st ) == 0 ) ;
+        CPPUNIT_ASSERT( st.st_mtime == 1000000000 ) ;
+        CPPUNIT_ASSERT( !exists( copy + ".part" ) ) ;
+
+        cerr << "the original not looked at until validated again" << endl ;
+        unlink( file.c_str() ) ;
+        CPPUNIT_ASSERT( files.get( file ) == copy ) ;
+
+        cerr << "a file not there is not copied" << endl ;
+        string missing = origin + "/nosuchfile.cbf" ;
+        CPPUNIT_ASSERT( files.get( missing ) == missing ) ;
+        CPPUNIT_ASSERT( !files.copy( missing ) ) ;
+        CPPUNIT_ASSERT( !exists( files.get_path( missing ) ) ) ;
+
+        cerr << "a file larger than the cache is not copied" << endl ;
+        CedarFileCache small( cache, 4, 60 ) ;
+        string large = origin + "/b.cbf" ;
+        write( large, "the records of b", 1000000000 ) ;
+        CPPUNIT_ASSERT( !small.copy( large ) ) ;
+        CPPUNIT_ASSERT( small.get( large ) == large ) ;
+    }
+
+    void do_validate()
+    {
+        CedarFileCache files( cache, 1024 * 1024, 0 ) ;
+        string file = origin + "/a.cbf" ;
+        write( file, "the records of a", 1000000000 ) ;
+        string copy = files.get_path( file ) ;
+        CPPUNIT_ASSERT( files.copy( file ) ) ;
+        CPPUNIT_ASSERT( files.get( file ) == copy ) ;
+
+        cerr << "a changed original is read and copied again" << endl ;
+        write( file, "the new records of a", 1000000100 ) ;
+        CPPUNIT_ASSERT( files.get( file ) == file ) ;
+        CPPUNIT_ASSERT( wait_for( copy ) ) ;
+        CPPUNIT_ASSERT( files.get( file ) == copy ) ;
+        CPPUNIT_ASSERT( read( copy ) == "the new records of a" ) ;
+
+        cerr << "a removed original removes the copy" << endl ;
+        unlink( file.c_str() ) ;
+        CPPUNIT_ASSERT( files.get( file ) == file ) ;
+        CPPUNIT_ASSERT( !exists( copy ) ) ;
+
+        cerr << "a copy left unfinished is made again" << endl ;
+        write( file, "the records of a", 1000000000 ) ;
+        write( copy + ".part", "the rec", 1000000000 ) ;
+        CPPUNIT_ASSERT( !files.copy( file ) ) ;
+        CPPUNIT_ASSERT( !exists( copy + ".part" ) ) ;
+        CPPUNIT_ASSERT( files.copy( file ) ) ;
+        CPPUNIT_ASSERT( read( copy ) == "the records of a" ) ;
+    }
+
+    void do_purge()
+    {
+        cerr << "the copies read least recently removed" << endl ;
+        string data( 1000, 'x' ) ;
+        CedarFileCache files( cache, 2500, 60 ) ;
+        string a = origin + "/a.cbf" ;
+        string b = origin + "/sub/b.cbf" ;
+        string c = origin + "/c.cbf" ;
+        mkdir( ( origin + "/sub" ).c_str(), 0755 ) ;
+        write( a, data, 1000000000 ) ;
+        write( b, data, 1000000000 ) ;
+        write( c, data, 1000000000 ) ;
+        CPPUNIT_ASSERT( files.copy( a ) ) ;
+        CPPUNIT_ASSERT( files.copy( b ) ) ;
+        time_t now = time( 0 ) ;
+        set_used( files.get_path( a ), now - 200 ) ;
+        set_used( files.get_path( b ), now - 100 ) ;
+        CPPUNIT_ASSERT( files.get( a ) == files.get_path( a ) ) ;
+        CPPUNIT_ASSERT( files.copy( c ) ) ;
+        CPPUNIT_ASSERT( exists( files.get_path( a ) ) ) ;
+        CPPUNIT_ASSERT( !exists( files.get_path( b ) ) ) ;
+        CPPUNIT_ASSERT( exists( files.get_path( c ) ) ) ;
+
+        cerr << "a removed copy is made again" << endl ;
+        set_used( files.get_path( a ), now - 50 ) ;
+        set_used( files.get_path( c ), now - 40 ) ;
+        CPPUNIT_ASSERT( files.get( b ) == b ) ;
+        CPPUNIT_ASSERT( wait_for( files.get_path( b ) ) ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( filecacheT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
@@ -0,0 +1,430 @@
+// inputT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::ifstream ;
+using std::ofstream ;
+using std::ostringstream ;
+using std::string ;
+using std::vector ;
+
+#include "BESError.h"
+#include "CedarInputFile.h"
+#include "CedarRawFile.h"
+#include "test_config.h"
+
+class inputT: public TestFixture {
+private:
+    string data_dir ;
+    string top ;
+
+    string contents( const string &path )
+    {
+        ifstream strm( path.c_str(), std::ios::binary ) ;
+        ostringstream all ;
+        all << strm.rdbuf() ;
+        return all.str() ;
+    }
+
+    // the logical records of the file, as they are read from the start
+    vector<string> records( const string &path )
+    {
+        vector<string> all ;
+        CedarRawFile raw( path ) ;
+        CedarRawRecord rec ;
+        while( raw.next_record( rec ) )
+            all.push_back( string( rec.get_bytes(), rec.get_size() ) ) ;
+        return all ;
+    }
+
+#ifdef HAVE_LIBZ
+    // gzip the data as members of at most member bytes each
+    void gzip( const string &data, const string &path, size_t member )
+    {
+        ofstream strm( path.c_str(), std::ios::binary ) ;
+        for( size_t start = 0; start < data.size(); start += member )
+        {
+            size_t len = data.size() - start ;
+            if( len > member )
+                len = member ;
+            z_stream z ;
+            memset( &z, 0, sizeof z ) ;
+            CPPUNIT_ASSERT( deflateInit2( &z, 6, Z_DEFLATED, 15 + 16, 8,
+                                          Z_DEFAULT_STRATEGY ) == Z_OK ) ;
+            vector<char> out( deflateBound( &z, len ) + 64 ) ;
+            z.next_in = (Bytef *)&data[start] ;
+            z.avail_in = len ;
+            z.next_out = (Bytef *)&out[0] ;
+            z.avail_out = out.size() ;
+            CPPUNIT_ASSERT( deflate( &z, Z_FINISH ) == Z_STREAM_END ) ;
+            strm.write( &out[0], out.size() - z.avail_out ) ;
+            deflateEnd( &z ) ;
+        }
+    }
+#endif
+
+#ifdef HAVE_ZSTD
+    // zstd the data as frames of at most frame bytes each
+    void zstd( const string &data, const string &path, size_t frame )
+    {
+        ofstream strm( path.c_str(), std::ios::binary ) ;
+        for( size_t start = 0; start < data.size(); start += frame )
+        {
+            size_t len = data.size() - start ;
+            if( len > frame )
+                len = frame ;
+            vector<char> out( ZSTD_compressBound( len ) ) ;
+            size_t made = ZSTD_compress( &out[0], out.size(), &data[start],
+                                         len, 3 ) ;
+            CPPUNIT_ASSERT( !ZSTD_isError( made ) ) ;
+            strm.write( &out[0], made ) ;
+        }
+    }
+#endif
+
+    // the file and its compressed copies
+    vector<string> copies( const string &name )
+    {
+        vector<string> paths ;
+        string path = data_dir + "/" + name ;
+        paths.push_back( path ) ;
+#if defined( HAVE_LIBZ ) || defined( HAVE_ZSTD )
+        string data = contents( path ) ;
+#endif
+#ifdef HAVE_LIBZ
+        gzip( data, top + "/" + name + ".gz", data.size() ) ;
+        paths.push_back( top + "/" + name + ".gz" ) ;
+        gzip( data, top + "/" + name + ".2.gz", 50000 ) ;
+        paths.push_back( top + "/" + name + ".2.gz" ) ;
+#endif
+#ifdef HAVE_ZSTD
+        zstd( data, top + "/" + name + ".zst", 16384 ) ;
+        paths.push_back( top + "/" + name + ".zst" ) ;
+#endif
+        return paths ;
+    }
+
+public:
+    inputT() {}
+    ~inputT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+        char dir[] = "/tmp/inputT.XXXXXX" ;
+        CPPUNIT_ASSERT( mkdtemp( dir ) ) ;
+        top = dir ;
+    }
+
+    void tearDown()
+    {
+        string cmd = "rm -rf " + top ;
+        system( cmd.c_str() ) ;
+        CedarSeekTable::Clear() ;
+    }
+
+    CPPUNIT_TEST_SUITE( inputT ) ;
+
+    CPPUNIT_TEST( do_names ) ;
+    CPPUNIT_TEST( do_read ) ;
+    CPPUNIT_TEST( do_input_seek ) ;
+    CPPUNIT_TEST( do_record_seek ) ;
+    CPPUNIT_TEST( do_read_ahead ) ;
+    CPPUNIT_TEST( do_plain ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_names()
+    {
+        cerr << "compressed files by name" << endl ;
+        CPPUNIT_ASSERT( CedarInputFile::strip( "a/mfp920504a.cbf.gz" )
+                        == "a/mfp920504a.cbf" ) ;
+        CPPUNIT_ASSERT( CedarInputFile::strip( "mlh090323g.001.zst" )
+                        == "mlh090323g.001" ) ;
+        CPPUNIT_ASSERT( CedarInputFile::strip( "mfp920504a.cbf" )
+                        == "mfp920504a.cbf" ) ;
+        CPPUNIT_ASSERT( CedarInputFile::is_compressed( "x.cbf.gz" ) ) ;
+        CPPUNIT_ASSERT( !CedarInputFile::is_compressed( "x.cbf" ) ) ;
+        CPPUNIT_ASSERT( !CedarInputFile::is_compressed( "x.gzip" ) ) ;
+    }
+
+    void do_read()
+    {
+        const char *names[] = { "mfp911104a.cbf", "mlh090323g.001" } ;
+        for( int n = 0; n < 2; n++ )
+        {
+            vector<string> paths = copies( names[n] ) ;
+            vector<string> expected = records( paths[0] ) ;
+            CPPUNIT_ASSERT( !expected.empty() ) ;
+            for( size_t p = 1; p < paths.size(); p++ )
+            {
+                cerr << "records of " << paths[p] << endl ;
+                CedarInputFile in( paths[p] ) ;
+                CPPUNIT_ASSERT( in.get_compression()
+                                != CedarInputFile::PLAIN ) ;
+                CPPUNIT_ASSERT( records( paths[p] ) == expected ) ;
+            }
+        }
+
+        cerr << "a truncated file" << endl ;
+#ifdef HAVE_LIBZ
+        string data = contents( data_dir + "/mfp920504a.cbf" ) ;
+        string gz = top + "/mfp920504a.cbf.gz" ;
+        gzip( data, gz, data.size() ) ;
+        string part = contents( gz ) ;
+        part.resize( part.size() / 2 ) ;
+        {
+            ofstream strm( gz.c_str(), std::ios::binary ) ;
+            strm << part ;
+        }
+        bool failed = false ;
+        try
+        {
+            records( gz ) ;
+        }
+        catch( BESError &e )
+        {
+            failed = true ;
+        }
+        CPPUNIT_ASSERT( failed ) ;
+#endif
+    }
+
+    void do_input_seek()
+    {
+        vector<string> paths = copies( "mfp911104a.cbf" ) ;
+        string data = contents( paths[0] ) ;
+        for( size_t p = 0; p < paths.size(); p++ )
+        {
+            cerr << "checkpoints of " << paths[p] << endl ;
+            vector<CedarInputFile::Point> points ;
+            {
+                CedarInputFile in( paths[p] ) ;
+                in.record( &points, 16384 ) ;
+                vector<char> all( data.size() + 10 ) ;
+                CPPUNIT_ASSERT( in.read( &all[0], all.size() )
+                                == data.size() ) ;
+                CPPUNIT_ASSERT( memcmp( &all[0], data.data(),
+                                        data.size() ) == 0 ) ;
+            }
+            if( p > 0 )
+                CPPUNIT_ASSERT( points.size() > 4 ) ;
+
+            cerr << "read from offsets of " << paths[p] << endl ;
+            unsigned long long offsets[] = { 300000, 5, 123457, 339000 } ;
+            CedarInputFile in( paths[p] ) ;
+            for( int o = 0; o < 4; o++ )
+            {
+                char buf[900] ;
+                in.seek( offsets[o], points ) ;
+                CPPUNIT_ASSERT( in.tell() == offsets[o] ) ;
+                size_t want = data.size() - offsets[o] ;
+                if( want > sizeof buf )
+                    want = sizeof buf ;
+                CPPUNIT_ASSERT( in.read( buf, sizeof buf ) == want ) ;
+                CPPUNIT_ASSERT( memcmp( buf, data.data() + offsets[o],
+                                        want ) == 0 ) ;
+            }
+        }
+    }
+
+    void do_record_seek()
+    {
+        const char *names[] = { "mfp911104a.cbf", "mlh090323g.001" } ;
+        for( int n = 0; n < 2; n++ )
+        {
+            vector<string> paths = copies( names[n] ) ;
+            vector<string> expected = records( paths[0] ) ;
+            for( size_t p = 0; p < paths.size(); p++ )
+            {
+                cerr << "seek table of " << paths[p] << endl ;
+                CedarSeekTable table( 8192, 16384 ) ;
+                {
+                    CedarRawFile raw( paths[p] ) ;
+                    raw.record( &table ) ;
+                    CedarRawRecord rec ;
+                    while( raw.next_record( rec ) ) ;
+                }
+                CPPUNIT_ASSERT( table.points.size() > 4 ) ;
+
+                cerr << "records read from the middle of " << paths[p]
+                     << endl ;
+                unsigned long last = expected.size() - 1 ;
+                unsigned long ordinals[] = { 0, last / 3, last / 2, last } ;
+                CedarRawFile raw( paths[p] ) ;
+                for( int o = 0; o < 4; o++ )
+                {
+                    bool jumped = raw.seek( table, ordinals[o] ) ;
+                    CPPUNIT_ASSERT( jumped == ( o > 0 ) ) ;
+                    CedarRawRecord rec ;
+                    unsigned long skipped = 0 ;
+                    do
+                    {
+                        CPPUNIT_ASSERT( raw.next_record( rec ) ) ;
+                        skipped++ ;
+                    } while( rec.get_ordinal() < ordinals[o] ) ;
+                    CPPUNIT_ASSERT( rec.get_ordinal() == ordinals[o] ) ;
+                    CPPUNIT_ASSERT( string( rec.get_bytes(), rec.get_size() )
+                                    == expected[ordinals[o]] ) ;
+                    if( jumped )
+                        CPPUNIT_ASSERT( skipped < last / 4 ) ;
+                }
+                CedarRawRecord rec ;
+                CPPUNIT_ASSERT( !raw.next_record( rec ) ) ;
+            }
+        }
+    }
+
+    void do_read_ahead()
+    {
+        const char *names[] = { "mfp911104a.cbf", "mlh090323g.001" } ;
+        for( int n = 0; n < 2; n++ )
+        {
+            vector<string> paths = copies( names[n] ) ;
+            vector<string> expected = records( paths[0] ) ;
+            for( size_t p = 0; p < paths.size(); p++ )
+            {
+                cerr << "records of " << paths[p] << " read ahead" << endl ;
+                CedarSeekTable table( 8192, 16384 ) ;
+                {
+                    CedarRawFile raw( paths[p] ) ;
+                    raw.record( &table ) ;
+                    raw.read_ahead( 2 ) ;
+                    CedarRawRecord rec ;
+                    vector<string> got ;
+                    while( raw.next_record( rec ) )
+                        got.push_back( string( rec.get_bytes(),
+                                               rec.get_size() ) ) ;
+                    raw.read_ahead( 0 ) ;
+                    CPPUNIT_ASSERT( got == expected ) ;
+                }
+                CPPUNIT_ASSERT( table.points.size() > 4 ) ;
+
+                cerr << "seeks while reading ahead" << endl ;
+                unsigned long last = expected.size() - 1 ;
+                unsigned long ordinals[] = { 1, last / 3, last / 3 + 1,
+                                             last / 2, last } ;
+                CedarRawFile raw( paths[p] ) ;
+                raw.read_ahead( 2 ) ;
+                for( int o = 0; o < 5; o++ )
+                {
+                    raw.seek( table, ordinals[o] ) ;
+                    CedarRawRecord rec ;
+                    do
+                    {
+                        CPPUNIT_ASSERT( raw.next_record( rec ) ) ;
+                    } while( rec.get_ordinal() < ordinals[o] ) ;
+                    CPPUNIT_ASSERT( string( rec.get_bytes(), rec.get_size() )
+                                    == expected[ordinals[o]] ) ;
+                }
+
+                cerr << "read on once reading ahead stops" << endl ;
+                CedarRawFile part( paths[p] ) ;
+                part.read_ahead( 2 ) ;
+                CedarRawRecord rec ;
+                for( unsigned long r = 0; r < last / 2; r++ )
+                    CPPUNIT_ASSERT( part.next_record( rec ) ) ;
+                part.read_ahead( 0 ) ;
+                for( unsigned long r = last / 2; r <= last; r++ )
+                {
+                    CPPUNIT_ASSERT( part.next_record( rec ) ) ;
+                    CPPUNIT_ASSERT( string( rec.get_bytes(), rec.get_size() )
+                                    == expected[r] ) ;
+                }
+                CPPUNIT_ASSERT( !part.next_record( rec ) ) ;
+            }
+        }
+    }
+
+    void do_plain()
+    {
+        cerr << "a plain file is used where it is" << endl ;
+        string path = data_dir + "/mfp920504a.cbf" ;
+        {
+            CedarPlainFile plain( path ) ;
+            CPPUNIT_ASSERT( plain.get_path() == path ) ;
+        }
+
+#ifdef HAVE_LIBZ
+        cerr << "a compressed file is decompressed to scratch" << endl ;
+        string data = contents( path ) ;
+        string gz = top + "/mfp920504a.cbf.gz" ;
+        gzip( data, gz, data.size() ) ;
+        string scratch ;
+        string copy ;
+        {
+            CedarPlainFile plain( gz ) ;
+            scratch = plain.get_path() ;
+            copy = plain.get_copy() ;
+            CPPUNIT_ASSERT( scratch != gz ) ;
+            CPPUNIT_ASSERT( !copy.empty() ) ;
+            CPPUNIT_ASSERT( contents( scratch ) == data ) ;
+
+            cerr << "and a second request reads the same copy" << endl ;
+            CedarPlainFile again( gz ) ;
+            CPPUNIT_ASSERT( again.get_copy() == copy ) ;
+            CPPUNIT_ASSERT( again.get_path() != scratch ) ;
+            struct stat first ;
+            struct stat second ;
+            CPPUNIT_ASSERT( stat( scratch.c_str(), &first ) == 0 ) ;
+            CPPUNIT_ASSERT( stat( again.get_path().c_str(), &second ) == 0 ) ;
+            CPPUNIT_ASSERT( first.st_ino == second.st_ino ) ;
+            scratch = again.get_path() ;
+        }
+        CPPUNIT_ASSERT( access( scratch.c_str(), F_OK ) != 0 ) ;
+
+        cerr << "the copy is kept for the requests after" << endl ;
+        CPPUNIT_ASSERT( contents( copy ) == data ) ;
+        unlink( copy.c_str() ) ;
+
+        cerr << "the checkpoints are recorded as the copy is made" << endl ;
+        vector<CedarInputFile::Point> points ;
+        {
+            CedarPlainFile plain( gz, &points, 16384 ) ;
+            CPPUNIT_ASSERT( contents( plain.get_path() ) == data ) ;
+            copy = plain.get_copy() ;
+        }
+        unlink( copy.c_str() ) ;
+        CPPUNIT_ASSERT( points.size() > 1 ) ;
+        CedarInputFile in( gz ) ;
+        unsigned long long at = points.back().out + 100 ;
+        CPPUNIT_ASSERT( at + 64 < data.size() ) ;
+        in.seek( at, points ) ;
+        char buf[64] ;
+        CPPUNIT_ASSERT( in.read( buf, sizeof buf ) == sizeof buf ) ;
+        CPPUNIT_ASSERT( string( buf, sizeof buf ) == data.substr( at, 64 ) ) ;
+#endif
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( inputT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
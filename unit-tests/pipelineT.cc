@@ -0,0 +1,509 @@
+// pipelineT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <pthread.h>
+#include <unistd.h>
+#include <stdio.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::ostringstream ;
+using std::string ;
+using std::vector ;
+
+#include "CedarPipeline.h"
+#include "CedarStageQueue.h"
+#include "CedarRecordReader.h"
+#include "CedarRecordSelection.h"
+#include "CedarRawFile.h"
+#include "BESInternalError.h"
+#include "test_config.h"
+
+// formats a line for each record, numbered in the order the records are
+// marked, and writes it to a string
+class TestReader : public CedarRecordReader
+{
+public:
+    string		buf ;
+    string		written ;
+    unsigned long	formatted ;
+    unsigned long	done_after ;
+    unsigned long	fail_at ;
+    bool		fail_write ;
+    useconds_t		slow ;
+    useconds_t		slow_format ;
+    bool		pooled ;
+    int			marked ;
+    pthread_t		request ;
+    bool		mark_apart ;
+    bool		format_apart ;
+    bool		write_apart ;
+    vector<pthread_t>	formatters ;
+    pthread_mutex_t	lock ;
+
+			TestReader()
+			    : formatted( 0 ),
+			      done_after( 0 ),
+			      fail_at( 0 ),
+			      fail_write( false ),
+			      slow( 0 ),
+			      slow_format( 0 ),
+			      pooled( false ),
+			      marked( 0 ),
+			      request( pthread_self() ),
+			      mark_apart( false ),
+			      format_apart( false ),
+			      write_apart( false )
+			{
+			    pthread_mutex_init( &lock, 0 ) ;
+			}
+    virtual		~TestReader()
+			{
+			    pthread_mutex_destroy( &lock ) ;
+			}
+
+    virtual void	data_record( const CedarRawRecord &rec,
+				     const CedarRecordSelection &sel )
+			{
+			    format_record( rec, sel, mark_record( rec, sel ),
+					   buf ) ;
+			    output( buf ) ;
+			}
+    virtual CedarRecordReader *make_worker() const ;
+    virtual int		mark_record( const CedarRawRecord &,
+				     const CedarRecordSelection & )
+			{
+			    if( !pthread_equal( pthread_self(), request ) )
+				mark_apart = true ;
+			    return marked++ ;
+			}
+    virtual void	format_record( const CedarRawRecord &rec,
+				       const CedarRecordSelection &,
+				       int mark, string &out )
+			{
+			    pthread_mutex_lock( &lock ) ;
+			    pthread_t self = pthread_self() ;
+			    if( !pthread_equal( self, request ) )
+				format_apart = true ;
+			    size_t f = 0 ;
+			    while( f < formatters.size()
+				   && !pthread_equal( formatters[f], self ) )
+				f++ ;
+			    if( f == formatters.size() )
+				formatters.push_back( self ) ;
+			    bool failed = ( ++formatted == fail_at ) ;
+			    pthread_mutex_unlock( &lock ) ;
+			    if( failed )
+				throw BESInternalError( "format failed",
+							__FILE__, __LINE__ ) ;
+			    if( slow_format )
+				usleep( slow_format ) ;
+			    char line[64] ;
+			    sprintf( line, "%d %lu %lu %d\n", mark,
+				     rec.get_ordinal(),
+				     (unsigned long)rec.get_size(),
+				     rec.get_kinst() ) ;
+			    out += line ;
+			}
+    virtual void	write( const string &data )
+			{
+			    if( !pthread_equal( pthread_self(), request ) )
+				write_apart = true ;
+			    if( fail_write )
+				throw BESInternalError( "write failed",
+							__FILE__, __LINE__ ) ;
+			    if( slow )
+				usleep( slow ) ;
+			    written += data ;
+			}
+    virtual bool	is_done() const
+			{
+			    return done_after && formatted >= done_after ;
+			}
+} ;
+
+// formats the records of a TestReader on a worker of the pipeline
+class TestWorker : public CedarRecordReader
+{
+public:
+    TestReader &	reader ;
+
+			TestWorker( TestReader &r ) : reader( r ) {}
+
+    virtual void	data_record( const CedarRawRecord &,
+				     const CedarRecordSelection & ) {}
+    virtual void	format_record( const CedarRawRecord &rec,
+				       const CedarRecordSelection &sel,
+				       int mark, string &out )
+			{
+			    reader.format_record( rec, sel, mark, out ) ;
+			}
+} ;
+
+CedarRecordReader *
+TestReader::make_worker() const
+{
+    return pooled ? new TestWorker( const_cast<TestReader &>( *this ) ) : 0 ;
+}
+
+// puts the numbers 0 to count - 1, noting how many were put
+class Producer
+{
+public:
+    CedarStageQueue<string> &	queue ;
+    int				count ;
+    int				put ;
+    pthread_mutex_t		lock ;
+
+				Producer( CedarStageQueue<string> &q,
+					  int c )
+				    : queue( q ), count( c ), put( 0 )
+				{
+				    pthread_mutex_init( &lock, 0 ) ;
+				}
+				~Producer()
+				{
+				    pthread_mutex_destroy( &lock ) ;
+				}
+    int				get_put()
+				{
+				    pthread_mutex_lock( &lock ) ;
+				    int p = put ;
+				    pthread_mutex_unlock( &lock ) ;
+				    return p ;
+				}
+    static void *		run( void *arg )
+				{
+				    Producer *p = (Producer *)arg ;
+				    for( int i = 0; i < p->count; i++ )
+				    {
+					ostringstream strm ;
+					strm << i ;
+					string item = strm.str() ;
+					if( !p->queue.put( item ) )
+					    break ;
+					pthread_mutex_lock( &p->lock ) ;
+					p->put++ ;
+					pthread_mutex_unlock( &p->lock ) ;
+				    }
+				    p->queue.close() ;
+				    return 0 ;
+				}
+} ;
+
+class pipelineT: public TestFixture {
+private:
+    vector<CedarRawRecord> records ;
+    CedarRecordSelection sel ;
+
+    // every record of the file handed to reader, as the request does
+    void deliver( TestReader &reader )
+    {
+        for( size_t r = 0; r < records.size() && !reader.is_stopped(); r++ )
+            reader.deliver( records[r], sel ) ;
+    }
+
+    string expected()
+    {
+        TestReader sync ;
+        CedarPipeline stages( sync, 0 ) ;
+        CPPUNIT_ASSERT( !stages.is_running() ) ;
+        deliver( sync ) ;
+        stages.finish() ;
+        CPPUNIT_ASSERT( !sync.format_apart ) ;
+        CPPUNIT_ASSERT( !sync.write_apart ) ;
+        CPPUNIT_ASSERT( sync.formatted == records.size() ) ;
+        return sync.written ;
+    }
+
+public:
+    pipelineT() {}
+    ~pipelineT() {}
+
+    void setUp()
+    {
+        string path = (string)TEST_SRC_DIR + "/../data/mfp911104a.cbf" ;
+        CedarRawFile raw( path ) ;
+        CedarRawRecord rec ;
+        records.clear() ;
+        while( raw.next_record( rec ) )
+            records.push_back( rec ) ;
+        CPPUNIT_ASSERT( records.size() > 100 ) ;
+    }
+
+    void tearDown()
+    {
+    }
+
+    CPPUNIT_TEST_SUITE( pipelineT ) ;
+
+    CPPUNIT_TEST( do_queue ) ;
+    CPPUNIT_TEST( do_order ) ;
+    CPPUNIT_TEST( do_done ) ;
+    CPPUNIT_TEST( do_fail ) ;
+    CPPUNIT_TEST( do_pool ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_queue()
+    {
+        cerr << "items handed on in order, a bounded number ahead" << endl ;
+        CedarStageQueue<string> queue( 3 ) ;
+        Producer producer( queue, 1000 ) ;
+        pthread_t t ;
+        CPPUNIT_ASSERT( pthread_create( &t, 0, Producer::run, &producer )
+                        == 0 ) ;
+        string item ;
+        int got = 0 ;
+        while( queue.get( item ) )
+        {
+            ostringstream strm ;
+            strm << got ;
+            CPPUNIT_ASSERT( item == strm.str() ) ;
+            got++ ;
+            if( got % 100 == 0 )
+            {
+                usleep( 20000 ) ;
+                CPPUNIT_ASSERT( producer.get_put() <= got + 3 ) ;
+            }
+        }
+        pthread_join( t, 0 ) ;
+        CPPUNIT_ASSERT( got == 1000 ) ;
+
+        cerr << "a stopped queue takes no more" << endl ;
+        CedarStageQueue<string> stopped( 3 ) ;
+        Producer held( stopped, 1000 ) ;
+        CPPUNIT_ASSERT( pthread_create( &t, 0, Producer::run, &held ) == 0 ) ;
+        CPPUNIT_ASSERT( stopped.get( item ) && item == "0" ) ;
+        stopped.stop() ;
+        pthread_join( t, 0 ) ;
+        CPPUNIT_ASSERT( held.get_put() < 10 ) ;
+        CPPUNIT_ASSERT( !stopped.get( item ) ) ;
+    }
+
+    void do_order()
+    {
+        string sync = expected() ;
+
+        cerr << "records formatted and written apart, in order" << endl ;
+        TestReader reader ;
+        {
+            CedarPipeline stages( reader, 4 ) ;
+            CPPUNIT_ASSERT( stages.is_running() ) ;
+            deliver( reader ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( reader.format_apart ) ;
+        CPPUNIT_ASSERT( reader.write_apart ) ;
+        CPPUNIT_ASSERT( reader.written == sync ) ;
+
+        cerr << "a slow client holds the records back" << endl ;
+        TestReader slow ;
+        slow.slow = 200 ;
+        {
+            CedarPipeline stages( slow, 2 ) ;
+            deliver( slow ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( slow.written == sync ) ;
+
+        cerr << "a reader already in a pipeline is not staged again" << endl ;
+        TestReader nested ;
+        {
+            CedarPipeline outer( nested, 4 ) ;
+            CedarPipeline inner( nested, 4 ) ;
+            CPPUNIT_ASSERT( outer.is_running() ) ;
+            CPPUNIT_ASSERT( !inner.is_running() ) ;
+            deliver( nested ) ;
+            inner.finish() ;
+            outer.finish() ;
+        }
+        CPPUNIT_ASSERT( nested.written == sync ) ;
+
+        cerr << "output after the pipeline is written directly" << endl ;
+        nested.buf = "end\n" ;
+        nested.output( nested.buf ) ;
+        CPPUNIT_ASSERT( nested.buf.empty() ) ;
+        CPPUNIT_ASSERT( nested.written == sync + "end\n" ) ;
+    }
+
+    void do_done()
+    {
+        cerr << "no more records read once the format stage is done" << endl ;
+        TestReader reader ;
+        reader.done_after = 10 ;
+        reader.slow = 1000 ;
+        {
+            CedarPipeline stages( reader, 4 ) ;
+            deliver( reader ) ;
+            CPPUNIT_ASSERT( reader.is_stopped() ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( reader.formatted == 10 ) ;
+        string sync = expected() ;
+        string::size_type end = 0 ;
+        for( int i = 0; i < 10; i++ )
+            end = sync.find( '\n', end ) + 1 ;
+        CPPUNIT_ASSERT( reader.written == sync.substr( 0, end ) ) ;
+    }
+
+    void do_fail()
+    {
+        cerr << "an error formatting is thrown on the request" << endl ;
+        TestReader reader ;
+        reader.fail_at = 20 ;
+        bool failed = false ;
+        try
+        {
+            CedarPipeline stages( reader, 4 ) ;
+            deliver( reader ) ;
+            stages.finish() ;
+        }
+        catch( BESError &e )
+        {
+            failed = e.get_message() == "format failed" ;
+        }
+        CPPUNIT_ASSERT( failed ) ;
+        CPPUNIT_ASSERT( reader.formatted == 20 ) ;
+
+        cerr << "an error writing is thrown on the request" << endl ;
+        TestReader writer ;
+        writer.fail_write = true ;
+        failed = false ;
+        try
+        {
+            CedarPipeline stages( writer, 4 ) ;
+            deliver( writer ) ;
+            stages.finish() ;
+        }
+        catch( BESError &e )
+        {
+            failed = e.get_message() == "write failed" ;
+        }
+        CPPUNIT_ASSERT( failed ) ;
+        CPPUNIT_ASSERT( writer.written.empty() ) ;
+
+        cerr << "records abandoned when the request fails" << endl ;
+        TestReader abandoned ;
+        abandoned.slow = 1000 ;
+        {
+            CedarPipeline stages( abandoned, 4 ) ;
+            deliver( abandoned ) ;
+        }
+        CPPUNIT_ASSERT( abandoned.formatted < records.size() ) ;
+        CPPUNIT_ASSERT( !abandoned.is_stopped() ) ;
+    }
+
+    void do_pool()
+    {
+        string sync = expected() ;
+
+        cerr << "records formatted by a pool of workers, in order" << endl ;
+        TestReader pooled ;
+        pooled.pooled = true ;
+        pooled.slow_format = 200 ;
+        {
+            CedarPipeline stages( pooled, 4, 4 ) ;
+            CPPUNIT_ASSERT( stages.is_running() ) ;
+            CPPUNIT_ASSERT( stages.get_workers() == 4 ) ;
+            deliver( pooled ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( !pooled.mark_apart ) ;
+        CPPUNIT_ASSERT( pooled.format_apart ) ;
+        CPPUNIT_ASSERT( pooled.formatters.size() > 1 ) ;
+        CPPUNIT_ASSERT( pooled.write_apart ) ;
+        CPPUNIT_ASSERT( pooled.formatted == records.size() ) ;
+        CPPUNIT_ASSERT( pooled.written == sync ) ;
+
+        cerr << "a slow client holds the workers back" << endl ;
+        TestReader slow ;
+        slow.pooled = true ;
+        slow.slow = 500 ;
+        {
+            CedarPipeline stages( slow, 2, 3 ) ;
+            CPPUNIT_ASSERT( stages.get_workers() == 3 ) ;
+            deliver( slow ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( slow.written == sync ) ;
+
+        cerr << "one thread, or a reader without workers, formats in turn"
+             << endl ;
+        TestReader single ;
+        single.pooled = true ;
+        {
+            CedarPipeline stages( single, 4, 1 ) ;
+            CPPUNIT_ASSERT( stages.is_running() ) ;
+            CPPUNIT_ASSERT( stages.get_workers() == 0 ) ;
+            deliver( single ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( single.formatters.size() == 1 ) ;
+        CPPUNIT_ASSERT( single.written == sync ) ;
+        TestReader unpooled ;
+        {
+            CedarPipeline stages( unpooled, 4, 4 ) ;
+            CPPUNIT_ASSERT( stages.is_running() ) ;
+            CPPUNIT_ASSERT( stages.get_workers() == 0 ) ;
+            deliver( unpooled ) ;
+            stages.finish() ;
+        }
+        CPPUNIT_ASSERT( unpooled.written == sync ) ;
+
+        cerr << "an error on a worker is thrown on the request" << endl ;
+        TestReader failing ;
+        failing.pooled = true ;
+        failing.fail_at = 100 ;
+        bool failed = false ;
+        try
+        {
+            CedarPipeline stages( failing, 4, 4 ) ;
+            deliver( failing ) ;
+            stages.finish() ;
+        }
+        catch( BESError &e )
+        {
+            failed = e.get_message() == "format failed" ;
+        }
+        CPPUNIT_ASSERT( failed ) ;
+        CPPUNIT_ASSERT( failing.written.length() < sync.length() ) ;
+        CPPUNIT_ASSERT( sync.compare( 0, failing.written.length(),
+                                      failing.written ) == 0 ) ;
+
+        cerr << "batches abandoned when the request fails" << endl ;
+        TestReader abandoned ;
+        abandoned.pooled = true ;
+        abandoned.slow_format = 1000 ;
+        {
+            CedarPipeline stages( abandoned, 4, 4 ) ;
+            deliver( abandoned ) ;
+        }
+        CPPUNIT_ASSERT( abandoned.written.length() < sync.length() ) ;
+        CPPUNIT_ASSERT( !abandoned.is_stopped() ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( pipelineT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
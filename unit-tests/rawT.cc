@@ -0,0 +1,479 @@
+// rawT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using std::cerr ;
+using std::endl ;
+using std::ifstream ;
+using std::ios ;
+using std::ostringstream ;
+using std::string ;
+using std::vector ;
+
+#include "CedarRawFile.h"
+#include "CedarRawOutput.h"
+#include "CedarCBFWriter.h"
+#include "CedarNetCDFWriter.h"
+#include "CedarArrowWriter.h"
+#include "CedarCompressStream.h"
+#include "BESError.h"
+#include "test_config.h"
+
+class rawT: public TestFixture {
+private:
+    string data_dir ;
+    string tmp_file ;
+
+    string read_file( const string &filename )
+    {
+        ifstream is( filename.c_str(), ios::binary|ios::in ) ;
+        string contents ;
+        char buf[4096] ;
+        while( is.read( buf, sizeof buf ) || is.gcount() )
+        {
+            contents.append( buf, is.gcount() ) ;
+        }
+        return contents ;
+    }
+
+    string read_records( const string &filename )
+    {
+        CedarRawFile raw( filename ) ;
+        CedarRawRecord rec ;
+        string contents ;
+        while( raw.next_record( rec ) )
+        {
+            contents.append( rec.get_bytes(), rec.get_size() ) ;
+        }
+        return contents ;
+    }
+
+    void write_records( const string &filename, const string &outfile )
+    {
+        int fd = open( outfile.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 ) ;
+        CPPUNIT_ASSERT( fd >= 0 ) ;
+        CedarRawOutput out( fd ) ;
+        CedarCBFWriter writer( out ) ;
+        CedarRawFile raw( filename ) ;
+        CedarRawRecord rec ;
+        while( raw.next_record( rec ) )
+        {
+            writer.add_record( rec ) ;
+        }
+        writer.finish() ;
+        close( fd ) ;
+    }
+
+    void count_records( const string &filename, int &header, int &catalog,
+                        int &data, int &rows )
+    {
+        header = catalog = data = rows = 0 ;
+        CedarRawFile raw( filename ) ;
+        CedarRawRecord rec ;
+        while( raw.next_record( rec ) )
+        {
+            switch( rec.get_type() )
+            {
+                case 1:
+                    CPPUNIT_ASSERT( rec.is_valid_data() ) ;
+                    data++ ;
+                    rows += rec.get_nrows() ;
+                    break ;
+                case 2:
+                    catalog++ ;
+                    break ;
+                case 3:
+                    header++ ;
+                    break ;
+                default:
+                    CPPUNIT_ASSERT( !"unknown record type" ) ;
+            }
+        }
+    }
+
+public:
+    rawT() {}
+    ~rawT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+        tmp_file = "./rawT.cbf" ;
+    }
+
+    void tearDown()
+    {
+        unlink( tmp_file.c_str() ) ;
+    }
+
+    CPPUNIT_TEST_SUITE( rawT ) ;
+
+    CPPUNIT_TEST( do_read ) ;
+    CPPUNIT_TEST( do_write ) ;
+    CPPUNIT_TEST( do_range ) ;
+    CPPUNIT_TEST( do_netcdf ) ;
+    CPPUNIT_TEST( do_arrow ) ;
+    CPPUNIT_TEST( do_compress ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_read()
+    {
+        try
+        {
+            int header, catalog, data, rows ;
+            cerr << "count records of mfp920504a.cbf" << endl ;
+            count_records( data_dir + "/mfp920504a.cbf",
+                           header, catalog, data, rows ) ;
+            CPPUNIT_ASSERT( header == 2 ) ;
+            CPPUNIT_ASSERT( catalog == 16 ) ;
+            CPPUNIT_ASSERT( data == 32 ) ;
+            CPPUNIT_ASSERT( rows == 988 ) ;
+
+            cerr << "count records of mlh090323g.001" << endl ;
+            count_records( data_dir + "/mlh090323g.001",
+                           header, catalog, data, rows ) ;
+            CPPUNIT_ASSERT( header == 1 ) ;
+            CPPUNIT_ASSERT( catalog == 1 ) ;
+            CPPUNIT_ASSERT( data == 19 ) ;
+            CPPUNIT_ASSERT( rows == 722 ) ;
+
+            CedarRawFile raw( data_dir + "/mlh090323g.001" ) ;
+            CPPUNIT_ASSERT( raw.get_format() == CedarRawFile::MADRIGAL_FORMAT ) ;
+            CedarRawRecord rec ;
+            CPPUNIT_ASSERT( raw.next_record( rec ) ) ;
+            CPPUNIT_ASSERT( rec.get_ordinal() == 0 ) ;
+            CPPUNIT_ASSERT( rec.get_type() == 2 ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to read the raw records" ) ;
+        }
+    }
+
+    void do_write()
+    {
+        try
+        {
+            // the sample cbf file is reproduced exactly
+            cerr << "rewrite mfp920504a.cbf" << endl ;
+            string cbf = data_dir + "/mfp920504a.cbf" ;
+            write_records( cbf, tmp_file ) ;
+            CPPUNIT_ASSERT( read_file( tmp_file ) == read_file( cbf ) ) ;
+
+            // the madrigal file becomes a cbf file with the same records
+            cerr << "rewrite mlh090323g.001 as cbf" << endl ;
+            string madrigal = data_dir + "/mlh090323g.001" ;
+            write_records( madrigal, tmp_file ) ;
+            CedarRawFile raw( tmp_file ) ;
+            CPPUNIT_ASSERT( raw.get_format() == CedarRawFile::CBF_FORMAT ) ;
+            CPPUNIT_ASSERT( read_file( tmp_file ).length() % 4096 == 0 ) ;
+            CPPUNIT_ASSERT( read_records( tmp_file ) == read_records( madrigal ) ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to write the raw records" ) ;
+        }
+    }
+
+    void do_range()
+    {
+        unsigned long long first = 0 ;
+        unsigned long long last = 0 ;
+        CedarByteRange range ;
+
+        CPPUNIT_ASSERT( range.parse( "bytes=100-199" ) ) ;
+        CPPUNIT_ASSERT( range.resolve( 1000, first, last ) ) ;
+        CPPUNIT_ASSERT( first == 100 && last == 199 ) ;
+        CPPUNIT_ASSERT( range.resolve( 150, first, last ) ) ;
+        CPPUNIT_ASSERT( first == 100 && last == 149 ) ;
+        CPPUNIT_ASSERT( !range.resolve( 100, first, last ) ) ;
+
+        CPPUNIT_ASSERT( range.parse( "bytes=500-" ) ) ;
+        CPPUNIT_ASSERT( range.resolve( 1000, first, last ) ) ;
+        CPPUNIT_ASSERT( first == 500 && last == 999 ) ;
+
+        CPPUNIT_ASSERT( range.parse( "bytes=-300" ) ) ;
+        CPPUNIT_ASSERT( range.is_suffix() ) ;
+        CPPUNIT_ASSERT( !range.resolve( first, last ) ) ;
+        CPPUNIT_ASSERT( range.resolve( 1000, first, last ) ) ;
+        CPPUNIT_ASSERT( first == 700 && last == 999 ) ;
+
+        CPPUNIT_ASSERT( !range.parse( "bytes=0-1,5-9" ) ) ;
+        CPPUNIT_ASSERT( !range.parse( "bytes=9-1" ) ) ;
+        CPPUNIT_ASSERT( !range.parse( "lines=1-5" ) ) ;
+        CPPUNIT_ASSERT( !range.is_set() ) ;
+
+        try
+        {
+            // write the whole of the sample file through a ranged output,
+            // only the requested bytes come out
+            cerr << "write bytes 5000-9999 of mfp920504a.cbf" << endl ;
+            string cbf = data_dir + "/mfp920504a.cbf" ;
+            string contents = read_file( cbf ) ;
+            int fd = open( tmp_file.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            CedarRawOutput out( fd ) ;
+            out.set_range( 5000, 9999 ) ;
+            for( size_t i = 0; i < contents.length() && !out.is_done(); i += 4096 )
+            {
+                out.write( contents.data() + i, 4096 ) ;
+            }
+            close( fd ) ;
+            CPPUNIT_ASSERT( out.is_done() ) ;
+            CPPUNIT_ASSERT( read_file( tmp_file ) == contents.substr( 5000, 5000 ) ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to write the byte range" ) ;
+        }
+    }
+
+    void do_netcdf()
+    {
+        try
+        {
+            // a row for every row of the data records, plus one for each
+            // data record without rows
+            cerr << "write mfp920504a.cbf as netcdf" << endl ;
+            string cbf = data_dir + "/mfp920504a.cbf" ;
+            unsigned long nrows = 0 ;
+            {
+                CedarRawFile raw( cbf ) ;
+                CedarRawRecord rec ;
+                while( raw.next_record( rec ) )
+                {
+                    if( rec.get_type() == 1 )
+                        nrows += rec.get_nrows() ? rec.get_nrows() : 1 ;
+                }
+            }
+            CPPUNIT_ASSERT( nrows == 988 ) ;
+
+            int fd = open( tmp_file.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            CedarRawOutput out( fd ) ;
+            CedarNetCDFWriter writer( out, "row" ) ;
+            writer.add_attribute( "source", "mfp920504a" ) ;
+            int record = writer.add_variable( "record", CEDAR_NC_INT ) ;
+            int kinst = writer.add_variable( "KINST", CEDAR_NC_SHORT ) ;
+            int value = writer.add_variable( "value", CEDAR_NC_SHORT ) ;
+            writer.add_attribute( value, "_FillValue", (short)-32767 ) ;
+            writer.add_attribute( value, "scale_factor", 0.01 ) ;
+            CPPUNIT_ASSERT( writer.has_variable( "KINST" ) ) ;
+            writer.write_header( nrows ) ;
+            unsigned long long header = out.get_position() ;
+
+            CedarRawFile raw( cbf ) ;
+            CedarRawRecord rec ;
+            while( raw.next_record( rec ) )
+            {
+                if( rec.get_type() != 1 )
+                    continue ;
+                writer.clear_record() ;
+                writer.set_value( record, rec.get_ordinal() ) ;
+                writer.set_value( kinst, rec.get_kinst() ) ;
+                if( rec.get_nrows() == 0 )
+                    writer.write_record() ;
+                for( int row = 0; row < rec.get_nrows(); row++ )
+                {
+                    writer.set_value( value, rec.get_mpar_value( row, 0 ) ) ;
+                    writer.write_record() ;
+                }
+            }
+            writer.finish() ;
+            close( fd ) ;
+
+            string contents = read_file( tmp_file ) ;
+            CPPUNIT_ASSERT( contents.length() == header + nrows * 12 ) ;
+            CPPUNIT_ASSERT( contents.substr( 0, 4 ) == string( "CDF\001", 4 ) ) ;
+            CPPUNIT_ASSERT( (unsigned char)contents[7] == ( nrows & 0xFF ) ) ;
+            CPPUNIT_ASSERT( (unsigned char)contents[6] == ( nrows >> 8 ) ) ;
+
+            // a record more than the header says is refused
+            bool refused = false ;
+            try
+            {
+                writer.write_record() ;
+            }
+            catch( BESError & )
+            {
+                refused = true ;
+            }
+            CPPUNIT_ASSERT( refused ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to write the netcdf file" ) ;
+        }
+    }
+
+    void do_arrow()
+    {
+        try
+        {
+            cerr << "write mfp920504a.cbf as an arrow stream" << endl ;
+            string cbf = data_dir + "/mfp920504a.cbf" ;
+            int fd = open( tmp_file.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644 ) ;
+            CPPUNIT_ASSERT( fd >= 0 ) ;
+            CedarRawOutput out( fd ) ;
+            CedarArrowWriter writer( out ) ;
+            writer.add_metadata( "source", "mfp920504a" ) ;
+            int record = writer.add_column( "record", 32, false ) ;
+            int kindat = writer.add_column( "KINDAT", 16, false ) ;
+            int value = writer.add_column( "value", 16, true ) ;
+            writer.add_metadata( value, "code", "10" ) ;
+            CPPUNIT_ASSERT( writer.has_column( "KINDAT" ) ) ;
+            writer.write_schema() ;
+            unsigned long long schema = out.get_position() ;
+            CPPUNIT_ASSERT( schema % 8 == 0 ) ;
+
+            CedarRawFile raw( cbf ) ;
+            CedarRawRecord rec ;
+            while( raw.next_record( rec ) )
+            {
+                if( rec.get_type() != 1 )
+                    continue ;
+                writer.flush() ;
+                CPPUNIT_ASSERT( writer.get_batch_rows() == 0 ) ;
+                writer.clear_row() ;
+                writer.set_value( record, rec.get_ordinal() ) ;
+                writer.set_value( kindat, rec.get_kindat() ) ;
+                if( rec.get_nrows() == 0 )
+                    writer.end_row() ;
+                for( int row = 0; row < rec.get_nrows(); row++ )
+                {
+                    writer.set_value( value, rec.get_mpar_value( row, 0 ) ) ;
+                    writer.end_row() ;
+                }
+            }
+            writer.finish() ;
+            close( fd ) ;
+            CPPUNIT_ASSERT( writer.get_total_rows() == 988 ) ;
+
+            // every message starts with the continuation marker and the
+            // stream ends with an empty one
+            string contents = read_file( tmp_file ) ;
+            CPPUNIT_ASSERT( contents.length() % 8 == 0 ) ;
+            CPPUNIT_ASSERT( contents.substr( 0, 4 ) == "\xff\xff\xff\xff" ) ;
+            CPPUNIT_ASSERT( contents.substr( schema, 4 ) == "\xff\xff\xff\xff" ) ;
+            CPPUNIT_ASSERT( contents.substr( contents.length() - 8 )
+                            == string( "\xff\xff\xff\xff\0\0\0\0", 8 ) ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to write the arrow stream" ) ;
+        }
+    }
+
+
+    void do_compress()
+    {
+        cerr << "negotiate the content encoding" << endl ;
+        string gzip = CedarCompressStream::is_supported( "gzip" ) ? "gzip" : "" ;
+        string zstd = CedarCompressStream::is_supported( "zstd" ) ? "zstd" : gzip ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "" ) == "" ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "identity, br" ) == "" ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "gzip" ) == gzip ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "x-gzip" ) == gzip ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "gzip;q=0.5, zstd" ) == zstd ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "zstd;q=0, *" ) == gzip ) ;
+        CPPUNIT_ASSERT( CedarCompressStream::negotiate( "*;q=0" ) == "" ) ;
+
+#ifdef HAVE_LIBZ
+        try
+        {
+            cerr << "gzip a flat like product as it is written" << endl ;
+            string text ;
+            for( int row = 0; row < 20000; row++ )
+            {
+                char line[64] ;
+                sprintf( line, "%9d%9d%9d\n", row, row % 360, -32767 ) ;
+                text += line ;
+            }
+            ostringstream strm ;
+            CedarCompressStream zs( strm, "gzip", 6, 4096, true ) ;
+            for( size_t i = 0; i < text.length(); i += 1000 )
+            {
+                zs << text.substr( i, 1000 ) ;
+                zs.flush() ;
+            }
+            zs.finish() ;
+            CPPUNIT_ASSERT( zs.get_buf().get_encoding() == "gzip" ) ;
+            CPPUNIT_ASSERT( zs.get_buf().get_in_bytes() == text.length() ) ;
+
+            string out = strm.str() ;
+            string::size_type body = out.find( "\r\n\r\n" ) ;
+            CPPUNIT_ASSERT( body != string::npos ) ;
+            string header = out.substr( 0, body ) ;
+            CPPUNIT_ASSERT( header.find( "Content-Encoding: gzip" ) != string::npos ) ;
+            CPPUNIT_ASSERT( header.find( "Vary: Accept-Encoding" ) != string::npos ) ;
+            body += 4 ;
+            CPPUNIT_ASSERT( out.length() - body < text.length() / 4 ) ;
+
+            z_stream z ;
+            memset( &z, 0, sizeof z ) ;
+            CPPUNIT_ASSERT( inflateInit2( &z, 15 + 16 ) == Z_OK ) ;
+            vector<char> plain( text.length() + 1 ) ;
+            z.next_in = (Bytef *)out.data() + body ;
+            z.avail_in = out.length() - body ;
+            z.next_out = (Bytef *)&plain[0] ;
+            z.avail_out = plain.size() ;
+            CPPUNIT_ASSERT( inflate( &z, Z_FINISH ) == Z_STREAM_END ) ;
+            CPPUNIT_ASSERT( z.total_out == text.length() ) ;
+            inflateEnd( &z ) ;
+            CPPUNIT_ASSERT( string( &plain[0], text.length() ) == text ) ;
+
+            cerr << "send a product below the threshold as is" << endl ;
+            ostringstream small ;
+            CedarCompressStream ss( small, "gzip", 6, 4096, true ) ;
+            ss << text.substr( 0, 100 ) ;
+            ss.finish() ;
+            CPPUNIT_ASSERT( ss.get_buf().get_encoding() == "" ) ;
+            out = small.str() ;
+            CPPUNIT_ASSERT( out.find( "Content-Encoding" ) == string::npos ) ;
+            CPPUNIT_ASSERT( out.substr( out.find( "\r\n\r\n" ) + 4 ) == text.substr( 0, 100 ) ) ;
+        }
+        catch( BESError &e )
+        {
+            cerr << e.get_message() << endl ;
+            CPPUNIT_ASSERT( !"Failed to compress the product" ) ;
+        }
+#endif
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( rawT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
+
@@ -0,0 +1,196 @@
+// scratchT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <stdlib.h>
+
+#include <iostream>
+#include <new>
+#include <ostream>
+#include <string>
+
+using std::cerr ;
+using std::endl ;
+using std::ostream ;
+using std::string ;
+
+#include "CedarFile.h"
+#include "CedarDataRecord.h"
+#include "CedarException.h"
+#include "CedarScratch.h"
+#include "test_config.h"
+
+// every allocation of the test is counted while counting is on
+static bool counting = false ;
+static unsigned long allocations = 0 ;
+
+void *
+operator new( size_t size ) throw( std::bad_alloc )
+{
+    if( counting )
+        allocations++ ;
+    void *p = malloc( size ? size : 1 ) ;
+    if( !p )
+        throw std::bad_alloc() ;
+    return p ;
+}
+
+void
+operator delete( void *p ) throw()
+{
+    free( p ) ;
+}
+
+void *
+operator new[]( size_t size ) throw( std::bad_alloc )
+{
+    return operator new( size ) ;
+}
+
+void
+operator delete[]( void *p ) throw()
+{
+    operator delete( p ) ;
+}
+
+class scratchT: public TestFixture {
+private:
+    string data_dir ;
+
+    void start()
+    {
+        allocations = 0 ;
+        counting = true ;
+    }
+    unsigned long stop()
+    {
+        counting = false ;
+        return allocations ;
+    }
+
+    // loads every record of path into the scratch with the methods
+    // load_dds, load_das and route_buffer use, counting the allocations
+    // of the loading only when count is set. The file allocates records of its
+    // own as it is read, so those are not counted
+    unsigned long load( const string &path, CedarScratch &scratch,
+                        bool count, unsigned long &records )
+    {
+        unsigned long made = 0 ;
+        CedarFile file ;
+        file.open_file( path.c_str() ) ;
+        const CedarLogicalRecord *lr = file.get_first_logical_record() ;
+        while( lr )
+        {
+            if( count )
+                start() ;
+            if( lr->get_type() == 1 )
+            {
+                CedarDataRecord *dr = (CedarDataRecord*)lr ;
+                scratch.load_codes( *dr ) ;
+                scratch.load_jpar( *dr ) ;
+                if( dr->get_mpar() > 0 && dr->get_nrows() > 0 )
+                {
+                    scratch.load_mpar( *dr ) ;
+                    for( int m = 0; m < dr->get_mpar(); m++ )
+                        scratch.load_column( m ) ;
+                }
+                records++ ;
+            }
+            else
+            {
+                scratch.save_text( *lr ) ;
+            }
+            if( count )
+                made += stop() ;
+            lr = 0 ;
+            if( !file.end_dataset() )
+                lr = file.get_next_logical_record() ;
+        }
+        return made ;
+    }
+
+public:
+    scratchT() {}
+    ~scratchT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+    }
+
+    void tearDown()
+    {
+        counting = false ;
+    }
+
+    CPPUNIT_TEST_SUITE( scratchT ) ;
+
+    CPPUNIT_TEST( do_text ) ;
+    CPPUNIT_TEST( do_records ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_text()
+    {
+        CedarScratch scratch ;
+        ostream strm( &scratch.text_buf ) ;
+        strm << "warming up the text buffer of the scratch" << '\n' ;
+        CPPUNIT_ASSERT( scratch.text
+                        == "warming up the text buffer of the scratch\n" ) ;
+
+        start() ;
+        for( int i = 0; i < 1000; i++ )
+        {
+            scratch.text.erase() ;
+            strm << "record " << i << " of " << 1000 << '\n' ;
+        }
+        unsigned long made = stop() ;
+        cerr << "allocations " << made << endl ;
+        CPPUNIT_ASSERT( made == 0 ) ;
+        CPPUNIT_ASSERT( scratch.text == "record 999 of 1000\n" ) ;
+    }
+
+    void do_records()
+    {
+        string path = data_dir + "/mfp911104a.cbf" ;
+        CedarScratch scratch ;
+        unsigned long records = 0 ;
+        try
+        {
+            // the first pass grows the buffers to the largest record
+            load( path, scratch, false, records ) ;
+
+            // and loading the same records again allocates nothing
+            records = 0 ;
+            unsigned long made = load( path, scratch, true, records ) ;
+            cerr << "records " << records << ", allocations " << made
+                 << endl ;
+            CPPUNIT_ASSERT( made == 0 ) ;
+        }
+        catch( CedarException &e )
+        {
+            counting = false ;
+            cerr << e.get_description() << endl ;
+            CPPUNIT_ASSERT( !"Failed to read the records" ) ;
+        }
+        CPPUNIT_ASSERT( records > 100 ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( scratchT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
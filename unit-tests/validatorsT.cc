@@ -0,0 +1,162 @@
+// validatorsT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <iostream>
+#include <string>
+
+using std::cerr ;
+using std::endl ;
+using std::string ;
+
+#include "CedarValidators.h"
+#include "CedarNotModifiedException.h"
+#include "CedarCache.h"
+#include "CedarResponseNames.h"
+#include "BESContextManager.h"
+#include "TheBESKeys.h"
+#include "test_config.h"
+
+class validatorsT: public TestFixture {
+private:
+    string data ;
+
+public:
+    validatorsT() {}
+    ~validatorsT() {}
+
+    void setUp()
+    {
+        TheBESKeys::ConfigFile = (string)TEST_SRC_DIR + "/bes.conf" ;
+        data = (string)TEST_SRC_DIR + "/../data/mfp920504a.cbf" ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_NONE_MATCH_CONTEXT, "" ) ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_MODIFIED_SINCE_CONTEXT, "" ) ;
+        CedarValidators::clear() ;
+    }
+
+    void tearDown()
+    {
+        BESContextManager::TheManager()->set_context( CEDAR_IF_NONE_MATCH_CONTEXT, "" ) ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_MODIFIED_SINCE_CONTEXT, "" ) ;
+        CedarValidators::clear() ;
+    }
+
+    CPPUNIT_TEST_SUITE( validatorsT ) ;
+
+    CPPUNIT_TEST( do_dates ) ;
+    CPPUNIT_TEST( do_matches ) ;
+    CPPUNIT_TEST( do_check ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_dates()
+    {
+        cerr << "parse the three forms of HTTP date" << endl ;
+        time_t t = 0 ;
+        CPPUNIT_ASSERT( CedarValidators::parse_http_date( "Sun, 06 Nov 1994 08:49:37 GMT", t ) ) ;
+        CPPUNIT_ASSERT( t == 784111777 ) ;
+        t = 0 ;
+        CPPUNIT_ASSERT( CedarValidators::parse_http_date( "Sunday, 06-Nov-94 08:49:37 GMT", t ) ) ;
+        CPPUNIT_ASSERT( t == 784111777 ) ;
+        t = 0 ;
+        CPPUNIT_ASSERT( CedarValidators::parse_http_date( "Sun Nov  6 08:49:37 1994", t ) ) ;
+        CPPUNIT_ASSERT( t == 784111777 ) ;
+        CPPUNIT_ASSERT( !CedarValidators::parse_http_date( "yesterday", t ) ) ;
+        CPPUNIT_ASSERT( !CedarValidators::parse_http_date( "", t ) ) ;
+
+        cerr << "format an HTTP date" << endl ;
+        CPPUNIT_ASSERT( CedarValidators::http_date( 784111777 ) == "Sun, 06 Nov 1994 08:49:37 GMT" ) ;
+    }
+
+    void do_matches()
+    {
+        string key = "0123456789abcdef0123456789abcdef" ;
+        string etag ;
+
+        cerr << "match If-None-Match lists" << endl ;
+        CPPUNIT_ASSERT( CedarValidators::matches( "\"" + key + "\"", key, etag ) ) ;
+        CPPUNIT_ASSERT( etag == "\"" + key + "\"" ) ;
+        CPPUNIT_ASSERT( CedarValidators::matches( "\"other\", W/\"" + key + "\"", key, etag ) ) ;
+        CPPUNIT_ASSERT( etag == "W/\"" + key + "\"" ) ;
+        CPPUNIT_ASSERT( CedarValidators::matches( "\"" + key + "-gzip\"", key, etag ) ) ;
+        CPPUNIT_ASSERT( CedarValidators::matches( " * ", key, etag ) ) ;
+        CPPUNIT_ASSERT( !CedarValidators::matches( "\"other\"", key, etag ) ) ;
+        CPPUNIT_ASSERT( !CedarValidators::matches( key, key, etag ) ) ;
+        CPPUNIT_ASSERT( !CedarValidators::matches( "\"" + key + "x\"", key, etag ) ) ;
+        CPPUNIT_ASSERT( !CedarValidators::matches( "", key, etag ) ) ;
+    }
+
+    void do_check()
+    {
+        string key = CedarCache::get_key( data, "get.tab", "parameters(54)" ) ;
+
+        cerr << "find the validators of a product" << endl ;
+        CedarValidators::check( data, "get.tab", "parameters(54)" ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_etag() == "\"" + key + "\"" ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_etag( "gzip" ) == "\"" + key + "-gzip\"" ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_last_modified() != 0 ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_http_header( "" ).find( "ETag: \"" + key + "\"\r\n" ) == 0 ) ;
+
+        cerr << "no validators for a missing file" << endl ;
+        CedarValidators::check( data + ".missing", "get.tab", "" ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_etag() == "" ) ;
+        CPPUNIT_ASSERT( CedarValidators::get_http_header( "" ) == "" ) ;
+
+        cerr << "stop when the ETag matches" << endl ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_NONE_MATCH_CONTEXT, "\"" + key + "\"" ) ;
+        bool stopped = false ;
+        try
+        {
+            CedarValidators::check( data, "get.tab", " parameters( 54 )" ) ;
+        }
+        catch( CedarNotModifiedException &e )
+        {
+            stopped = true ;
+            CPPUNIT_ASSERT( e.get_etag() == "\"" + key + "\"" ) ;
+        }
+        CPPUNIT_ASSERT( stopped ) ;
+
+        cerr << "go on when the ETag is of another product" << endl ;
+        CedarValidators::check( data, "get.flat", "parameters(54)" ) ;
+        CedarValidators::check( data, "get.tab", "parameters(160)" ) ;
+
+        cerr << "If-Modified-Since is ignored with If-None-Match" << endl ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_MODIFIED_SINCE_CONTEXT, "Fri, 31 Dec 2999 23:59:59 GMT" ) ;
+        CedarValidators::check( data, "get.flat", "parameters(54)" ) ;
+
+        cerr << "stop when the file has not changed since" << endl ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_NONE_MATCH_CONTEXT, "" ) ;
+        stopped = false ;
+        try
+        {
+            CedarValidators::check( data, "get.flat", "parameters(54)" ) ;
+        }
+        catch( CedarNotModifiedException &e )
+        {
+            stopped = true ;
+        }
+        CPPUNIT_ASSERT( stopped ) ;
+
+        cerr << "go on when the file has changed since" << endl ;
+        BESContextManager::TheManager()->set_context( CEDAR_IF_MODIFIED_SINCE_CONTEXT, "Sun, 06 Nov 1994 08:49:37 GMT" ) ;
+        CedarValidators::check( data, "get.flat", "parameters(54)" ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( validatorsT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}
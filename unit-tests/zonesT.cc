@@ -0,0 +1,204 @@
+// zonesT.cc
+
+#include <cppunit/TextTestRunner.h>
+#include <cppunit/extensions/TestFactoryRegistry.h>
+#include <cppunit/extensions/HelperMacros.h>
+
+using namespace CppUnit ;
+
+#include <iostream>
+#include <string>
+#include <utility>
+
+using std::cerr ;
+using std::endl ;
+using std::string ;
+using std::pair ;
+
+#include "CedarZoneMap.h"
+#include "CedarRawFile.h"
+#include "test_config.h"
+
+class zonesT: public TestFixture {
+private:
+    string data_dir ;
+
+    CedarZoneMap *build( const string &filename )
+    {
+        CedarZoneMap *zones = new CedarZoneMap ;
+        CedarRawFile raw( filename ) ;
+        CedarRawRecord rec ;
+        while( raw.next_record( rec ) )
+        {
+            zones->add_record( rec ) ;
+        }
+        return zones ;
+    }
+
+    // every value of every data record is within its zone
+    void check( const string &filename )
+    {
+        CedarZoneMap *zones = build( filename ) ;
+        CPPUNIT_ASSERT( zones->is_complete() ) ;
+        CedarRawFile raw( filename ) ;
+        CedarRawRecord rec ;
+        unsigned long records = 0 ;
+        unsigned long data = 0 ;
+        while( raw.next_record( rec ) )
+        {
+            records++ ;
+            const CedarZoneMap::Zone *z = zones->get_zones( rec ) ;
+            if( rec.get_type() != 1 || !rec.is_valid_data()
+                || rec.get_mpar() == 0 )
+            {
+                CPPUNIT_ASSERT( z == 0 ) ;
+                continue ;
+            }
+            CPPUNIT_ASSERT( z != 0 ) ;
+            data++ ;
+            for( int m = 0; m < rec.get_mpar(); m++ )
+            {
+                int nulls = 0 ;
+                bool min_seen = false ;
+                bool max_seen = false ;
+                for( int row = 0; row < rec.get_nrows(); row++ )
+                {
+                    int value = rec.get_mpar_value( row, m ) ;
+                    if( value == CEDAR_RAW_MISSING )
+                    {
+                        nulls++ ;
+                        continue ;
+                    }
+                    CPPUNIT_ASSERT( value >= z[m].min ) ;
+                    CPPUNIT_ASSERT( value <= z[m].max ) ;
+                    if( value == z[m].min ) min_seen = true ;
+                    if( value == z[m].max ) max_seen = true ;
+                }
+                CPPUNIT_ASSERT( nulls == z[m].nulls ) ;
+                if( nulls < rec.get_nrows() )
+                {
+                    CPPUNIT_ASSERT( min_seen && max_seen ) ;
+                }
+            }
+        }
+        CPPUNIT_ASSERT( records == zones->get_records() ) ;
+        CPPUNIT_ASSERT( data > 0 ) ;
+        delete zones ;
+    }
+
+    CedarZoneMap::Zone zone( int min, int max, int nulls )
+    {
+        CedarZoneMap::Zone z ;
+        z.min = min ;
+        z.max = max ;
+        z.nulls = nulls ;
+        return z ;
+    }
+
+public:
+    zonesT() {}
+    ~zonesT() {}
+
+    void setUp()
+    {
+        data_dir = (string)TEST_SRC_DIR + "/../data" ;
+        CedarZoneMap::Clear() ;
+    }
+
+    void tearDown()
+    {
+        CedarZoneMap::Clear() ;
+    }
+
+    CPPUNIT_TEST_SUITE( zonesT ) ;
+
+    CPPUNIT_TEST( do_build ) ;
+    CPPUNIT_TEST( do_match ) ;
+    CPPUNIT_TEST( do_keep ) ;
+
+    CPPUNIT_TEST_SUITE_END() ;
+
+    void do_build()
+    {
+        cerr << "zones of a cbf file" << endl ;
+        check( data_dir + "/mfp920504a.cbf" ) ;
+        cerr << "zones of a madrigal file" << endl ;
+        check( data_dir + "/mlh090323g.001" ) ;
+    }
+
+    void do_match()
+    {
+        CedarZoneFilter::Runs runs ;
+        runs.push_back( pair<int,int>( 100, 200 ) ) ;
+        runs.push_back( pair<int,int>( 300, 400 ) ) ;
+
+        cerr << "values in the runs" << endl ;
+        CPPUNIT_ASSERT( CedarZoneFilter::passes( runs, 100 ) ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::passes( runs, 350 ) ) ;
+        CPPUNIT_ASSERT( !CedarZoneFilter::passes( runs, 99 ) ) ;
+        CPPUNIT_ASSERT( !CedarZoneFilter::passes( runs, 250 ) ) ;
+        CPPUNIT_ASSERT( !CedarZoneFilter::passes( runs, 401 ) ) ;
+        CPPUNIT_ASSERT( !CedarZoneFilter::passes( runs, CEDAR_RAW_MISSING ) ) ;
+
+        cerr << "zones against the runs" << endl ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 120, 180, 0 ), 10, runs ) == CedarZoneFilter::ALL ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 0, 99, 0 ), 10, runs ) == CedarZoneFilter::NONE ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 201, 299, 0 ), 10, runs ) == CedarZoneFilter::NONE ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 500, 600, 0 ), 10, runs ) == CedarZoneFilter::NONE ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 150, 350, 0 ), 10, runs ) == CedarZoneFilter::SOME ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 0, 1000, 0 ), 10, runs ) == CedarZoneFilter::SOME ) ;
+
+        cerr << "missing values" << endl ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 120, 180, 2 ), 10, runs ) == CedarZoneFilter::SOME ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 32767, -32768, 10 ), 10, runs ) == CedarZoneFilter::NONE ) ;
+        runs.insert( runs.begin(), pair<int,int>( CEDAR_RAW_MISSING, CEDAR_RAW_MISSING ) ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 120, 180, 2 ), 10, runs ) == CedarZoneFilter::ALL ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 32767, -32768, 10 ), 10, runs ) == CedarZoneFilter::ALL ) ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 0, 99, 2 ), 10, runs ) == CedarZoneFilter::SOME ) ;
+
+        cerr << "records without rows" << endl ;
+        CPPUNIT_ASSERT( CedarZoneFilter::match( zone( 32767, -32768, 0 ), 0, runs ) == CedarZoneFilter::NONE ) ;
+    }
+
+    void do_keep()
+    {
+        cerr << "keep a complete zone map" << endl ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "file" ) == 0 ) ;
+        CedarZoneMap *zones = build( data_dir + "/mlh090323g.001" ) ;
+        CedarZoneMap::add( "file", zones ) ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "file" ) == zones ) ;
+        CedarZoneMap::add( "file", build( data_dir + "/mlh090323g.001" ) ) ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "file" ) == zones ) ;
+        CedarZoneMap::add( "", build( data_dir + "/mlh090323g.001" ) ) ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "" ) == 0 ) ;
+
+        cerr << "do not keep an incomplete zone map" << endl ;
+        CedarZoneMap *partial = new CedarZoneMap ;
+        CedarRawFile raw( data_dir + "/mlh090323g.001" ) ;
+        CedarRawRecord rec ;
+        raw.next_record( rec ) ;
+        raw.next_record( rec ) ;
+        partial->add_record( rec ) ;
+        CPPUNIT_ASSERT( !partial->is_complete() ) ;
+        CedarZoneMap::add( "partial", partial ) ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "partial" ) == 0 ) ;
+
+        cerr << "drop the zone maps" << endl ;
+        CedarZoneMap::Clear() ;
+        CPPUNIT_ASSERT( CedarZoneMap::get( "file" ) == 0 ) ;
+    }
+
+} ;
+
+CPPUNIT_TEST_SUITE_REGISTRATION( zonesT ) ;
+
+int
+main( int, char** )
+{
+    CppUnit::TextTestRunner runner ;
+    runner.addTest( CppUnit::TestFactoryRegistry::getRegistry().makeTest() ) ;
+
+    bool wasSuccessful = runner.run( "", false )  ;
+
+    return wasSuccessful ? 0 : 1 ;
+}